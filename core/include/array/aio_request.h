@@ -0,0 +1,72 @@
+/**
+ * @file   aio_request.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2016 MIT and Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * @section DESCRIPTION
+ *
+ * A C-style struct that specifies an asynchronous read request.
+ */
+
+#ifndef __AIO_REQUEST_H__
+#define __AIO_REQUEST_H__
+
+#include <stddef.h>
+
+/** 
+ * Specifies an asynchronous read request. It must have the same layout as
+ * TileDB_AIO_Request in the C API.
+ */
+typedef struct AIO_Request {
+  /** The buffers where the results are written (see Array::read()). */
+  void** buffers_;
+  /** 
+   * The sizes of the buffers, which are updated with the sizes of the useful
+   * data upon completion (see Array::read()).
+   */
+  size_t* buffer_sizes_;
+  /** 
+   * The function invoked (by an internal thread) upon the completion of the
+   * request. It may be NULL.
+   */
+  void (*completion_handle_)(void*);
+  /** The argument passed to *completion_handle_*. */
+  void* completion_data_;
+  /** 
+   * The status of the request. It can be one of the following:
+   *    - TILEDB_AIO_INPROGRESS
+   *    - TILEDB_AIO_COMPLETED
+   *    - TILEDB_AIO_OVERFLOW
+   *    - TILEDB_AIO_ERR
+   */
+  volatile int status_;
+  /** 
+   * A new subarray to read from. If it is NULL, the request continues from
+   * where the previous read on the array stopped.
+   */
+  const void* subarray_;
+} AIO_Request;
+
+#endif
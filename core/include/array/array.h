@@ -33,10 +33,17 @@
 #ifndef __ARRAY_H__
 #define __ARRAY_H__
 
+#include "aio_request.h"
 #include "array_read_state.h"
 #include "array_schema.h"
+#include "config.h"
+#include "consolidation_policy.h"
 #include "constants.h"
 #include "fragment.h"
+#include "thread_pool.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 
 
 
@@ -83,6 +90,22 @@ class Array {
   /** Returns the ids of the attributes the array focuses on. */
   const std::vector<int>& attribute_ids() const;
 
+  /** Returns the configuration parameters of the array. */
+  const Config* config() const;
+
+  /**
+   * Estimates the sizes of the buffers that would hold the entire result of
+   * read() on the current subarray and attributes, using only the 
+   * book-keeping of the fragments (i.e., without reading any tiles). The 
+   * estimates are upper bounds, so that the result can be retrieved with a
+   * single read() into buffers of these sizes.
+   *
+   * @param buffer_sizes The estimated sizes (in bytes), one per buffer of 
+   *     read(), i.e., two for each variable-sized attribute.
+   * @return TILEDB_AR_OK for success and TILEDB_AR_ERR for error.
+   */
+  int estimate_result_size(size_t* buffer_sizes) const;
+
   /** Returns the number of fragments in this array. */
   int fragment_num() const;
 
@@ -128,6 +151,26 @@ class Array {
    */
   int read(void** buffers, size_t* buffer_sizes); 
 
+  /**
+   * Performs a zero-copy read operation in an array, which must be initialized
+   * with mode TILEDB_ARRAY_READ. Instead of copying the result cells into user
+   * buffers, it returns a view for each attribute, i.e., a pointer to the next
+   * run of result cells inside a decompressed (or memory-mapped) tile, along
+   * with the size of the run. The views are leased to the caller and remain
+   * valid until release_views() is invoked, which must precede the next 
+   * invocation. Only **fixed-sized** attributes are supported, and the 
+   * function cannot be mixed with read() on the same array: each of the two
+   * fails once the other has been used, until reset_subarray() is invoked.
+   *
+   * @param views An array of views, one for each attribute, in the same order
+   *     as the attributes specified in init() or reset_attributes().
+   * @param view_sizes The sizes (in bytes) of the views (there is a one-to-one
+   *     correspondence). A zero size indicates that there are no more results
+   *     for the attribute.
+   * @return TILEDB_AR_OK for success and TILEDB_AR_ERR for error.
+   */
+  int read_views(const void** views, size_t* view_sizes); 
+
   /** Returns the subarray in which the array is constrained. */
   const void* subarray() const;
 
@@ -139,22 +182,46 @@ class Array {
   /* ********************************* */
 
   /**
-   * Consolidates all fragments into a new single one, on a per-attribute basis.
+   * Submits an asynchronous read request, which is served by a thread of the
+   * input pool. The requests submitted to the same array are served one at a
+   * time in submission order, so a request that completed with status
+   * TILEDB_AIO_OVERFLOW can simply be resubmitted to continue the read. The
+   * caller must not invoke read() or reset_subarray() while requests are
+   * pending. Upon completion, the status of the request is set and its
+   * completion handle (if any) is invoked.
+   *
+   * @param aio_request The read request.
+   * @param thread_pool The thread pool that will serve the request.
+   * @return TILEDB_AR_OK for success and TILEDB_AR_ERR for error.
+   */
+  int aio_read(AIO_Request* aio_request, ThreadPool* thread_pool);
+
+  /**
+   * Consolidates the fragments selected by a policy into a new single one. 
+   * All the attributes are read and written in a single pass, so that the 
+   * fragment cell ranges are merged only once. When only some of the 
+   * fragments are merged, the new fragment takes the place of the newest
+   * merged fragment in the fragment order.
    *
+   * @param policy The policy that selects the fragments to be merged.
+   * @param buffer_size The total size of the buffers through which the cells
+   *     of all the attributes are copied into the new fragment.
    * @return TILEDB_AR_OK for success and TILEDB_AR_ERR for error.
    */
-  int consolidate();
+  int consolidate(const ConsolidationPolicy* policy, size_t buffer_size);
 
   /**
-   * Consolidates all fragment into a new single one, focusing on a specific
-   * attribute.
+   * Consolidates the opened fragments into a new single one, copying all 
+   * attributes through buffers of a given total size. The buffers of an 
+   * attribute are enlarged when they cannot hold even a single cell.
    *
    * @param new_fragment The new consolidated fragment object.
-   * @param attribute_i The id of the target attribute.
+   * @param buffer_size The total size of the buffers.
+   * @return TILEDB_AR_OK for success and TILEDB_AR_ERR for error.
    */
   int consolidate(
       Fragment* new_fragment,
-      int attribute_id);
+      size_t buffer_size);
 
   /**
    * Finalizes the array, properly freeing up memory space.
@@ -180,6 +247,8 @@ class Array {
    *     the coordinates in the case of sparse arrays).
    * @param attribute_num The number of the input attributes. If *attributes* is
    *     NULL, then this should be set to 0.
+   * @param config The configuration parameters of the array. If it is NULL,
+   *     the current parameters are kept (initially the default ones).
    * @return TILEDB_AR_OK on success, and TILEDB_AR_ERR on error.
    */
   int init(
@@ -187,7 +256,16 @@ class Array {
       int mode,
       const char** attributes,
       int attribute_num,
-      const void* range);
+      const void* range,
+      const Config* config);
+
+  /**
+   * Releases the views returned by the last invocation of read_views(), 
+   * which become invalid.
+   *
+   * @return TILEDB_AR_OK on success, and TILEDB_AR_ERR on error.
+   */
+  int release_views();
 
   /**
    * Resets the attributes used upon initialization of the array. 
@@ -239,7 +317,13 @@ class Array {
    *      function internally sorts the cells and writes them to the disk on the
    *      proper order. In addition, each invocation creates a **new** fragment.
    *      Finally, the buffers in each invocation must be synced, i.e., they
-   *      must have the same number of cell values across all attributes.
+   *      must have the same number of cell values across all attributes. \n
+   *      If a merge buffer size is set for a sparse array (see
+   *      Config::unsorted_merge_buffer_size()), each invocation instead writes
+   *      a sorted run inside the directory of a single new fragment, and
+   *      finalize() merges the runs into that fragment, using buffers of the
+   *      given total size. Hence, the cells of all the invocations are 
+   *      ordered globally without ever being held in memory together.
    * 
    * @param buffers An array of buffers, one for each attribute. These must be
    *     provided in the same order as the attributes specified in
@@ -259,6 +343,15 @@ class Array {
   /*         PRIVATE ATTRIBUTES        */
   /* ********************************* */
 
+  /** Signals that all asynchronous read requests have been served. */
+  std::condition_variable aio_cv_;
+  /** Protects the asynchronous read request queue. */
+  std::mutex aio_mtx_;
+  /**
+   * The pending asynchronous read requests. The front one is being served
+   * whenever the queue is not empty.
+   */
+  std::deque<AIO_Request*> aio_queue_;
   /** The array schema. */
   const ArraySchema* array_schema_;
   /** The read state of the array. */
@@ -269,6 +362,8 @@ class Array {
    * reading.
    */
   std::vector<int> attribute_ids_;
+  /** The configuration parameters of the array. */
+  Config config_;
   /** The array fragments. */
   std::vector<Fragment*> fragments_;
   /** 
@@ -283,6 +378,13 @@ class Array {
    * range must be the same as the type of the array coordinates.
    */
   void* subarray_;
+  /** 
+   * The name of the fragment into which the sorted runs of the unsorted
+   * writes are merged.
+   */
+  std::string unsorted_fragment_name_;
+  /** The names of the sorted runs written by the unsorted writes. */
+  std::vector<std::string> unsorted_run_names_;
 
 
 
@@ -291,6 +393,91 @@ class Array {
   /*           PRIVATE METHODS         */
   /* ********************************* */
   
+  /**
+   * Serves the queued asynchronous read requests in order, until the queue
+   * becomes empty. It runs in a thread of the pool passed to aio_read().
+   *
+   * @return void
+   */
+  void aio_handle_requests();
+
+  /** 
+   * Blocks until all the queued asynchronous read requests are served.
+   *
+   * @return void
+   */
+  void aio_wait();
+
+  /**
+   * Extends a selection of fragments to be merged by a consolidation with the
+   * fragments that conflict with it (see consolidation_fragments()), until
+   * there are none.
+   *
+   * @template T The coordinates type.
+   * @param bounds The bounds of the fragments (see fragment_bounds()).
+   * @param timestamps The timestamps of the fragments.
+   * @param merged One flag per fragment, which is *true* if the fragment is
+   *     selected.
+   * @param subarray It will hold the bounding subarray of the selected 
+   *     fragments.
+   * @return *false* if the selected fragments cannot be merged, because they
+   *     do not cover the bounding subarray of a dense array, and *true* 
+   *     otherwise.
+   */
+  template<class T>
+  bool consolidation_closure(
+      const std::vector<std::vector<T> >& bounds,
+      const std::vector<int64_t>& timestamps,
+      std::vector<bool>& merged,
+      T* subarray) const;
+
+  /**
+   * Selects the fragments to be merged by a consolidation. Besides the
+   * fragments chosen by the policy, it selects every fragment whose cells 
+   * would otherwise be overwritten wrongly by (or take precedence wrongly 
+   * over) the cells of the new fragment, since the latter takes the place of
+   * the newest selected fragment in the fragment order.
+   *
+   * @param policy The consolidation policy.
+   * @param merged It will hold one flag per fragment, which is *true* if the
+   *     fragment is selected.
+   * @param subarray It will hold the bounding subarray of the selected 
+   *     fragments, which is the domain of the new fragment.
+   * @return TILEDB_AR_OK for success and TILEDB_AR_ERR for error.
+   */
+  int consolidation_fragments(
+      const ConsolidationPolicy* policy,
+      std::vector<bool>& merged,
+      void* subarray) const;
+
+  /**
+   * Selects the fragments to be merged by a consolidation (see
+   * consolidation_fragments()).
+   *
+   * @template T The coordinates type.
+   */
+  template<class T>
+  void consolidation_fragments(
+      const ConsolidationPolicy* policy,
+      std::vector<bool>& merged,
+      T* subarray) const;
+
+  /**
+   * Computes the subarray bounding the cells of a fragment, i.e., the 
+   * non-empty domain of a dense fragment, or the bounding box of the MBRs
+   * of a sparse fragment.
+   *
+   * @template T The coordinates type.
+   * @param fragment The fragment.
+   * @param bounds The subarray where the result is stored.
+   * @return void
+   */
+  template<class T>
+  void fragment_bounds(const Fragment* fragment, T* bounds) const;
+
+  /** Returns the timestamp that orders a fragment, parsed from its name. */
+  int64_t fragment_timestamp(const std::string& fragment_name) const;
+
   /** 
    * Returns a new fragment name, which is in the form: <br>
    * .__<process_id>_<timestamp>
@@ -303,8 +490,31 @@ class Array {
    */
   std::string new_fragment_name() const;
 
+  /** 
+   * Returns a new fragment name that is ordered by a given timestamp, in the
+   * form: <br>
+   * .__<process_id>_<timestamp>_<current_timestamp>
+   *
+   * The current timestamp keeps the name unique, in case the process has
+   * also created the fragment with the given timestamp.
+   *
+   * @param timestamp The timestamp that orders the new fragment.
+   * @return A new special fragment name.
+   */
+  std::string new_fragment_name(int64_t timestamp) const;
+
   /**
-   * Opens the existing fragments in TILEDB_ARRAY_READ_MODE.
+   * Merges the sorted runs written by the unsorted writes into a single
+   * fragment, reading them through buffers whose total size is set by 
+   * Config::unsorted_merge_buffer_size(). The runs are deleted afterwards.
+   *
+   * @return TILEDB_AR_OK for success and TILEDB_AR_ERR for error.
+   */
+  int merge_runs();
+
+  /**
+   * Opens the existing fragments in TILEDB_ARRAY_READ_MODE. The fragments are
+   * loaded in parallel, but kept sorted on their timestamps.
    *
    * @return TILEDB_AR_OK for success and TILEDB_AR_ERR for error.
    */
@@ -314,6 +524,17 @@ class Array {
    * Appropriately sorts the fragment names based on their name timestamps.
    */
   void sort_fragment_names(std::vector<std::string>& fragment_names) const;
+
+  /**
+   * Sorts the cells of an unsorted write and writes them as a new sorted run,
+   * in the runs directory of the fragment returned by the merge upon 
+   * finalization.
+   *
+   * @param buffers The cell buffers (see write()).
+   * @param buffer_sizes The sizes (in bytes) of the cell buffers.
+   * @return TILEDB_AR_OK for success and TILEDB_AR_ERR for error.
+   */
+  int write_run(const void** buffers, const size_t* buffer_sizes);
 };
 
 #endif
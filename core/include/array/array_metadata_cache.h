@@ -0,0 +1,377 @@
+/**
+ * @file   array_metadata_cache.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2016 MIT and Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file defines class ArrayMetadataCache.
+ */
+
+#ifndef __ARRAY_METADATA_CACHE_H__
+#define __ARRAY_METADATA_CACHE_H__
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+
+
+
+
+class ArraySchema;
+class BookKeeping;
+
+/**
+ * A process-wide cache of the parsed array schemas and the loaded fragment
+ * book-keeping structures, shared by all the arrays opened in the process.
+ * Schemas are identified by their array (or metadata) directory, and they
+ * are validated against the status of their schema file, so that an array
+ * recreated under the same name is detected. Book-keeping structures are
+ * identified by their (uniquely named) fragment directory. Both are immutable
+ * once loaded, and reference-counted: they are kept while some array uses
+ * them, plus a bounded number of unused ones in LRU order, so that an array
+ * that is reopened shortly after it was closed does not reload its metadata
+ * from the disk. Cached book-keeping structures hold a reference on the
+ * schema they were loaded with. The entries of deleted, moved or consolidated
+ * fragments and arrays must be dropped with invalidate().
+ */
+class ArrayMetadataCache {
+ public:
+  /* ********************************* */
+  /*    CONSTRUCTORS & DESTRUCTORS     */
+  /* ********************************* */
+
+  /** Constructor. */
+  ArrayMetadataCache();
+
+  /** Destructor. */
+  ~ArrayMetadataCache();
+
+
+
+
+  /* ********************************* */
+  /*             ACCESSORS             */
+  /* ********************************* */
+
+  /** Returns the array metadata cache shared by the entire process. */
+  static ArrayMetadataCache* instance();
+
+  /**
+   * Returns the maximum number of array schemas, as well as of book-keeping
+   * structures, kept cached while no array uses them.
+   */
+  size_t capacity() const;
+
+
+
+
+  /* ********************************* */
+  /*             MUTATORS              */
+  /* ********************************* */
+
+  /**
+   * Looks up the schema of an array and, if it is cached, acquires a
+   * reference on it. The schema must be returned with release_array_schema().
+   *
+   * @param dir The real array (or metadata) directory.
+   * @param file_stat The current status of the array schema file.
+   * @return The cached schema, or NULL if it is not cached or it was loaded
+   *     from a different version of the array schema file.
+   */
+  const ArraySchema* acquire_array_schema(
+      const std::string& dir,
+      const struct stat& file_stat);
+
+  /**
+   * Looks up the book-keeping of a fragment and, if it is cached, acquires a
+   * reference on it. The book-keeping must be returned with
+   * release_book_keeping().
+   *
+   * @param fragment_name The fragment directory.
+   * @return The cached book-keeping, or NULL if it is not cached.
+   */
+  BookKeeping* acquire_book_keeping(const std::string& fragment_name);
+
+  /**
+   * Removes all the cached entries that are not used by any array.
+   *
+   * @return void
+   */
+  void clear();
+
+  /**
+   * Hands a newly loaded array schema over to the cache, and acquires a
+   * reference on it. If another schema got cached for the same array in the
+   * meantime, the input schema is deleted and the cached one is acquired
+   * instead. The returned schema must be released with release_array_schema().
+   *
+   * @param dir The real array (or metadata) directory.
+   * @param file_stat The status of the array schema file the schema was
+   *     loaded from.
+   * @param array_schema The loaded schema, which is owned by the cache from
+   *     now on.
+   * @return The acquired schema.
+   */
+  const ArraySchema* insert_array_schema(
+      const std::string& dir,
+      const struct stat& file_stat,
+      ArraySchema* array_schema);
+
+  /**
+   * Hands a newly loaded book-keeping structure over to the cache, and
+   * acquires a reference on it. If another book-keeping got cached for the
+   * same fragment in the meantime, the input one is deleted and the cached one
+   * is acquired instead. The book-keeping is cached only if the array schema
+   * it was loaded with is cached as well. The returned book-keeping must be
+   * released with release_book_keeping().
+   *
+   * @param fragment_name The fragment directory.
+   * @param book_keeping The loaded book-keeping, which is owned by the cache
+   *     from now on.
+   * @return The acquired book-keeping.
+   */
+  BookKeeping* insert_book_keeping(
+      const std::string& fragment_name,
+      BookKeeping* book_keeping);
+
+  /**
+   * Drops the cached schemas and book-keeping structures of the arrays and
+   * fragments contained in the input directory (or of the array or fragment
+   * with the input name). The entries still in use are deleted when they are
+   * released. This must be invoked whenever arrays or fragments get deleted,
+   * moved or consolidated.
+   *
+   * @param dir A workspace, group, array, metadata or fragment directory.
+   * @return void
+   */
+  void invalidate(const std::string& dir);
+
+  /**
+   * Releases a reference on an array schema. Schemas that are not known to
+   * the cache are simply deleted.
+   *
+   * @param array_schema The schema to be released.
+   * @return void
+   */
+  void release_array_schema(const ArraySchema* array_schema);
+
+  /**
+   * Releases a reference on a book-keeping structure. Book-keeping structures
+   * that are not known to the cache are simply deleted.
+   *
+   * @param book_keeping The book-keeping to be released.
+   * @return void
+   */
+  void release_book_keeping(const BookKeeping* book_keeping);
+
+  /**
+   * Sets the maximum number of array schemas, as well as of book-keeping
+   * structures, kept cached while no array uses them, evicting entries if
+   * necessary. A zero capacity disables caching.
+   *
+   * @param capacity The new capacity.
+   * @return void
+   */
+  void set_capacity(size_t capacity);
+
+
+
+
+ private:
+  /* ********************************* */
+  /*          TYPE DEFINITIONS         */
+  /* ********************************* */
+
+  /** A cached array schema or book-keeping structure. */
+  template<class T>
+  struct Entry {
+    /** *true* if the entry can be looked up by its name. */
+    bool cached_;
+    /** The status of the file the object was loaded from (if applicable). */
+    struct stat file_stat_;
+    /** The position of the entry in the unused list (if unused and cached). */
+    typename std::list<const T*>::iterator lru_it_;
+    /** The array or fragment directory. */
+    std::string name_;
+    /** The number of references held on the entry. */
+    int ref_num_;
+  };
+
+  /** The entries of a type, indexed on their objects. */
+  template<class T>
+  struct EntrySet {
+    /** The entries. */
+    std::map<const T*, Entry<T> > entries_;
+    /** Maps the names of the cached entries to their objects. */
+    std::map<std::string, T*> names_;
+    /** The unused cached entries, with the most recently used in the front. */
+    std::list<const T*> lru_;
+  };
+
+
+
+
+  /* ********************************* */
+  /*        PRIVATE ATTRIBUTES         */
+  /* ********************************* */
+
+  /** The array schemas. */
+  EntrySet<ArraySchema> array_schemas_;
+  /** The book-keeping structures. */
+  EntrySet<BookKeeping> book_keepings_;
+  /** The maximum number of unused cached entries of each type. */
+  size_t capacity_;
+  /** Protects the cache from concurrent accesses. */
+  mutable std::mutex mtx_;
+
+
+
+
+  /* ********************************* */
+  /*          PRIVATE METHODS          */
+  /* ********************************* */
+
+  /**
+   * Acquires a reference on the entry with the input name. The caller must
+   * hold the cache mutex.
+   *
+   * @template T The entry object type.
+   * @param entry_set The entries of the object type.
+   * @param name The entry name.
+   * @param file_stat The current status of the file the object is loaded
+   *     from, or NULL if the entry need not be validated.
+   * @return The entry object, or NULL if no valid entry has the input name.
+   */
+  template<class T>
+  T* acquire(
+      EntrySet<T>& entry_set,
+      const std::string& name,
+      const struct stat* file_stat);
+
+  /**
+   * Deletes an unused entry, releasing the references it holds. The caller
+   * must hold the cache mutex.
+   *
+   * @param object The entry object.
+   * @return void
+   */
+  void destroy(const ArraySchema* object);
+
+  /**
+   * Deletes an unused entry, releasing the references it holds. The caller
+   * must hold the cache mutex.
+   *
+   * @param object The entry object.
+   * @return void
+   */
+  void destroy(const BookKeeping* object);
+
+  /**
+   * Removes an entry from the entries of its type, without deleting its
+   * object. The caller must hold the cache mutex.
+   *
+   * @template T The entry object type.
+   * @param entry_set The entries of the object type.
+   * @param object The entry object.
+   * @return void
+   */
+  template<class T>
+  void erase(EntrySet<T>& entry_set, const T* object);
+
+  /**
+   * Deletes the least recently used unused entries until at most the input
+   * number of them remains. The caller must hold the cache mutex.
+   *
+   * @template T The entry object type.
+   * @param entry_set The entries of the object type.
+   * @param num The maximum number of unused entries to be kept.
+   * @return void
+   */
+  template<class T>
+  void evict(EntrySet<T>& entry_set, size_t num);
+
+  /**
+   * Inserts a new entry and acquires a reference on it. The caller must hold
+   * the cache mutex.
+   *
+   * @template T The entry object type.
+   * @param entry_set The entries of the object type.
+   * @param name The entry name.
+   * @param file_stat The status of the file the object was loaded from, or
+   *     NULL if not applicable.
+   * @param object The entry object.
+   * @param cached *true* if the entry can be looked up by its name.
+   * @return void
+   */
+  template<class T>
+  void insert(
+      EntrySet<T>& entry_set,
+      const std::string& name,
+      const struct stat* file_stat,
+      T* object,
+      bool cached);
+
+  /**
+   * Drops the cached entries contained in the input directory. The caller
+   * must hold the cache mutex.
+   *
+   * @template T The entry object type.
+   * @param entry_set The entries of the object type.
+   * @param dir The directory.
+   * @return void
+   */
+  template<class T>
+  void invalidate(EntrySet<T>& entry_set, const std::string& dir);
+
+  /**
+   * Releases a reference on an entry, deleting it if it is not used anymore
+   * and not cached. The caller must hold the cache mutex.
+   *
+   * @template T The entry object type.
+   * @param entry_set The entries of the object type.
+   * @param object The entry object.
+   * @return *false* if the object is not known to the cache, and *true*
+   *     otherwise.
+   */
+  template<class T>
+  bool release(EntrySet<T>& entry_set, const T* object);
+
+  /**
+   * Makes an entry impossible to look up, deleting it if it is not used. The
+   * caller must hold the cache mutex.
+   *
+   * @template T The entry object type.
+   * @param entry_set The entries of the object type.
+   * @param object The entry object.
+   * @return void
+   */
+  template<class T>
+  void uncache(EntrySet<T>& entry_set, const T* object);
+};
+
+#endif
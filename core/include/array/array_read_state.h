@@ -33,6 +33,7 @@
 #ifndef __ARRAY_READ_STATE_H__
 #define __ARRAY_READ_STATE_H__
 
+#include "arena.h"
 #include "array.h"
 #include "array_schema.h"
 #include <cstring>
@@ -124,6 +125,19 @@ class ArrayReadState {
   /*             ACCESSORS             */
   /* ********************************* */
 
+  /**
+   * Estimates the sizes of the buffers that would hold the entire result of
+   * read(), using only the book-keeping of the fragments (see 
+   * ReadState::estimate_result_size()). The estimates are upper bounds. For
+   * dense arrays, they account for every cell of the subarray, including the
+   * empty cells that no fragment covers.
+   *
+   * @param buffer_sizes The estimated sizes (in bytes), one per buffer of 
+   *     read(), i.e., two for each variable-sized attribute.
+   * @return TILEDB_ARS_OK for success and TILEDB_ARS_ERR for error.
+   */
+  int estimate_result_size(size_t* buffer_sizes) const;
+
   /** Indicates whether the read on a particular attribute overflowed. */
   bool overflow(int attribute_id) const;
 
@@ -151,10 +165,47 @@ class ArrayReadState {
    *     on an overflow flag which can be checked with function overflow(). The
    *     next invocation will resume for the point the previous one stopped,
    *     without inflicting a considerable performance penalty due to overflow.
-   * @return TILEDB_ARS_OK for success and TILEDB_ARS_ERR for error.
+   * @return TILEDB_ARS_OK for success and TILEDB_ARS_ERR for error (including
+   *     the case where read_views() has been used in this read state).
    */
   int read(void** buffers, size_t* buffer_sizes); 
 
+  /**
+   * Performs a zero-copy read operation in an array, which must be initialized
+   * with mode TILEDB_ARRAY_READ. Instead of copying the result cells into user
+   * buffers, the function returns a view for each attribute, i.e., a pointer
+   * to the next run of result cells in a decompressed (or memory-mapped) tile
+   * and the size of the run. Successive invocations return the result cells 
+   * in the same order as read(). The views are leased to the caller until
+   * release_views() is invoked, which must happen before the next invocation.
+   * It cannot be mixed with read() and supports only **fixed-sized** 
+   * attributes.
+   *
+   * @param views An array of views, one for each attribute, in the same order
+   *     as the attributes specified in Array::init() or 
+   *     Array::reset_attributes().
+   * @param view_sizes The sizes (in bytes) of the views (there is a one-to-one
+   *     correspondence). A zero size indicates that there are no more results
+   *     for the attribute.
+   * @return TILEDB_ARS_OK for success and TILEDB_ARS_ERR for error (including
+   *     the cases where the previous views are not released, or read() has
+   *     been used in this read state).
+   */
+  int read_views(const void** views, size_t* view_sizes);
+
+
+
+
+  /* ********************************* */
+  /*             MUTATORS              */
+  /* ********************************* */
+
+  /** 
+   * Releases the views returned by the last invocation of read_views(), 
+   * which become invalid.
+   */
+  void release_views();
+
 
 
 
@@ -165,8 +216,26 @@ class ArrayReadState {
   
   /** The array this array read state belongs to. */
   const Array* array_;
+  /** 
+   * The arenas the cell ranges of the read rounds are allocated from, one
+   * per read round computed ahead (so that the rounds can be merged in 
+   * parallel). They are recycled whenever new read rounds are computed,
+   * since the cell ranges do not outlive the computation of the cell 
+   * position ranges.
+   */
+  std::vector<Arena> cell_range_arenas_;
+  /**
+   * Records, for each attribute, the position of the first cell position range
+   * of the current read round that is not entirely copied to the buffers.
+   */
+  std::vector<int64_t> copy_range_pos_;
   /** Indicates whether the read operation for this query is done. */
   bool done_;
+  /** 
+   * Indicates whether read() has been used, which rules out read_views()
+   * (and vice versa, see views_used_).
+   */
+  bool read_used_;
   /** State per attribute indicating the number of empty cells written. */
   std::vector<int64_t> empty_cells_written_;
   /** 
@@ -182,6 +251,11 @@ class ArrayReadState {
   int fragment_num_;
   /** Stores the read state of each fragment. */
   std::vector<ReadState*> fragment_read_states_;
+  /** 
+   * Private fragment read states (created on demand) for each read round
+   * that is merged in parallel. Applicable only to the **sparse** array case.
+   */
+  std::vector<std::vector<ReadState*> > merge_read_states_;
   /**
    * The minimum bounding coordinates end point. Applicable only to the 
    * **sparse** array case.
@@ -195,6 +269,20 @@ class ArrayReadState {
   void* subarray_tile_coords_;
   /** The tile domain of the query subarray. */
   void* subarray_tile_domain_;
+  /** 
+   * The arena holding the empty cells exposed by read_views(), which lasts
+   * until the views are released.
+   */
+  Arena view_arena_;
+  /**
+   * Records, for each attribute, the position of the next cell position range
+   * to be exposed by read_views() in the current read round.
+   */
+  std::vector<int64_t> view_range_pos_;
+  /** Indicates whether the views of read_views() are leased to the caller. */
+  bool views_leased_;
+  /** Indicates whether read_views() has been used, which rules out read(). */
+  bool views_used_;
 
 
 
@@ -206,21 +294,47 @@ class ArrayReadState {
   /** Cleans fragment cell positions that are processed by all attributes. */
   void clean_up_processed_fragment_cell_pos_ranges();
 
+  /**
+   * Computes the cell ranges of the empty fragment (with id -1) for the
+   * current read run of a **dense** array, which cover the overlap of the
+   * subarray with the current tile. The ranges of the actual fragments trim
+   * them when they are sorted, so that only the cells no fragment holds are
+   * read as empty.
+   *
+   * @template T The coordinates type.
+   * @param overlap_subarray The overlap of the subarray with the current tile.
+   * @param overlap The type of the overlap with the current tile (see
+   *     ArraySchema::subarray_overlap()).
+   * @param unsorted_fragment_cell_ranges The ranges are appended to it.
+   * @param arena The arena the cell ranges are allocated from.
+   * @return void
+   */
+  template<class T>
+  void compute_empty_fragment_cell_ranges_dense(
+      const T* overlap_subarray,
+      int overlap,
+      FragmentCellRanges& unsorted_fragment_cell_ranges,
+      Arena& arena) const;
+
   /**
    * Computes the cell position ranges that must be copied from each fragment to
    * the user buffers for the current read round. The cell positions are 
    * practically the relative positions of the cells in their tile on the
-   * disk. The function properly cleans up the input fragment cell ranges. 
+   * disk. The function clears the input fragment cell ranges, whose space
+   * is recycled along with their arena.
    *
    * @template T The coordinates type.
    * @param fragment_cell_ranges The input fragment cell ranges.
    * @param fragment_cell_pos_ranges The output fragment cell position ranges. 
+   * @param read_states The fragment read states used to search the
+   *     coordinate tiles.
    * @return TILEDB_ARS_OK on success and TILEDB_ARS_ERR on error.
    */
   template<class T>
   int compute_fragment_cell_pos_ranges(
       FragmentCellRanges& fragment_cell_ranges,
-      FragmentCellPosRanges& fragment_cell_pos_ranges) const;
+      FragmentCellPosRanges& fragment_cell_pos_ranges,
+      const std::vector<ReadState*>& read_states) const;
 
   /**
    * Computes the smallest end bounding coordinates for the current read round.
@@ -241,11 +355,13 @@ class ArrayReadState {
    * @template T The coordinates type.
    * @param unsorted_fragment_cell_ranges It will hold the result of this
    *     function.
+   * @param arena The arena the cell ranges are allocated from.
    * @return TILEDB_ARS_OK on success and TILEDB_ARS_ERR on error.
    */
   template<class T>
   int compute_unsorted_fragment_cell_ranges_sparse(
-      FragmentCellRanges& unsorted_fragment_cell_ranges);
+      FragmentCellRanges& unsorted_fragment_cell_ranges,
+      Arena& arena);
 
   /**
    * Computes the relevant fragment cell ranges for the current read run, 
@@ -255,11 +371,13 @@ class ArrayReadState {
    * @template T The coordinates type.
    * @param unsorted_fragment_cell_ranges It will hold the result of this
    *     function.
+   * @param arena The arena the cell ranges are allocated from.
    * @return TILEDB_ARS_OK on success and TILEDB_ARS_ERR on error.
    */
   template<class T>
   int compute_unsorted_fragment_cell_ranges_dense(
-      FragmentCellRanges& unsorted_fragment_cell_ranges);
+      FragmentCellRanges& unsorted_fragment_cell_ranges,
+      Arena& arena);
 
   /**
    * Copies the cell ranges calculated in the current read round into the
@@ -356,13 +474,51 @@ class ArrayReadState {
       size_t& buffer_var_offset,
       const CellPosRange& cell_pos_range);
 
+  /**
+   * Estimates the sizes of the buffers that would hold the entire result of
+   * read() (see estimate_result_size()).
+   *
+   * @template T The coordinates type.
+   * @param buffer_sizes The estimated sizes (in bytes).
+   * @return TILEDB_ARS_OK for success and TILEDB_ARS_ERR for error.
+   */
+  template<class T>
+  int estimate_result_size(size_t* buffer_sizes) const;
+
+  /**
+   * Writes the empty value of the input attribute to all the values of the
+   * input number of cells.
+   *
+   * @param attribute_id The id of the targeted attribute.
+   * @param buffer The buffer to be filled, which must hold *cell_num* cells.
+   * @param cell_num The number of empty cells to be written.
+   * @return void
+   */
+  void fill_empty_cells(
+      int attribute_id, 
+      void* buffer, 
+      int64_t cell_num) const;
+
   // TODO
   template<class T>
   int get_next_fragment_cell_ranges_dense();
 
+  /**
+   * Computes the fragment cell position ranges of a single read round, for
+   * the case of **dense** arrays. 
+   *
+   * @template T The coordinates type.
+   * @return TILEDB_ARS_OK on success and TILEDB_ARS_ERR on error.
+   */
+  template<class T>
+  int get_next_fragment_cell_ranges_dense_round();
+
   /**
    * Gets the next fragment cell ranges that are relevant in the current read
-   * round.
+   * round. The ranges of up to TILEDB_PREFETCH_ROUND_NUM read rounds are
+   * computed at once, they are merged in parallel (see 
+   * merge_fragment_cell_ranges_sparse()) and their tiles are prefetched (see
+   * prefetch_tiles()).
    *
    * @template T The coordinates type.
    * @return TILEDB_ARS_OK on success and TILEDB_ARS_ERR on error.
@@ -370,6 +526,23 @@ class ArrayReadState {
   template<class T>
   int get_next_fragment_cell_ranges_sparse();
 
+  /**
+   * Computes the unsorted fragment cell ranges of a single read round, for
+   * the case of **sparse** arrays. The ranges of a round fall before the
+   * smallest end bounding coordinates of the current fragment tiles, and
+   * after those of the previous round.
+   *
+   * @template T The coordinates type.
+   * @param unsorted_fragment_cell_ranges The unsorted fragment cell ranges
+   *     output by the function.
+   * @param arena The arena the cell ranges are allocated from.
+   * @return TILEDB_ARS_OK on success and TILEDB_ARS_ERR on error.
+   */
+  template<class T>
+  int get_next_fragment_cell_ranges_sparse_round(
+      FragmentCellRanges& unsorted_fragment_cell_ranges,
+      Arena& arena);
+
   /**
    * Gets the next overlapping tiles in the fragment read states, for the case
    * of **dense** arrays. 
@@ -409,6 +582,39 @@ class ArrayReadState {
   template<class T>
   void init_subarray_tile_coords();
 
+  /**
+   * Cuts and sorts the unsorted fragment cell ranges of a set of consecutive
+   * read rounds of a **sparse** array, and appends the resulting fragment
+   * cell position ranges to the state. Since the read rounds cover disjoint
+   * and ordered parts of the coordinate space, they are merged independently
+   * in parallel, each with its own fragment read states (see 
+   * merge_read_states_), and their results are concatenated in order. The
+   * cell ranges of each round must be allocated from the arena of the round
+   * (see cell_range_arenas_), which is used for the cut ranges as well.
+   *
+   * @template T The coordinates type.
+   * @param unsorted_fragment_cell_ranges_vec The unsorted fragment cell ranges
+   *     of each read round.
+   * @return TILEDB_ARS_OK on success and TILEDB_ARS_ERR on error.
+   */
+  template<class T>
+  int merge_fragment_cell_ranges_sparse(
+      std::vector<FragmentCellRanges>& unsorted_fragment_cell_ranges_vec);
+
+  /**
+   * Reads and decompresses in parallel into the tile cache the tiles of all
+   * the attributes the array focuses on, which are needed by the read rounds
+   * starting from the input one. The cells are still copied into the user
+   * buffers in order afterwards, but they will then be found in the tile
+   * cache. The prefetched tiles are limited to half the tile cache capacity,
+   * so that they are not evicted before they are copied.
+   *
+   * @param first_round The position of the first read round in
+   *     fragment_cell_pos_ranges_vec_, whose tiles will be prefetched.
+   * @return void
+   */
+  void prefetch_tiles(int64_t first_round) const;
+
   /**
    * Performs a read operation in a **dense** array.
    * 
@@ -486,6 +692,40 @@ class ArrayReadState {
       void* buffer_var, 
       size_t& buffer_var_size);
 
+  /**
+   * Returns a view of the next run of result cells for a particular
+   * **fixed-sized** attribute, focusing on the **dense** array case (see
+   * read_views()). 
+   *
+   * @param attribute_id The id of the attribute.
+   * @param view The view to be returned.
+   * @param view_size The size (in bytes) of the view, which is 0 if there are
+   *     no more results for the attribute.
+   * @return TILEDB_ARS_OK for success and TILEDB_ARS_ERR for error.
+   */
+  int read_dense_attr_view(
+      int attribute_id,
+      const void*& view,
+      size_t& view_size);
+
+  /**
+   * Returns a view of the next run of result cells for a particular
+   * **fixed-sized** attribute, focusing on the **dense** array case (see
+   * read_views()). 
+   *
+   * @template T The coordinates type.
+   * @param attribute_id The id of the attribute.
+   * @param view The view to be returned.
+   * @param view_size The size (in bytes) of the view, which is 0 if there are
+   *     no more results for the attribute.
+   * @return TILEDB_ARS_OK for success and TILEDB_ARS_ERR for error.
+   */
+  template<class T>
+  int read_dense_attr_view(
+      int attribute_id,
+      const void*& view,
+      size_t& view_size);
+
   /**
    * Performs a read operation in a **sparse** array.
    * 
@@ -563,21 +803,76 @@ class ArrayReadState {
       void* buffer_var, 
       size_t& buffer_var_size);
 
+  /**
+   * Returns a view of the next run of result cells for a particular
+   * **fixed-sized** attribute, focusing on the **sparse** array case (see
+   * read_views()). 
+   *
+   * @param attribute_id The id of the attribute.
+   * @param view The view to be returned.
+   * @param view_size The size (in bytes) of the view, which is 0 if there are
+   *     no more results for the attribute.
+   * @return TILEDB_ARS_OK for success and TILEDB_ARS_ERR for error.
+   */
+  int read_sparse_attr_view(
+      int attribute_id,
+      const void*& view,
+      size_t& view_size);
+
+  /**
+   * Returns a view of the next run of result cells for a particular
+   * **fixed-sized** attribute, focusing on the **sparse** array case (see
+   * read_views()). 
+   *
+   * @template T The coordinates type.
+   * @param attribute_id The id of the attribute.
+   * @param view The view to be returned.
+   * @param view_size The size (in bytes) of the view, which is 0 if there are
+   *     no more results for the attribute.
+   * @return TILEDB_ARS_OK for success and TILEDB_ARS_ERR for error.
+   */
+  template<class T>
+  int read_sparse_attr_view(
+      int attribute_id,
+      const void*& view,
+      size_t& view_size);
+
   /**
    * Uses the heap algorithm to cut and sort the relevant cell ranges for
-   * the current read run. The function properly cleans up the input
-   * unsorted fragment cell ranges.
+   * the current read run. The function clears the input unsorted fragment
+   * cell ranges.
    *
    * @template T The coordinates type.
    * @param unsorted_fragment_cell_ranges The unsorted fragment cell ranges.
    * @param fragment_cell_ranges The sorted fragment cell ranges output by
    *     the function as a result.
+   * @param read_states The fragment read states used to search the
+   *     coordinate tiles.
+   * @param arena The arena the cut cell ranges are allocated from.
    * @return TILEDB_ARS_OK on success and TILEDB_ARS_ERR on error.
    */
   template<class T>
   int sort_fragment_cell_ranges(
       FragmentCellRanges& unsorted_fragment_cell_ranges,
-      FragmentCellRanges& fragment_cell_ranges) const;
+      FragmentCellRanges& fragment_cell_ranges,
+      const std::vector<ReadState*>& read_states,
+      Arena& arena) const;
+
+  /**
+   * Exposes the next run of result cells of the current read round for a
+   * particular **fixed-sized** attribute, without copying them. Empty cells
+   * are materialized in view_arena_.
+   *
+   * @param attribute_id The id of the attribute.
+   * @param view The view to be returned.
+   * @param view_size The size (in bytes) of the view, which is 0 if the read
+   *     round has no more results for the attribute.
+   * @return TILEDB_ARS_OK for success and TILEDB_ARS_ERR for error.
+   */
+  int view_cells(
+      int attribute_id,
+      const void*& view,
+      size_t& view_size);
 };
 
 
@@ -132,6 +132,12 @@ class ArraySchema {
   /** Returns the compression type of the attribute with the input id. */
   int compression(int attribute_id) const;
 
+  /** 
+   * Returns the compression level of the attribute with the input id (0 for
+   * the default level of its codec).
+   */
+  int compression_level(int attribute_id) const;
+
   /** Returns the coordinates size. */
   size_t coords_size() const;
 
@@ -147,6 +153,13 @@ class ArraySchema {
   /** Returns the domain. */
   const void* domain() const;
 
+  /**
+   * Returns the filter chain applied to the tiles of the attribute with the
+   * input id before compression (0 for no filters). The chain is encoded as
+   * in the bits above TILEDB_FILTER_SHIFT of the attribute compression.
+   */
+  int filters(int attribute_id) const;
+
   /**
    * Gets the ids of the input attributes.
    *
@@ -235,6 +248,9 @@ class ArraySchema {
   /** Returns the type of the i-th attribute, or NULL if 'i' is invalid. */
   int type(int i) const;
 
+  /** Returns the size of the type of the attribute with the input id. */
+  size_t type_size(int attribute_id) const;
+
   /** Returns the number of attributes with variable-sized values. */
   int var_attribute_num() const;
 
@@ -305,7 +321,15 @@ class ArraySchema {
    */
   int set_cell_order(int cell_order);
 
-  /** Sets the compression types. */
+  /** 
+   * Sets the compression types (potentially combined with compression
+   * levels and filter chains). The codecs must be supported by this build,
+   * and filters are allowed only on compressed attributes.
+   *
+   * @param compression The compression for each attribute (plus one extra
+   *     at the end for the coordinates).
+   * @return TILEDB_AS_OK for success, and TILEDB_AS_ERR for error.
+   */
   int set_compression(int* compression);
 
   /** Sets the proper flag to indicate if the array is dense. */
@@ -539,6 +563,24 @@ class ArraySchema {
   template<class T>
   int64_t hilbert_id(const T* coords) const;
 
+  /** 
+   * Computes the Hilbert ids of a batch of cells. It is safe to invoke it 
+   * concurrently.
+   *
+   * @template T The coordinates type.
+   * @param cell_coords The coordinates of the cells, stored contiguously.
+   * @param cell_num The number of cells in *cell_coords*.
+   * @param ids The output Hilbert ids, one per cell.
+   * @param thread_num The maximum number of threads computing the ids.
+   * @return void
+   */
+  template<class T>
+  void hilbert_ids(
+      const T* cell_coords, 
+      int64_t cell_num, 
+      int64_t* ids,
+      int thread_num) const;
+
   /**
    * Checks the order of the input coordinates. First the tile order is checked
    * (which, in case of non-regular tiles, is always the same), breaking the
@@ -565,6 +607,24 @@ class ArraySchema {
   template<class T>
   int64_t tile_id(const T* cell_coords) const;
 
+  /** 
+   * Computes the ids of the tiles a batch of cells fall into, without any 
+   * per-cell allocation. It is safe to invoke it concurrently.
+   * 
+   * @template T The coordinates type.
+   * @param cell_coords The coordinates of the cells, stored contiguously.
+   * @param cell_num The number of cells in *cell_coords*.
+   * @param ids The output tile ids, one per cell.
+   * @param thread_num The maximum number of threads computing the ids.
+   * @return void
+   */
+  template<class T>
+  void tile_ids(
+      const T* cell_coords, 
+      int64_t cell_num, 
+      int64_t* ids,
+      int thread_num) const;
+
 
 
 
@@ -608,11 +668,15 @@ class ArraySchema {
    * The compression type for each attribute (plus one extra at the end for the
    * coordinates. It can be one of the following: 
    *    - TILEDB_NO_COMPRESSION
-   *    - TILEDB_GZIP. 
+   *    - TILEDB_GZIP
+   *    - TILEDB_LZ4
+   *    - TILEDB_ZSTD
+   *    - TILEDB_SHUFFLE_LZ4
+   *
+   * The compression level is stored in the bits above 
+   * TILEDB_COMPRESSION_TYPE_MASK.
    */
   std::vector<int> compression_;
-  /** Auxiliary variable used when calculating Hilbert ids. */
-  int* coords_for_hilbert_;
   /** 
    * Specifies if the array is dense or sparse. If the array is dense, 
    * then the user must specify tile extents (see below).
@@ -648,6 +712,12 @@ class ArraySchema {
    * array has irregular tiles (and, hence, it is sparse).
    */
   void* tile_extents_;
+  /** 
+   * The offset of each tile coordinate in a tile id, i.e., the number of
+   * tiles spanned by a unit step along each dimension in the tile order
+   * (only applicable to regular tiles). 
+   */
+  std::vector<int64_t> tile_offsets_;
   /** 
    * The tile order. It can be one of the following:
    *    - TILEDB_ROW_MAJOR
@@ -732,6 +802,24 @@ class ArraySchema {
   template<class T>
   void compute_tile_domain();
 
+  /**
+   * Computes the tile offsets (see tile_offsets_). Applicable only to arrays
+   * with regular tiles. 
+   *
+   * @return void
+   */
+  void compute_tile_offsets();
+
+  /**
+   * Computes the tile offsets (see tile_offsets_). Applicable only to arrays
+   * with regular tiles. 
+   *
+   * @template T The domain type.
+   * @return void
+   */
+  template<class T>
+  void compute_tile_offsets();
+
   /** Computes and returns the size of a type. */
   size_t compute_type_size(int attribute_id) const;
 
@@ -889,6 +977,9 @@ class ArraySchema {
       const T* domain,
       const T* tile_coords) const;
 
+  /** Returns *true* if some attribute has a filter chain. */
+  bool has_filters() const;
+
   /** Initializes a Hilbert curve. */
   void init_hilbert_curve();
 };
@@ -69,7 +69,13 @@ typedef struct ArraySchemaC {
    * The compression type for each attribute (plus one extra at the end for the
    * coordinates. It can be one of the following: 
    *    - TILEDB_NO_COMPRESSION
-   *    - TILEDB_GZIP. 
+   *    - TILEDB_GZIP
+   *    - TILEDB_LZ4
+   *    - TILEDB_ZSTD
+   *    - TILEDB_SHUFFLE_LZ4
+   *
+   * It may be combined with a compression level (see 
+   * TILEDB_COMPRESSION_LEVEL()) and a filter chain (see TILEDB_FILTER()).
    */
   int* compression_;
   /** 
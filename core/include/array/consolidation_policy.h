@@ -0,0 +1,66 @@
+/**
+ * @file   consolidation_policy.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2016 MIT and Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * @section DESCRIPTION
+ *
+ * A C-style struct that specifies which fragments a consolidation merges.
+ */
+
+#ifndef __CONSOLIDATION_POLICY_H__
+#define __CONSOLIDATION_POLICY_H__
+
+/** 
+ * Specifies which fragments a consolidation merges. It must have the same
+ * layout as TileDB_ConsolidationPolicy in the C API.
+ */
+typedef struct ConsolidationPolicy {
+  /** 
+   * The consolidation mode. It can be one of the following:
+   *    - TILEDB_CONSOLIDATION_ALL: All the fragments are merged.
+   *    - TILEDB_CONSOLIDATION_TIERED: A run of consecutive fragments of
+   *      similar size is merged (see the *tier_* fields).
+   *    - TILEDB_CONSOLIDATION_SUBARRAY: The fragments overlapping
+   *      *subarray_* are merged.
+   */
+  int mode_;
+  /** 
+   * The maximum ratio between the sizes of the largest and the smallest
+   * fragment of a run merged in TILEDB_CONSOLIDATION_TIERED mode.
+   */
+  double tier_size_ratio_;
+  /** The minimum number of fragments of a run merged in tiered mode. */
+  int tier_min_fragment_num_;
+  /** The maximum number of fragments of a run merged in tiered mode. */
+  int tier_max_fragment_num_;
+  /** 
+   * The subarray of TILEDB_CONSOLIDATION_SUBARRAY mode, in the form of
+   * [low, high] pairs, one pair per dimension.
+   */
+  const void* subarray_;
+} ConsolidationPolicy;
+
+#endif
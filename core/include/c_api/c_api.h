@@ -75,6 +75,27 @@ TILEDB_EXPORT int tiledb_ctx_init(
  */
 TILEDB_EXPORT int tiledb_ctx_finalize(TileDB_CTX* tiledb_ctx);
 
+/** 
+ * Sets a configuration parameter of the TileDB context, overriding the value
+ * of the configuration file. This allows tuning different workloads of the
+ * same program without configuration files. The parameters that tune the
+ * arrays (*compression_level*, *io_mode*, *sorted_buffer_size*, *thread_num*
+ * and *unsorted_merge_buffer_size*) take effect on the arrays initialized
+ * afterwards. The cache sizes (*tile_cache_size* and 
+ * *array_metadata_cache_size*) are process-wide, and setting them affects
+ * every context of the process.
+ *
+ * @param tiledb_ctx The TileDB context.
+ * @param parameter The parameter name, as in the configuration file (see 
+ *     StorageManager::config_set()).
+ * @param value The parameter value, as in the configuration file.
+ * @return TILEDB_OK for success and TILEDB_ERR for error.
+ */
+TILEDB_EXPORT int tiledb_ctx_set_config(
+    TileDB_CTX* tiledb_ctx,
+    const char* parameter,
+    const char* value);
+
 
 
 
@@ -159,6 +180,21 @@ typedef struct TileDB_ArraySchema {
    * coordinates). It can be one of the following: 
    *    - TILEDB_NO_COMPRESSION
    *    - TILEDB_GZIP 
+   *    - TILEDB_LZ4 (requires a build with LZ4=1)
+   *    - TILEDB_ZSTD (requires a build with ZSTD=1)
+   *    - TILEDB_SHUFFLE_LZ4 (requires a build with LZ4=1)
+   *
+   * A compression level can be combined with the type using
+   * TILEDB_COMPRESSION_LEVEL(), e.g., 
+   * `TILEDB_ZSTD | TILEDB_COMPRESSION_LEVEL(19)`. A compressed attribute
+   * may also have a chain of filters applied to its tiles before compression
+   * using TILEDB_FILTER(), e.g., 
+   * `TILEDB_GZIP | TILEDB_FILTER(0, TILEDB_FILTER_DELTA)`. The filters are:
+   *    - TILEDB_FILTER_DELTA
+   *    - TILEDB_FILTER_DOUBLE_DELTA
+   *    - TILEDB_FILTER_BYTE_SHUFFLE
+   *    - TILEDB_FILTER_BIT_SHUFFLE
+   *    - TILEDB_FILTER_BIT_PACKING
    *
    * If it is *NULL*, then the default TILEDB_NO_COMPRESSION is used for all
    * attributes.
@@ -263,6 +299,24 @@ TILEDB_EXPORT int tiledb_array_create(
     const TileDB_CTX* tiledb_ctx,
     const TileDB_ArraySchema* tiledb_array_schema);
 
+/**
+ * Overrides a configuration parameter of the TileDB context for a single
+ * array. The override takes effect on the subsequent initializations of the
+ * array (and of its iterators) with this context.
+ *
+ * @param tiledb_ctx The TileDB context.
+ * @param array The directory of the array.
+ * @param parameter The parameter name. It must be one of the parameters that
+ *     tune the arrays (see tiledb_ctx_set_config()).
+ * @param value The parameter value.
+ * @return TILEDB_OK for success and TILEDB_ERR for error.
+ */
+TILEDB_EXPORT int tiledb_array_set_config(
+    TileDB_CTX* tiledb_ctx,
+    const char* array,
+    const char* parameter,
+    const char* value);
+
 /**
  * Initializes a TileDB array.
  *
@@ -387,6 +441,9 @@ TILEDB_EXPORT int tiledb_array_free_schema(
  *      addition, each invocation creates a **new** fragment. Finally, the
  *      buffers in each invocation must be synchronized, i.e., they must have
  *      the same number of cell values across all attributes.
+ *      If the *unsorted_merge_buffer_size* configuration parameter is set, 
+ *      the invocations on a sparse array instead write sorted runs, which
+ *      are merged into a single **new** fragment by tiledb_array_finalize().
  * 
  * @param tiledb_array The TileDB array object (must be already initialized).
  * @param buffers An array of buffers, one for each attribute. These must be
@@ -405,6 +462,27 @@ TILEDB_EXPORT int tiledb_array_write(
     const void** buffers,
     const size_t* buffer_sizes);
 
+/**
+ * Estimates the sizes of the buffers that would hold the entire result of
+ * tiledb_array_read() on the current subarray and attributes of an array,
+ * which must be initialized with mode TILEDB_ARRAY_READ. The estimates are
+ * computed from the book-keeping of the fragments (i.e., the tile cell
+ * numbers, the tile MBRs and the variable tile sizes) without reading any
+ * tiles. They are upper bounds, so that buffers of these sizes receive the
+ * entire result in a single tiledb_array_read(), without overflow. For dense
+ * arrays, the fixed-sized buffers are sized for every cell of the subarray,
+ * since the cells that no fragment covers are returned as empty.
+ *
+ * @param tiledb_array The TileDB array.
+ * @param buffer_sizes The estimated sizes (in bytes), one for each buffer of
+ *     tiledb_array_read(), i.e., two for each variable-sized attribute (the
+ *     offsets and the actual values).
+ * @return TILEDB_OK for success and TILEDB_ERR for error.
+ */
+TILEDB_EXPORT int tiledb_array_estimate_result_size(
+    const TileDB_Array* tiledb_array,
+    size_t* buffer_sizes);
+
 /**
  * Performs a read operation on an array, which must be initialized with mode
  * TILEDB_ARRAY_READ. The function retrieves the result cells that lie inside
@@ -438,6 +516,98 @@ TILEDB_EXPORT int tiledb_array_read(
     void** buffers,
     size_t* buffer_sizes);
 
+/** An asynchronous read request. */
+typedef struct TileDB_AIO_Request {
+  /** The buffers where the results are written (see tiledb_array_read()). */
+  void** buffers_;
+  /** 
+   * The sizes of the buffers, which are updated with the sizes of the useful
+   * data upon completion (see tiledb_array_read()).
+   */
+  size_t* buffer_sizes_;
+  /** 
+   * The function invoked upon the completion of the request, from an internal
+   * TileDB thread. It may be NULL. It must not finalize the array.
+   */
+  void (*completion_handle_)(void*);
+  /** The argument passed to *completion_handle_*. */
+  void* completion_data_;
+  /** 
+   * The status of the request, set by TileDB. It may be polled by the user
+   * to detect completion. It can be one of the following:
+   *    - TILEDB_AIO_INPROGRESS: The request is queued or being served.
+   *    - TILEDB_AIO_COMPLETED: All the results have been retrieved.
+   *    - TILEDB_AIO_OVERFLOW: Some buffer overflowed. The request can be
+   *      resubmitted (after consuming the results) to continue the read.
+   *    - TILEDB_AIO_ERR: The read failed.
+   */
+  volatile int status_;
+  /** 
+   * A new subarray to read from (see tiledb_array_reset_subarray()). If it is
+   * NULL, the read continues from where the previous read on the array
+   * stopped.
+   */
+  const void* subarray_;
+} TileDB_AIO_Request;
+
+/**
+ * Submits an asynchronous read request on an array, which must be initialized
+ * with mode TILEDB_ARRAY_READ, and returns immediately. The request is served
+ * by an internal pool of I/O threads (see the *aio_thread_num* configuration
+ * parameter). The requests on the same array are served one at a time in
+ * submission order, whereas requests on different arrays are served
+ * concurrently. Upon completion, the *status_* of the request is set and its
+ * *completion_handle_* (if any) is invoked. The request (and its buffers) must
+ * remain valid until then. Also, tiledb_array_read() and 
+ * tiledb_array_reset_subarray() must not be invoked on the array while
+ * requests are pending. tiledb_array_finalize() waits for the pending
+ * requests on the array.
+ *
+ * @param tiledb_array The TileDB array.
+ * @param tiledb_aio_request The read request.
+ * @return TILEDB_OK for success and TILEDB_ERR for error.
+ */
+TILEDB_EXPORT int tiledb_array_read_async(
+    const TileDB_Array* tiledb_array,
+    TileDB_AIO_Request* tiledb_aio_request);
+
+/**
+ * Performs a zero-copy read operation in an array, which must be initialized
+ * with mode TILEDB_ARRAY_READ. Instead of copying the result cells into user
+ * buffers like tiledb_array_read(), it returns a view per attribute, i.e., a
+ * pointer to the next run of result cells inside a decompressed (or
+ * memory-mapped) tile and the size of the run in bytes. Invoking it 
+ * repeatedly yields the result cells in the same order as 
+ * tiledb_array_read(), and a zero size indicates that there are no more 
+ * results for the attribute. The views are leased to the caller, i.e., they
+ * remain valid until tiledb_array_release_views() is invoked, which must
+ * precede the next invocation. Only fixed-sized attributes are supported,
+ * and the function cannot be mixed with tiledb_array_read() on the same
+ * array: each of the two fails once the other has been used, until the
+ * subarray is reset (see tiledb_array_reset_subarray()).
+ *
+ * @param tiledb_array The TileDB array.
+ * @param views An array of views, one for each attribute, in the same order
+ *     as the attributes specified in tiledb_array_init() or 
+ *     tiledb_array_reset_attributes().
+ * @param view_sizes The sizes (in bytes) of the views (there is a one-to-one
+ *     correspondence).
+ * @return TILEDB_OK for success and TILEDB_ERR for error.
+ */
+TILEDB_EXPORT int tiledb_array_read_views(
+    const TileDB_Array* tiledb_array,
+    const void** views,
+    size_t* view_sizes);
+
+/**
+ * Releases the views returned by the last tiledb_array_read_views() on an
+ * array, which become invalid.
+ *
+ * @param tiledb_array The TileDB array.
+ * @return TILEDB_OK for success and TILEDB_ERR for error.
+ */
+TILEDB_EXPORT int tiledb_array_release_views(const TileDB_Array* tiledb_array);
+
 /**
  * Checks if a read operation for a particular attribute resulted in a
  * buffer overflow.
@@ -460,13 +630,61 @@ TILEDB_EXPORT int tiledb_array_overflow(
     int attribute_id);
 
 /**
- * Consolidates the fragments of an array into a single fragment. 
+ * Consolidates fragments of an array into a single fragment. The fragments
+ * are selected by the consolidation policy of the configuration (by default,
+ * all the fragments are merged). The cells of all the attributes are copied
+ * through buffers whose total size is set by the *consolidation_buffer_size*
+ * configuration parameter.
  * 
  * @param tiledb_array The TileDB array to be consolidated.
  * @return TILEDB_OK on success, and TILEDB_ERR on error.
  */
 TILEDB_EXPORT int tiledb_array_consolidate(const TileDB_Array* tiledb_array);
 
+/** A policy that selects the fragments merged by a consolidation. */
+typedef struct TileDB_ConsolidationPolicy {
+  /** 
+   * The consolidation mode. It can be one of the following:
+   *    - TILEDB_CONSOLIDATION_ALL: All the fragments are merged.
+   *    - TILEDB_CONSOLIDATION_TIERED: The newest run of at least
+   *      *tier_min_fragment_num_* and at most *tier_max_fragment_num_*
+   *      consecutive fragments, whose sizes differ at most by a factor of
+   *      *tier_size_ratio_*, is merged. Merging only fragments of similar size
+   *      keeps the cost of consolidating a newly added small fragment
+   *      proportional to its size, rather than to the size of the array.
+   *    - TILEDB_CONSOLIDATION_SUBARRAY: The fragments overlapping
+   *      *subarray_* are merged.
+   */
+  int mode_;
+  /** The maximum size ratio of the fragments merged in tiered mode. */
+  double tier_size_ratio_;
+  /** The minimum number of fragments merged in tiered mode. */
+  int tier_min_fragment_num_;
+  /** The maximum number of fragments merged in tiered mode. */
+  int tier_max_fragment_num_;
+  /** 
+   * The subarray of TILEDB_CONSOLIDATION_SUBARRAY mode, in the form of
+   * [low, high] pairs, one pair per dimension.
+   */
+  const void* subarray_;
+} TileDB_ConsolidationPolicy;
+
+/**
+ * Consolidates the fragments of an array selected by a policy into a single
+ * fragment, which takes the place of the newest merged fragment in the 
+ * fragment order. Besides the fragments chosen by the policy, TileDB merges
+ * every fragment whose cells would otherwise be overwritten wrongly by (or
+ * take precedence wrongly over) the cells of the new fragment.
+ * 
+ * @param tiledb_array The TileDB array to be consolidated.
+ * @param policy The consolidation policy. If it is NULL, the policy of the
+ *     configuration is used.
+ * @return TILEDB_OK on success, and TILEDB_ERR on error.
+ */
+TILEDB_EXPORT int tiledb_array_consolidate_with_policy(
+    const TileDB_Array* tiledb_array,
+    const TileDB_ConsolidationPolicy* policy);
+
 /** 
  * Finalizes a TileDB array, properly freeing its memory space. 
  *
@@ -610,6 +828,21 @@ typedef struct TileDB_MetadataSchema {
    * key). It can be one of the following: 
    *    - TILEDB_NO_COMPRESSION
    *    - TILEDB_GZIP 
+   *    - TILEDB_LZ4 (requires a build with LZ4=1)
+   *    - TILEDB_ZSTD (requires a build with ZSTD=1)
+   *    - TILEDB_SHUFFLE_LZ4 (requires a build with LZ4=1)
+   *
+   * A compression level can be combined with the type using
+   * TILEDB_COMPRESSION_LEVEL(), e.g., 
+   * `TILEDB_ZSTD | TILEDB_COMPRESSION_LEVEL(19)`. A compressed attribute
+   * may also have a chain of filters applied to its tiles before compression
+   * using TILEDB_FILTER(), e.g., 
+   * `TILEDB_GZIP | TILEDB_FILTER(0, TILEDB_FILTER_DELTA)`. The filters are:
+   *    - TILEDB_FILTER_DELTA
+   *    - TILEDB_FILTER_DOUBLE_DELTA
+   *    - TILEDB_FILTER_BYTE_SHUFFLE
+   *    - TILEDB_FILTER_BIT_SHUFFLE
+   *    - TILEDB_FILTER_BIT_PACKING
    *
    * If it is *NULL*, then the default TILEDB_NO_COMPRESSION is used for all
    * attributes.
@@ -817,7 +1050,9 @@ TILEDB_EXPORT int tiledb_metadata_overflow(
     int attribute_id);
 
 /**
- * Consolidates the fragments of a metadata object into a single fragment. 
+ * Consolidates fragments of a metadata object into a single fragment, using
+ * the consolidation policy of the configuration (see 
+ * tiledb_array_consolidate()).
  * 
  * @param tiledb_metadata The TileDB metadata to be consolidated.
  * @return TILEDB_OK on success, and TILEDB_ERR on error.
@@ -52,12 +52,27 @@
 #define TILEDB_ARRAY_WRITE_UNSORTED                  2
 /**@}*/
 
+/**@{*/
+/** Asynchronous read request status. */
+#define TILEDB_AIO_ERR                              -1
+#define TILEDB_AIO_COMPLETED                         0
+#define TILEDB_AIO_INPROGRESS                        1
+#define TILEDB_AIO_OVERFLOW                          2
+/**@}*/
+
 /**@{*/
 /** Metadata mode. */
 #define TILEDB_METADATA_READ                         0
 #define TILEDB_METADATA_WRITE                        1
 /**@}*/
 
+/**@{*/
+/** Consolidation mode. */
+#define TILEDB_CONSOLIDATION_ALL                     0
+#define TILEDB_CONSOLIDATION_TIERED                  1
+#define TILEDB_CONSOLIDATION_SUBARRAY                2
+/**@}*/
+
 /** 
  * The TileDB home directory, where TileDB-related system metadata structures
  * are kept. If it is set to "", then the home directory is set to "~/.tiledb"
@@ -76,8 +91,104 @@
 /** The maximum length for the names of TileDB objects. */
 #define TILEDB_NAME_MAX_LEN                        256
 
-/** Size of the buffer used during consolidation. */
-#define TILEDB_CONSOLIDATION_BUFFER_SIZE      10000000 // ~10 MB
+/** 
+ * Default total size of the buffers through which the cells of all the
+ * attributes are copied during consolidation.
+ */
+#define TILEDB_CONSOLIDATION_BUFFER_SIZE     100000000 // ~100 MB
+
+/** 
+ * Default total size of the buffers through which the sorted runs of an
+ * unsorted write are merged. A zero value disables the runs, i.e., every
+ * unsorted write creates a separate fragment.
+ */
+#define TILEDB_UNSORTED_MERGE_BUFFER_SIZE            0
+
+/** Default consolidation mode. */
+#define TILEDB_CONSOLIDATION_MODE     TILEDB_CONSOLIDATION_ALL
+
+/** 
+ * Default maximum ratio between the sizes of the largest and the smallest
+ * fragment merged together by tiered consolidation.
+ */
+#define TILEDB_CONSOLIDATION_TIER_SIZE_RATIO       4.0
+
+/**@{*/
+/** Default range of the number of fragments merged by tiered consolidation. */
+#define TILEDB_CONSOLIDATION_TIER_MIN_FRAGMENT_NUM   4
+#define TILEDB_CONSOLIDATION_TIER_MAX_FRAGMENT_NUM  32
+/**@}*/
+
+/** 
+ * Default maximum size of the (decompressed) tiles cached across all array
+ * reads of the process. A zero value disables the tile cache.
+ */
+#define TILEDB_TILE_CACHE_SIZE               100000000 // ~100 MB
+
+/**@{*/
+/** 
+ * Bounds on the number and size of the chunks of keys that radix sort
+ * processes in parallel.
+ */
+#define TILEDB_RADIX_SORT_MAX_CHUNK_NUM             64
+#define TILEDB_RADIX_SORT_MIN_CHUNK_SIZE         65536
+/**@}*/
+
+/** 
+ * Default maximum number of array schemas, as well as of fragment book-keeping
+ * structures, kept cached for reuse while no open array uses them. A zero
+ * value disables the array metadata cache.
+ */
+#define TILEDB_ARRAY_METADATA_CACHE_SIZE          1024
+
+/** Default number of threads serving asynchronous reads in a context. */
+#define TILEDB_AIO_THREAD_NUM                        4
+
+/** 
+ * Default number of threads running the parallel loops of array reads and
+ * writes (e.g., tile compression and prefetching). A zero value uses the
+ * OpenMP default.
+ */
+#define TILEDB_THREAD_NUM                            0
+
+/**@{*/
+/** I/O mode in which the tiles are read from the fragment files. */
+#define TILEDB_IO_READ                               0
+#define TILEDB_IO_MMAP                               1
+/**@}*/
+
+/** 
+ * Number of read rounds (typically one per tile) whose cell ranges are
+ * computed ahead during reads, so that their tiles can be fetched and
+ * decompressed in parallel.
+ */
+#define TILEDB_PREFETCH_ROUND_NUM                    8
+
+/** 
+ * Size of the memory blocks of the arenas from which the cell ranges of the
+ * read rounds are allocated.
+ */
+#define TILEDB_ARENA_BLOCK_SIZE                  65536 // 64KB
+
+/** 
+ * Maximum total size of the full tiles buffered during writes before they
+ * are compressed in parallel and appended to their files.
+ */
+#define TILEDB_COMPRESSION_BATCH_SIZE         10000000 // ~10 MB
+
+/** 
+ * Maximum number of fragment files kept open across all array reads of the
+ * process, so that the tile reads do not reopen them. It is further bounded
+ * by half the limit on the open files of the process. Once it is reached,
+ * the rest of the files are opened and closed upon every tile read.
+ */
+#define TILEDB_MAX_CACHED_FILE_NUM                1024
+
+/**
+ * Number of children of each node of the R-tree built over the tile MBRs of
+ * a sparse fragment.
+ */
+#define TILEDB_RTREE_FANOUT                         16
 
 /**@{*/
 /** Special empty cell value. */
@@ -114,6 +225,51 @@
 /** Compression type. */
 #define TILEDB_NO_COMPRESSION                        0
 #define TILEDB_GZIP                                  1
+#define TILEDB_LZ4                                   2
+#define TILEDB_ZSTD                                  3
+#define TILEDB_SHUFFLE_LZ4                           4
+/**@}*/
+
+/**@{*/
+/** 
+ * A compression level may be combined with the compression type of an
+ * attribute as `TILEDB_ZSTD | TILEDB_COMPRESSION_LEVEL(19)`. A zero level
+ * selects the default level of the codec. Otherwise, the level must lie in
+ * the range of the codec, i.e., 1-9 for GZIP, 1-22 for Zstd, and 1-31 for
+ * the acceleration factor of LZ4 and shuffle-LZ4.
+ */
+#define TILEDB_COMPRESSION_TYPE_MASK              0x07
+#define TILEDB_COMPRESSION_LEVEL_SHIFT               3
+#define TILEDB_COMPRESSION_LEVEL_MAX                31
+#define TILEDB_COMPRESSION_LEVEL(level) \
+    ((level) << TILEDB_COMPRESSION_LEVEL_SHIFT)
+/**@}*/
+
+/**@{*/
+/** Tile filter type. */
+#define TILEDB_FILTER_NONE                           0
+#define TILEDB_FILTER_DELTA                          1
+#define TILEDB_FILTER_DOUBLE_DELTA                   2
+#define TILEDB_FILTER_BYTE_SHUFFLE                   3
+#define TILEDB_FILTER_BIT_SHUFFLE                    4
+#define TILEDB_FILTER_BIT_PACKING                    5
+/**@}*/
+
+/**@{*/
+/**
+ * A chain of up to TILEDB_FILTER_MAX_NUM filters may be combined with the
+ * compression type of a compressed attribute, e.g.,
+ * `TILEDB_GZIP | TILEDB_FILTER(0, TILEDB_FILTER_DELTA) |
+ * TILEDB_FILTER(1, TILEDB_FILTER_BYTE_SHUFFLE)`. The filters are applied in
+ * the order of their positions before compression, and reversed after
+ * decompression.
+ */
+#define TILEDB_FILTER_SHIFT                          8
+#define TILEDB_FILTER_BITS                           4
+#define TILEDB_FILTER_MASK                        0x0f
+#define TILEDB_FILTER_MAX_NUM                        6
+#define TILEDB_FILTER(pos, filter) \
+    ((filter) << (TILEDB_FILTER_SHIFT + (pos) * TILEDB_FILTER_BITS))
 /**@}*/
 
 /**@{*/
@@ -139,6 +295,7 @@
 #define TILEDB_FRAGMENT_FILENAME          "__tiledb_fragment.tdb"
 #define TILEDB_GROUP_FILENAME                "__tiledb_group.tdb"
 #define TILEDB_WORKSPACE_FILENAME        "__tiledb_workspace.tdb"
+#define TILEDB_RUNS_DIRNAME                             ".__runs"
 /**@}*/
 
 /**@{*/
@@ -147,4 +304,10 @@
 #define TILEDB_SORTED_BUFFER_VAR_SIZE         10000000  // ~10MB
 /**@}*/
 
+/** 
+ * Size of the blocks of sorted cells that are gathered by a single thread
+ * during unsorted writes, small enough to stay in the CPU cache.
+ */
+#define TILEDB_GATHER_BLOCK_SIZE                 65536  // 64KB
+
 #endif
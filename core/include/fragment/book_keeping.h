@@ -34,6 +34,8 @@
 #define __BOOK_KEEPING_H__
 
 #include "fragment.h"
+#include "rtree.h"
+#include "tile_stats.h"
 #include <vector>
 #include <zlib.h>
 
@@ -50,6 +52,9 @@
 #define TILEDB_BK_ERR        -1
 /**@}*/
 
+/** Version of the book-keeping file format. */
+#define TILEDB_BK_VERSION     2
+
 
 
 
@@ -63,7 +68,10 @@ class BookKeeping {
   /* ********************************* */
 
   /** 
-   * Constructor. 
+   * Constructor. The book-keeping structure keeps only the array schema,
+   * name, mode and type (dense or sparse) of the fragment, so that once
+   * loaded it can outlive the fragment and be shared by other fragment
+   * objects of the same fragment (see ArrayMetadataCache).
    *
    * @param fragment The fragment the book-keeping structure belongs to.
    */
@@ -79,8 +87,15 @@ class BookKeeping {
   /*             ACCESSORS             */
   /* ********************************* */
 
-  /** Returns the bounding coordinates. */
-  const std::vector<void*>& bounding_coords() const; 
+  /** Returns the schema of the array the fragment belongs to. */
+  const ArraySchema* array_schema() const;
+
+  /** 
+   * Returns the bounding coordinates of all tiles, stored contiguously (i.e.,
+   * the first and last coordinates of the tile at position *i* start at
+   * element *2 * i * dim_num*).
+   */
+  const void* bounding_coords() const; 
 
   /** Returns the number of cells in the tile at the input position. */
   int64_t cell_num(int64_t tile_pos) const;
@@ -91,23 +106,37 @@ class BookKeeping {
   /** Returns the number of cells in the last tile. */
   int64_t last_tile_cell_num() const;
 
-  /** Returns the MBRs. */
-  const std::vector<void*>& mbrs() const; 
+  /** 
+   * Returns the MBRs of all tiles, stored contiguously (i.e., the MBR of the
+   * tile at position *i* starts at element *2 * i * dim_num*).
+   */
+  const void* mbrs() const; 
 
   /** Returns the non-empty domain in which the fragment is constrained. */
   const void* non_empty_domain() const;
 
+  /** Returns the R-tree over the MBRs. */
+  const RTree* rtree() const;
+
   /** Returns the number of tiles in the fragment. */
   int64_t tile_num() const;
 
-  /** Returns the tile offsets. */
-  const std::vector<std::vector<off_t> >& tile_offsets() const;
+  /** Returns the tile offsets of the input attribute. */
+  const off_t* tile_offsets(int attribute_id) const;
 
-  /** Returns the variable tile offsets. */
-  const std::vector<std::vector<off_t> >& tile_var_offsets() const;
+  /** 
+   * Returns the statistics of the tiles of the input attribute, one per tile,
+   * or NULL if they are not kept for the attribute. They are kept for the
+   * fixed-sized attributes (excluding the coordinates) of the fragments 
+   * written with the current book-keeping format. 
+   */
+  const TileStats* tile_stats(int attribute_id) const;
 
-  /** Returns the variable tile sizes. */
-  const std::vector<std::vector<size_t> >& tile_var_sizes() const;
+  /** Returns the variable tile offsets of the input attribute. */
+  const off_t* tile_var_offsets(int attribute_id) const;
+
+  /** Returns the variable tile sizes of the input attribute. */
+  const size_t* tile_var_sizes(int attribute_id) const;
 
 
 
@@ -143,6 +172,15 @@ class BookKeeping {
    */
   void append_tile_offset(int attribute_id, size_t step);
 
+  /** 
+   * Appends the statistics of the next tile of the input attribute. 
+   *
+   * @param attribute_id The id of the attribute the tile belongs to.
+   * @param stats The tile statistics to be appended.
+   * @return void
+   */
+  void append_tile_stats(int attribute_id, const TileStats& stats);
+
   /** 
    * Appends a variable tile offset for the input attribute. 
    *
@@ -180,7 +218,10 @@ class BookKeeping {
   int init(const void* non_empty_domain);
 
   /**
-   * Loads the book-keeping structures from the disk.
+   * Loads the book-keeping structures from the disk. The book-keeping file is
+   * memory-mapped, and the MBRs, bounding coordinates and tile offsets and 
+   * sizes are accessed directly in the mapped file, so that only the pages
+   * touched by the queries (e.g., those of the queried attributes) are read.
    *
    * @return TILEDB_BK_OK for success, and TILEDB_OK_ERR for error.
    */
@@ -202,8 +243,19 @@ class BookKeeping {
   /*         PRIVATE ATTRIBUTES        */
   /* ********************************* */
 
-  /** The first and last coordinates of each tile. */
-  std::vector<void*> bounding_coords_;
+  /** The schema of the array the fragment belongs to. */
+  const ArraySchema* array_schema_;
+  /** The first and last coordinates of each tile, stored contiguously. */
+  void* bounding_coords_;
+  /** 
+   * The allocated size of bounding_coords_ (zero if bounding_coords_ points
+   * into map_).
+   */
+  size_t bounding_coords_allocated_size_;
+  /** The number of tiles in bounding_coords_. */
+  int64_t bounding_coords_num_;
+  /** True if the fragment is dense, and false if it is sparse. */
+  bool dense_;
   /**
    * The (expanded) domain in which the fragment is constrained. "Expanded"
    * means that the domain is enlarged minimally to coincide with tile 
@@ -211,12 +263,25 @@ class BookKeeping {
    * type of the domain must be the same as the type of the array coordinates.
    */
   void* domain_;
-  /** The fragment the book-keeping belongs to. */
-  const Fragment* fragment_;
+  /** The name of the fragment the book-keeping belongs to. */
+  std::string fragment_name_;
   /** Number of cells in the last tile (meaningful only in the sparse case). */
   int64_t last_tile_cell_num_;
-  /** The MBRs (applicable only to the sparse case with irregular tiles). */
-  std::vector<void*> mbrs_;
+  /** The memory-mapped book-keeping file (read mode). */
+  void* map_;
+  /** The size of map_. */
+  size_t map_size_;
+  /** 
+   * The MBRs, stored contiguously (applicable only to the sparse case with
+   * irregular tiles).
+   */
+  void* mbrs_;
+  /** The allocated size of mbrs_ (zero if mbrs_ points into map_). */
+  size_t mbrs_allocated_size_;
+  /** The number of MBRs in mbrs_. */
+  int64_t mbr_num_;
+  /** The mode of the fragment the book-keeping belongs to. */
+  int mode_;
   /** The offsets of the next tile for each attribute. */
   std::vector<off_t> next_tile_offsets_;
   /** The offsets of the next variable tile for each attribute. */
@@ -226,21 +291,48 @@ class BookKeeping {
    * type of the domain must be the same as the type of the array coordinates.
    */
   void* non_empty_domain_;
+  /** 
+   * The R-tree over the MBRs (applicable only to the sparse case), which
+   * prunes the tiles that do not overlap a query subarray.
+   */
+  RTree rtree_;
   /** 
    * The tile offsets in their corresponding attribute files. Meaningful only
    * when there is compression.
    */
   std::vector<std::vector<off_t> > tile_offsets_;
+  /** 
+   * The tile offsets of each attribute after loading, pointing either into
+   * map_ or into tile_offsets_ (for the older GZIP-compressed format).
+   */
+  std::vector<const off_t*> tile_offsets_ptrs_;
+  /** The statistics of the tiles of each attribute. */
+  std::vector<std::vector<TileStats> > tile_stats_;
+  /** 
+   * The tile statistics of each attribute after loading, pointing into map_
+   * (NULL if the attribute has none).
+   */
+  std::vector<const TileStats*> tile_stats_ptrs_;
   /**
    * The variable tile offsets in their corresponding attribute files.
    * Meaningful only for variable-sized tiles.
    */
   std::vector<std::vector<off_t> > tile_var_offsets_;
+  /** 
+   * The variable tile offsets of each attribute after loading, pointing 
+   * either into map_ or into tile_var_offsets_.
+   */
+  std::vector<const off_t*> tile_var_offsets_ptrs_;
   /*
    * The sizes of the uncompressed variable tiles. 
    * Meaningful only when there is compression for variable tiles.
    */
   std::vector<std::vector<size_t> > tile_var_sizes_;
+  /** 
+   * The variable tile sizes of each attribute after loading, pointing either
+   * into map_ or into tile_var_sizes_.
+   */
+  std::vector<const size_t*> tile_var_sizes_ptrs_;
 
 
 
@@ -249,21 +341,39 @@ class BookKeeping {
   /*           PRIVATE METHODS         */
   /* ********************************* */
 
+  /** 
+   * Builds the R-tree over the MBRs.
+   *
+   * @return void
+   */
+  void build_rtree();
+
+  /** 
+   * Builds the R-tree over the MBRs.
+   *
+   * @template T The coordinates type.
+   * @return void
+   */
+  template<class T>
+  void build_rtree();
+
   /**
    * Writes the bounding coordinates in the book-keeping file on disk.
    *
    * @param fd The descriptor of the book-keeping file.
    * @return TILEDB_BK_OK on success and TILEDB_BK_ERR on error.
    */
-  int flush_bounding_coords(gzFile fd) const;
+  int flush_bounding_coords(int fd) const;
 
  /**
-   * Writes the cell number of the last tile in the book-keeping file on disk.
+   * Writes the header of the book-keeping file on disk, which holds the format
+   * version, the cell number of the last tile and the sizes of all the
+   * sections that follow it.
    *
    * @param fd The descriptor of the book-keeping file.
    * @return TILEDB_BK_OK on success and TILEDB_BK_ERR on error.
    */
-  int flush_last_tile_cell_num(gzFile fd) const;
+  int flush_header(int fd) const;
 
  /**
    * Writes the MBRs in the book-keeping file on disk.
@@ -271,7 +381,7 @@ class BookKeeping {
    * @param fd The descriptor of the book-keeping file.
    * @return TILEDB_BK_OK on success and TILEDB_BK_ERR on error.
    */
-  int flush_mbrs(gzFile fd) const;
+  int flush_mbrs(int fd) const;
 
  /**
    * Writes the non-empty domain in the book-keeping file on disk.
@@ -279,7 +389,15 @@ class BookKeeping {
    * @param fd The descriptor of the book-keeping file.
    * @return TILEDB_BK_OK on success and TILEDB_BK_ERR on error.
    */
-  int flush_non_empty_domain(gzFile fd) const;
+  int flush_non_empty_domain(int fd) const;
+
+ /**
+   * Writes the R-tree in the book-keeping file on disk.
+   *
+   * @param fd The descriptor of the book-keeping file.
+   * @return TILEDB_BK_OK on success and TILEDB_BK_ERR on error.
+   */
+  int flush_rtree(int fd) const;
 
  /**
    * Writes the tile offsets in the book-keeping file on disk.
@@ -287,7 +405,15 @@ class BookKeeping {
    * @param fd The descriptor of the book-keeping file.
    * @return TILEDB_BK_OK on success and TILEDB_BK_ERR on error.
    */
-  int flush_tile_offsets(gzFile fd) const;
+  int flush_tile_offsets(int fd) const;
+
+ /**
+   * Writes the tile statistics in the book-keeping file on disk.
+   *
+   * @param fd The descriptor of the book-keeping file.
+   * @return TILEDB_BK_OK on success and TILEDB_BK_ERR on error.
+   */
+  int flush_tile_stats(int fd) const;
 
  /**
    * Writes the variable tile offsets in the book-keeping file on disk.
@@ -295,7 +421,7 @@ class BookKeeping {
    * @param fd The descriptor of the book-keeping file.
    * @return TILEDB_BK_OK on success and TILEDB_BK_ERR on error.
    */
-  int flush_tile_var_offsets(gzFile fd) const;
+  int flush_tile_var_offsets(int fd) const;
 
  /**
    * Writes the variable tile sizes in the book-keeping file on disk.
@@ -303,7 +429,7 @@ class BookKeeping {
    * @param fd The descriptor of the book-keeping file.
    * @return TILEDB_BK_OK on success and TILEDB_BK_ERR on error.
    */
-  int flush_tile_var_sizes(gzFile fd) const;
+  int flush_tile_var_sizes(int fd) const;
 
   /**
    * Loads the bounding coordinates from the book-keeping file on disk.
@@ -313,6 +439,14 @@ class BookKeeping {
    */
   int load_bounding_coords(gzFile fd);
 
+  /**
+   * Loads the book-keeping structures from a GZIP-compressed book-keeping
+   * file of the older format, which is read entirely into memory.
+   *
+   * @return TILEDB_BK_OK for success, and TILEDB_OK_ERR for error.
+   */
+  int load_gz();
+
   /**
    * Loads the cell number of the last tile from the book-keeping file on disk.
    *
@@ -337,6 +471,24 @@ class BookKeeping {
    */
   int load_non_empty_domain(gzFile fd);
 
+  /**
+   * Loads the R-tree from the book-keeping file on disk. If the file has no
+   * R-tree (i.e., it was created before the R-tree was introduced), the
+   * R-tree is built from the loaded MBRs.
+   *
+   * @param fd The descriptor of the book-keeping file.
+   * @return TILEDB_BK_OK on success and TILEDB_BK_ERR on error.
+   */
+  int load_rtree(gzFile fd);
+
+  /**
+   * Sets the book-keeping structures to the sections of the memory-mapped
+   * book-keeping file, after validating its header.
+   *
+   * @return TILEDB_BK_OK for success, and TILEDB_OK_ERR for error.
+   */
+  int load_sections();
+
   /**
    * Loads the tile offsets from the book-keeping file on disk.
    *
@@ -39,6 +39,8 @@
 #include "constants.h"
 #include "read_state.h"
 #include "write_state.h"
+#include <atomic>
+#include <mutex>
 #include <vector>
 
 
@@ -89,21 +91,82 @@ class Fragment {
   /** Returns the array the fragment belongs to. */
   const Array* array() const;
 
+  /** Returns the book-keeping of the fragment. */
+  BookKeeping* book_keeping() const;
+
   /** Returns the number of cell per (full) tile. */
   int64_t cell_num_per_tile() const;
 
   /** Returns true if the fragment is dense, and false if it is sparse. */
   bool dense() const;
 
+  /**
+   * Returns the descriptor of an attribute file of the fragment, opened for
+   * reading. The file is opened upon the first call and kept open until the
+   * fragment is finalized, so that the tile reads do not reopen it, as long
+   * as the files kept open by all the fragments of the process are fewer than
+   * TILEDB_MAX_CACHED_FILE_NUM and half the limit on the open files. 
+   * Otherwise, the caller must close the returned descriptor. This function
+   * is thread-safe.
+   *
+   * @param attribute_id The id of the attribute (the coordinates have id
+   *     equal to the number of attributes).
+   * @param var If *true*, the file of the variable-sized cell values of the
+   *     attribute is opened instead of that of its cells (or cell offsets).
+   * @param cached Set to *true* if the fragment keeps the file open, and to
+   *     *false* if the caller must close it.
+   * @return The file descriptor on success and -1 on error.
+   */
+  int file_descriptor(int attribute_id, bool var, bool& cached) const;
+
+  /** 
+   * Returns the size of an attribute file of the fragment. The size is
+   * retrieved once, when the file is first opened (see file_descriptor()).
+   * This function is thread-safe.
+   *
+   * @param attribute_id The id of the attribute.
+   * @param var If *true*, the size of the file of the variable-sized cell
+   *     values of the attribute is returned.
+   * @return The file size on success and TILEDB_FG_ERR on error.
+   */
+  off_t file_size(int attribute_id, bool var) const;
+
   /** Returns the fragment name. */
   const std::string& fragment_name() const;
 
   /** Returns the mode of the fragment. */
   int mode() const;
 
+  /**
+   * Reads data from an attribute file of the fragment into a buffer, with
+   * *pread* on the cached file descriptor, or on a descriptor opened only for
+   * this read once the limit on the cached ones is reached (see 
+   * file_descriptor()). This function is thread-safe.
+   *
+   * @param attribute_id The id of the attribute.
+   * @param var If *true*, the data are read from the file of the
+   *     variable-sized cell values of the attribute.
+   * @param offset The offset in the file from which the read will start.
+   * @param buffer The buffer into which the data will be written.
+   * @param length The size of the data to be read from the file.
+   * @return TILEDB_FG_OK on success and TILEDB_FG_ERR on error.
+   */
+  int read_from_file(
+      int attribute_id,
+      bool var,
+      off_t offset,
+      void* buffer,
+      size_t length) const;
+
   /** Returns the read state of the fragment. */
   ReadState* read_state() const;
 
+  /** 
+   * Returns the total size of the attribute files of the fragment, which is
+   * the cost of rewriting the fragment upon consolidation.
+   */
+  off_t size() const;
+
   /** 
    * Returns the tile size for a given attribute (TILEDB_VAR_SIZE in case
    * of a variable-sized attribute.
@@ -198,6 +261,25 @@ class Fragment {
   BookKeeping* book_keeping_;
   /** Indicates whether the fragment is dense or sparse. */
   bool dense_;
+  /** 
+   * The number of file descriptors kept open by all the fragments of the
+   * process.
+   */
+  static std::atomic<int> cached_fd_num_;
+  /** 
+   * The descriptors of the attribute files kept open for reading (-1 if not
+   * opened yet, or not kept open). The descriptors of the files with the
+   * variable-sized cell values follow those of all the attributes and the
+   * coordinates.
+   */
+  mutable std::vector<int> fds_;
+  /** 
+   * The sizes of the files opened at least once (-1 if not opened yet), in 
+   * the same order as fds_. 
+   */
+  mutable std::vector<off_t> file_sizes_;
+  /** Protects fds_ and file_sizes_. */
+  mutable std::mutex files_mtx_;
   /** The fragment name. */
   std::string fragment_name_;
   /*
@@ -219,6 +301,15 @@ class Fragment {
   /*          PRIVATE METHODS          */
   /* ********************************* */
 
+  /** Closes the attribute files opened for reading. */
+  void close_files();
+
+  /** 
+   * Returns the maximum number of file descriptors that all the fragments of
+   * the process may keep open (see file_descriptor()).
+   */
+  static int max_cached_fd_num();
+
   /** 
    * Changes the temporary fragment name into a stable one.
    *
@@ -33,6 +33,7 @@
 #ifndef __READ_STATE_H__
 #define __READ_STATE_H__
 
+#include "arena.h"
 #include "book_keeping.h"
 #include "fragment.h"
 #include <vector>
@@ -204,6 +205,24 @@ class ReadState {
       size_t& buffer_var_offset,
       const CellPosRange& cell_pos_range);
 
+  /**
+   * Estimates the number of cells of the fragment that lie in the query
+   * subarray, as well as the size of their variable-sized values, using only
+   * the book-keeping (i.e., without fetching any tiles). The estimates are
+   * upper bounds. The cell number is exact for dense fragments, and for
+   * sparse fragments whose overlapping tiles lie entirely in the subarray.
+   *
+   * @template T The coordinates type.
+   * @param cell_num The estimated number of cells.
+   * @param var_sizes The estimated sizes of the variable-sized values, 
+   *     indexed by attribute id, are added to this vector.
+   * @return TILEDB_RS_OK on success and TILEDB_RS_ERR on error.
+   */
+  template<class T>
+  int estimate_result_size(
+      int64_t& cell_num,
+      std::vector<size_t>& var_sizes) const;
+
   /** 
    * Retrieves the coordinates after the input coordinates in the search tile.
    * 
@@ -219,6 +238,24 @@ class ReadState {
       T* coords_after,
       bool& coords_retrieved);
 
+  /** 
+   * Retrieves the coordinates after the input coordinates in a designated
+   * tile.
+   * 
+   * @template T The coordinates type.
+   * @param tile_i The tile to search in.
+   * @param coords The target coordinates.
+   * @param coords_after The coordinates to be retrieved.
+   * @param coords_retrieved *true* if *coords_after* are indeed retrieved.
+   * @return TILEDB_RS_OK on success and TILEDB_RS_ERR on error.
+   */
+  template<class T>
+  int get_coords_after(
+      int64_t tile_i,
+      const T* coords,
+      T* coords_after,
+      bool& coords_retrieved);
+
   /**
    * Given a target coordinates set, it returns the coordinates preceding and
    * succeeding it in a designated tile and inside an indicated coordinate
@@ -272,12 +309,14 @@ class ReadState {
    * @template T The coordinates type.
    * @param fragment_i The fragment id. 
    * @param fragment_cell_ranges The output fragment cell ranges.
+   * @param arena The arena the cell ranges are allocated from.
    * @return TILEDB_RS_OK on success and TILEDB_RS_ERR on error.
    */
   template<class T>
   int get_fragment_cell_ranges_dense(
       int fragment_i,
-      FragmentCellRanges& fragment_cell_ranges); 
+      FragmentCellRanges& fragment_cell_ranges,
+      Arena& arena); 
 
   /**
    * Computes the fragment cell ranges corresponding to the current search
@@ -286,12 +325,14 @@ class ReadState {
    * @template T The coordinates type.
    * @param fragment_i The fragment id. 
    * @param fragment_cell_ranges The output fragment cell ranges.
+   * @param arena The arena the cell ranges are allocated from.
    * @return TILEDB_RS_OK on success and TILEDB_RS_ERR on error.
    */
   template<class T>
   int get_fragment_cell_ranges_sparse(
       int fragment_i,
-      FragmentCellRanges& fragment_cell_ranges); 
+      FragmentCellRanges& fragment_cell_ranges,
+      Arena& arena); 
 
   /**
    * Computes the fragment cell ranges corresponding to the current search
@@ -303,6 +344,7 @@ class ReadState {
    * @param start_coords The start coordinates of the specified range.
    * @param end_coords The end coordinates of the specified range.
    * @param fragment_cell_ranges The output fragment cell ranges.
+   * @param arena The arena the cell ranges are allocated from.
    * @return TILEDB_RS_OK on success and TILEDB_RS_ERR on error.
    */
   template<class T>
@@ -310,7 +352,8 @@ class ReadState {
       int fragment_i,
       const T* start_coords,
       const T* end_coords,
-      FragmentCellRanges& fragment_cell_ranges); 
+      FragmentCellRanges& fragment_cell_ranges,
+      Arena& arena); 
 
   /**
    * Gets the next overlapping tile from the fragment, which may overlap or not
@@ -346,6 +389,40 @@ class ReadState {
   template<class T>
   void get_next_overlapping_tile_sparse(const T* tile_coords);
 
+  /**
+   * Reads and decompresses a tile of the input attribute directly into the
+   * tile cache, without altering the read state. It is thread-safe, so that
+   * multiple tiles can be prefetched in parallel. This is a no-op if the
+   * attribute is not compressed, or the tile is already cached.
+   *
+   * @param attribute_id The id of the attribute the tile is prefetched for.
+   * @param tile_i The position of the tile to be prefetched.
+   * @return TILEDB_RS_OK on success and TILEDB_RS_ERR on error.
+   */
+  int prefetch_tile(int attribute_id, int64_t tile_i) const;
+
+  /**
+   * Exposes the cells of the input **fixed-sized** attribute in the input 
+   * cell position range without copying them, i.e., it returns a pointer 
+   * into the (decompressed or memory-mapped) tile that holds them. The view
+   * remains valid until the next tile of the attribute is fetched. 
+   *
+   * @param attribute_id The id of the targeted attribute.
+   * @param tile_i The tile holding the cells.
+   * @param cell_pos_range The cell position range to be exposed.
+   * @param view The pointer to the first cell of the range. It is NULL if the
+   *     attribute is empty in this fragment.
+   * @param view_size The size (in bytes) of the range, or 0 if the attribute
+   *     is empty in this fragment.
+   * @return TILEDB_RS_OK on success and TILEDB_RS_ERR on error.
+   */
+  int view_cells(
+      int attribute_id,
+      int64_t tile_i,
+      const CellPosRange& cell_pos_range,
+      const void*& view,
+      size_t& view_size);
+
 
 
 
@@ -362,6 +439,11 @@ class ReadState {
   std::vector<int64_t> fetched_tile_;
   /** The fragment the read state belongs to. */
   const Fragment* fragment_;
+  /** 
+   * The I/O mode in which the tiles are read, TILEDB_IO_READ or 
+   * TILEDB_IO_MMAP, fixed upon construction by the array configuration.
+   */
+  int io_mode_;
   /** 
    * Last investigated tile coordinates. Applicable only to **sparse** fragments
    * for **dense** arrays.
@@ -511,6 +593,27 @@ class ReadState {
   template<class T>
   void compute_tile_search_range_hil();
 
+  /**
+   * Decompresses a tile with the codec of its attribute, and reverses the
+   * filters of the attribute (if any).
+   *
+   * @param attribute_id The id of the attribute the tile belongs to.
+   * @param var *true* if this is the tile with the actual variable-sized cell
+   *     values, and *false* otherwise.
+   * @param tile_compressed The compressed tile.
+   * @param tile_compressed_size The size of the compressed tile.
+   * @param tile The buffer where the decompressed tile will be stored.
+   * @param tile_size The expected size of the decompressed tile.
+   * @return TILEDB_RS_OK for success and TILEDB_RS_ERR for error.
+   */
+  int decompress_tile(
+      int attribute_id,
+      bool var,
+      const void* tile_compressed,
+      size_t tile_compressed_size,
+      void* tile,
+      size_t tile_size) const;
+
   /** 
    * Returns the cell position in the search tile that is after the
    * input coordinates.
@@ -549,13 +652,13 @@ class ReadState {
 
   /**
    * Reads/maps a tile from the disk into a local buffer for an attribute. This
-   * function focuses on the case there is GZIP compression.
+   * function focuses on the case there is compression.
    *
    * @param attribute_id The id of the attribute the tile is read for. 
    * @param tile_i The position of the tile to be read from the disk.
    * @return TILEDB_RS_OK for success and TILEDB_RS_ERR for error.
    */
-  int get_tile_from_disk_cmp_gzip(int attribute_id, int64_t tile_i);
+  int get_tile_from_disk_cmp(int attribute_id, int64_t tile_i);
 
   /**
    * Reads a tile from the disk into a local buffer for an attribute. This
@@ -569,13 +672,13 @@ class ReadState {
 
   /**
    * Reads a tile from the disk into a local buffer for an attribute. This
-   * function focuses on the case of variable-sized tiles with GZIP compression.
+   * function focuses on the case of variable-sized tiles with compression.
    *
    * @param attribute_id The id of the attribute the tile is read for. 
    * @param tile_i The position of the tile to be read from the disk.
    * @return TILEDB_RS_OK for success and TILEDB_RS_ERR for error.
    */
-  int get_tile_from_disk_var_cmp_gzip(int attribute_id, int64_t tile_i);
+  int get_tile_from_disk_var_cmp(int attribute_id, int64_t tile_i);
 
   /**
    * Reads a tile from the disk into a local buffer for an attribute. This
@@ -590,16 +693,34 @@ class ReadState {
   /** Returns *true* if the file of the input attribute is empty. */
   bool is_empty_attribute(int attribute_id) const;
 
+  /**
+   * Reads a compressed tile from its attribute file, decompresses it into a
+   * new buffer and inserts it into the tile cache. Used by prefetch_tile().
+   *
+   * @param tile_offsets The start offsets of the tiles in the file.
+   * @param attribute_id The id of the attribute the tile belongs to.
+   * @param tile_i The position of the tile to be prefetched.
+   * @param var *true* if the tile holds actual variable-sized cell values.
+   * @param tile_size The size of the decompressed tile.
+   * @return TILEDB_RS_OK for success and TILEDB_RS_ERR for error.
+   */
+  int prefetch_tile_cmp(
+      const off_t* tile_offsets,
+      int attribute_id,
+      int64_t tile_i,
+      bool var,
+      size_t tile_size) const;
+
   /** 
    * Reads a tile from the disk for an attribute into a local buffer. This
-   * function focuses on the case there is GZIP compression. 
+   * function focuses on the case there is compression. 
    *
    * @param attribute_id The id of the attribute the read occurs for.
    * @param offset The offset at which the tile starts in the file.
    * @param tile_size The tile size. 
    * @return TILEDB_RS_OK for success, and TILEDB_RS_ERR for error.
    */
-  int read_tile_from_file_cmp_gzip(
+  int read_tile_from_file_cmp(
       int attribute_id,
       off_t offset,
       size_t tile_size);
@@ -621,14 +742,14 @@ class ReadState {
   /** 
    * Reads a tile from the disk for an attribute into a local buffer, using 
    * memory map (mmap). This function is invoked in place of
-   * ReadState::read_tile_from_file_cmp_gzip if _TILEDB_USE_MMAP is defined.
+   * ReadState::read_tile_from_file_cmp in the TILEDB_IO_MMAP I/O mode.
    *
    * @param attribute_id The id of the attribute the read occurs for.
    * @param offset The offset at which the tile starts in the file.
    * @param tile_size The tile size. 
    * @return TILEDB_RS_OK for success, and TILEDB_RS_ERR for error.
    */
-  int read_tile_from_file_with_mmap_cmp_gzip(
+  int read_tile_from_file_with_mmap_cmp(
       int attribute_id,
       off_t offset,
       size_t tile_size);
@@ -636,7 +757,7 @@ class ReadState {
   /** 
    * Reads a tile from the disk for an attribute into a local buffer, using 
    * memory map (mmap). This function is invoked in place of
-   * ReadState::read_tile_from_file_cmp_none if _TILEDB_USE_MMAP is defined.
+   * ReadState::read_tile_from_file_cmp_none in the TILEDB_IO_MMAP I/O mode.
    *
    * @param attribute_id The id of the attribute the read occurs for.
    * @param offset The offset at which the tile starts in the file.
@@ -650,14 +771,14 @@ class ReadState {
 
   /** 
    * Reads a tile from the disk for an attribute into a local buffer. This
-   * function focuses on the case of variable-sized tiles and GZIP compression. 
+   * function focuses on the case of variable-sized tiles and compression. 
    *
    * @param attribute_id The id of the attribute the read occurs for.
    * @param offset The offset at which the tile starts in the file.
    * @param tile_size The tile size. 
    * @return TILEDB_RS_OK for success, and TILEDB_RS_ERR for error.
    */
-  int read_tile_from_file_var_cmp_gzip(
+  int read_tile_from_file_var_cmp(
       int attribute_id,
       off_t offset,
       size_t tile_size);
@@ -679,14 +800,14 @@ class ReadState {
   /** 
    * Reads a tile from the disk for an attribute into a local buffer, using 
    * memory map (mmap). This function is invoked in place of
-   * ReadState::read_tile_from_file_var_cmp_gzip if _TILEDB_USE_MMAP is defined.
+   * ReadState::read_tile_from_file_var_cmp in the TILEDB_IO_MMAP I/O mode.
    *
    * @param attribute_id The id of the attribute the read occurs for.
    * @param offset The offset at which the tile starts in the file.
    * @param tile_size The tile size. 
    * @return TILEDB_RS_OK for success, and TILEDB_RS_ERR for error.
    */
-  int read_tile_from_file_with_mmap_var_cmp_gzip(
+  int read_tile_from_file_with_mmap_var_cmp(
       int attribute_id,
       off_t offset,
       size_t tile_size);
@@ -694,7 +815,7 @@ class ReadState {
   /** 
    * Reads a tile from the disk for an attribute into a local buffer, using 
    * memory map (mmap). This function is invoked in place of
-   * ReadState::read_tile_from_file_var_cmp_none if _TILEDB_USE_MMAP is defined.
+   * ReadState::read_tile_from_file_var_cmp_none in the TILEDB_IO_MMAP I/O mode.
    *
    * @param attribute_id The id of the attribute the read occurs for.
    * @param offset The offset at which the tile starts in the file.
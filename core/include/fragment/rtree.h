@@ -0,0 +1,195 @@
+/**
+ * @file   rtree.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2016 MIT and Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file defines class RTree.
+ */
+
+#ifndef __RTREE_H__
+#define __RTREE_H__
+
+#include <inttypes.h>
+#include <sys/types.h>
+#include <vector>
+#include <zlib.h>
+
+
+
+
+/* ********************************* */
+/*             CONSTANTS             */
+/* ********************************* */
+
+/**@{*/
+/** Return code. */
+#define TILEDB_RT_OK          0
+#define TILEDB_RT_ERR        -1
+/**@}*/
+
+
+
+
+/**
+ * A packed R-tree over the tile MBRs of a sparse fragment. The MBRs are the
+ * leaves, and every group of *fanout* consecutive nodes of a level is covered
+ * by a single node of the level above, up to a single root. Since the tiles
+ * of a fragment are already stored along the global cell order (which
+ * clusters nearby cells), packing the MBRs in their tile order produces tight
+ * nodes, while it preserves the tile positions, so that the tree can serve
+ * the tiles overlapping a query in the order they must be read.
+ */
+class RTree {
+ public:
+  /* ********************************* */
+  /*    CONSTRUCTORS & DESTRUCTORS     */
+  /* ********************************* */
+
+  /** Constructor. */
+  RTree();
+
+  /** Destructor. */
+  ~RTree();
+
+
+
+
+  /* ********************************* */
+  /*             ACCESSORS             */
+  /* ********************************* */
+
+  /**
+   * Writes the tree in a book-keeping file.
+   *
+   * @param fd The descriptor of the book-keeping file.
+   * @return TILEDB_RT_OK on success and TILEDB_RT_ERR on error.
+   */
+  int flush(int fd) const;
+
+  /** Returns the number of levels above the leaves. */
+  int level_num() const;
+
+  /**
+   * Finds the first leaf in a range of leaf positions whose MBR overlaps a
+   * subarray, skipping every node whose MBR does not overlap it.
+   *
+   * @template T The coordinates type.
+   * @param mbrs The leaf MBRs the tree is built on, stored contiguously.
+   * @param mbr_num The number of leaf MBRs.
+   * @param subarray The subarray.
+   * @param pos The first leaf position in the range.
+   * @param end The last leaf position in the range.
+   * @return The position of the overlapping leaf, or -1 if there is none.
+   */
+  template<class T>
+  int64_t next_overlapping_leaf(
+      const void* mbrs,
+      int64_t mbr_num,
+      const T* subarray,
+      int64_t pos,
+      int64_t end) const;
+
+
+
+
+  /* ********************************* */
+  /*             MUTATORS              */
+  /* ********************************* */
+
+  /**
+   * Bulk-loads the tree over the input MBRs, discarding any previous tree.
+   *
+   * @template T The coordinates type.
+   * @param mbrs The leaf MBRs in their tile order, stored contiguously.
+   * @param mbr_num The number of leaf MBRs.
+   * @param dim_num The number of dimensions.
+   * @param fanout The number of children of each node.
+   * @return void
+   */
+  template<class T>
+  void build(const void* mbrs, int64_t mbr_num, int dim_num, int fanout);
+
+  /**
+   * Loads the tree from a buffer holding it in the format written by flush().
+   *
+   * @param buffer The buffer.
+   * @param buffer_size The size of the buffer.
+   * @param dim_num The number of dimensions.
+   * @param coords_size The size of the coordinates.
+   * @return TILEDB_RT_OK on success and TILEDB_RT_ERR on error.
+   */
+  int load(
+      const void* buffer, 
+      size_t buffer_size, 
+      int dim_num, 
+      size_t coords_size);
+
+  /**
+   * Loads the tree from a GZIP-compressed book-keeping file of the older
+   * format. If the file has no tree, the tree is left empty.
+   *
+   * @param fd The descriptor of the book-keeping file.
+   * @param dim_num The number of dimensions.
+   * @param coords_size The size of the coordinates.
+   * @return TILEDB_RT_OK on success and TILEDB_RT_ERR on error.
+   */
+  int load(gzFile fd, int dim_num, size_t coords_size);
+
+
+
+
+ private:
+  /* ********************************* */
+  /*        PRIVATE ATTRIBUTES         */
+  /* ********************************* */
+
+  /** The number of dimensions. */
+  int dim_num_;
+  /** The number of children of each node. */
+  int fanout_;
+  /** 
+   * The node MBRs of each level above the leaves, stored contiguously per
+   * level, from the level right above the leaves up to the root. 
+   */
+  std::vector<void*> levels_;
+  /** The size of a node MBR. */
+  size_t mbr_size_;
+  /** The number of nodes of each level in levels_. */
+  std::vector<int64_t> node_nums_;
+
+
+
+
+  /* ********************************* */
+  /*          PRIVATE METHODS          */
+  /* ********************************* */
+
+  /** Frees the levels of the tree. */
+  void clear();
+};
+
+#endif
@@ -0,0 +1,249 @@
+/**
+ * @file   tile_cache.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2016 MIT and Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file defines class TileCache.
+ */
+
+#ifndef __TILE_CACHE_H__
+#define __TILE_CACHE_H__
+
+#include <inttypes.h>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+
+
+
+/**
+ * A process-wide, size-bounded LRU cache of decompressed tiles, shared by all
+ * the fragment read states. A tile is identified by its fragment name, its
+ * attribute id, its position in the fragment, and whether it is the
+ * variable-sized part of a variable-sized attribute tile. Fragments are
+ * immutable once written, so the cached tiles never become stale unless a
+ * fragment is deleted (see invalidate()).
+ */
+class TileCache {
+ public:
+  /* ********************************* */
+  /*          TYPE DEFINITIONS         */
+  /* ********************************* */
+
+  /** A tuple [fragment_name, attribute_id, tile_pos, var]. */
+  typedef std::tuple<std::string, int, int64_t, bool> TileKey;
+
+
+
+
+  /* ********************************* */
+  /*    CONSTRUCTORS & DESTRUCTORS     */
+  /* ********************************* */
+
+  /** Constructor. */
+  TileCache();
+
+  /** Destructor. */
+  ~TileCache();
+
+
+
+
+  /* ********************************* */
+  /*             ACCESSORS             */
+  /* ********************************* */
+
+  /** Returns the tile cache shared by the entire process. */
+  static TileCache* instance();
+
+  /** Returns the maximum size (in bytes) of the cached tiles. */
+  size_t capacity() const;
+
+  /**
+   * Checks if a tile is cached.
+   *
+   * @param fragment_name The name of the fragment the tile belongs to.
+   * @param attribute_id The id of the attribute the tile belongs to.
+   * @param tile_i The position of the tile in the fragment.
+   * @param var *true* if this is the tile with the actual variable-sized cell
+   *     values, and *false* otherwise.
+   * @return *true* if the tile is cached and *false* otherwise.
+   */
+  bool contains(
+      const std::string& fragment_name,
+      int attribute_id,
+      int64_t tile_i,
+      bool var) const;
+
+  /**
+   * Copies a cached tile into the input buffer, marking it as the most
+   * recently used one.
+   *
+   * @param fragment_name The name of the fragment the tile belongs to.
+   * @param attribute_id The id of the attribute the tile belongs to.
+   * @param tile_i The position of the tile in the fragment.
+   * @param var *true* if this is the tile with the actual variable-sized cell
+   *     values, and *false* otherwise.
+   * @param tile The buffer where the tile will be copied into.
+   * @param tile_size The expected size of the tile (in bytes).
+   * @return *true* if the tile was found in the cache (with the expected size)
+   *     and copied into *tile*, and *false* otherwise.
+   */
+  bool get(
+      const std::string& fragment_name,
+      int attribute_id,
+      int64_t tile_i,
+      bool var,
+      void* tile,
+      size_t tile_size);
+
+  /** Returns the current size (in bytes) of the cached tiles. */
+  size_t size() const;
+
+
+
+
+  /* ********************************* */
+  /*             MUTATORS              */
+  /* ********************************* */
+
+  /** Removes all the tiles from the cache. */
+  void clear();
+
+  /**
+   * Inserts a copy of a (decompressed) tile into the cache, evicting the least
+   * recently used tiles if the capacity is exceeded. Tiles larger than the
+   * capacity are not cached.
+   *
+   * @param fragment_name The name of the fragment the tile belongs to.
+   * @param attribute_id The id of the attribute the tile belongs to.
+   * @param tile_i The position of the tile in the fragment.
+   * @param var *true* if this is the tile with the actual variable-sized cell
+   *     values, and *false* otherwise.
+   * @param tile The tile to be cached.
+   * @param tile_size The size of the tile (in bytes).
+   * @return void
+   */
+  void insert(
+      const std::string& fragment_name,
+      int attribute_id,
+      int64_t tile_i,
+      bool var,
+      const void* tile,
+      size_t tile_size);
+
+  /**
+   * Removes all the cached tiles of the fragments contained in the input
+   * directory (or of the fragment with the input name). This must be invoked
+   * whenever fragments get deleted.
+   *
+   * @param dir A fragment or array directory.
+   * @return void
+   */
+  void invalidate(const std::string& dir);
+
+  /**
+   * Sets the maximum size (in bytes) of the cached tiles, evicting tiles if
+   * necessary. A zero capacity disables caching.
+   *
+   * @param capacity The new capacity.
+   * @return void
+   */
+  void set_capacity(size_t capacity);
+
+
+
+
+ private:
+  /* ********************************* */
+  /*          TYPE DEFINITIONS         */
+  /* ********************************* */
+
+  /** A cached tile. */
+  struct TileEntry {
+    /** The tile identifier. */
+    TileKey key_;
+    /** The tile buffer. */
+    void* tile_;
+    /** The tile size. */
+    size_t tile_size_;
+  };
+
+  /** The cached tiles, with the most recently used in the front. */
+  typedef std::list<TileEntry> TileList;
+
+  /** Maps each tile identifier to its position in the tile list. */
+  typedef std::map<TileKey, TileList::iterator> TileMap;
+
+
+
+
+  /* ********************************* */
+  /*        PRIVATE ATTRIBUTES         */
+  /* ********************************* */
+
+  /** The maximum size (in bytes) of the cached tiles. */
+  size_t capacity_;
+  /** Protects the cache from concurrent accesses. */
+  mutable std::mutex mtx_;
+  /** The current size (in bytes) of the cached tiles. */
+  size_t size_;
+  /** The cached tiles in LRU order. */
+  TileList tile_list_;
+  /** Index on the cached tiles. */
+  TileMap tile_map_;
+
+
+
+
+  /* ********************************* */
+  /*          PRIVATE METHODS          */
+  /* ********************************* */
+
+  /**
+   * Evicts the least recently used tiles until the cache size does not
+   * exceed the input size. The caller must hold the cache mutex.
+   *
+   * @param size The target cache size.
+   * @return void
+   */
+  void evict(size_t size);
+
+  /**
+   * Removes the cached tile at the input position of the tile list. The caller
+   * must hold the cache mutex.
+   *
+   * @param it The position of the tile in the tile list.
+   * @return void
+   */
+  void remove(TileList::iterator it);
+};
+
+#endif
@@ -0,0 +1,67 @@
+/**
+ * @file   rtree.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2016 MIT and Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file defines struct TileStats.
+ */
+
+#ifndef __TILE_STATS_H__
+#define __TILE_STATS_H__
+
+#include <inttypes.h>
+
+
+
+
+/** 
+ * The statistics of the values of a fixed-sized attribute in a tile (i.e., a
+ * zone map). The empty values (as well as the NaN values) are not taken into
+ * account. The minimum, maximum and sum are held as int64_t values for the
+ * integer and character attributes, and as double values for the real ones.
+ * The integer sum wraps around upon overflow.
+ */
+struct TileStats {
+  /** A statistic value, whose type depends on the attribute type. */
+  union Value {
+    /** The value of an integer or character attribute. */
+    int64_t int_;
+    /** The value of a real attribute. */
+    double real_;
+  };
+
+  /** The number of non-empty values in the tile. */
+  int64_t count_;
+  /** The minimum value (meaningful only if count_ is positive). */
+  Value min_;
+  /** The maximum value (meaningful only if count_ is positive). */
+  Value max_;
+  /** The sum of the values. */
+  Value sum_;
+};
+
+#endif
@@ -35,6 +35,7 @@
 
 #include "book_keeping.h"
 #include "fragment.h"
+#include "tile_stats.h"
 #include <vector>
 #include <iostream>
 
@@ -59,21 +60,6 @@ class BookKeeping;
 /** Stores the state necessary when writing cells to a fragment. */
 class WriteState {
  public:
-  /* ********************************* */
-  /*          TYPE DEFINITIONS         */
-  /* ********************************* */
-
-  /**@{*/
-  /** Custom comparator in cell sorting. */
-  template<typename T> class SmallerIdCol;
-  template<typename T> class SmallerIdRow;
-  template<class T> class SmallerCol;
-  template<class T> class SmallerRow;
-  /**@}*/
-
-
-
-
   /* ********************************* */
   /*     CONSTRUCTORS & DESTRUCTORS    */
   /* ********************************* */
@@ -142,6 +128,34 @@ class WriteState {
 
 
  private:
+  /* ********************************* */
+  /*          TYPE DEFINITIONS         */
+  /* ********************************* */
+
+  /** A full tile waiting to be compressed and appended to its file. */
+  struct PendingTile {
+    /** The id of the attribute the tile belongs to. */
+    int attribute_id_;
+    /** The uncompressed tile (NULL for an empty variable tile). */
+    void* tile_;
+    /** The compressed tile. */
+    void* tile_compressed_;
+    /** The size of the compressed tile (TILEDB_CP_ERR on failure). */
+    ssize_t tile_compressed_size_;
+    /** The size of the uncompressed tile. */
+    size_t tile_size_;
+    /** The statistics of the tile values (see has_tile_stats()). */
+    TileStats tile_stats_;
+    /**
+     * *true* if this is the tile with the actual variable-sized cell values,
+     * and *false* otherwise.
+     */
+    bool var_;
+  };
+
+
+
+
   /* ********************************* */
   /*         PRIVATE ATTRIBUTES        */
   /* ********************************* */
@@ -160,8 +174,20 @@ class WriteState {
   const Fragment* fragment_;
   /** The MBR of the tile currently being populated. */
   void* mbr_;
+  /** 
+   * The full tiles that await compression, in the order they must be appended
+   * to their attribute files.
+   */
+  std::vector<PendingTile> pending_tiles_;
+  /** The total size (in bytes) of the uncompressed pending tiles. */
+  size_t pending_tiles_size_;
   /** The number of cells written in the current tile for each attribute. */
   std::vector<int64_t> tile_cell_num_;
+  /** 
+   * The statistics of the current tile of each uncompressed fixed-sized 
+   * attribute (see update_tile_stats()). 
+   */
+  std::vector<TileStats> tile_stats_;
   /** Internal buffers used in the case of compression. */
   std::vector<void*> tiles_;
   /** Offsets to the internal variable tile buffers. */
@@ -173,10 +199,6 @@ class WriteState {
    * tiles. 
    */
   std::vector<size_t> tiles_var_sizes_;
-  /** Internal buffer used in the case of compression. */
-  void* tile_compressed_;
-  /** Allocated size for internal buffer used in the case of compression. */
-  size_t tile_compressed_allocated_size_;
   /** Offsets to the internal tile buffers used in compression. */
   std::vector<size_t> tile_offsets_;
 
@@ -188,8 +210,11 @@ class WriteState {
   /* ********************************* */
 
   /**
-   * Compresses the current tile for the input attribute, and writes (appends)
-   * it to its corresponding file on the disk.
+   * Schedules the current tile for the input attribute for compression and
+   * writing (appending) to its corresponding file on the disk. The tile is
+   * copied, so the caller may reuse its tile buffer immediately. The pending
+   * tiles are flushed with flush_pending_tiles() once their total size
+   * reaches TILEDB_COMPRESSION_BATCH_SIZE.
    *
    * @param attribute_id The id of the attribute whose tile is compressed and
    *     written.
@@ -198,8 +223,9 @@ class WriteState {
   int compress_and_write_tile(int attribute_id);
 
   /**
-   * Compresses the current variable-sized tile for the input attribute, and
-   * writes (appends) it to its corresponding file on the disk.
+   * Schedules the current variable-sized tile for the input attribute for
+   * compression and writing (appending) to its corresponding file on the disk.
+   * See compress_and_write_tile().
    *
    * @param attribute_id The id of the attribute whose tile is compressed and
    *     written.
@@ -207,6 +233,55 @@ class WriteState {
    */
   int compress_and_write_tile_var(int attribute_id);
 
+  /**
+   * Computes the statistics of the values of a tile.
+   *
+   * @param attribute_id The id of the attribute the tile belongs to.
+   * @param tile The tile.
+   * @param tile_size The size of the tile.
+   * @param tile_stats The tile statistics to be computed.
+   * @return void
+   */
+  void compute_tile_stats(
+      int attribute_id,
+      const void* tile,
+      size_t tile_size,
+      TileStats& tile_stats) const;
+
+  /**
+   * Computes the statistics of the values of a tile.
+   *
+   * @template T The attribute type.
+   * @param values The tile values.
+   * @param value_num The number of values.
+   * @param empty The empty value of the attribute type.
+   * @param tile_stats The tile statistics to be computed.
+   * @return void
+   */
+  template<class T>
+  void compute_tile_stats(
+      const T* values,
+      int64_t value_num,
+      T empty,
+      TileStats& tile_stats) const;
+
+  /**
+   * Enqueues a copy of a full tile to the pending tiles, flushing them if
+   * their total size reaches TILEDB_COMPRESSION_BATCH_SIZE.
+   *
+   * @param attribute_id The id of the attribute the tile belongs to.
+   * @param var *true* if this is the tile with the actual variable-sized cell
+   *     values, and *false* otherwise.
+   * @param tile The tile to be enqueued (NULL for an empty variable tile).
+   * @param tile_size The size of the tile.
+   * @return TILEDB_WS_OK on success and TILEDB_WS_ERR on error.
+   */
+  int enqueue_tile(
+      int attribute_id,
+      bool var,
+      const void* tile,
+      size_t tile_size);
+
   /**
    * Expands the current MBR with the input coordinates.
    *
@@ -217,6 +292,38 @@ class WriteState {
   template<class T>
   void expand_mbr(const T* coords);
 
+  /**
+   * Compresses all the pending tiles (computing the statistics of their
+   * values) in parallel and then appends them to
+   * their attribute files sequentially, in the order they were enqueued. This
+   * keeps the tile offsets recorded in the book-keeping structure consistent
+   * with the file layout.
+   *
+   * @return TILEDB_WS_OK on success and TILEDB_WS_ERR on error.
+   */
+  int flush_pending_tiles();
+
+  /** 
+   * Returns *true* if the statistics of the tiles of the input attribute are
+   * kept in the book-keeping, i.e., if it is a fixed-sized attribute other 
+   * than the coordinates. 
+   */
+  bool has_tile_stats(int attribute_id) const;
+
+  /**
+   * Merges the statistics of some values of a tile into the statistics of
+   * the tile.
+   *
+   * @param attribute_id The id of the attribute the tile belongs to.
+   * @param stats The statistics of the values to be merged.
+   * @param tile_stats The tile statistics to be updated.
+   * @return void
+   */
+  void merge_tile_stats(
+      int attribute_id,
+      const TileStats& stats,
+      TileStats& tile_stats) const;
+
   /**
    * Shifts the offsets of the variable-sized cells recorded in the input
    * buffer, so that they correspond to the actual offsets in the corresponding
@@ -256,7 +363,9 @@ class WriteState {
   /**
    * Sorts the input cell coordinates according to the order specified in the
    * array schema. This is not done in place; the sorted positions are stored
-   * in a separate vector.
+   * in a separate vector. The positions are radix-sorted on compact keys
+   * derived from each coordinate and from the tile (or Hilbert) ids, so that
+   * the coordinates are not accessed at random upon every comparison.
    * 
    * @template T The type of coordinates stored in *buffer*.
    * @param buffer The buffer holding the cell coordinates.
@@ -291,6 +400,22 @@ class WriteState {
   template<class T>
   void update_book_keeping(const void* buffer, size_t buffer_size);
 
+  /**
+   * Updates the statistics of the current tile of an uncompressed attribute
+   * with the input cells, appending them to the book-keeping every time the
+   * tile gets full (the compressed tiles get their statistics when they are
+   * flushed, see flush_pending_tiles()).
+   *
+   * @param attribute_id The id of the attribute the cells belong to.
+   * @param buffer The cells.
+   * @param buffer_size The size (in bytes) of *buffer*.
+   * @return void
+   */
+  void update_tile_stats(
+      int attribute_id,
+      const void* buffer,
+      size_t buffer_size);
+
   /**
    * Takes the appropriate actions for writing the very last tile of this write
    * operation, such as updating the book-keeping structures, and compressing
@@ -341,14 +466,14 @@ class WriteState {
 
   /**
    * Performs the write operation for the case of a dense fragment, focusing
-   * on a single fixed-sized attribute and the case of GZIP compression.
+   * on a single fixed-sized attribute and the case of compression.
    *
    * @param attribute_id The id of the attribute this operation focuses on.
    * @param buffer See write().
    * @param buffer_size See write().
    * @return TILEDB_WS_OK on success and TILEDB_WS_ERR on error.
    */
-  int write_dense_attr_cmp_gzip(
+  int write_dense_attr_cmp(
       int attribute_id,
       const void* buffer, 
       size_t buffer_size);
@@ -391,7 +516,7 @@ class WriteState {
 
   /**
    * Performs the write operation for the case of a dense fragment, focusing
-   * on a single variable-sized attribute and the case of GZIP compression.
+   * on a single variable-sized attribute and the case of compression.
    *
    * @param attribute_id The id of the attribute this operation focuses on.
    * @param buffer See write() - start offsets in *buffer_var*.
@@ -400,7 +525,7 @@ class WriteState {
    * @param buffer_size See write().
    * @return TILEDB_WS_OK on success and TILEDB_WS_ERR on error.
    */
-  int write_dense_attr_var_cmp_gzip(
+  int write_dense_attr_var_cmp(
       int attribute_id,
       const void* buffer, 
       size_t buffer_size,
@@ -448,14 +573,14 @@ class WriteState {
 
   /**
    * Performs the write operation for the case of a sparse fragment, focusing
-   * on a single fixed-sized attribute and the case of GZIP compression.
+   * on a single fixed-sized attribute and the case of compression.
    *
    * @param attribute_id The id of the attribute this operation focuses on.
    * @param buffer See write().
    * @param buffer_size See write().
    * @return TILEDB_WS_OK on success and TILEDB_WS_ERR on error.
    */
-  int write_sparse_attr_cmp_gzip(
+  int write_sparse_attr_cmp(
       int attribute_id,
       const void* buffer, 
       size_t buffer_size);
@@ -498,7 +623,7 @@ class WriteState {
 
   /**
    * Performs the write operation for the case of a sparse fragment, focusing
-   * on a single variable-sized attribute and the case of GZIP compression.
+   * on a single variable-sized attribute and the case of compression.
    *
    * @param attribute_id The id of the attribute this operation focuses on.
    * @param buffer See write() - start offsets in *buffer_var*.
@@ -507,7 +632,7 @@ class WriteState {
    * @param buffer_size See write().
    * @return TILEDB_WS_OK on success and TILEDB_WS_ERR on error.
    */
-  int write_sparse_attr_var_cmp_gzip(
+  int write_sparse_attr_var_cmp(
       int attribute_id,
       const void* buffer, 
       size_t buffer_size,
@@ -528,52 +653,21 @@ class WriteState {
 
   /**
    * Performs the write operation for the case of a sparse fragment when the 
-   * coordinates are unsorted, focusing on a single fixed-sized attribute.
-   *
-   * @param attribute_id The id of the attribute this operation focuses on.
-   * @param buffer See write().
-   * @param buffer_size See write().
-   * @param cell_pos The sorted positions of the cells.
-   * @return TILEDB_WS_OK on success and TILEDB_WS_ERR on error.
-   */
-  int write_sparse_unsorted_attr(
-      int attribute_id,
-      const void* buffer, 
-      size_t buffer_size,
-      const std::vector<int64_t>& cell_pos);
-
-  /**
-   * Performs the write operation for the case of a sparse fragment when the 
-   * coordinates are unsorted, focusing on a single fixed-sized attribute and
-   * the case of no compression.
-   *
-   * @param attribute_id The id of the attribute this operation focuses on.
-   * @param buffer See write().
-   * @param buffer_size See write().
-   * @param cell_pos The sorted positions of the cells.
-   * @return TILEDB_WS_OK on success and TILEDB_WS_ERR on error.
-   */
-  int write_sparse_unsorted_attr_cmp_none(
-      int attribute_id,
-      const void* buffer, 
-      size_t buffer_size,
-      const std::vector<int64_t>& cell_pos);
-
-  /**
-   * Performs the write operation for the case of a sparse fragment when the 
-   * coordinates are unsorted, focusing on a single fixed-sized attribute and
-   * the case of GZIP compression.
-   *
-   * @param attribute_id The id of the attribute this operation focuses on.
-   * @param buffer See write().
-   * @param buffer_size See write().
+   * coordinates are unsorted, focusing on the fixed-sized attributes. The
+   * cells of all these attributes are gathered in sorted order in batches
+   * that fit in a sorted buffer, with the cache-sized blocks of each batch
+   * gathered in parallel, and each batch is written attribute by attribute.
+   *
+   * @param attribute_ids The ids of the fixed-sized attributes.
+   * @param buffers The buffers of the attributes (see write()).
+   * @param buffer_sizes The sizes of the buffers of the attributes.
    * @param cell_pos The sorted positions of the cells.
    * @return TILEDB_WS_OK on success and TILEDB_WS_ERR on error.
    */
-  int write_sparse_unsorted_attr_cmp_gzip(
-      int attribute_id,
-      const void* buffer, 
-      size_t buffer_size,
+  int write_sparse_unsorted_attrs(
+      const std::vector<int>& attribute_ids,
+      const std::vector<const void*>& buffers, 
+      const std::vector<size_t>& buffer_sizes,
       const std::vector<int64_t>& cell_pos);
 
   /**
@@ -620,7 +714,7 @@ class WriteState {
   /**
    * Performs the write operation for the case of a sparse fragment when the 
    * coordinates are unsorted, focusing on a single variable-sized attribute and
-   * the case of GZIP compression.
+   * the case of compression.
    *
    * @param attribute_id The id of the attribute this operation focuses on.
    * @param buffer See write() - start offsets in *buffer_var*.
@@ -630,7 +724,7 @@ class WriteState {
    * @param cell_pos The sorted positions of the cells.
    * @return TILEDB_WS_OK on success and TILEDB_WS_ERR on error.
    */
-  int write_sparse_unsorted_attr_var_cmp_gzip(
+  int write_sparse_unsorted_attr_var_cmp(
       int attribute_id,
       const void* buffer, 
       size_t buffer_size,
@@ -639,197 +733,4 @@ class WriteState {
       const std::vector<int64_t>& cell_pos);
 };
 
-/** 
- * Wrapper of comparison function for sorting cells; first by the smallest id,
- * and then by column-major order of coordinates. 
- */
-template<class T>
-class WriteState::SmallerIdCol {
- public:
-  /** 
-   * Constructor. 
-   * 
-   * @param buffer The buffer containing the cells to be sorted.
-   * @param dim_num The number of dimensions of the cells.
-   * @param ids The ids of the cells in the buffer.
-   */
-  SmallerIdCol(const T* buffer, int dim_num, const std::vector<int64_t>& ids) 
-      : buffer_(buffer),
-        dim_num_(dim_num),
-        ids_(ids) { }
-
-  /**
-   * Comparison operator. 
-   *
-   * @param a The first cell position in the cell buffer.
-   * @param b The second cell position in the cell buffer.
-   */
-  bool operator () (int64_t a, int64_t b) {
-    if(ids_[a] < ids_[b])
-      return true;
-
-    if(ids_[a] > ids_[b])
-      return false;
-
-    // a.id_ == b.id_ --> check coordinates
-    const T* coords_a = &buffer_[a * dim_num_];
-    const T* coords_b = &buffer_[b * dim_num_];
-
-    for(int i=dim_num_-1; i>=0; --i) 
-      if(coords_a[i] < coords_b[i]) 
-        return true;
-      else if(coords_a[i] > coords_b[i]) 
-        return false;
-      // else coords_a[i] == coords_b[i] --> continue
-
-    return false;
-  }
-
- private:
-  /** Cell buffer. */
-  const T* buffer_;
-  /** Number of dimensions. */
-  int dim_num_;
-  /** The cell ids. */
-  const std::vector<int64_t>& ids_;
-};
-
-/** 
- * Wrapper of comparison function for sorting cells; first by the smallest id,
- * and then by row-major order of coordinates. 
- */
-template<class T>
-class WriteState::SmallerIdRow {
- public:
-  /** 
-   * Constructor. 
-   * 
-   * @param buffer The buffer containing the cells to be sorted.
-   * @param dim_num The number of dimensions of the cells.
-   * @param ids The ids of the cells in the buffer.
-   */
-  SmallerIdRow(const T* buffer, int dim_num, const std::vector<int64_t>& ids) 
-      : buffer_(buffer),
-        dim_num_(dim_num),
-        ids_(ids) { }
-
-  /**
-   * Comparison operator. 
-   *
-   * @param a The first cell position in the cell buffer.
-   * @param b The second cell position in the cell buffer.
-   */
-  bool operator () (int64_t a, int64_t b) {
-    if(ids_[a] < ids_[b])
-      return true;
-
-    if(ids_[a] > ids_[b])
-      return false;
-
-    // a.id_ == b.id_ --> check coordinates
-    const T* coords_a = &buffer_[a * dim_num_];
-    const T* coords_b = &buffer_[b * dim_num_];
-
-    for(int i=0; i<dim_num_; ++i) { 
-      if(coords_a[i] < coords_b[i]) 
-        return true;
-      else if(coords_a[i] > coords_b[i]) 
-        return false;
-      // else coords_a[i] == coords_b[i] --> continue
-    }
-
-    return false;
-  }
-
- private:
-  /** Cell buffer. */
-  const T* buffer_;
-  /** Number of dimensions. */
-  int dim_num_;
-  /** The cell ids. */
-  const std::vector<int64_t>& ids_;
-};
-
-/** Wrapper of comparison function for sorting cells on column-major order. */
-template<class T>
-class WriteState::SmallerCol {
- public:
-  /** 
-   * Constructor. 
-   * 
-   * @param buffer The buffer containing the cells to be sorted.
-   * @param dim_num The number of dimensions of the cells.
-   */
-  SmallerCol(const T* buffer, int dim_num) 
-      : buffer_(buffer),
-        dim_num_(dim_num) { }
-
-  /**
-   * Comparison operator. 
-   *
-   * @param a The first cell position in the cell buffer.
-   * @param b The second cell position in the cell buffer.
-   */
-  bool operator () (int64_t a, int64_t b) {
-    const T* coords_a = &buffer_[a * dim_num_];
-    const T* coords_b = &buffer_[b * dim_num_];
-
-    for(int i=dim_num_-1; i>=0; --i) 
-      if(coords_a[i] < coords_b[i]) 
-        return true;
-      else if(coords_a[i] > coords_b[i]) 
-        return false;
-      // else coords_a[i] == coords_b[i] --> continue
-
-    return false;
-  }
-
- private:
-  /** Cell buffer. */
-  const T* buffer_;
-  /** Number of dimensions. */
-  int dim_num_;
-};
-
-/** Wrapper of comparison function for sorting cells on row-major order. */
-template<class T>
-class WriteState::SmallerRow {
- public:
-  /** 
-   * Constructor. 
-   * 
-   * @param buffer The buffer containing the cells to be sorted.
-   * @param dim_num The number of dimensions of the cells.
-   */
-  SmallerRow(const T* buffer, int dim_num) 
-      : buffer_(buffer),
-        dim_num_(dim_num) { }
-
-  /**
-   * Comparison operator. 
-   *
-   * @param a The first cell position in the cell buffer.
-   * @param b The second cell position in the cell buffer.
-   */
-  bool operator () (int64_t a, int64_t b) {
-    const T* coords_a = &buffer_[a * dim_num_];
-    const T* coords_b = &buffer_[b * dim_num_];
-
-    for(int i=0; i<dim_num_; ++i) 
-      if(coords_a[i] < coords_b[i]) 
-        return true;
-      else if(coords_a[i] > coords_b[i]) 
-        return false;
-      // else coords_a[i] == coords_b[i] --> continue
-
-    return false;
-  }
-
- private:
-  /** Cell buffer. */
-  const T* buffer_;
-  /** Number of dimensions. */
-  int dim_num_;
-};
-
 #endif
@@ -117,11 +117,15 @@ class Metadata {
   /* ********************************* */
 
   /**
-   * Consolidates the fragments of a metadata object into a single fragment. 
+   * Consolidates fragments of a metadata object into a single fragment
+   * (see Array::consolidate()).
    * 
+   * @param policy The policy that selects the fragments to be merged.
+   * @param buffer_size The total size of the buffers used during 
+   *     consolidation.
    * @return TILEDB_MT_OK on success, and TILEDB_MT_ERR on error.
    */
-  int consolidate();
+  int consolidate(const ConsolidationPolicy* policy, size_t buffer_size);
 
   /**
    * Finalizes the metadata, properly freeing up the memory space.
@@ -142,13 +146,16 @@ class Metadata {
    *     the key as an extra attribute in the end).
    * @param attribute_num The number of the input attributes. If *attributes* is
    *     NULL, then this should be set to 0.
+   * @param config The configuration parameters of the underlying array. If it
+   *     is NULL, the default parameters are used.
    * @return TILEDB_MT_OK on success, and TILEDB_MT_ERR on error.
    */
   int init(
       const ArraySchema* array_schema, 
       int mode,
       const char** attributes,
-      int attribute_num);
+      int attribute_num,
+      const Config* config);
 
   /**
    * Resets the attributes used upon initialization of the metadata. 
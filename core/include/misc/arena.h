@@ -0,0 +1,97 @@
+/**
+ * @file   arena.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2016 MIT and Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file defines class Arena.
+ */
+
+
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <cstddef>
+#include <vector>
+
+
+
+
+/**
+ * A bump allocator for many small, short-lived objects that are released
+ * together (e.g., the cell ranges computed in a read round). The objects are
+ * carved contiguously out of large blocks, and reset() recycles all of them
+ * at once, keeping the blocks for the subsequent allocations.
+ */
+class Arena {
+ public:
+  /* ********************************* */
+  /*    CONSTRUCTORS & DESTRUCTORS     */
+  /* ********************************* */
+
+  /** Constructor. */
+  Arena();
+
+
+
+
+  /* ********************************* */
+  /*             MUTATORS              */
+  /* ********************************* */
+
+  /**
+   * Allocates space for an object, aligned for any fixed-sized TileDB type.
+   * The space is valid until the next reset().
+   *
+   * @param size The size (in bytes) of the object.
+   * @return The allocated space.
+   */
+  void* allocate(size_t size);
+
+  /** 
+   * Releases all the allocated objects at once. 
+   *
+   * @return void
+   */
+  void reset();
+
+
+
+
+ private:
+  /* ********************************* */
+  /*        PRIVATE ATTRIBUTES         */
+  /* ********************************* */
+
+  /** The index of the block the objects are currently allocated from. */
+  int block_;
+  /** The memory blocks, allocated upon demand and kept across resets. */
+  std::vector<std::vector<char> > blocks_;
+  /** The offset of the free space in the current block. */
+  size_t offset_;
+};
+
+#endif
@@ -0,0 +1,277 @@
+/**
+ * @file   compressor.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2016 MIT and Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * @section DESCRIPTION
+ *
+ * This file defines class Compressor and the supported codecs.
+ */
+
+#ifndef __COMPRESSOR_H__
+#define __COMPRESSOR_H__
+
+#include <sys/types.h>
+#include <vector>
+
+
+
+
+/* ********************************* */
+/*             CONSTANTS             */
+/* ********************************* */
+
+/**@{*/
+/** Return code. */
+#define TILEDB_CP_OK         0
+#define TILEDB_CP_ERR       -1
+/**@}*/
+
+
+
+
+/**
+ * The interface of a tile codec. Each codec is registered under a compression
+ * type constant (e.g., TILEDB_GZIP) and is retrieved with get(). Codecs are
+ * stateless, so a single instance is shared by all threads.
+ */
+class Compressor {
+ public:
+  /* ********************************* */
+  /*    CONSTRUCTORS & DESTRUCTORS     */
+  /* ********************************* */
+
+  /** Destructor. */
+  virtual ~Compressor();
+
+
+
+
+  /* ********************************* */
+  /*             ACCESSORS             */
+  /* ********************************* */
+
+  /**
+   * Returns the codec registered for the input compression type.
+   *
+   * @param compression The compression type (e.g., TILEDB_GZIP).
+   * @return The codec, or NULL if the compression type is TILEDB_NO_COMPRESSION
+   *     or its codec is not supported by this build.
+   */
+  static const Compressor* get(int compression);
+
+  /**
+   * Returns the highest compression level accepted by any of the codecs
+   * supported by this build.
+   *
+   * @return The maximum compression level.
+   */
+  static int max_supported_level();
+
+  /**
+   * Returns the maximum size of the compressed form of a buffer.
+   *
+   * @param in_size The size of the uncompressed buffer.
+   * @return The maximum compressed size.
+   */
+  virtual size_t compress_bound(size_t in_size) const = 0;
+
+  /**
+   * Returns the highest compression level the codec accepts. Levels range
+   * from 1 to this value, whereas 0 selects the codec default.
+   *
+   * @return The maximum compression level.
+   */
+  virtual int max_level() const = 0;
+
+  /**
+   * Compresses the input buffer into the output buffer.
+   *
+   * @param level The compression level (0 selects the codec default).
+   * @param type_size The size of the values stored in the input buffer. Codecs
+   *     that reorganize the bytes of the values (e.g., shuffling) use it.
+   * @param in The input buffer.
+   * @param in_size The size of the input buffer.
+   * @param out The output buffer.
+   * @param out_size The available size in the output buffer. It must be at
+   *     least compress_bound(in_size).
+   * @return The size of compressed data on success, and TILEDB_CP_ERR on error.
+   */
+  virtual ssize_t compress(
+      int level,
+      size_t type_size,
+      const void* in,
+      size_t in_size,
+      void* out,
+      size_t out_size) const = 0;
+
+  /**
+   * Decompresses the input buffer into the output buffer.
+   *
+   * @param type_size The size of the values stored in the uncompressed buffer.
+   *     It must be the same as the one used in compression.
+   * @param in The input buffer.
+   * @param in_size The size of the input buffer.
+   * @param out The output buffer.
+   * @param avail_out The available size in the output buffer.
+   * @param out_size The size of the decompressed data.
+   * @return TILEDB_CP_OK on success and TILEDB_CP_ERR on error.
+   */
+  virtual int decompress(
+      size_t type_size,
+      const void* in,
+      size_t in_size,
+      void* out,
+      size_t avail_out,
+      size_t& out_size) const = 0;
+};
+
+/** GZIP (zlib) codec. Levels range from 1 (fastest) to 9 (best ratio). */
+class GzipCompressor : public Compressor {
+ public:
+  size_t compress_bound(size_t in_size) const;
+  int max_level() const;
+  ssize_t compress(
+      int level,
+      size_t type_size,
+      const void* in,
+      size_t in_size,
+      void* out,
+      size_t out_size) const;
+  int decompress(
+      size_t type_size,
+      const void* in,
+      size_t in_size,
+      void* out,
+      size_t avail_out,
+      size_t& out_size) const;
+};
+
+#ifdef HAVE_LZ4
+/** 
+ * LZ4 codec, optimized for decompression speed. The level is used as the
+ * LZ4 acceleration factor (higher is faster, with a lower ratio).
+ */
+class LZ4Compressor : public Compressor {
+ public:
+  size_t compress_bound(size_t in_size) const;
+  int max_level() const;
+  ssize_t compress(
+      int level,
+      size_t type_size,
+      const void* in,
+      size_t in_size,
+      void* out,
+      size_t out_size) const;
+  int decompress(
+      size_t type_size,
+      const void* in,
+      size_t in_size,
+      void* out,
+      size_t avail_out,
+      size_t& out_size) const;
+};
+
+/**
+ * Byte-shuffle followed by LZ4. The bytes of the values are regrouped by
+ * significance before compression, which makes numeric tiles with slowly
+ * changing values (e.g., coordinates) far more compressible.
+ */
+class ShuffleLZ4Compressor : public Compressor {
+ public:
+  size_t compress_bound(size_t in_size) const;
+  int max_level() const;
+  ssize_t compress(
+      int level,
+      size_t type_size,
+      const void* in,
+      size_t in_size,
+      void* out,
+      size_t out_size) const;
+  int decompress(
+      size_t type_size,
+      const void* in,
+      size_t in_size,
+      void* out,
+      size_t avail_out,
+      size_t& out_size) const;
+};
+#endif
+
+#ifdef HAVE_ZSTD
+/** Zstandard codec. Levels range from 1 (fastest) to 22 (best ratio). */
+class ZstdCompressor : public Compressor {
+ public:
+  size_t compress_bound(size_t in_size) const;
+  int max_level() const;
+  ssize_t compress(
+      int level,
+      size_t type_size,
+      const void* in,
+      size_t in_size,
+      void* out,
+      size_t out_size) const;
+  int decompress(
+      size_t type_size,
+      const void* in,
+      size_t in_size,
+      void* out,
+      size_t avail_out,
+      size_t& out_size) const;
+};
+#endif
+
+
+
+
+/* ********************************* */
+/*             FUNCTIONS             */
+/* ********************************* */
+
+/**
+ * Groups the bytes of the input values by significance, i.e., it stores the
+ * first byte of every value, then the second byte of every value, etc. Any
+ * trailing bytes that do not form a full value are copied as is.
+ *
+ * @param type_size The size of each value.
+ * @param in The input buffer.
+ * @param size The size of the input (and output) buffer.
+ * @param out The output buffer.
+ * @return void
+ */
+void byte_shuffle(size_t type_size, const void* in, size_t size, void* out);
+
+/**
+ * Reverses byte_shuffle().
+ *
+ * @param type_size The size of each value.
+ * @param in The shuffled input buffer.
+ * @param size The size of the input (and output) buffer.
+ * @param out The output buffer.
+ * @return void
+ */
+void byte_unshuffle(size_t type_size, const void* in, size_t size, void* out);
+
+#endif
@@ -0,0 +1,188 @@
+/**
+ * @file   config.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2016 MIT and Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file defines class Config.
+ */
+
+
+#ifndef __CONFIG_H__
+#define __CONFIG_H__
+
+#include <string>
+
+
+
+
+/* ********************************* */
+/*             CONSTANTS             */
+/* ********************************* */
+
+/**@{*/
+/** Return code. */
+#define TILEDB_CF_OK                                 0
+#define TILEDB_CF_ERR                               -1
+/**@}*/
+
+/** 
+ * Configuration parameter for the compression level of the attributes whose
+ * schema sets none (0 lets each compressor pick its own default). It is
+ * checked against the codec of each such attribute when a fragment is
+ * written (see Compressor::max_level()).
+ */
+#define TILEDB_CF_COMPRESSION_LEVEL          "compression_level"
+
+/** 
+ * Configuration parameter for the I/O mode in which the tiles are read from
+ * the fragment files, *read* (pread) or *mmap*.
+ */
+#define TILEDB_CF_IO_MODE                              "io_mode"
+
+/** 
+ * Configuration parameter for the size (in bytes) of the buffers through
+ * which the cells of unsorted writes are sorted.
+ */
+#define TILEDB_CF_SORTED_BUFFER_SIZE        "sorted_buffer_size"
+
+/** 
+ * Configuration parameter for the number of threads running the parallel
+ * loops of array reads and writes (0 uses the OpenMP default).
+ */
+#define TILEDB_CF_THREAD_NUM                        "thread_num"
+
+/** 
+ * Configuration parameter for the total size (in bytes) of the buffers
+ * through which the sorted runs of unsorted writes are merged (see 
+ * Array::write()). A zero value disables the runs.
+ */
+#define TILEDB_CF_UNSORTED_MERGE_BUFFER_SIZE \
+    "unsorted_merge_buffer_size"
+
+
+
+
+/** 
+ * The configuration parameters that tune the reads and writes of a single
+ * array. The storage manager keeps the parameters of its context, possibly
+ * overridden for specific arrays, and hands a copy to every array it
+ * initializes.
+ */
+class Config {
+ public:
+  /* ********************************* */
+  /*    CONSTRUCTORS & DESTRUCTORS     */
+  /* ********************************* */
+
+  /** Constructor. All the parameters take their default values. */
+  Config();
+
+
+
+
+  /* ********************************* */
+  /*             ACCESSORS             */
+  /* ********************************* */
+
+  /** 
+   * Returns the compression level used for the attributes whose schema sets
+   * none.
+   */
+  int compression_level() const;
+
+  /** 
+   * Checks if the input is the name of a parameter kept by Config.
+   *
+   * @param parameter The parameter name.
+   * @return *true* if the parameter is kept by Config. 
+   */
+  static bool has_parameter(const std::string& parameter);
+
+  /** Returns the I/O mode, TILEDB_IO_READ or TILEDB_IO_MMAP. */
+  int io_mode() const;
+
+  /** Returns the size of the buffers used for sorting unsorted writes. */
+  size_t sorted_buffer_size() const;
+
+  /** 
+   * Returns the number of threads of the parallel loops, resolving the
+   * OpenMP default (it is always at least 1).
+   */
+  int thread_num() const;
+
+  /** 
+   * Returns the total size of the buffers through which the sorted runs of
+   * unsorted writes are merged (0 if the runs are disabled).
+   */
+  size_t unsorted_merge_buffer_size() const;
+
+
+
+
+  /* ********************************* */
+  /*             MUTATORS              */
+  /* ********************************* */
+
+  /** 
+   * Sets a parameter from its textual value.
+   *
+   * @param parameter The parameter name. It must be one of the TILEDB_CF_*
+   *     parameters.
+   * @param value The parameter value.
+   * @return TILEDB_CF_OK for success and TILEDB_CF_ERR for error (unknown
+   *     parameter or invalid value).
+   */
+  int set(const std::string& parameter, const std::string& value);
+
+  /** 
+   * Sets all the parameters to their default values. 
+   *
+   * @return void
+   */
+  void set_default();
+
+
+
+
+ private:
+  /* ********************************* */
+  /*        PRIVATE ATTRIBUTES         */
+  /* ********************************* */
+
+  /** The compression level of the attributes whose schema sets none. */
+  int compression_level_;
+  /** The I/O mode, TILEDB_IO_READ or TILEDB_IO_MMAP. */
+  int io_mode_;
+  /** The size of the buffers used for sorting unsorted writes. */
+  size_t sorted_buffer_size_;
+  /** The number of threads of the parallel loops (0 for the default). */
+  int thread_num_;
+  /** The total size of the buffers merging the runs of unsorted writes. */
+  size_t unsorted_merge_buffer_size_;
+};
+
+#endif
@@ -0,0 +1,228 @@
+/**
+ * @file   filter.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2016 MIT and Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file defines class FilterPipeline.
+ */
+
+#ifndef __FILTER_H__
+#define __FILTER_H__
+
+#include <sys/types.h>
+#include <vector>
+
+
+
+
+/* ********************************* */
+/*             CONSTANTS             */
+/* ********************************* */
+
+/**@{*/
+/** Return code. */
+#define TILEDB_FL_OK         0
+#define TILEDB_FL_ERR       -1
+/**@}*/
+
+
+
+
+/**
+ * A chain of reversible filters that transforms a tile before compression, so
+ * that the codec finds more redundancy in it. The values of the tile are
+ * treated as unsigned integers of the attribute type size (wrapping around on
+ * overflow), which makes every filter exactly reversible for all types. The
+ * supported filters are:
+ *    - TILEDB_FILTER_DELTA: Replaces each value with its difference from the
+ *      value at the same position of the previous cell.
+ *    - TILEDB_FILTER_DOUBLE_DELTA: Replaces each value with the difference of
+ *      its delta from the previous delta.
+ *    - TILEDB_FILTER_BYTE_SHUFFLE: Groups the bytes of the values by
+ *      significance.
+ *    - TILEDB_FILTER_BIT_SHUFFLE: Groups the bits of the values by
+ *      significance.
+ *    - TILEDB_FILTER_BIT_PACKING: Frame-of-reference bit-packing, i.e., it
+ *      stores the minimum value followed by the differences of all values from
+ *      it, using only as many bits as the largest difference needs. It is the
+ *      only filter that changes the tile size, and it can appear at most once
+ *      in a chain.
+ */
+class FilterPipeline {
+ public:
+  /* ********************************* */
+  /*    CONSTRUCTORS & DESTRUCTORS     */
+  /* ********************************* */
+
+  /**
+   * Constructor.
+   *
+   * @param filters The filter chain, encoded as in the bits above
+   *     TILEDB_FILTER_SHIFT of an attribute compression (see TILEDB_FILTER()),
+   *     shifted down by TILEDB_FILTER_SHIFT.
+   * @param type_size The size of the values stored in the tiles.
+   * @param stride The number of values per cell. The delta filters compute
+   *     the differences between the values at the same position of
+   *     consecutive cells (e.g., between the same coordinate of consecutive
+   *     cells).
+   */
+  FilterPipeline(int filters, size_t type_size, int stride);
+
+
+
+
+  /* ********************************* */
+  /*             ACCESSORS             */
+  /* ********************************* */
+
+  /** Returns *true* if the chain has no filters. */
+  bool empty() const;
+
+  /**
+   * Applies the filter chain to a tile.
+   *
+   * @param tile The tile to be filtered.
+   * @param tile_size The size of the tile.
+   * @param out The output buffer.
+   * @param out_size The available size in the output buffer. It must be at
+   *     least filter_bound(tile_size).
+   * @return The size of the filtered tile on success, and TILEDB_FL_ERR on
+   *     error.
+   */
+  ssize_t filter(
+      const void* tile,
+      size_t tile_size,
+      void* out,
+      size_t out_size) const;
+
+  /**
+   * Returns the maximum size of the filtered form of a tile.
+   *
+   * @param tile_size The size of the tile.
+   * @return The maximum size of the filtered tile.
+   */
+  size_t filter_bound(size_t tile_size) const;
+
+  /**
+   * Reverses the filter chain.
+   *
+   * @param in The filtered tile.
+   * @param in_size The size of the filtered tile.
+   * @param tile The buffer where the original tile will be stored.
+   * @param tile_size The size of the original tile.
+   * @return TILEDB_FL_OK on success and TILEDB_FL_ERR on error.
+   */
+  int unfilter(
+      const void* in,
+      size_t in_size,
+      void* tile,
+      size_t tile_size) const;
+
+  /**
+   * Checks if a filter chain is valid, i.e., if it consists of known filters
+   * and has at most one TILEDB_FILTER_BIT_PACKING.
+   *
+   * @param filters The filter chain (see FilterPipeline()).
+   * @return *true* if the chain is valid and *false* otherwise.
+   */
+  static bool valid(int filters);
+
+
+
+
+ private:
+  /* ********************************* */
+  /*        PRIVATE ATTRIBUTES         */
+  /* ********************************* */
+
+  /** The filters in the order they are applied. */
+  std::vector<int> filters_;
+  /** The number of values per cell. */
+  int stride_;
+  /** The size of the values stored in the tiles. */
+  size_t type_size_;
+
+
+
+
+  /* ********************************* */
+  /*          PRIVATE METHODS          */
+  /* ********************************* */
+
+  /**
+   * Applies a single filter.
+   *
+   * @param filter The filter.
+   * @param in The input buffer.
+   * @param in_size The size of the input buffer.
+   * @param out The output buffer, of size at least filter_bound(in_size).
+   * @return The size of the output.
+   */
+  size_t apply_filter(
+      int filter,
+      const void* in,
+      size_t in_size,
+      void* out) const;
+
+  /** Applies a single filter on values of type T. */
+  template<class T>
+  size_t apply_filter(
+      int filter,
+      const void* in,
+      size_t in_size,
+      void* out,
+      int stride) const;
+
+  /**
+   * Reverses a single filter.
+   *
+   * @param filter The filter.
+   * @param in The input buffer.
+   * @param in_size The size of the input buffer.
+   * @param out The output buffer.
+   * @param out_size The size of the output.
+   * @return TILEDB_FL_OK on success and TILEDB_FL_ERR on error.
+   */
+  int reverse_filter(
+      int filter,
+      const void* in,
+      size_t in_size,
+      void* out,
+      size_t out_size) const;
+
+  /** Reverses a single filter on values of type T. */
+  template<class T>
+  int reverse_filter(
+      int filter,
+      const void* in,
+      size_t in_size,
+      void* out,
+      size_t out_size,
+      int stride) const;
+};
+
+#endif
@@ -163,8 +163,6 @@ class HilbertCurve {
   int bits_;
   /** Number of dimensions. */	
   int dim_num_;
-  /** Temporary buffer. */
-  int temp_[HC_MAX_DIM];
 
 
 
@@ -0,0 +1,114 @@
+/**
+ * @file   thread_pool.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2016 MIT and Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file defines class ThreadPool.
+ */
+
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+
+
+/**
+ * A fixed-size pool of worker threads executing tasks in FIFO order. The
+ * threads are spawned upon the first scheduled task, so that a pool that is
+ * never used costs nothing.
+ */
+class ThreadPool {
+ public:
+  /* ********************************* */
+  /*    CONSTRUCTORS & DESTRUCTORS     */
+  /* ********************************* */
+
+  /**
+   * Constructor.
+   *
+   * @param thread_num The number of worker threads (at least one is used).
+   */
+  ThreadPool(int thread_num);
+
+  /** Destructor. It waits for all the scheduled tasks to complete. */
+  ~ThreadPool();
+
+
+
+
+  /* ********************************* */
+  /*             MUTATORS              */
+  /* ********************************* */
+
+  /**
+   * Schedules a task for execution by some worker thread.
+   *
+   * @param task The task to be executed.
+   * @return void
+   */
+  void schedule(const std::function<void()>& task);
+
+
+
+
+ private:
+  /* ********************************* */
+  /*        PRIVATE ATTRIBUTES         */
+  /* ********************************* */
+
+  /** Signals the workers that a task is pending or the pool is stopping. */
+  std::condition_variable cv_;
+  /** Protects the task queue and the stop flag. */
+  std::mutex mtx_;
+  /** *true* when the pool is being destroyed. */
+  bool stop_;
+  /** The pending tasks. */
+  std::deque<std::function<void()> > tasks_;
+  /** The number of worker threads. */
+  int thread_num_;
+  /** The worker threads. */
+  std::vector<std::thread> threads_;
+
+
+
+
+  /* ********************************* */
+  /*          PRIVATE METHODS          */
+  /* ********************************* */
+
+  /** The loop each worker thread runs, executing tasks until stopped. */
+  void worker();
+};
+
+#endif
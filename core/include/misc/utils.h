@@ -33,6 +33,7 @@
 #ifndef __UTILS_H__
 #define __UTILS_H__
 
+#include <stdint.h>
 #include <string>
 #include <vector>
 
@@ -247,6 +248,42 @@ void expand_mbr(T* mbr, const T* coords, int dim_num);
  */
 off_t file_size(const std::string& filename);
 
+/**
+ * Writes the input value to the first *value_num* positions of the input
+ * buffer. The loop is specialized on the value type, so that the compiler
+ * emits wide (broadcast) stores instead of one copy per value.
+ *
+ * @template T The type of the values.
+ * @param buffer The buffer to be filled.
+ * @param value The value to be written.
+ * @param value_num The number of values to be written.
+ * @return void
+ */
+template<class T>
+void fill_values(T* buffer, T value, int64_t value_num);
+
+/**
+ * Copies the cells of a buffer to another buffer in the order of the input
+ * cell positions, i.e., the i-th cell copied is the one at position 
+ * *cell_pos[i]* of the input buffer. Cells of 4, 8 and 16 bytes are copied
+ * with fixed-size copies, which compile to single moves, without requiring
+ * the buffers to be aligned.
+ *
+ * @param cells The input cells.
+ * @param cell_size The size (in bytes) of each cell.
+ * @param cell_pos The positions of the cells to be copied.
+ * @param cell_num The number of cells to be copied.
+ * @param sorted_cells The buffer where the cells are copied, which must hold 
+ *     *cell_num* cells.
+ * @return void
+ */
+void gather_cells(
+    const void* cells,
+    size_t cell_size,
+    const int64_t* cell_pos,
+    int64_t cell_num,
+    void* sorted_cells);
+
 /** Returns the names of the directories inside the input directory. */
 std::vector<std::string> get_dirs(const std::string& dir);
 
@@ -261,13 +298,15 @@ std::vector<std::string> get_fragment_dirs(const std::string& dir);
  * @param in_size The size of the input buffer.
  * @param out The output buffer.
  * @param avail_out_size The available size in the output buffer.
+ * @param level The zlib compression level.
  * @return The size of compressed data on success, and TILEDB_UT_ERR on error.
  */
 ssize_t gzip(
     unsigned char* in, 
     size_t in_size, 
     unsigned char* out, 
-    size_t out_size);
+    size_t out_size,
+    int level);
 
 /** 
  * Decompresses the GZIPed input buffer and stores the result in the output 
@@ -384,6 +423,18 @@ bool is_unary_subarray(const T* subarray, int dim_num);
  */
 bool is_workspace(const std::string& dir);
 
+/**
+ * Checks if two subarrays overlap.
+ *
+ * @template T The subarray type.
+ * @param subarray_a The first subarray.
+ * @param subarray_b The second subarray.
+ * @param dim_num The number of dimensions of the subarrays.
+ * @return *true* if the subarrays have common cells, and *false* otherwise.
+ */
+template<class T>
+bool overlap(const T* subarray_a, const T* subarray_b, int dim_num);
+
 /** 
  * Returns the parent directory of the input directory. 
  *
@@ -405,6 +456,35 @@ std::string parent_dir(const std::string& dir);
  */
 void purge_dots_from_path(std::string& path);
 
+/**
+ * Maps a value to an unsigned integer key, such that the keys of any two
+ * values compare in the same way as the values themselves. This allows
+ * sorting values of any type with radix_sort().
+ *
+ * @template T The value type.
+ * @param value The input value.
+ * @return The order-preserving key of the value.
+ */
+template<class T>
+uint64_t radix_key(T value);
+
+/**
+ * Sorts the input keys in ascending order with a (stable) LSD radix sort,
+ * permuting the input values along with them. Only the bytes in which the
+ * keys differ from their minimum are sorted on, and the passes are
+ * parallelized over chunks of the input.
+ *
+ * @param keys The keys to be sorted.
+ * @param values The values attached to the keys, which must be as many as the
+ *     keys.
+ * @param thread_num The maximum number of threads sorting the chunks.
+ * @return void
+ */
+void radix_sort(
+    std::vector<uint64_t>& keys, 
+    std::vector<int64_t>& values,
+    int thread_num);
+
 /**
  * Reads data from a file into a buffer.
  *
@@ -37,10 +37,15 @@
 #include "array_iterator.h"
 #include "array_schema.h"
 #include "array_schema_c.h"
+#include "config.h"
 #include "metadata.h"
 #include "metadata_iterator.h"
 #include "metadata_schema_c.h"
+#include "thread_pool.h"
+#include <map>
 #include <string>
+#include <utility>
+#include <vector>
 
 /* ********************************* */
 /*             CONSTANTS             */
@@ -55,6 +60,48 @@
 /** Name of the master catalog. */
 #define TILEDB_SM_MASTER_CATALOG      "master_catalog"
 
+/** 
+ * Configuration parameter for the maximum size (in bytes) of the tile cache
+ * shared by all array reads in the process. Setting it in any context 
+ * changes it for all the contexts of the process.
+ */
+#define TILEDB_SM_CONFIG_TILE_CACHE_SIZE    "tile_cache_size"
+
+/** 
+ * Configuration parameter for the maximum number of array schemas, as well as
+ * of fragment book-keeping structures, kept cached by the process while no
+ * array uses them. Setting it in any context changes it for all the contexts
+ * of the process.
+ */
+#define TILEDB_SM_CONFIG_ARRAY_METADATA_CACHE_SIZE "array_metadata_cache_size"
+
+/** 
+ * Configuration parameter for the number of threads serving the asynchronous
+ * reads of a context.
+ */
+#define TILEDB_SM_CONFIG_AIO_THREAD_NUM      "aio_thread_num"
+
+/** 
+ * Configuration parameter for the total size (in bytes) of the buffers
+ * through which the cells of all the attributes are copied during
+ * consolidation.
+ */
+#define TILEDB_SM_CONFIG_CONSOLIDATION_BUFFER_SIZE "consolidation_buffer_size"
+
+/**@{*/
+/** 
+ * Configuration parameters for the default consolidation policy (see 
+ * ConsolidationPolicy).
+ */
+#define TILEDB_SM_CONFIG_CONSOLIDATION_MODE       "consolidation_mode"
+#define TILEDB_SM_CONFIG_CONSOLIDATION_TIER_SIZE_RATIO \
+    "consolidation_tier_size_ratio"
+#define TILEDB_SM_CONFIG_CONSOLIDATION_TIER_MIN_FRAGMENT_NUM \
+    "consolidation_tier_min_fragment_num"
+#define TILEDB_SM_CONFIG_CONSOLIDATION_TIER_MAX_FRAGMENT_NUM \
+    "consolidation_tier_max_fragment_num"
+/**@}*/
+
 /** 
  * The storage manager, which is repsonsible for creating, deleting, etc. of
  * TileDB objects (i.e., workspaces, groups, arrays and metadata).
@@ -82,6 +129,19 @@ class StorageManager {
   /*              MUTATORS             */
   /* ********************************* */
 
+  /** 
+   * Sets a configuration parameter of the context, overriding the value of
+   * the configuration file. The parameters that tune the arrays (see Config)
+   * take effect on the arrays initialized afterwards.
+   *
+   * @param parameter The parameter name (see config_set()).
+   * @param value The parameter value.
+   * @return TILEDB_SM_OK for success and TILEDB_SM_ERR for error.
+   */
+  int config_set_parameter(
+      const std::string& parameter, 
+      const std::string& value);
+
   /** 
    * Initializes the storage manager. This function create the TileDB home
    * directory, which by default is "~/.tiledb/". If the user home directory
@@ -155,6 +215,48 @@ class StorageManager {
   /*              ARRAY                */
   /* ********************************* */
 
+  /**
+   * Submits an asynchronous read request on an array, which will be served
+   * by the asynchronous I/O threads of the storage manager.
+   *
+   * @param array The array to read from (initialized in TILEDB_ARRAY_READ
+   *     mode).
+   * @param aio_request The read request.
+   * @return TILEDB_SM_OK for success and TILEDB_SM_ERR for error.
+   * @see Array::aio_read()
+   */
+  int array_aio_read(Array* array, AIO_Request* aio_request) const;
+
+  /**
+   * Overrides a configuration parameter of the context for a single array
+   * (or metadata). The override takes effect on the subsequent 
+   * initializations of the array (including its iterators) by this context.
+   *
+   * @param array_dir The directory of the array or metadata.
+   * @param parameter The parameter name. It must be one of the parameters
+   *     kept by Config.
+   * @param value The parameter value.
+   * @return TILEDB_SM_OK for success and TILEDB_SM_ERR for error.
+   */
+  int array_config_set(
+      const char* array_dir,
+      const std::string& parameter, 
+      const std::string& value);
+
+  /**
+   * Consolidates fragments of an array into a single fragment, using the
+   * consolidation buffer size of the configuration.
+   *
+   * @param array The array to be consolidated.
+   * @param policy The policy that selects the fragments to be merged. If it
+   *     is NULL, the consolidation policy of the configuration is used.
+   * @return TILEDB_SM_OK for success and TILEDB_SM_ERR for error.
+   * @see Array::consolidate()
+   */
+  int array_consolidate(
+      Array* array, 
+      const ConsolidationPolicy* policy) const;
+
   /**
    * Creates a new TileDB array.
    *
@@ -174,8 +276,10 @@ class StorageManager {
   int array_create(const ArraySchema* array_schema) const; 
 
   /**
-   * Loads the schema of an array from the disk, allocating appropriate memory
-   * space for it.
+   * Loads the schema of an array from the disk, unless it is already cached
+   * in the process-wide ArrayMetadataCache. The schema is shared, and it must
+   * be released with ArrayMetadataCache::release_array_schema() (which an
+   * Array does upon destruction).
    *
    * @param array_dir The directory of the array.
    * @param array_schema The schema to be loaded.
@@ -183,7 +287,7 @@ class StorageManager {
    */
   int array_load_schema(
       const char* array_dir, 
-      ArraySchema*& array_schema) const;
+      const ArraySchema*& array_schema) const;
 
   /**
    * Initializes a TileDB array.
@@ -275,6 +379,16 @@ class StorageManager {
   /*              METADATA             */
   /* ********************************* */
 
+  /**
+   * Consolidates fragments of a metadata object into a single fragment,
+   * using the consolidation policy and buffer size of the configuration.
+   *
+   * @param metadata The metadata to be consolidated.
+   * @return TILEDB_SM_OK for success and TILEDB_SM_ERR for error.
+   * @see Metadata::consolidate()
+   */
+  int metadata_consolidate(Metadata* metadata) const;
+
   /**
    * Creates a new TileDB metadata object.
    *
@@ -292,8 +406,8 @@ class StorageManager {
   int metadata_create(const ArraySchema* array_schema) const; 
 
   /**
-   * Loads the schema of a metadata object from the disk, allocating appropriate
-   * memory space for it.
+   * Loads the schema of a metadata object from the disk, unless it is already
+   * cached (see array_load_schema()).
    *
    * @param metadata_dir The directory of the metadata.
    * @param array_schema The schema to be loaded.
@@ -301,7 +415,7 @@ class StorageManager {
    */
   int metadata_load_schema(
       const char* metadata_dir, 
-      ArraySchema*& array_schema) const;
+      const ArraySchema*& array_schema) const;
 
   /**
    * Initializes a TileDB metadata object.
@@ -441,6 +555,22 @@ class StorageManager {
   /*        PRIVATE ATTRIBUTES         */
   /* ********************************* */
 
+  /** The number of threads serving the asynchronous reads. */
+  int aio_thread_num_;
+  /** The threads serving the asynchronous reads. */
+  ThreadPool* aio_thread_pool_;
+  /** 
+   * The configuration parameters overridden per array, as (parameter, value)
+   * pairs in the order they were set, indexed by the real array directory.
+   */
+  std::map<std::string, std::vector<std::pair<std::string, std::string> > >
+      array_config_params_;
+  /** The configuration parameters handed to the arrays. */
+  Config config_;
+  /** The total size of the buffers used during consolidation. */
+  size_t consolidation_buffer_size_;
+  /** The default consolidation policy. */
+  ConsolidationPolicy consolidation_policy_;
   /** The directory of the master catalog. */
   std::string master_catalog_dir_;
   /** The TileDB home directory. */
@@ -459,6 +589,16 @@ class StorageManager {
    */
   int array_clear(const std::string& array) const;
 
+  /**
+   * Retrieves the configuration parameters of an array, i.e., those of the
+   * context with the array overrides applied.
+   *
+   * @param array_dir The directory of the array.
+   * @param config The configuration to be retrieved.
+   * @return void
+   */
+  void array_config_get(const char* array_dir, Config& config) const;
+
   /**
    * Deletes a TileDB array entirely.
    *
@@ -478,18 +618,70 @@ class StorageManager {
        const std::string& old_array,
        const std::string& new_array) const;
 
+  /** 
+   * Checks if the input is the name of a configuration parameter, either of
+   * the context or of the arrays (see Config).
+   *
+   * @param parameter The parameter name.
+   * @return *true* if the parameter is known.
+   */
+  static bool config_has_parameter(const std::string& parameter);
+
   /** 
    * It sets the TileDB configuration parameters from a file.
    *
    * @param config_filename The name of the configuration file.
    *     Each line in the file correspond to a single parameter, and should
-   *     be in the form <parameter> <value> (i.e., space-separated).
+   *     be in the form <parameter> <value> (i.e., space-separated). Empty
+   *     lines and lines starting with '#' are ignored. The parameters that
+   *     are not specified in the file take their default values. Currently
+   *     supported parameters:
+   *      - tile_cache_size: The maximum size (in bytes) of the decompressed
+   *        tiles cached across all reads of the process (0 disables caching).
+   *        Note that this setting is process-wide: it applies to all the
+   *        contexts, and it is not reset to its default by the contexts
+   *        that do not set it.
+   *      - array_metadata_cache_size: The maximum number of array schemas,
+   *        as well as of fragment book-keeping structures, kept cached for
+   *        reuse while no array uses them (0 disables caching). Note that
+   *        this setting is process-wide, as the one above.
+   *      - aio_thread_num: The number of threads serving the asynchronous
+   *        reads of the context.
+   *      - compression_level: The compression level of the attributes whose
+   *        schema sets none (0, the default, lets each compressor choose).
+   *        Writing to an array fails if the level exceeds the maximum of
+   *        the codec of such an attribute.
+   *      - consolidation_buffer_size: The total size (in bytes) of the
+   *        buffers used during consolidation.
+   *      - consolidation_mode: The default consolidation mode, *all* or 
+   *        *tiered*.
+   *      - consolidation_tier_size_ratio: The maximum ratio between the sizes
+   *        of the fragments merged by tiered consolidation.
+   *      - consolidation_tier_min_fragment_num: The minimum number of 
+   *        fragments merged by tiered consolidation.
+   *      - consolidation_tier_max_fragment_num: The maximum number of 
+   *        fragments merged by tiered consolidation.
+   *      - io_mode: The way the tiles are read from the fragment files,
+   *        *read* (pread) or *mmap*. The default is set by the USE_MMAP
+   *        build flag.
+   *      - sorted_buffer_size: The size (in bytes) of the buffers through
+   *        which the cells of unsorted writes are sorted.
+   *      - thread_num: The number of threads running the parallel loops of
+   *        array reads and writes, such as tile compression and prefetching
+   *        (0, the default, uses the OpenMP default).
+   *      - unsorted_merge_buffer_size: The total size (in bytes) of the
+   *        buffers through which the unsorted writes to a sparse array are
+   *        merged into a single fragment upon finalization. Each unsorted 
+   *        write then spills a sorted run to the disk, instead of creating
+   *        a separate fragment (0, the default, disables the runs).
    * @return TILEDB_SM_OK for success, and TILEDB_SM_ERR for error.
    */
   int config_set(const char* config_filename);
 
   /** 
-   * Sets the TileDB configuration parameters to default values. 
+   * Sets the TileDB configuration parameters of the context to default 
+   * values. The process-wide cache sizes are left intact, so that the
+   * initialization of a context does not override those set by another.
    *
    * @return void
    */
@@ -31,10 +31,13 @@
  */
 
 #include "array.h"
+#include "array_metadata_cache.h"
+#include "tile_cache.h"
 #include "utils.h"
 #include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <functional>
 #include <iostream>
 #include <sstream>
 #include <sys/time.h>
@@ -85,12 +88,14 @@ Array::Array() {
 }
 
 Array::~Array() {
+  aio_wait();
+
   for(int i=0; i<fragments_.size(); ++i)
     if(fragments_[i] != NULL)
        delete fragments_[i];
 
   if(array_schema_ != NULL)
-    delete array_schema_;
+    ArrayMetadataCache::instance()->release_array_schema(array_schema_);
 
   if(subarray_ != NULL)
     free(subarray_);
@@ -114,6 +119,40 @@ const std::vector<int>& Array::attribute_ids() const {
   return attribute_ids_;
 }
 
+const Config* Array::config() const {
+  return &config_;
+}
+
+int Array::estimate_result_size(size_t* buffer_sizes) const {
+  // Sanity check
+  if(mode_ != TILEDB_ARRAY_READ) {
+    PRINT_ERROR("Cannot estimate result size; Invalid mode");
+    return TILEDB_AR_ERR;
+  }
+
+  // No fragments - empty result
+  if(fragments_.size() == 0) {
+    int buffer_i = 0;
+    int attribute_id_num = attribute_ids_.size();
+    for(int i=0; i<attribute_id_num; ++i) {
+      buffer_sizes[buffer_i] = 0; 
+      if(!array_schema_->var_size(attribute_ids_[i])) {
+        ++buffer_i;
+      } else {
+        buffer_sizes[buffer_i+1] = 0; 
+        buffer_i += 2;
+      }
+    }
+    return TILEDB_AR_OK;
+  }
+
+  // Estimate
+  if(array_read_state_->estimate_result_size(buffer_sizes) != TILEDB_ARS_OK)
+    return TILEDB_AR_ERR;
+  else
+    return TILEDB_AR_OK;
+}
+
 int Array::fragment_num() const {
   return fragments_.size();
 }
@@ -169,6 +208,30 @@ int Array::read(void** buffers, size_t* buffer_sizes) {
     return TILEDB_AR_ERR;
 }
 
+int Array::read_views(const void** views, size_t* view_sizes) {
+  // Sanity checks
+  if(mode_ != TILEDB_ARRAY_READ) {
+    PRINT_ERROR("Cannot read views from array; Invalid mode");
+    return TILEDB_AR_ERR;
+  }
+
+  // No fragments - nothing to view
+  if(fragments_.size() == 0) {
+    int attribute_id_num = attribute_ids_.size();
+    for(int i=0; i<attribute_id_num; ++i) {
+      views[i] = NULL;
+      view_sizes[i] = 0; 
+    }
+    return TILEDB_AR_OK;
+  }
+
+  // Read views
+  if(array_read_state_->read_views(views, view_sizes) != TILEDB_ARS_OK)
+    return TILEDB_AR_ERR;
+  else
+    return TILEDB_AR_OK;
+}
+
 const void* Array::subarray() const {
   return subarray_;
 }
@@ -180,28 +243,101 @@ const void* Array::subarray() const {
 /*            MUTATORS            */
 /* ****************************** */
 
-int Array::consolidate() {
+int Array::aio_read(AIO_Request* aio_request, ThreadPool* thread_pool) {
+  // Sanity checks
+  if(mode_ != TILEDB_ARRAY_READ) {
+    PRINT_ERROR("Cannot submit asynchronous read; Invalid mode");
+    return TILEDB_AR_ERR;
+  }
+  if(aio_request == NULL || thread_pool == NULL) {
+    PRINT_ERROR("Cannot submit asynchronous read; Invalid request");
+    return TILEDB_AR_ERR;
+  }
+
+  // Queue the request, and schedule the queue to be served if it was idle
+  __atomic_store_n(
+      &aio_request->status_, TILEDB_AIO_INPROGRESS, __ATOMIC_RELEASE);
+  bool idle;
+  {
+    std::lock_guard<std::mutex> lock(aio_mtx_);
+    idle = aio_queue_.empty();
+    aio_queue_.push_back(aio_request);
+  }
+  if(idle)
+    thread_pool->schedule(std::bind(&Array::aio_handle_requests, this));
+
+  // Success
+  return TILEDB_AR_OK;
+}
+
+int Array::consolidate(
+    const ConsolidationPolicy* policy,
+    size_t buffer_size) {
   // Reinit with all attributes and whole domain
   finalize();
-  init(array_schema_, TILEDB_ARRAY_READ, NULL, 0, NULL);
+  init(array_schema_, TILEDB_ARRAY_READ, NULL, 0, NULL, NULL);
+
+  // Select the fragments to be merged
+  int fragment_num = fragments_.size();
+  std::vector<bool> merged;
+  void* subarray = malloc(2*array_schema_->coords_size());
+  if(consolidation_fragments(policy, merged, subarray) != TILEDB_AR_OK) {
+    free(subarray);
+    return TILEDB_AR_ERR;
+  }
+  int merged_num = 0, last = -1;
+  for(int i=0; i<fragment_num; ++i) {
+    if(merged[i]) {
+      ++merged_num;
+      last = i;
+    }
+  }
 
   // Trivial case
-  if(fragments_.size() == 1)
-    return TILEDB_AS_OK;
+  if(merged_num <= 1) {
+    free(subarray);
+    return TILEDB_AR_OK;
+  }
+
+  // Unless the policy merges all the fragments, the new fragment takes the
+  // place of the newest merged fragment, and only the merged fragments are
+  // read within their bounding subarray
+  std::string fragment_name;
+  if(policy->mode_ == TILEDB_CONSOLIDATION_ALL) {
+    fragment_name = new_fragment_name();
+  } else {
+    int64_t timestamp = fragment_timestamp(fragments_[last]->fragment_name());
+    fragment_name = new_fragment_name(timestamp);
+    std::vector<Fragment*> merged_fragments;
+    int rc = TILEDB_FG_OK;
+    for(int i=0; i<fragment_num; ++i) {
+      if(merged[i]) {
+        merged_fragments.push_back(fragments_[i]);
+      } else {
+        if(fragments_[i]->finalize() != TILEDB_FG_OK)
+          rc = TILEDB_FG_ERR;
+        delete fragments_[i];
+      }
+    }
+    fragments_ = merged_fragments;
+    if(rc != TILEDB_FG_OK || reset_subarray(subarray) != TILEDB_AR_OK) {
+      free(subarray);
+      return TILEDB_AR_ERR;
+    }
+  }
+  free(subarray);
 
   // Create new fragment
   Fragment* new_fragment = new Fragment(this);
-  if(new_fragment->init(new_fragment_name(), TILEDB_ARRAY_WRITE, subarray_) != 
+  if(new_fragment->init(fragment_name, TILEDB_ARRAY_WRITE, subarray_) != 
      TILEDB_FG_OK)
     return TILEDB_AR_ERR;
 
-  // Consolidate on a per-attribute basis
-  for(int i=0; i<array_schema_->attribute_num()+1; ++i) {
-    if(consolidate(new_fragment, i) != TILEDB_AR_OK) {
-      delete_dir(new_fragment->fragment_name());
-      delete new_fragment;
-      return TILEDB_AR_ERR;
-    }
+  // Consolidate all attributes in a single pass
+  if(consolidate(new_fragment, buffer_size) != TILEDB_AR_OK) {
+    delete_dir(new_fragment->fragment_name());
+    delete new_fragment;
+    return TILEDB_AR_ERR;
   }
 
   // Finalize new fragment
@@ -213,6 +349,8 @@ int Array::consolidate() {
     if(fragments_[i]->finalize() != TILEDB_FG_OK)
       return TILEDB_AR_ERR;
 
+    TileCache::instance()->invalidate(fragments_[i]->fragment_name());
+    ArrayMetadataCache::instance()->invalidate(fragments_[i]->fragment_name());
     if(delete_dir(fragments_[i]->fragment_name()) != TILEDB_UT_OK)
       return TILEDB_AR_ERR;
 
@@ -226,65 +364,91 @@ int Array::consolidate() {
 
 int Array::consolidate(
     Fragment* new_fragment,
-    int attribute_id) {
+    size_t buffer_size) {
   // For easy reference
-  int attribute_num = array_schema_->attribute_num();
+  int attribute_id_num = attribute_ids_.size();
 
-  // Do nothing if the array is dense for the coordinates attribute
-  if(array_schema_->dense() && attribute_id == attribute_num)
-    return TILEDB_AR_OK;
+  // Count the buffers (two per variable-sized attribute)
+  int buffer_num = 0;
+  for(int i=0; i<attribute_id_num; ++i) 
+    buffer_num += (array_schema_->var_size(attribute_ids_[i])) ? 2 : 1;
+
+  // Split the memory budget evenly across the buffers
+  size_t buffer_allocated_size = buffer_size / buffer_num;
+  if(buffer_allocated_size == 0)
+    buffer_allocated_size = 1;
+  std::vector<void*> buffers(buffer_num);
+  std::vector<size_t> buffer_sizes(buffer_num);
+  std::vector<size_t> buffer_allocated_sizes(
+                          buffer_num, 
+                          buffer_allocated_size);
+  int rc = TILEDB_AR_OK;
+  for(int i=0; i<buffer_num; ++i) {
+    buffers[i] = malloc(buffer_allocated_size);
+    if(buffers[i] == NULL) 
+      rc = TILEDB_AR_ERR;
+  }
+  if(rc != TILEDB_AR_OK)
+    PRINT_ERROR("Cannot consolidate array; Cannot allocate buffers");
 
-  // Prepare buffers
-  void** buffers;
-  size_t* buffer_sizes;
+  // Read and write all attributes until there is no overflow
+  bool any_overflow = true;
+  while(rc == TILEDB_AR_OK && any_overflow) {
+    // Read
+    for(int i=0; i<buffer_num; ++i)
+      buffer_sizes[i] = buffer_allocated_sizes[i];
+    if(read(&buffers[0], &buffer_sizes[0]) != TILEDB_AR_OK) {
+      rc = TILEDB_AR_ERR;
+      break;
+    }
 
-  // Count the number of variable attributes
-  int var_attribute_num = array_schema_->var_attribute_num();
+    // Write (the buffers need not be synchronized)
+    if(new_fragment->write(
+           (const void**) &buffers[0], 
+           &buffer_sizes[0]) != TILEDB_FG_OK) {
+      rc = TILEDB_AR_ERR;
+      break;
+    }
 
-  // Populate the buffers
-  int buffer_num = attribute_num + 1 + var_attribute_num;
-  buffers = (void**) malloc(buffer_num * sizeof(void*));
-  buffer_sizes = (size_t*) malloc(buffer_num * sizeof(size_t));
-  int buffer_i = 0;
-  for(int i=0; i<attribute_num+1; ++i) {
-    if(i == attribute_id) {
-      buffers[buffer_i] = malloc(TILEDB_CONSOLIDATION_BUFFER_SIZE);
-      buffer_sizes[buffer_i] = TILEDB_CONSOLIDATION_BUFFER_SIZE;
-      ++buffer_i;
-      if(array_schema_->var_size(i)) {
-        buffers[buffer_i] = malloc(TILEDB_CONSOLIDATION_BUFFER_SIZE);
-        buffer_sizes[buffer_i] = TILEDB_CONSOLIDATION_BUFFER_SIZE;
-        ++buffer_i;
-      }
-    } else {
-      buffers[buffer_i] = NULL;
-      buffer_sizes[buffer_i] = 0;
-      ++buffer_i;
-      if(array_schema_->var_size(i)) {
-        buffers[buffer_i] = NULL;
-        buffer_sizes[buffer_i] = 0;
-        ++buffer_i;
+    // Check for overflow, enlarging the buffers of the attributes that 
+    // could not fit a single cell
+    any_overflow = false;
+    int buffer_i = 0;
+    for(int i=0; i<attribute_id_num && rc == TILEDB_AR_OK; ++i) {
+      int attribute_buffer_num = 
+          (array_schema_->var_size(attribute_ids_[i])) ? 2 : 1;
+      if(overflow(attribute_ids_[i])) {
+        any_overflow = true;
+        if(buffer_sizes[buffer_i] == 0) {
+          for(int j=buffer_i; j<buffer_i+attribute_buffer_num; ++j) {
+            // A buffer that cannot be enlarged is kept, and freed below
+            void* buffer = realloc(buffers[j], 2*buffer_allocated_sizes[j]);
+            if(buffer == NULL) {
+              PRINT_ERROR("Cannot consolidate array; Cannot enlarge buffers");
+              rc = TILEDB_AR_ERR;
+              break;
+            }
+            buffers[j] = buffer;
+            buffer_allocated_sizes[j] *= 2;
+          }
+        }
       }
+      buffer_i += attribute_buffer_num;
     }
   }
 
-  // Read and write attribute until there is no overflow
-  do {
-    // Read
-    if(read(buffers, buffer_sizes) != TILEDB_AR_OK) 
-      return TILEDB_AR_ERR;
-    // Write
-    if(new_fragment->write(
-       (const void**) buffers, 
-       (const size_t*) buffer_sizes) != TILEDB_FG_OK)
-      return TILEDB_AR_ERR;
-  } while(overflow(attribute_id));
+  // Clean up
+  for(int i=0; i<buffer_num; ++i)
+    free(buffers[i]);
 
-  // Success
-  return TILEDB_AR_OK;
+  // Return
+  return rc;
 }
 
 int Array::finalize() {
+  // Wait for the pending asynchronous reads
+  aio_wait();
+
   int rc = TILEDB_FG_OK;
   for(int i=0; i<fragments_.size(); ++i) {
     rc = fragments_[i]->finalize();
@@ -299,6 +463,12 @@ int Array::finalize() {
     array_read_state_ = NULL;
   }
 
+  // Merge the sorted runs of the unsorted writes into a single fragment
+  if(rc == TILEDB_FG_OK && 
+     unsorted_run_names_.size() != 0 && 
+     merge_runs() != TILEDB_AR_OK)
+    rc = TILEDB_FG_ERR;
+
   if(rc == TILEDB_FG_OK)
     return TILEDB_AR_OK; 
   else
@@ -310,7 +480,16 @@ int Array::init(
     int mode,
     const char** attributes,
     int attribute_num,
-    const void* subarray) {
+    const void* subarray,
+    const Config* config) {
+  // Set array schema (released upon destruction, even if the initialization
+  // fails)
+  array_schema_ = array_schema;
+
+  // Set the configuration parameters
+  if(config != NULL)
+    config_ = *config;
+
   // Sanity check on mode
   if(mode != TILEDB_ARRAY_READ &&
      mode != TILEDB_ARRAY_WRITE &&
@@ -346,9 +525,6 @@ int Array::init(
     }
   }
   
-  // Set array schema
-  array_schema_ = array_schema;
-
   // Set attribute ids
   if(array_schema->get_attribute_ids(attributes_vec, attribute_ids_) 
          == TILEDB_AS_ERR)
@@ -374,6 +550,21 @@ int Array::init(
   return TILEDB_AR_OK;
 }
 
+int Array::release_views() {
+  // Sanity check
+  if(mode_ != TILEDB_ARRAY_READ) {
+    PRINT_ERROR("Cannot release views; Invalid mode");
+    return TILEDB_AR_ERR;
+  }
+
+  // Release views
+  if(array_read_state_ != NULL)
+    array_read_state_->release_views();
+
+  // Success
+  return TILEDB_AR_OK;
+}
+
 int Array::reset_attributes(
     const char** attributes,
     int attribute_num) {
@@ -442,6 +633,13 @@ int Array::write(const void** buffers, const size_t* buffer_sizes) {
     return TILEDB_AR_ERR;
   }
 
+  // The unsorted writes to a sparse array may be written as sorted runs, 
+  // which are merged upon finalization
+  if(mode_ == TILEDB_ARRAY_WRITE_UNSORTED && 
+     config_.unsorted_merge_buffer_size() != 0 &&
+     !array_schema_->dense())
+    return write_run(buffers, buffer_sizes);
+
   // Create and initialize a new fragment 
   if(fragments_.size() == 0) {
     Fragment* fragment = new Fragment(this);
@@ -473,6 +671,304 @@ int Array::write(const void** buffers, const size_t* buffer_sizes) {
 /*          PRIVATE METHODS       */
 /* ****************************** */
 
+void Array::aio_handle_requests() {
+  std::unique_lock<std::mutex> lock(aio_mtx_);
+  while(!aio_queue_.empty()) {
+    AIO_Request* aio_request = aio_queue_.front();
+    lock.unlock();
+
+    // Serve the request
+    int status = TILEDB_AIO_COMPLETED;
+    if((aio_request->subarray_ != NULL && 
+        reset_subarray(aio_request->subarray_) != TILEDB_AR_OK) ||
+       read(aio_request->buffers_, aio_request->buffer_sizes_) != 
+       TILEDB_AR_OK) {
+      status = TILEDB_AIO_ERR;
+    } else {
+      for(int i=0; i<int(attribute_ids_.size()); ++i) {
+        if(overflow(attribute_ids_[i])) {
+          status = TILEDB_AIO_OVERFLOW;
+          break;
+        }
+      }
+    }
+
+    // Signal the completion. The request may be reused (or resubmitted) by
+    // the user as soon as its status is set, so it is not accessed afterwards.
+    void (*completion_handle)(void*) = aio_request->completion_handle_;
+    void* completion_data = aio_request->completion_data_;
+    __atomic_store_n(&aio_request->status_, status, __ATOMIC_RELEASE);
+    if(completion_handle != NULL)
+      (*completion_handle)(completion_data);
+
+    // Dequeue the request 
+    lock.lock();
+    aio_queue_.pop_front();
+  }
+
+  // Wake up any thread waiting for the requests to be served
+  aio_cv_.notify_all();
+}
+
+void Array::aio_wait() {
+  std::unique_lock<std::mutex> lock(aio_mtx_);
+  aio_cv_.wait(lock, [this] { return aio_queue_.empty(); });
+}
+
+int Array::consolidation_fragments(
+    const ConsolidationPolicy* policy,
+    std::vector<bool>& merged,
+    void* subarray) const {
+  // Sanity checks
+  if(policy->mode_ != TILEDB_CONSOLIDATION_ALL &&
+     policy->mode_ != TILEDB_CONSOLIDATION_TIERED &&
+     policy->mode_ != TILEDB_CONSOLIDATION_SUBARRAY) {
+    PRINT_ERROR("Cannot consolidate array; Invalid consolidation mode");
+    return TILEDB_AR_ERR;
+  }
+  if(policy->mode_ == TILEDB_CONSOLIDATION_TIERED &&
+     (policy->tier_size_ratio_ < 1 ||
+      policy->tier_min_fragment_num_ < 2 ||
+      policy->tier_max_fragment_num_ < policy->tier_min_fragment_num_)) {
+    PRINT_ERROR("Cannot consolidate array; Invalid tier thresholds");
+    return TILEDB_AR_ERR;
+  }
+  if(policy->mode_ == TILEDB_CONSOLIDATION_SUBARRAY && 
+     policy->subarray_ == NULL) {
+    PRINT_ERROR("Cannot consolidate array; Missing subarray");
+    return TILEDB_AR_ERR;
+  }
+
+  // Select the fragments
+  int coords_type = array_schema_->coords_type();
+  if(coords_type == TILEDB_INT32)
+    consolidation_fragments(policy, merged, static_cast<int*>(subarray));
+  else if(coords_type == TILEDB_INT64)
+    consolidation_fragments(policy, merged, static_cast<int64_t*>(subarray));
+  else if(coords_type == TILEDB_FLOAT32)
+    consolidation_fragments(policy, merged, static_cast<float*>(subarray));
+  else if(coords_type == TILEDB_FLOAT64)
+    consolidation_fragments(policy, merged, static_cast<double*>(subarray));
+
+  // Success
+  return TILEDB_AR_OK;
+}
+
+template<class T>
+bool Array::consolidation_closure(
+    const std::vector<std::vector<T> >& bounds,
+    const std::vector<int64_t>& timestamps,
+    std::vector<bool>& merged,
+    T* subarray) const {
+  // For easy reference
+  int dim_num = array_schema_->dim_num();
+  int fragment_num = fragments_.size();
+  bool dense = array_schema_->dense();
+
+  bool added, covered;
+  do {
+    // Find the merged fragments range and their bounding subarray
+    int first = -1, last = -1;
+    for(int i=0; i<fragment_num; ++i) {
+      if(!merged[i])
+        continue;
+      if(first == -1) {
+        memcpy(subarray, &bounds[i][0], 2*dim_num*sizeof(T));
+        first = i;
+      } else {
+        for(int j=0; j<dim_num; ++j) {
+          subarray[2*j] = std::min(subarray[2*j], bounds[i][2*j]);
+          subarray[2*j+1] = std::max(subarray[2*j+1], bounds[i][2*j+1]);
+        }
+      }
+      last = i;
+    }
+    if(first == -1)
+      return false;
+
+    // Check if the merged dense fragments cover the subarray, i.e., if one
+    // of them contains it, or if they are disjoint and their cells add up
+    // to those of the subarray
+    covered = false;
+    if(dense) {
+      bool disjoint = true;
+      int64_t cell_num = 0;
+      for(int i=first; i<=last && !covered; ++i) {
+        if(!merged[i])
+          continue;
+        if(!fragments_[i]->dense()) {
+          disjoint = false;
+          continue;
+        }
+        covered = true;
+        for(int j=0; j<dim_num; ++j) {
+          if(bounds[i][2*j] > subarray[2*j] || 
+             bounds[i][2*j+1] < subarray[2*j+1]) {
+            covered = false;
+            break;
+          }
+        }
+        cell_num += cell_num_in_subarray(&bounds[i][0], dim_num);
+        for(int j=first; j<i && disjoint; ++j) 
+          if(merged[j] && overlap(&bounds[i][0], &bounds[j][0], dim_num))
+            disjoint = false;
+      }
+      if(!covered && disjoint && 
+         cell_num == cell_num_in_subarray(subarray, dim_num))
+        covered = true;
+    }
+
+    // Add the conflicting fragments. A fragment with the same timestamp as
+    // the newest merged fragment is always added, since their order would be
+    // ambiguous. In dense arrays, the new fragment stores all the cells of
+    // the subarray, hence it conflicts with the fragments overlapping the
+    // subarray that lie between the merged ones, as well as with the older
+    // ones unless the subarray is covered. In sparse arrays, a fragment 
+    // conflicts with the older merged fragments that it overlaps.
+    added = false;
+    for(int i=0; i<fragment_num; ++i) {
+      if(merged[i])
+        continue;
+      bool conflict = false;
+      if(timestamps[i] == timestamps[last]) {
+        conflict = true;
+      } else if(i < last && dense) {
+        conflict = overlap(&bounds[i][0], subarray, dim_num) && 
+                   (i > first || !covered);
+      } else if(i < last) {
+        for(int j=first; j<i && !conflict; ++j) 
+          conflict = merged[j] && 
+                     overlap(&bounds[i][0], &bounds[j][0], dim_num);
+      }
+      if(conflict) {
+        merged[i] = true;
+        added = true;
+      }
+    }
+  } while(added);
+
+  // The dense reads return the cells that no merged fragment covers as empty,
+  // which would shadow the older fragments in the new fragment, hence the 
+  // merged fragments of a dense array must cover the new fragment domain
+  return !dense || covered;
+}
+
+template<class T>
+void Array::consolidation_fragments(
+    const ConsolidationPolicy* policy,
+    std::vector<bool>& merged,
+    T* subarray) const {
+  // For easy reference
+  int dim_num = array_schema_->dim_num();
+  int fragment_num = fragments_.size();
+
+  // Trivial case
+  if(policy->mode_ == TILEDB_CONSOLIDATION_ALL) {
+    merged.assign(fragment_num, true);
+    return;
+  }
+
+  // Get the bounds and the timestamps of the fragments
+  std::vector<std::vector<T> > bounds(fragment_num, std::vector<T>(2*dim_num));
+  std::vector<int64_t> timestamps(fragment_num);
+  for(int i=0; i<fragment_num; ++i) {
+    fragment_bounds(fragments_[i], &bounds[i][0]);
+    timestamps[i] = fragment_timestamp(fragments_[i]->fragment_name());
+  }
+
+  // Select the fragments overlapping the subarray
+  if(policy->mode_ == TILEDB_CONSOLIDATION_SUBARRAY) {
+    const T* policy_subarray = static_cast<const T*>(policy->subarray_);
+    merged.assign(fragment_num, false);
+    for(int i=0; i<fragment_num; ++i)
+      merged[i] = overlap(&bounds[i][0], policy_subarray, dim_num);
+    if(!consolidation_closure(bounds, timestamps, merged, subarray))
+      merged.assign(fragment_num, false);
+    return;
+  }
+
+  // Select the newest run of consecutive fragments of similar size that
+  // can be merged
+  std::vector<off_t> sizes(fragment_num);
+  for(int i=0; i<fragment_num; ++i)
+    sizes[i] = std::max(fragments_[i]->size(), (off_t) 1);
+  for(int last=fragment_num-1; last>=0; --last) {
+    off_t min_size = sizes[last], max_size = sizes[last];
+    int first = last;
+    while(first > 0 && 
+          last - first + 1 < policy->tier_max_fragment_num_) {
+      off_t new_min_size = std::min(min_size, sizes[first-1]);
+      off_t new_max_size = std::max(max_size, sizes[first-1]);
+      if(new_max_size > policy->tier_size_ratio_ * new_min_size)
+        break;
+      min_size = new_min_size;
+      max_size = new_max_size;
+      --first;
+    }
+    if(last - first + 1 < policy->tier_min_fragment_num_)
+      continue;
+    merged.assign(fragment_num, false);
+    for(int i=first; i<=last; ++i)
+      merged[i] = true;
+    if(consolidation_closure(bounds, timestamps, merged, subarray))
+      return;
+  }
+  merged.assign(fragment_num, false);
+}
+
+template<class T>
+void Array::fragment_bounds(const Fragment* fragment, T* bounds) const {
+  // For easy reference
+  int dim_num = array_schema_->dim_num();
+  size_t domain_size = 2*array_schema_->coords_size();
+  const BookKeeping* book_keeping = fragment->book_keeping();
+  const T* mbrs = static_cast<const T*>(book_keeping->mbrs());
+
+  // Dense fragment, or sparse fragment without cells
+  if(fragment->dense() || book_keeping->tile_num() == 0) {
+    const void* non_empty_domain = book_keeping->non_empty_domain();
+    memcpy(
+        bounds, 
+        (non_empty_domain != NULL) ? non_empty_domain : 
+                                     array_schema_->domain(),
+        domain_size);
+    return;
+  }
+
+  // Sparse fragment
+  int64_t mbr_num = book_keeping->tile_num();
+  memcpy(bounds, mbrs, domain_size);
+  for(int64_t i=1; i<mbr_num; ++i) {
+    const T* mbr = &mbrs[2*dim_num*i];
+    for(int j=0; j<dim_num; ++j) {
+      bounds[2*j] = std::min(bounds[2*j], mbr[2*j]);
+      bounds[2*j+1] = std::max(bounds[2*j+1], mbr[2*j+1]);
+    }
+  }
+}
+
+int64_t Array::fragment_timestamp(const std::string& fragment_name) const {
+  // Strip fragment name
+  std::string parent_fragment_name = parent_dir(fragment_name);
+  std::string stripped_fragment_name = 
+      fragment_name.substr(parent_fragment_name.size() + 1);
+  assert(starts_with(stripped_fragment_name, "__"));
+  int64_t stripped_fragment_name_size = stripped_fragment_name.size();
+
+  // Search for the timestamp in the end of the name after '_'
+  int64_t t = 0;
+  for(int j=2; j<stripped_fragment_name_size; ++j) {
+    if(stripped_fragment_name[j] == '_') {
+      std::string t_str = stripped_fragment_name.substr(
+                              j+1,stripped_fragment_name_size-j);
+      sscanf(t_str.c_str(), "%lld", &t); 
+      break;
+    }
+  }
+
+  return t;
+}
+
 std::string Array::new_fragment_name() const {
   std::stringstream fragment_name;
   struct timeval tp;
@@ -484,6 +980,84 @@ std::string Array::new_fragment_name() const {
   return fragment_name.str();
 }
 
+std::string Array::new_fragment_name(int64_t timestamp) const {
+  std::stringstream fragment_name;
+  struct timeval tp;
+  gettimeofday(&tp, NULL);
+  uint64_t ms = (uint64_t) tp.tv_sec * 1000L + tp.tv_usec / 1000;
+  fragment_name << array_schema_->array_name() << "/.__" 
+                << getpid() << "_" << timestamp << "_" << ms;
+
+  return fragment_name.str();
+}
+
+int Array::merge_runs() {
+  // Open the runs for reading, in the order they were written
+  int mode = mode_;
+  mode_ = TILEDB_ARRAY_READ;
+  int run_num = unsorted_run_names_.size();
+  for(int i=0; i<run_num; ++i) 
+    fragments_.push_back(new Fragment(this));
+  std::vector<int> rcs(run_num);
+  #pragma omp parallel for schedule(dynamic) num_threads(config_.thread_num())
+  for(int i=0; i<run_num; ++i) 
+    rcs[i] = fragments_[i]->init(unsorted_run_names_[i], mode_, NULL);
+  int rc = TILEDB_AR_OK;
+  for(int i=0; i<run_num; ++i) 
+    if(rcs[i] != TILEDB_FG_OK)
+      rc = TILEDB_AR_ERR;
+
+  // Merge the runs in the new fragment, reading the entire domain, as the
+  // runs hold all the cells of the writes
+  Fragment* new_fragment = NULL;
+  if(rc == TILEDB_AR_OK) {
+    new_fragment = new Fragment(this);
+    if(new_fragment->init(
+           unsorted_fragment_name_, 
+           TILEDB_ARRAY_WRITE, 
+           subarray_) != TILEDB_FG_OK ||
+       reset_subarray(NULL) != TILEDB_AR_OK ||
+       consolidate(new_fragment, config_.unsorted_merge_buffer_size()) != 
+       TILEDB_AR_OK)
+      rc = TILEDB_AR_ERR;
+  }
+
+  // Delete the runs
+  for(int i=0; i<run_num; ++i) {
+    if(fragments_[i]->finalize() != TILEDB_FG_OK)
+      rc = TILEDB_AR_ERR;
+    delete fragments_[i];
+  }
+  fragments_.clear();
+  if(array_read_state_ != NULL) {
+    delete array_read_state_;
+    array_read_state_ = NULL;
+  }
+  std::string runs_dir = 
+      unsorted_fragment_name_ + "/" + TILEDB_RUNS_DIRNAME;
+  TileCache::instance()->invalidate(runs_dir);
+  ArrayMetadataCache::instance()->invalidate(runs_dir);
+  for(int i=0; i<run_num; ++i) 
+    if(delete_dir(unsorted_run_names_[i]) != TILEDB_UT_OK)
+      rc = TILEDB_AR_ERR;
+  if(delete_dir(runs_dir) != TILEDB_UT_OK)
+    rc = TILEDB_AR_ERR;
+  unsorted_run_names_.clear();
+  mode_ = mode;
+
+  // Finalize the new fragment, which is deleted upon error
+  if(new_fragment != NULL) {
+    if(rc == TILEDB_AR_OK && new_fragment->finalize() != TILEDB_FG_OK)
+      rc = TILEDB_AR_ERR;
+    delete new_fragment;
+  }
+  if(rc != TILEDB_AR_OK && is_dir(unsorted_fragment_name_))
+    delete_dir(unsorted_fragment_name_);
+
+  // Return
+  return rc;
+}
+
 int Array::open_fragments() {
   // Get directory names in the array folder
   std::vector<std::string> dirs = 
@@ -492,15 +1066,34 @@ int Array::open_fragments() {
   // Sort the fragment names
   sort_fragment_names(dirs);
 
-  // Create a fragment object for each fragment directory
-  for(int i=0; i<dirs.size(); ++i) {
-    if(is_fragment(dirs[i])) {
-      Fragment* fragment = new Fragment(this);
-      fragments_.push_back(fragment);
-      if(fragment->init(dirs[i], mode_, NULL) != TILEDB_FG_OK)
-        return TILEDB_AR_ERR;
+  // Keep only the fragment directories, checking them in parallel
+  int64_t dir_num = dirs.size();
+  std::vector<char> fragment_flags(dir_num);
+  #pragma omp parallel for schedule(dynamic) num_threads(config_.thread_num())
+  for(int64_t i=0; i<dir_num; ++i) 
+    fragment_flags[i] = is_fragment(dirs[i]);
+
+  // Create a fragment object for each fragment directory, in timestamp order
+  std::vector<std::string> fragment_names;
+  for(int64_t i=0; i<dir_num; ++i) {
+    if(fragment_flags[i]) {
+      fragments_.push_back(new Fragment(this));
+      fragment_names.push_back(dirs[i]);
     }
-  } 
+  }
+
+  // Load the book-keeping and create the read state of each fragment in
+  // parallel
+  int64_t fragment_num = fragment_names.size();
+  std::vector<int> rcs(fragment_num);
+  #pragma omp parallel for schedule(dynamic) num_threads(config_.thread_num())
+  for(int64_t i=0; i<fragment_num; ++i) 
+    rcs[i] = fragments_[i]->init(fragment_names[i], mode_, NULL);
+
+  // Check for errors
+  for(int64_t i=0; i<fragment_num; ++i) 
+    if(rcs[i] != TILEDB_FG_OK)
+      return TILEDB_AR_ERR;
 
   // Success
   return TILEDB_AR_OK;
@@ -510,32 +1103,13 @@ void Array::sort_fragment_names(
     std::vector<std::string>& fragment_names) const {
   // Initializations
   int fragment_num = fragment_names.size();
-  std::string t_str;
-  int64_t stripped_fragment_name_size, t;
   std::vector<std::pair<int64_t, int> > t_pos_vec;
   t_pos_vec.resize(fragment_num);
 
   // Get the timestamp for each fragment
-  for(int i=0; i<fragment_num; ++i) {
-    // Strip fragment name
-    std::string& fragment_name = fragment_names[i];
-    std::string parent_fragment_name = parent_dir(fragment_name);
-    std::string stripped_fragment_name = 
-        fragment_name.substr(parent_fragment_name.size() + 1);
-    assert(starts_with(stripped_fragment_name, "__"));
-    stripped_fragment_name_size = stripped_fragment_name.size();
-
-    // Search for the timestamp in the end of the name after '_'
-    for(int j=2; j<stripped_fragment_name_size; ++j) {
-      if(stripped_fragment_name[j] == '_') {
-        t_str = stripped_fragment_name.substr(
-                    j+1,stripped_fragment_name_size-j);
-        sscanf(t_str.c_str(), "%lld", &t); 
-        t_pos_vec[i] = std::pair<int64_t, int>(t, i);
-        break;
-      }
-    }
-  }
+  for(int i=0; i<fragment_num; ++i) 
+    t_pos_vec[i] = std::pair<int64_t, int>(
+                       fragment_timestamp(fragment_names[i]), i);
 
   // Sort the names based on the timestamps
   SORT(t_pos_vec.begin(), t_pos_vec.end()); 
@@ -546,3 +1120,41 @@ void Array::sort_fragment_names(
   fragment_names = fragment_names_sorted;
 }
 
+int Array::write_run(const void** buffers, const size_t* buffer_sizes) {
+  // Create the directory of the new fragment and its runs directory upon 
+  // the first run, replacing the fragment created upon initialization
+  std::string runs_dir;
+  if(unsorted_run_names_.size() == 0) {
+    if(fragments_.size() != 0) {
+      unsorted_fragment_name_ = fragments_[0]->fragment_name();
+      delete fragments_[0];
+      fragments_.clear();
+    } else {
+      unsorted_fragment_name_ = new_fragment_name();
+    }
+    runs_dir = unsorted_fragment_name_ + "/" + TILEDB_RUNS_DIRNAME;
+    if(create_dir(unsorted_fragment_name_) != TILEDB_UT_OK ||
+       create_dir(runs_dir) != TILEDB_UT_OK)
+      return TILEDB_AR_ERR;
+  } else {
+    runs_dir = unsorted_fragment_name_ + "/" + TILEDB_RUNS_DIRNAME;
+  }
+
+  // Sort and write the cells in a new run, which is named like a fragment
+  // ordered by the run number
+  std::stringstream run_name;
+  run_name << runs_dir << "/.__run_" << unsorted_run_names_.size();
+  Fragment* run = new Fragment(this);
+  int rc = TILEDB_AR_OK;
+  if(run->init(run_name.str(), mode_, subarray_) != TILEDB_FG_OK ||
+     run->write(buffers, buffer_sizes) != TILEDB_FG_OK ||
+     run->finalize() != TILEDB_FG_OK) 
+    rc = TILEDB_AR_ERR;
+  else
+    unsorted_run_names_.push_back(run->fragment_name());
+  delete run;
+
+  // Return
+  return rc;
+}
+
@@ -0,0 +1,335 @@
+/**
+ * @file   array_metadata_cache.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2016 MIT and Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file implements the ArrayMetadataCache class.
+ */
+
+#include "array_metadata_cache.h"
+#include "array_schema.h"
+#include "book_keeping.h"
+#include "constants.h"
+#include <vector>
+
+
+
+
+/* ****************************** */
+/*   CONSTRUCTORS & DESTRUCTORS   */
+/* ****************************** */
+
+ArrayMetadataCache::ArrayMetadataCache() {
+  capacity_ = TILEDB_ARRAY_METADATA_CACHE_SIZE;
+}
+
+ArrayMetadataCache::~ArrayMetadataCache() {
+  std::map<const BookKeeping*, Entry<BookKeeping> >::iterator bk_it =
+      book_keepings_.entries_.begin();
+  for(; bk_it != book_keepings_.entries_.end(); ++bk_it)
+    delete bk_it->first;
+
+  std::map<const ArraySchema*, Entry<ArraySchema> >::iterator as_it =
+      array_schemas_.entries_.begin();
+  for(; as_it != array_schemas_.entries_.end(); ++as_it)
+    delete as_it->first;
+}
+
+
+
+
+/* ****************************** */
+/*            ACCESSORS           */
+/* ****************************** */
+
+ArrayMetadataCache* ArrayMetadataCache::instance() {
+  static ArrayMetadataCache array_metadata_cache;
+  return &array_metadata_cache;
+}
+
+size_t ArrayMetadataCache::capacity() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return capacity_;
+}
+
+
+
+
+/* ****************************** */
+/*            MUTATORS            */
+/* ****************************** */
+
+const ArraySchema* ArrayMetadataCache::acquire_array_schema(
+    const std::string& dir,
+    const struct stat& file_stat) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return acquire(array_schemas_, dir, &file_stat);
+}
+
+BookKeeping* ArrayMetadataCache::acquire_book_keeping(
+    const std::string& fragment_name) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return acquire(book_keepings_, fragment_name, NULL);
+}
+
+void ArrayMetadataCache::clear() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  evict(book_keepings_, 0);
+  evict(array_schemas_, 0);
+}
+
+const ArraySchema* ArrayMetadataCache::insert_array_schema(
+    const std::string& dir,
+    const struct stat& file_stat,
+    ArraySchema* array_schema) {
+  std::lock_guard<std::mutex> lock(mtx_);
+
+  // Use the schema cached in the meantime, if any
+  ArraySchema* cached_array_schema = 
+      acquire(array_schemas_, dir, &file_stat);
+  if(cached_array_schema != NULL) {
+    delete array_schema;
+    return cached_array_schema;
+  }
+
+  // Replace the schema of a previous version of the array, if any
+  std::map<std::string, ArraySchema*>::iterator it = 
+      array_schemas_.names_.find(dir);
+  if(it != array_schemas_.names_.end())
+    uncache(array_schemas_, it->second);
+
+  // Insert the new schema
+  insert(array_schemas_, dir, &file_stat, array_schema, capacity_ > 0);
+
+  return array_schema;
+}
+
+BookKeeping* ArrayMetadataCache::insert_book_keeping(
+    const std::string& fragment_name,
+    BookKeeping* book_keeping) {
+  std::lock_guard<std::mutex> lock(mtx_);
+
+  // Use the book-keeping cached in the meantime, if any
+  BookKeeping* cached_book_keeping = 
+      acquire(book_keepings_, fragment_name, NULL);
+  if(cached_book_keeping != NULL) {
+    delete book_keeping;
+    return cached_book_keeping;
+  }
+
+  // The book-keeping holds a reference on its array schema (if the latter is
+  // known to the cache), and it is cached only along with the schema
+  bool cached = false;
+  std::map<const ArraySchema*, Entry<ArraySchema> >::iterator it =
+      array_schemas_.entries_.find(book_keeping->array_schema());
+  if(it != array_schemas_.entries_.end()) {
+    Entry<ArraySchema>& entry = it->second;
+    if(entry.ref_num_ == 0)
+      array_schemas_.lru_.erase(entry.lru_it_);
+    ++entry.ref_num_;
+    cached = capacity_ > 0 && entry.cached_;
+  }
+
+  // Insert the new book-keeping
+  insert(book_keepings_, fragment_name, NULL, book_keeping, cached);
+
+  return book_keeping;
+}
+
+void ArrayMetadataCache::invalidate(const std::string& dir) {
+  std::lock_guard<std::mutex> lock(mtx_);
+
+  // The book-keeping structures go first, since they reference the schemas
+  invalidate(book_keepings_, dir);
+  invalidate(array_schemas_, dir);
+}
+
+void ArrayMetadataCache::release_array_schema(
+    const ArraySchema* array_schema) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if(!release(array_schemas_, array_schema))
+    delete array_schema;
+}
+
+void ArrayMetadataCache::release_book_keeping(
+    const BookKeeping* book_keeping) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if(!release(book_keepings_, book_keeping))
+    delete book_keeping;
+}
+
+void ArrayMetadataCache::set_capacity(size_t capacity) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  capacity_ = capacity;
+  evict(book_keepings_, capacity_);
+  evict(array_schemas_, capacity_);
+}
+
+
+
+
+/* ****************************** */
+/*         PRIVATE METHODS        */
+/* ****************************** */
+
+template<class T>
+T* ArrayMetadataCache::acquire(
+    EntrySet<T>& entry_set,
+    const std::string& name,
+    const struct stat* file_stat) {
+  // Trivial case
+  if(capacity_ == 0)
+    return NULL;
+
+  // Search for the entry
+  typename std::map<std::string, T*>::iterator it =
+      entry_set.names_.find(name);
+  if(it == entry_set.names_.end())
+    return NULL;
+
+  // Check if the file was modified since the entry was loaded
+  Entry<T>& entry = entry_set.entries_[it->second];
+  if(file_stat != NULL &&
+     (file_stat->st_dev != entry.file_stat_.st_dev ||
+      file_stat->st_ino != entry.file_stat_.st_ino ||
+      file_stat->st_size != entry.file_stat_.st_size ||
+      file_stat->st_mtim.tv_sec != entry.file_stat_.st_mtim.tv_sec ||
+      file_stat->st_mtim.tv_nsec != entry.file_stat_.st_mtim.tv_nsec))
+    return NULL;
+
+  // Acquire a reference, taking the entry out of the unused list
+  if(entry.ref_num_ == 0)
+    entry_set.lru_.erase(entry.lru_it_);
+  ++entry.ref_num_;
+
+  return it->second;
+}
+
+void ArrayMetadataCache::destroy(const ArraySchema* object) {
+  erase(array_schemas_, object);
+  delete object;
+}
+
+void ArrayMetadataCache::destroy(const BookKeeping* object) {
+  erase(book_keepings_, object);
+  release(array_schemas_, object->array_schema());
+  delete object;
+}
+
+template<class T>
+void ArrayMetadataCache::erase(EntrySet<T>& entry_set, const T* object) {
+  typename std::map<const T*, Entry<T> >::iterator it =
+      entry_set.entries_.find(object);
+  Entry<T>& entry = it->second;
+  if(entry.cached_) {
+    entry_set.names_.erase(entry.name_);
+    if(entry.ref_num_ == 0)
+      entry_set.lru_.erase(entry.lru_it_);
+  }
+  entry_set.entries_.erase(it);
+}
+
+template<class T>
+void ArrayMetadataCache::evict(EntrySet<T>& entry_set, size_t num) {
+  while(entry_set.lru_.size() > num)
+    destroy(entry_set.lru_.back());
+}
+
+template<class T>
+void ArrayMetadataCache::insert(
+    EntrySet<T>& entry_set,
+    const std::string& name,
+    const struct stat* file_stat,
+    T* object,
+    bool cached) {
+  Entry<T>& entry = entry_set.entries_[object];
+  entry.cached_ = cached;
+  if(file_stat != NULL)
+    entry.file_stat_ = *file_stat;
+  entry.name_ = name;
+  entry.ref_num_ = 1;
+  if(cached)
+    entry_set.names_[name] = object;
+}
+
+template<class T>
+void ArrayMetadataCache::invalidate(
+    EntrySet<T>& entry_set,
+    const std::string& dir) {
+  // Collect the entries contained in the directory
+  std::vector<const T*> objects;
+  typename std::map<std::string, T*>::iterator it = entry_set.names_.begin();
+  for(; it != entry_set.names_.end(); ++it) {
+    const std::string& name = it->first;
+    if(name == dir ||
+       (name.size() > dir.size() &&
+        name.compare(0, dir.size(), dir) == 0 &&
+        name[dir.size()] == '/'))
+      objects.push_back(it->second);
+  }
+
+  // Drop the entries
+  for(int i=0; i<objects.size(); ++i) 
+    uncache(entry_set, objects[i]);
+}
+
+template<class T>
+bool ArrayMetadataCache::release(EntrySet<T>& entry_set, const T* object) {
+  // Search for the entry
+  typename std::map<const T*, Entry<T> >::iterator it =
+      entry_set.entries_.find(object);
+  if(it == entry_set.entries_.end())
+    return false;
+
+  // Release the reference
+  Entry<T>& entry = it->second;
+  if(--entry.ref_num_ > 0)
+    return true;
+
+  // The entry is not used anymore
+  if(entry.cached_) {
+    entry_set.lru_.push_front(object);
+    entry.lru_it_ = entry_set.lru_.begin();
+    evict(entry_set, capacity_);
+  } else {
+    destroy(object);
+  }
+
+  return true;
+}
+
+template<class T>
+void ArrayMetadataCache::uncache(EntrySet<T>& entry_set, const T* object) {
+  // Delete the unused entry, or hide it until it is released
+  Entry<T>& entry = entry_set.entries_[object];
+  if(entry.ref_num_ == 0) {
+    destroy(object);
+  } else {
+    entry_set.names_.erase(entry.name_);
+    entry.cached_ = false;
+  }
+}
@@ -31,9 +31,11 @@
  */
 
 #include "array_read_state.h"
+#include "tile_cache.h"
 #include "utils.h"
 #include <cassert>
 #include <cmath>
+#include <set>
 
 
 
@@ -71,18 +73,26 @@ ArrayReadState::ArrayReadState(
   int attribute_num = array_schema->attribute_num();
 
   // Initializations
+  cell_range_arenas_.resize(TILEDB_PREFETCH_ROUND_NUM);
+  copy_range_pos_.resize(attribute_num+1);
   done_ = false;
+  read_used_ = false;
   empty_cells_written_.resize(attribute_num+1);
   fragment_cell_pos_ranges_vec_pos_.resize(attribute_num+1);
   min_bounding_coords_end_ = NULL;
   read_round_done_.resize(attribute_num);
   subarray_tile_coords_ = NULL;
   subarray_tile_domain_ = NULL;
+  view_range_pos_.resize(attribute_num+1);
+  views_leased_ = false;
+  views_used_ = false;
 
   for(int i=0; i<attribute_num+1; ++i) {
+    copy_range_pos_[i] = 0;
     empty_cells_written_[i] = 0;
     fragment_cell_pos_ranges_vec_pos_[i] = 0;
     read_round_done_[i] = true;
+    view_range_pos_[i] = 0;
   }
 
   // Get fragment read states
@@ -106,6 +116,11 @@ ArrayReadState::~ArrayReadState() {
   for(int i=0; i<fragment_bounding_coords_.size(); ++i)
     if(fragment_bounding_coords_[i] != NULL)
       free(fragment_bounding_coords_[i]);
+
+  for(int i=0; i<merge_read_states_.size(); ++i)
+    for(int j=0; j<merge_read_states_[i].size(); ++j)
+      if(merge_read_states_[i][j] != NULL)
+        delete merge_read_states_[i][j];
 }
 
 
@@ -115,6 +130,25 @@ ArrayReadState::~ArrayReadState() {
 /*           ACCESSORS            */
 /* ****************************** */
 
+int ArrayReadState::estimate_result_size(size_t* buffer_sizes) const {
+  // For easy reference
+  int coords_type = array_->array_schema()->coords_type();
+
+  // Invoke the proper templated function
+  if(coords_type == TILEDB_INT32) {
+    return estimate_result_size<int>(buffer_sizes);
+  } else if(coords_type == TILEDB_INT64) {
+    return estimate_result_size<int64_t>(buffer_sizes);
+  } else if(coords_type == TILEDB_FLOAT32) {
+    return estimate_result_size<float>(buffer_sizes);
+  } else if(coords_type == TILEDB_FLOAT64) {
+    return estimate_result_size<double>(buffer_sizes);
+  } else {
+    PRINT_ERROR("Cannot estimate result size; Invalid coordinates type");
+    return TILEDB_ARS_ERR;
+  }
+}
+
 bool ArrayReadState::overflow(int attribute_id) const {
   return overflow_[attribute_id];
 }
@@ -129,6 +163,13 @@ int ArrayReadState::read(
   const ArraySchema* array_schema = array_->array_schema();
   int attribute_num = array_schema->attribute_num();
 
+  // The results are either copied or viewed, never both
+  if(views_used_) {
+    PRINT_ERROR("Cannot read; The results are read through views");
+    return TILEDB_ARS_ERR;
+  }
+  read_used_ = true;
+
   // Reset overflow
   overflow_.resize(attribute_num+1); 
   for(int i=0; i<attribute_num+1; ++i)
@@ -143,6 +184,81 @@ int ArrayReadState::read(
     return read_sparse(buffers, buffer_sizes);
 }
 
+int ArrayReadState::read_views(const void** views, size_t* view_sizes) {
+  // Sanity check
+  assert(fragment_num_);
+
+  // For easy reference
+  const ArraySchema* array_schema = array_->array_schema();
+  int attribute_num = array_schema->attribute_num();
+  const std::vector<int>& attribute_ids = array_->attribute_ids();
+  int attribute_id_num = attribute_ids.size(); 
+  bool dense = array_schema->dense();
+
+  // Check the lease and the attributes
+  if(read_used_) {
+    PRINT_ERROR("Cannot read views; The results are read through copies");
+    return TILEDB_ARS_ERR;
+  }
+  if(views_leased_) {
+    PRINT_ERROR("Cannot read views; The previous views are not released");
+    return TILEDB_ARS_ERR;
+  }
+  for(int i=0; i<attribute_id_num; ++i) {
+    if(array_schema->var_size(attribute_ids[i])) {
+      PRINT_ERROR("Cannot read views; Variable-sized attributes are not "
+                  "supported");
+      return TILEDB_ARS_ERR;
+    }
+  }
+  views_used_ = true;
+
+  // In the sparse case, read the coordinates attribute first, as in read()
+  int coords_i = -1;
+  if(!dense) {
+    for(int i=0; i<attribute_id_num; ++i) { 
+      if(attribute_ids[i] == attribute_num) {
+        coords_i = i;
+        if(read_sparse_attr_view(
+               attribute_num, 
+               views[i], 
+               view_sizes[i]) != TILEDB_ARS_OK)
+          return TILEDB_ARS_ERR;
+        break;
+      }
+    }
+  }
+
+  // Read a view for each attribute individually
+  for(int i=0; i<attribute_id_num; ++i) {
+    if(i == coords_i)
+      continue;
+    int rc = (dense) 
+        ? read_dense_attr_view(attribute_ids[i], views[i], view_sizes[i])
+        : read_sparse_attr_view(attribute_ids[i], views[i], view_sizes[i]);
+    if(rc != TILEDB_ARS_OK)
+      return TILEDB_ARS_ERR;
+  }
+
+  // The views are leased until they are released
+  views_leased_ = true;
+
+  // Success
+  return TILEDB_ARS_OK; 
+}
+
+
+
+
+/* ****************************** */
+/*            MUTATORS            */
+/* ****************************** */
+
+void ArrayReadState::release_views() {
+  view_arena_.reset();
+  views_leased_ = false;
+}
+
 
 
 
@@ -178,10 +294,73 @@ void ArrayReadState::clean_up_processed_fragment_cell_pos_ranges() {
   }
 }
 
+template<class T>
+void ArrayReadState::compute_empty_fragment_cell_ranges_dense(
+    const T* overlap_subarray,
+    int overlap,
+    FragmentCellRanges& unsorted_fragment_cell_ranges,
+    Arena& arena) const {
+  // For easy reference
+  const ArraySchema* array_schema = array_->array_schema();
+  int dim_num = array_schema->dim_num();
+  int cell_order = array_schema->cell_order();
+  size_t cell_range_size = 2*array_schema->coords_size();
+  FragmentInfo fragment_info = FragmentInfo(-1, -1);
+
+  // Contiguous cells, single cell range
+  if(overlap == 1 || overlap == 3) {
+    T* cell_range = static_cast<T*>(arena.allocate(cell_range_size));
+    for(int i=0; i<dim_num; ++i) {
+      cell_range[i] = overlap_subarray[2*i];
+      cell_range[dim_num + i] = overlap_subarray[2*i+1];
+    }
+    unsorted_fragment_cell_ranges.push_back(
+        FragmentCellRange(fragment_info, cell_range));
+    return;
+  }
+
+  // Non-contiguous cells, a range per slab along the last (row-major) or
+  // the first (column-major) dimension
+  assert(cell_order == TILEDB_ROW_MAJOR || cell_order == TILEDB_COL_MAJOR);
+  int slab_dim = (cell_order == TILEDB_ROW_MAJOR) ? dim_num-1 : 0;
+  T* coords = new T[dim_num];
+  for(int i=0; i<dim_num; ++i)
+    coords[i] = overlap_subarray[2*i];
+  for(;;) {
+    // Make a cell range representing a slab
+    T* cell_range = static_cast<T*>(arena.allocate(cell_range_size));
+    for(int i=0; i<dim_num; ++i) {
+      cell_range[i] = coords[i];
+      cell_range[dim_num + i] = coords[i];
+    }
+    cell_range[slab_dim] = overlap_subarray[2*slab_dim];
+    cell_range[dim_num + slab_dim] = overlap_subarray[2*slab_dim+1];
+    unsorted_fragment_cell_ranges.push_back(
+        FragmentCellRange(fragment_info, cell_range));
+
+    // Advance the coordinates of the other dimensions in the cell order
+    int i = (cell_order == TILEDB_ROW_MAJOR) ? dim_num-2 : 1;
+    int step = (cell_order == TILEDB_ROW_MAJOR) ? -1 : 1;
+    int last = (cell_order == TILEDB_ROW_MAJOR) ? 0 : dim_num-1;
+    ++coords[i];
+    while(i != last && coords[i] > overlap_subarray[2*i+1]) {
+      coords[i] = overlap_subarray[2*i];
+      i += step;
+      ++coords[i];
+    }
+    if(coords[last] > overlap_subarray[2*last+1])
+      break;
+  }
+
+  // Clean up
+  delete [] coords;
+}
+
 template<class T>
 int ArrayReadState::compute_fragment_cell_pos_ranges(
     FragmentCellRanges& fragment_cell_ranges,
-    FragmentCellPosRanges& fragment_cell_pos_ranges) const {
+    FragmentCellPosRanges& fragment_cell_pos_ranges,
+    const std::vector<ReadState*>& read_states) const {
   // For easy reference
   const ArraySchema* array_schema = array_->array_schema();
   int dim_num = array_schema->dim_num();
@@ -192,7 +371,7 @@ int ArrayReadState::compute_fragment_cell_pos_ranges(
   for(int64_t i=0; i<fragment_cell_ranges_num; ++i) { 
     fragment_i = fragment_cell_ranges[i].first.first;
     if(fragment_i == -1 ||
-       fragment_read_states_[fragment_i]->dense()) {  // DENSE
+       read_states[fragment_i]->dense()) {  // DENSE
       // Create a new fragment cell position range
       FragmentCellPosRange fragment_cell_pos_range;
       fragment_cell_pos_range.first = fragment_cell_ranges[i].first;
@@ -200,19 +379,28 @@ int ArrayReadState::compute_fragment_cell_pos_ranges(
       T* cell_range = static_cast<T*>(fragment_cell_ranges[i].second);
       cell_pos_range.first = array_schema->get_cell_pos(cell_range);
       cell_pos_range.second = array_schema->get_cell_pos(&cell_range[dim_num]);
+      // Coalesce with the previous range if the two slabs are contiguous in 
+      // the same tile (e.g., when the subarray spans whole tile rows), so 
+      // that they are copied at once
+      if(!fragment_cell_pos_ranges.empty()) {
+        FragmentCellPosRange& last = fragment_cell_pos_ranges.back();
+        if(last.first == fragment_cell_pos_range.first &&
+           last.second.second + 1 == cell_pos_range.first) {
+          last.second.second = cell_pos_range.second;
+          continue;
+        }
+      }
       // Insert into the result
       fragment_cell_pos_ranges.push_back(fragment_cell_pos_range); 
     } else {                                          // SPARSE
       // Create a new fragment cell position range
       FragmentCellPosRange fragment_cell_pos_range;
-      if(fragment_read_states_[fragment_cell_ranges[i].first.first]->
+      if(read_states[fragment_cell_ranges[i].first.first]->
             get_fragment_cell_pos_range_sparse<T>(
                 fragment_cell_ranges[i].first,
                 static_cast<T*>(fragment_cell_ranges[i].second),
                 fragment_cell_pos_range) != TILEDB_RS_OK) {
         // Clean up
-        for(int j=i; j<fragment_cell_ranges_num; ++j) 
-          free(fragment_cell_ranges[j].second);
         fragment_cell_ranges.clear();
         fragment_cell_pos_ranges.clear();
         // Exit
@@ -222,9 +410,6 @@ int ArrayReadState::compute_fragment_cell_pos_ranges(
       if(fragment_cell_pos_range.second.first != -1)
         fragment_cell_pos_ranges.push_back(fragment_cell_pos_range);
     }
-    
-    // Clean up corresponding input cell range
-    free(fragment_cell_ranges[i].second);
   }
 
   // Clean up
@@ -271,21 +456,47 @@ void ArrayReadState::compute_min_bounding_coords_end() {
 
 template<class T>
 int ArrayReadState::compute_unsorted_fragment_cell_ranges_dense(
-    FragmentCellRanges& unsorted_fragment_cell_ranges) {
+    FragmentCellRanges& unsorted_fragment_cell_ranges,
+    Arena& arena) {
   // For easy reference
   const ArraySchema* array_schema = array_->array_schema();
-  size_t coords_size = array_schema->coords_size();
+  int dim_num = array_schema->dim_num();
+  const T* subarray = static_cast<const T*>(array_->subarray());
+
+  // Compute the overlap of the subarray with the current tile
+  T* tile_subarray = new T[2*dim_num];
+  T* overlap_subarray = new T[2*dim_num];
+  array_schema->get_tile_subarray(
+      static_cast<const T*>(subarray_tile_coords_), 
+      tile_subarray);
+  int overlap = 
+      array_schema->subarray_overlap(subarray, tile_subarray, overlap_subarray);
+  int64_t overlap_cell_num = cell_num_in_subarray(overlap_subarray, dim_num);
+  bool covered = false;
 
   // Compute cell ranges for all fragments
-  for(int i=0; i<fragment_num_; ++i) {
+  int rc = TILEDB_ARS_OK;
+  for(int i=0; i<fragment_num_ && rc == TILEDB_ARS_OK; ++i) {
     if(!fragment_read_states_[i]->done()) {
       if(fragment_read_states_[i]->dense()) {     // DENSE
         // Get fragment cell ranges
         FragmentCellRanges fragment_cell_ranges;
         if(fragment_read_states_[i]->get_fragment_cell_ranges_dense<T>(
             i,
-            fragment_cell_ranges) != TILEDB_RS_OK)
-          return TILEDB_ARS_ERR;
+            fragment_cell_ranges,
+            arena) != TILEDB_RS_OK) {
+          rc = TILEDB_ARS_ERR;
+          break;
+        }
+        // The fragment may hold every cell of the overlap
+        int64_t cell_num = 0;
+        for(int j=0; j<fragment_cell_ranges.size(); ++j) {
+          const T* cell_range = static_cast<T*>(fragment_cell_ranges[j].second);
+          cell_num += array_schema->get_cell_pos(&cell_range[dim_num]) - 
+                      array_schema->get_cell_pos(cell_range) + 1;
+        }
+        if(cell_num == overlap_cell_num)
+          covered = true;
         // Insert fragment cell ranges to the result
         unsorted_fragment_cell_ranges.insert(
             unsorted_fragment_cell_ranges.end(),
@@ -301,8 +512,11 @@ int ArrayReadState::compute_unsorted_fragment_cell_ranges_dense(
           fragment_cell_ranges.clear();
           if(fragment_read_states_[i]->get_fragment_cell_ranges_sparse<T>(
              i,
-             fragment_cell_ranges) != TILEDB_RS_OK)
-            return TILEDB_ARS_ERR;
+             fragment_cell_ranges,
+             arena) != TILEDB_RS_OK) {
+            rc = TILEDB_ARS_ERR;
+            break;
+          }
           // Insert fragment cell ranges to the result
           unsorted_fragment_cell_ranges.insert(
               unsorted_fragment_cell_ranges.end(),
@@ -314,13 +528,27 @@ int ArrayReadState::compute_unsorted_fragment_cell_ranges_dense(
     }
   }
 
-  // Success
-  return TILEDB_ARS_OK;
+  // Read the cells that no fragment holds as empty, unless a single fragment
+  // holds them all
+  if(rc == TILEDB_ARS_OK && !covered)
+    compute_empty_fragment_cell_ranges_dense<T>(
+        overlap_subarray,
+        overlap,
+        unsorted_fragment_cell_ranges,
+        arena);
+
+  // Clean up
+  delete [] tile_subarray;
+  delete [] overlap_subarray;
+
+  // Return
+  return rc;
 }
 
 template<class T>
 int ArrayReadState::compute_unsorted_fragment_cell_ranges_sparse(
-    FragmentCellRanges& unsorted_fragment_cell_ranges) {
+    FragmentCellRanges& unsorted_fragment_cell_ranges,
+    Arena& arena) {
   // For easy reference
   const ArraySchema* array_schema = array_->array_schema();
   int dim_num = array_schema->dim_num();
@@ -341,7 +569,8 @@ int ArrayReadState::compute_unsorted_fragment_cell_ranges_sparse(
           i,
           fragment_bounding_coords,
           min_bounding_coords_end,
-          fragment_cell_ranges) != TILEDB_RS_OK)
+          fragment_cell_ranges,
+          arena) != TILEDB_RS_OK)
         return TILEDB_ARS_ERR;
 
       unsorted_fragment_cell_ranges.insert(
@@ -394,8 +623,10 @@ int ArrayReadState::copy_cells(
   // Sanity check
   assert(!array_schema->var_size(attribute_id));
 
-  // Copy the cell ranges one by one
-  for(int64_t i=0; i<fragment_cell_pos_ranges_num; ++i) {
+  // Copy the cell ranges one by one, resuming from the range that did not
+  // fit in the buffers last time
+  int64_t& i = copy_range_pos_[attribute_id];
+  for(; i<fragment_cell_pos_ranges_num; ++i) {
     int64_t tile_i = fragment_cell_pos_ranges[i].first.second;
     fragment_i = fragment_cell_pos_ranges[i].first.first; 
     tile_i = fragment_cell_pos_ranges[i].first.second; 
@@ -436,6 +667,7 @@ int ArrayReadState::copy_cells(
   if(!overflow_[attribute_id]) {
     ++fragment_cell_pos_ranges_vec_pos_[attribute_id];
     read_round_done_[attribute_id] = true;
+    i = 0;
   } else {
     read_round_done_[attribute_id] = false;
   }
@@ -466,8 +698,10 @@ int ArrayReadState::copy_cells_var(
   // Sanity check
   assert(array_schema->var_size(attribute_id));
 
-  // Copy the cell ranges one by one
-  for(int64_t i=0; i<fragment_cell_pos_ranges_num; ++i) {
+  // Copy the cell ranges one by one, resuming from the range that did not
+  // fit in the buffers last time
+  int64_t& i = copy_range_pos_[attribute_id];
+  for(; i<fragment_cell_pos_ranges_num; ++i) {
     tile_i = fragment_cell_pos_ranges[i].first.second; 
     fragment_i = fragment_cell_pos_ranges[i].first.first; 
     CellPosRange& cell_pos_range = fragment_cell_pos_ranges[i].second; 
@@ -513,6 +747,7 @@ int ArrayReadState::copy_cells_var(
   if(!overflow_[attribute_id]) {
     ++fragment_cell_pos_ranges_vec_pos_[attribute_id];
     read_round_done_[attribute_id] = true;
+    i = 0;
   } else {
     read_round_done_[attribute_id] = false;
   }
@@ -555,31 +790,9 @@ void ArrayReadState::copy_cells_with_empty(
   size_t bytes_to_copy = std::min(bytes_left_to_copy, buffer_free_space); 
   int64_t cell_num_to_copy = bytes_to_copy / cell_size; 
 
-  // Get the empty value 
-  int type = array_schema->type(attribute_id);
-  void* empty_cell = malloc(cell_size);
-  if(type == TILEDB_INT32) {
-    int empty_cell_v = TILEDB_EMPTY_INT32;
-    memcpy(empty_cell, &empty_cell_v, cell_size);
-  } else if(type == TILEDB_INT64) {
-    int64_t empty_cell_v = TILEDB_EMPTY_INT64;
-    memcpy(empty_cell, &empty_cell_v, cell_size);
-  } else if(type == TILEDB_FLOAT32) {
-    float empty_cell_v = TILEDB_EMPTY_FLOAT32;
-    memcpy(empty_cell, &empty_cell_v, cell_size);
-  } else if(type == TILEDB_FLOAT64) {
-    double empty_cell_v = TILEDB_EMPTY_FLOAT64;
-    memcpy(empty_cell, &empty_cell_v, cell_size);
-  } else if(type == TILEDB_CHAR) {
-    char empty_cell_v = TILEDB_EMPTY_CHAR;
-    memcpy(empty_cell, &empty_cell_v, cell_size);
-  }
-
   // Copy empty cells to buffer
-  for(int64_t i=0; i<cell_num_to_copy; ++i) {
-    memcpy(buffer_c + buffer_offset, empty_cell, cell_size);
-    buffer_offset += cell_size;
-  } 
+  fill_empty_cells(attribute_id, buffer_c + buffer_offset, cell_num_to_copy);
+  buffer_offset += bytes_to_copy;
   empty_cells_written_[attribute_id] += cell_num_to_copy;
 
   // Handle buffer overflow
@@ -587,9 +800,6 @@ void ArrayReadState::copy_cells_with_empty(
     overflow_[attribute_id] = true;
   else // Done copying this range
     empty_cells_written_[attribute_id] = 0;
-
-  // Clean up
-  free(empty_cell);
 }
 
 template<class T>
@@ -619,31 +829,19 @@ void ArrayReadState::copy_cells_with_empty_var(
     return;
   }
 
-  // Get the empty value 
+  // Get the size of the empty value 
   int type = array_schema->type(attribute_id);
-  void* empty_cell = malloc(cell_size);
   size_t cell_size_var;
-  if(type == TILEDB_INT32) {
-    int empty_cell_v = TILEDB_EMPTY_INT32;
-    memcpy(empty_cell, &empty_cell_v, cell_size);
+  if(type == TILEDB_INT32) 
     cell_size_var = sizeof(int);
-  } else if(type == TILEDB_INT64) {
-    int64_t empty_cell_v = TILEDB_EMPTY_INT64;
-    memcpy(empty_cell, &empty_cell_v, cell_size);
+  else if(type == TILEDB_INT64) 
     cell_size_var = sizeof(int64_t);
-  } else if(type == TILEDB_FLOAT32) {
-    float empty_cell_v = TILEDB_EMPTY_FLOAT32;
-    memcpy(empty_cell, &empty_cell_v, cell_size);
+  else if(type == TILEDB_FLOAT32) 
     cell_size_var = sizeof(float);
-  } else if(type == TILEDB_FLOAT64) {
-    double empty_cell_v = TILEDB_EMPTY_FLOAT64;
-    memcpy(empty_cell, &empty_cell_v, cell_size);
+  else if(type == TILEDB_FLOAT64) 
     cell_size_var = sizeof(double);
-  } else if(type == TILEDB_CHAR) {
-    char empty_cell_v = TILEDB_EMPTY_CHAR;
-    memcpy(empty_cell, &empty_cell_v, cell_size);
+  else if(type == TILEDB_CHAR) 
     cell_size_var = sizeof(char);
-  }
 
   // Sanity check
   assert(array_schema->var_size(attribute_id));
@@ -661,19 +859,37 @@ void ArrayReadState::copy_cells_with_empty_var(
   int64_t cell_num_to_copy_var = bytes_to_copy_var / cell_size_var; 
   cell_num_to_copy = std::min(cell_num_to_copy, cell_num_to_copy_var);
 
-  // Copy empty cells to buffers
-  for(int64_t i=0; i<cell_num_to_copy; ++i) {
-    memcpy(
-        buffer_c + buffer_offset, 
-        &buffer_var_offset, 
-        cell_size);
-    buffer_offset += cell_size;
-    memcpy(
-        buffer_var_c + buffer_var_offset, 
-        empty_cell,
-        cell_size_var);
-    buffer_var_offset += cell_size_var;
-  }
+  // Write the offsets of the empty cells, each holding a single value
+  size_t* buffer_s = reinterpret_cast<size_t*>(buffer_c + buffer_offset);
+  for(int64_t i=0; i<cell_num_to_copy; ++i) 
+    buffer_s[i] = buffer_var_offset + i*cell_size_var;
+  buffer_offset += cell_num_to_copy * cell_size;
+
+  // Fill the variable-sized buffer with empty values in a single pass
+  char* buffer_var_start = buffer_var_c + buffer_var_offset;
+  if(type == TILEDB_INT32) 
+    fill_values<int>(
+        reinterpret_cast<int*>(buffer_var_start), 
+        TILEDB_EMPTY_INT32, 
+        cell_num_to_copy);
+  else if(type == TILEDB_INT64) 
+    fill_values<int64_t>(
+        reinterpret_cast<int64_t*>(buffer_var_start), 
+        TILEDB_EMPTY_INT64, 
+        cell_num_to_copy);
+  else if(type == TILEDB_FLOAT32) 
+    fill_values<float>(
+        reinterpret_cast<float*>(buffer_var_start), 
+        TILEDB_EMPTY_FLOAT32, 
+        cell_num_to_copy);
+  else if(type == TILEDB_FLOAT64) 
+    fill_values<double>(
+        reinterpret_cast<double*>(buffer_var_start), 
+        TILEDB_EMPTY_FLOAT64, 
+        cell_num_to_copy);
+  else if(type == TILEDB_CHAR) 
+    fill_values<char>(buffer_var_start, TILEDB_EMPTY_CHAR, cell_num_to_copy);
+  buffer_var_offset += cell_num_to_copy * cell_size_var;
   empty_cells_written_[attribute_id] += cell_num_to_copy;
 
   // Handle buffer overflow
@@ -681,9 +897,97 @@ void ArrayReadState::copy_cells_with_empty_var(
     overflow_[attribute_id] = true;
   else // Done copying this range
     empty_cells_written_[attribute_id] = 0;
+}
 
-  // Clean up
-  free(empty_cell);
+template<class T>
+int ArrayReadState::estimate_result_size(size_t* buffer_sizes) const {
+  // For easy reference
+  const ArraySchema* array_schema = array_->array_schema();
+  int attribute_num = array_schema->attribute_num();
+  int dim_num = array_schema->dim_num();
+  const std::vector<int>& attribute_ids = array_->attribute_ids();
+  int attribute_id_num = attribute_ids.size(); 
+
+  // Add up the estimates of the fragments. The cell number of a dense
+  // fragment is exact, so the largest one is a lower bound of the cells of
+  // the subarray covered by the fragments.
+  int64_t cell_num = 0;
+  int64_t covered_cell_num = 0;
+  std::vector<size_t> var_sizes(attribute_num+1, 0);
+  for(int i=0; i<fragment_num_; ++i) {
+    int64_t fragment_cell_num;
+    if(fragment_read_states_[i]->estimate_result_size<T>(
+           fragment_cell_num, 
+           var_sizes) != TILEDB_RS_OK)
+      return TILEDB_ARS_ERR;
+    cell_num += fragment_cell_num;
+    if(fragment_read_states_[i]->dense())
+      covered_cell_num = std::max(covered_cell_num, fragment_cell_num);
+  }
+
+  // A dense read returns every cell of the subarray, where the cells that 
+  // no fragment covers are empty, holding a single value if variable-sized
+  int64_t empty_cell_num = 0;
+  if(array_schema->dense()) {
+    cell_num = cell_num_in_subarray(
+                   static_cast<const T*>(array_->subarray()), 
+                   dim_num);
+    empty_cell_num = cell_num - covered_cell_num;
+  }
+
+  // Compute the buffer sizes
+  int buffer_i = 0;
+  for(int i=0; i<attribute_id_num; ++i) {
+    if(!array_schema->var_size(attribute_ids[i])) { // FIXED CELLS
+      buffer_sizes[buffer_i] = 
+          cell_num * array_schema->cell_size(attribute_ids[i]);
+      ++buffer_i;
+    } else {                                        // VARIABLE-SIZED CELLS
+      buffer_sizes[buffer_i] = cell_num * TILEDB_CELL_VAR_OFFSET_SIZE;
+      buffer_sizes[buffer_i+1] = 
+          var_sizes[attribute_ids[i]] + 
+          empty_cell_num * array_schema->type_size(attribute_ids[i]);
+      buffer_i += 2;
+    }
+  }
+
+  // Success
+  return TILEDB_ARS_OK;
+}
+
+void ArrayReadState::fill_empty_cells(
+    int attribute_id,
+    void* buffer,
+    int64_t cell_num) const {
+  // For easy reference
+  const ArraySchema* array_schema = array_->array_schema();
+  int type = array_schema->type(attribute_id);
+  size_t size = cell_num * array_schema->cell_size(attribute_id);
+
+  // Fill the buffer in a single pass, since every value of an empty cell is
+  // the empty value of the attribute type
+  if(type == TILEDB_INT32) 
+    fill_values<int>(
+        static_cast<int*>(buffer), 
+        TILEDB_EMPTY_INT32, 
+        size / sizeof(int));
+  else if(type == TILEDB_INT64) 
+    fill_values<int64_t>(
+        static_cast<int64_t*>(buffer), 
+        TILEDB_EMPTY_INT64, 
+        size / sizeof(int64_t));
+  else if(type == TILEDB_FLOAT32) 
+    fill_values<float>(
+        static_cast<float*>(buffer), 
+        TILEDB_EMPTY_FLOAT32, 
+        size / sizeof(float));
+  else if(type == TILEDB_FLOAT64) 
+    fill_values<double>(
+        static_cast<double*>(buffer), 
+        TILEDB_EMPTY_FLOAT64, 
+        size / sizeof(double));
+  else if(type == TILEDB_CHAR) 
+    fill_values<char>(static_cast<char*>(buffer), TILEDB_EMPTY_CHAR, size);
 }
 
 template<class T>
@@ -692,6 +996,27 @@ int ArrayReadState::get_next_fragment_cell_ranges_dense() {
   if(done_)
     return TILEDB_ARS_OK;
 
+  // Compute the cell ranges of several read rounds ahead
+  int64_t first_new_round = fragment_cell_pos_ranges_vec_.size();
+  for(int i=0; i<TILEDB_PREFETCH_ROUND_NUM; ++i) {
+    if(get_next_fragment_cell_ranges_dense_round<T>() != TILEDB_ARS_OK)
+      return TILEDB_ARS_ERR;
+    if(done_)
+      break;
+  }
+
+  // Fetch and decompress the tiles of the new read rounds in parallel
+  prefetch_tiles(first_new_round);
+
+  // Clean up processed overlapping tiles
+  clean_up_processed_fragment_cell_pos_ranges();
+
+  // Success
+  return TILEDB_ARS_OK;
+}
+
+template<class T>
+int ArrayReadState::get_next_fragment_cell_ranges_dense_round() {
   // Get the next overlapping tile for each fragment
   get_next_overlapping_tiles_dense<T>();
 
@@ -699,32 +1024,38 @@ int ArrayReadState::get_next_fragment_cell_ranges_dense() {
   if(done_) 
     return TILEDB_ARS_OK;
 
+  // The cell ranges of the round are allocated from a recycled arena, since
+  // they are all consumed by the end of the round
+  Arena& arena = cell_range_arenas_[0];
+  arena.reset();
+
   // Compute the unsorted fragment cell ranges needed for this read run
   FragmentCellRanges unsorted_fragment_cell_ranges;
   if(compute_unsorted_fragment_cell_ranges_dense<T>(
-         unsorted_fragment_cell_ranges) != TILEDB_ARS_OK)
+         unsorted_fragment_cell_ranges,
+         arena) != TILEDB_ARS_OK)
     return TILEDB_ARS_ERR;
 
   // Sort fragment cell ranges
   FragmentCellRanges fragment_cell_ranges;
   if(sort_fragment_cell_ranges<T>(
          unsorted_fragment_cell_ranges, 
-         fragment_cell_ranges) != TILEDB_ARS_OK) 
+         fragment_cell_ranges,
+         fragment_read_states_,
+         arena) != TILEDB_ARS_OK) 
     return TILEDB_ARS_ERR;
 
   // Compute the fragment cell position ranges
   FragmentCellPosRanges fragment_cell_pos_ranges;
   if(compute_fragment_cell_pos_ranges<T>(
          fragment_cell_ranges, 
-         fragment_cell_pos_ranges) != TILEDB_ARS_OK) 
+         fragment_cell_pos_ranges,
+         fragment_read_states_) != TILEDB_ARS_OK) 
     return TILEDB_ARS_ERR;
 
   // Insert cell pos ranges in the state
   fragment_cell_pos_ranges_vec_.push_back(fragment_cell_pos_ranges);
 
-  // Clean up processed overlapping tiles
-  clean_up_processed_fragment_cell_pos_ranges();
-
   // Success
   return TILEDB_ARS_OK;
 }
@@ -736,6 +1067,43 @@ int ArrayReadState::get_next_fragment_cell_ranges_sparse() {
   if(done_)
     return TILEDB_ARS_OK;
 
+  // Compute the unsorted cell ranges of several read rounds ahead. Each 
+  // round covers a separate part of the coordinate space, bounded by the
+  // bounding coordinates of the current fragment tiles, and allocates its
+  // cell ranges from its own (recycled) arena
+  std::vector<FragmentCellRanges> unsorted_fragment_cell_ranges_vec;
+  for(int i=0; i<TILEDB_PREFETCH_ROUND_NUM; ++i) {
+    FragmentCellRanges unsorted_fragment_cell_ranges;
+    cell_range_arenas_[i].reset();
+    if(get_next_fragment_cell_ranges_sparse_round<T>(
+           unsorted_fragment_cell_ranges,
+           cell_range_arenas_[i]) != TILEDB_ARS_OK) 
+      return TILEDB_ARS_ERR;
+    if(done_)
+      break;
+    unsorted_fragment_cell_ranges_vec.push_back(unsorted_fragment_cell_ranges);
+  }
+
+  // Merge the cell ranges of the new read rounds in parallel
+  int64_t first_new_round = fragment_cell_pos_ranges_vec_.size();
+  if(merge_fragment_cell_ranges_sparse<T>(
+         unsorted_fragment_cell_ranges_vec) != TILEDB_ARS_OK)
+    return TILEDB_ARS_ERR;
+
+  // Fetch and decompress the tiles of the new read rounds in parallel
+  prefetch_tiles(first_new_round);
+
+  // Clean up processed overlapping tiles
+  clean_up_processed_fragment_cell_pos_ranges();
+
+  // Success
+  return TILEDB_ARS_OK;
+}
+
+template<class T>
+int ArrayReadState::get_next_fragment_cell_ranges_sparse_round(
+    FragmentCellRanges& unsorted_fragment_cell_ranges,
+    Arena& arena) {
   // Gets the next overlapping tiles in the fragment read states
   get_next_overlapping_tiles_sparse<T>();
 
@@ -747,31 +1115,11 @@ int ArrayReadState::get_next_fragment_cell_ranges_sparse() {
   compute_min_bounding_coords_end<T>(); 
 
   // Compute the unsorted fragment cell ranges needed for this read run
-  FragmentCellRanges unsorted_fragment_cell_ranges;
   if(compute_unsorted_fragment_cell_ranges_sparse<T>(
-         unsorted_fragment_cell_ranges) != TILEDB_ARS_OK)
-    return TILEDB_ARS_ERR;
-
-  // Sort fragment cell ranges
-  FragmentCellRanges fragment_cell_ranges;
-  if(sort_fragment_cell_ranges<T>(
-         unsorted_fragment_cell_ranges, 
-         fragment_cell_ranges) != TILEDB_ARS_OK) 
-    return TILEDB_ARS_ERR;
-
-  // Compute the fragment cell position ranges
-  FragmentCellPosRanges fragment_cell_pos_ranges;
-  if(compute_fragment_cell_pos_ranges<T>(
-         fragment_cell_ranges, 
-         fragment_cell_pos_ranges) != TILEDB_ARS_OK) 
+         unsorted_fragment_cell_ranges,
+         arena) != TILEDB_ARS_OK)
     return TILEDB_ARS_ERR;
 
-  // Insert cell pos ranges in the state
-  fragment_cell_pos_ranges_vec_.push_back(fragment_cell_pos_ranges);
-
-  // Clean up processed overlapping tiles
-  clean_up_processed_fragment_cell_pos_ranges();
-
   // Success
   return TILEDB_ARS_OK;
 }
@@ -844,9 +1192,8 @@ void ArrayReadState::get_next_overlapping_tiles_sparse() {
   size_t coords_size = array_schema->coords_size();
 
   // Get the first overlapping tile for each fragment
-  if(fragment_cell_pos_ranges_vec_.size() == 0) {
+  if(fragment_bounding_coords_.size() == 0) {
     // Initializations 
-    assert(fragment_bounding_coords_.size() == 0);
     fragment_bounding_coords_.resize(fragment_num_);
 
     // Get next overlapping tile and bounding coordinates 
@@ -980,6 +1327,138 @@ void ArrayReadState::get_next_subarray_tile_coords() {
   } 
 }
 
+template<class T>
+int ArrayReadState::merge_fragment_cell_ranges_sparse(
+    std::vector<FragmentCellRanges>& unsorted_fragment_cell_ranges_vec) {
+  // For easy reference
+  int round_num = unsorted_fragment_cell_ranges_vec.size();
+  std::vector<Fragment*> fragments = array_->fragments();
+
+  // Trivial case
+  if(round_num == 0)
+    return TILEDB_ARS_OK;
+
+  // Each round searches the coordinate tiles with its own fragment read
+  // states, since the searches fetch tiles into the read state buffers. 
+  // A single round uses the main fragment read states.
+  if(round_num > 1 && 
+     int(merge_read_states_.size()) < round_num) 
+    merge_read_states_.resize(
+        round_num, 
+        std::vector<ReadState*>(fragment_num_, NULL));
+  for(int i=0; round_num > 1 && i<round_num; ++i) {
+    const FragmentCellRanges& unsorted_fragment_cell_ranges = 
+        unsorted_fragment_cell_ranges_vec[i];
+    int64_t range_num = unsorted_fragment_cell_ranges.size();
+    for(int64_t j=0; j<range_num; ++j) {
+      int fragment_i = unsorted_fragment_cell_ranges[j].first.first;
+      if(fragment_i != -1 && merge_read_states_[i][fragment_i] == NULL) 
+        merge_read_states_[i][fragment_i] = 
+            new ReadState(
+                fragments[fragment_i], 
+                fragments[fragment_i]->book_keeping());
+    }
+  }
+
+  // Cut and sort the cell ranges, and compute the cell position ranges of
+  // each round in parallel
+  std::vector<FragmentCellPosRanges> fragment_cell_pos_ranges_vec(round_num);
+  std::vector<int> rcs(round_num, TILEDB_ARS_OK);
+  #pragma omp parallel for schedule(dynamic) if(round_num > 1) \
+      num_threads(array_->config()->thread_num())
+  for(int i=0; i<round_num; ++i) {
+    const std::vector<ReadState*>& read_states = 
+        (round_num > 1) ? merge_read_states_[i] : fragment_read_states_;
+    FragmentCellRanges fragment_cell_ranges;
+    rcs[i] = sort_fragment_cell_ranges<T>(
+                 unsorted_fragment_cell_ranges_vec[i], 
+                 fragment_cell_ranges,
+                 read_states,
+                 cell_range_arenas_[i]);
+    if(rcs[i] == TILEDB_ARS_OK)
+      rcs[i] = compute_fragment_cell_pos_ranges<T>(
+                   fragment_cell_ranges, 
+                   fragment_cell_pos_ranges_vec[i],
+                   read_states);
+  }
+
+  // Check for errors
+  for(int i=0; i<round_num; ++i) 
+    if(rcs[i] != TILEDB_ARS_OK)
+      return TILEDB_ARS_ERR;
+
+  // Insert the cell pos ranges in the state in the global cell order
+  fragment_cell_pos_ranges_vec_.insert(
+      fragment_cell_pos_ranges_vec_.end(),
+      fragment_cell_pos_ranges_vec.begin(),
+      fragment_cell_pos_ranges_vec.end());
+
+  // Success
+  return TILEDB_ARS_OK;
+}
+
+void ArrayReadState::prefetch_tiles(int64_t first_round) const {
+  // Trivial case - the tile cache is disabled
+  TileCache* tile_cache = TileCache::instance();
+  size_t prefetch_size_max = tile_cache->capacity() / 2;
+  if(prefetch_size_max == 0)
+    return;
+
+  // For easy reference
+  const ArraySchema* array_schema = array_->array_schema();
+  const std::vector<int>& attribute_ids = array_->attribute_ids();
+  int attribute_id_num = attribute_ids.size(); 
+  std::vector<Fragment*> fragments = array_->fragments();
+  int64_t round_num = fragment_cell_pos_ranges_vec_.size();
+
+  // Collect the distinct (fragment, tile) pairs of the read rounds
+  std::set<FragmentInfo> fragment_tiles;
+  for(int64_t i=first_round; i<round_num; ++i) {
+    const FragmentCellPosRanges& fragment_cell_pos_ranges = 
+        fragment_cell_pos_ranges_vec_[i];
+    int64_t fragment_cell_pos_ranges_num = fragment_cell_pos_ranges.size();
+    for(int64_t j=0; j<fragment_cell_pos_ranges_num; ++j) 
+      if(fragment_cell_pos_ranges[j].first.first != -1) // Non-empty fragment
+        fragment_tiles.insert(fragment_cell_pos_ranges[j].first);
+  }
+
+  // Create a prefetch task per attribute and (fragment, tile) pair, stopping
+  // altogether as soon as the prefetch budget is exhausted
+  std::vector<std::pair<int, FragmentInfo> > tasks;
+  size_t prefetch_size = 0;
+  bool budget_exhausted = false;
+  std::set<FragmentInfo>::const_iterator it = fragment_tiles.begin();
+  for(; it != fragment_tiles.end() && !budget_exhausted; ++it) {
+    for(int i=0; i<attribute_id_num; ++i) {
+      if(array_schema->compression(attribute_ids[i]) == TILEDB_NO_COMPRESSION)
+        continue;
+      size_t tile_size = fragments[it->first]->tile_size(attribute_ids[i]);
+      if(array_schema->var_size(attribute_ids[i]))
+        tile_size *= 2; // Rough estimate of the variable tile
+      if(prefetch_size + tile_size > prefetch_size_max) {
+        budget_exhausted = true;
+        break;
+      }
+      prefetch_size += tile_size;
+      tasks.push_back(std::pair<int, FragmentInfo>(attribute_ids[i], *it));
+    }
+  }
+
+  // Nothing to parallelize
+  int64_t task_num = tasks.size();
+  if(task_num < 2)
+    return;
+
+  // Prefetch the tiles in parallel - this is best-effort, since any error
+  // will be reported when the tile is actually fetched
+  #pragma omp parallel for schedule(dynamic) \
+      num_threads(array_->config()->thread_num())
+  for(int64_t i=0; i<task_num; ++i) 
+    fragment_read_states_[tasks[i].second.first]->prefetch_tile(
+        tasks[i].first,
+        tasks[i].second.second);
+}
+
 int ArrayReadState::read_dense(
     void** buffers,  
     size_t* buffer_sizes) {
@@ -1196,6 +1675,63 @@ int ArrayReadState::read_dense_attr_var(
   }
 }
 
+int ArrayReadState::read_dense_attr_view(
+    int attribute_id,
+    const void*& view,  
+    size_t& view_size) {
+  // For easy reference
+  const ArraySchema* array_schema = array_->array_schema();
+  int coords_type = array_schema->coords_type();
+
+  // Invoke the proper templated function
+  if(coords_type == TILEDB_INT32) {
+    return read_dense_attr_view<int>(
+               attribute_id, 
+               view, 
+               view_size);
+  }   else if(coords_type == TILEDB_INT64) {
+    return read_dense_attr_view<int64_t>(
+               attribute_id, 
+               view, 
+               view_size);
+  } else {
+    PRINT_ERROR("Cannot read views from array; Invalid coordinates type");
+    return TILEDB_ARS_ERR;
+  }
+}
+
+template<class T>
+int ArrayReadState::read_dense_attr_view(
+    int attribute_id,
+    const void*& view,  
+    size_t& view_size) {
+  // Until a non-empty view is found or the read is done
+  for(;;) {
+    // Prepare the cell ranges for the next read round
+    if(fragment_cell_pos_ranges_vec_pos_[attribute_id] >= 
+       fragment_cell_pos_ranges_vec_.size()) {
+      // Get next cell ranges
+      if(get_next_fragment_cell_ranges_dense<T>() != TILEDB_ARS_OK)
+        return TILEDB_ARS_ERR;
+    }
+
+    // Check if read is done
+    if(done_ &&
+       fragment_cell_pos_ranges_vec_pos_[attribute_id] == 
+       fragment_cell_pos_ranges_vec_.size()) {
+      view = NULL;
+      view_size = 0;
+      return TILEDB_ARS_OK;
+    }
+
+    // Expose the next run of cells
+    if(view_cells(attribute_id, view, view_size) != TILEDB_ARS_OK)
+      return TILEDB_ARS_ERR;
+    if(view_size != 0)
+      return TILEDB_ARS_OK;
+  }
+}
+
 int ArrayReadState::read_sparse(
     void** buffers,  
     size_t* buffer_sizes) {
@@ -1468,12 +2004,91 @@ int ArrayReadState::read_sparse_attr_var(
   }
 }
 
+int ArrayReadState::read_sparse_attr_view(
+    int attribute_id,
+    const void*& view,  
+    size_t& view_size) {
+  // For easy reference
+  const ArraySchema* array_schema = array_->array_schema();
+  int coords_type = array_schema->coords_type();
+
+  // Invoke the proper templated function
+  if(coords_type == TILEDB_INT32) {
+    return read_sparse_attr_view<int>(
+               attribute_id, 
+               view, 
+               view_size);
+  }   else if(coords_type == TILEDB_INT64) {
+    return read_sparse_attr_view<int64_t>(
+               attribute_id, 
+               view, 
+               view_size);
+  }   else if(coords_type == TILEDB_FLOAT32) {
+    return read_sparse_attr_view<float>(
+               attribute_id, 
+               view, 
+               view_size);
+  }   else if(coords_type == TILEDB_FLOAT64) {
+    return read_sparse_attr_view<double>(
+               attribute_id, 
+               view, 
+               view_size);
+  } else {
+    PRINT_ERROR("Cannot read views from array; Invalid coordinates type");
+    return TILEDB_ARS_ERR;
+  }
+}
+
+template<class T>
+int ArrayReadState::read_sparse_attr_view(
+    int attribute_id,
+    const void*& view,  
+    size_t& view_size) {
+  // Until a non-empty view is found or the read is done
+  for(;;) {
+    // Prepare the cell ranges for the next read round
+    if(fragment_cell_pos_ranges_vec_pos_[attribute_id] >= 
+       fragment_cell_pos_ranges_vec_.size()) {
+      // Get next cell ranges
+      if(get_next_fragment_cell_ranges_sparse<T>() != TILEDB_ARS_OK)
+        return TILEDB_ARS_ERR;
+    }
+
+    // Check if read is done
+    if(done_ &&
+       fragment_cell_pos_ranges_vec_pos_[attribute_id] == 
+       fragment_cell_pos_ranges_vec_.size()) {
+      view = NULL;
+      view_size = 0;
+      return TILEDB_ARS_OK;
+    }
+
+    // Expose the next run of cells
+    if(view_cells(attribute_id, view, view_size) != TILEDB_ARS_OK)
+      return TILEDB_ARS_ERR;
+    if(view_size != 0)
+      return TILEDB_ARS_OK;
+  }
+}
+
 template<class T>
 int ArrayReadState::sort_fragment_cell_ranges(
     FragmentCellRanges& unsorted_fragment_cell_ranges,
-    FragmentCellRanges& fragment_cell_ranges) const {
-  // Trivial case - single fragment
-  if(fragment_num_ == 1) {
+    FragmentCellRanges& fragment_cell_ranges,
+    const std::vector<ReadState*>& read_states,
+    Arena& arena) const {
+  // Trivial case - the ranges of a single fragment are already sorted
+  int64_t unsorted_fragment_cell_ranges_num = 
+      unsorted_fragment_cell_ranges.size();
+  bool single_fragment = true;
+  for(int64_t i=1; i<unsorted_fragment_cell_ranges_num; ++i) {
+    if(unsorted_fragment_cell_ranges[i].first.first != 
+       unsorted_fragment_cell_ranges[0].first.first) {
+      single_fragment = false;
+      break;
+    }
+  }
+  if(single_fragment) {
     fragment_cell_ranges = unsorted_fragment_cell_ranges;
     unsorted_fragment_cell_ranges.clear();
     return TILEDB_ARS_OK;
@@ -1504,7 +2119,6 @@ int ArrayReadState::sort_fragment_cell_ranges(
       FragmentCellRange,
       FragmentCellRanges,
       SmallerFragmentCellRange<T> > pq(array_schema);
-  int unsorted_fragment_cell_ranges_num = unsorted_fragment_cell_ranges.size();
   for(int64_t i=0; i<unsorted_fragment_cell_ranges_num; ++i)  
     pq.push(unsorted_fragment_cell_ranges[i]);
   unsorted_fragment_cell_ranges.clear();
@@ -1535,48 +2149,44 @@ int ArrayReadState::sort_fragment_cell_ranges(
 
     // Dinstinguish two cases
     if(popped_fragment_i == -1 ||                       // DENSE OR UNARY POPPED
-       fragment_read_states_[popped_fragment_i]->dense() ||
+       read_states[popped_fragment_i]->dense() ||
        !memcmp(popped_range, &popped_range[dim_num], coords_size)) { 
       // Keep on discarding ranges from the queue
       while(!pq.empty() &&
             top_fragment_i < popped_fragment_i &&
-            array_schema->cell_order_cmp(top_range, popped_range) >= 0 &&
-            array_schema->cell_order_cmp(
+            array_schema->tile_cell_order_cmp(top_range, popped_range) >= 0 &&
+            array_schema->tile_cell_order_cmp(
                 top_range, 
                 &popped_range[dim_num]) <= 0) {
         // Cut the top range and re-insert, only if there is partial overlap
-        if(array_schema->cell_order_cmp(
+        if(array_schema->tile_cell_order_cmp(
                &top_range[dim_num], 
                &popped_range[dim_num]) > 0) {
           // Create the new trimmed top range
           FragmentCellRange trimmed_top;
           trimmed_top.first = FragmentInfo(top_fragment_i, top_tile_i);
-          trimmed_top.second = malloc(2*coords_size);
+          trimmed_top.second = arena.allocate(2*coords_size);
           T* trimmed_top_range = static_cast<T*>(trimmed_top.second);
           memcpy(trimmed_top_range, &popped_range[dim_num], coords_size);
           memcpy(&trimmed_top_range[dim_num], &top_range[dim_num], coords_size);
-          if(fragment_read_states_[top_fragment_i]->dense()) {
-            array_schema->get_next_cell_coords<T>( // TOP IS DENSE
+          if(top_fragment_i == -1 ||               // TOP IS DENSE
+             read_states[top_fragment_i]->dense()) {
+            array_schema->get_next_cell_coords<T>(
                 tile_domain, 
                 trimmed_top_range);
             pq.push(trimmed_top);
           } else {                                 // TOP IS SPARSE
             bool coords_retrieved;
-            if(fragment_read_states_[top_fragment_i]->get_coords_after(
+            if(read_states[top_fragment_i]->get_coords_after(
+                   top_tile_i,
                    &popped_range[dim_num], 
                    trimmed_top_range,
-                   coords_retrieved)) {
-              free(trimmed_top_range);
+                   coords_retrieved))
               return TILEDB_ARS_ERR;
-            }
             if(coords_retrieved)
               pq.push(trimmed_top);
-            else
-              free(trimmed_top_range);
           }
-        } else { // Simply discard top and get a new one
-          free(top.second);
-        }
+        } // else, simply discard top and get a new one
 
         // Get a new top
         pq.pop();
@@ -1589,14 +2199,14 @@ int ArrayReadState::sort_fragment_cell_ranges(
       // Potentially trim the popped range
       if(!pq.empty() && 
          top_fragment_i > popped_fragment_i && 
-         array_schema->cell_order_cmp(
+         array_schema->tile_cell_order_cmp(
              top_range, 
              &popped_range[dim_num]) <= 0) {         
         // Create a new popped range
         FragmentCellRange extra_popped;
         extra_popped.first.first = popped_fragment_i;
         extra_popped.first.second = popped_tile_i;
-        extra_popped.second = malloc(2*coords_size);
+        extra_popped.second = arena.allocate(2*coords_size);
         T* extra_popped_range = static_cast<T*>(extra_popped.second);
 
         memcpy(extra_popped_range, top_range, coords_size);
@@ -1631,13 +2241,13 @@ int ArrayReadState::sort_fragment_cell_ranges(
         FragmentCellRange left;
         left.first.first = popped_fragment_i;
         left.first.second = popped_tile_i;
-        left.second = malloc(2*coords_size);
+        left.second = arena.allocate(2*coords_size);
         memcpy(left.second, popped_range, coords_size);
         T* left_range = static_cast<T*>(left.second);
         
         // Get the first two coordinates from the coordinates tile 
         bool left_retrieved, right_retrieved, target_exists;
-        if(fragment_read_states_[popped_fragment_i]->get_enclosing_coords<T>(
+        if(read_states[popped_fragment_i]->get_enclosing_coords<T>(
                popped_tile_i,          // Tile
                top_range,              // Target coords
                popped_range,           // Start coords
@@ -1648,8 +2258,6 @@ int ArrayReadState::sort_fragment_cell_ranges(
                right_retrieved,        // Right retrieved 
                target_exists)          // Target exists
             != TILEDB_RS_OK) {  
-          free(left.second);
-          free(popped.second);
           rc = TILEDB_ARS_ERR;
           break;
         }
@@ -1657,21 +2265,17 @@ int ArrayReadState::sort_fragment_cell_ranges(
         // Insert left range to the result
         if(left_retrieved) 
           fragment_cell_ranges.push_back(left);
-        else 
-          free(left.second);
 
         // Re-insert right range to the priority queue
         if(right_retrieved)
           pq.push(popped);
-        else
-          free(popped.second);
         
         // Re-Insert unary range into the priority queue
         if(target_exists) {
           FragmentCellRange unary;
           unary.first.first = popped_fragment_i;
           unary.first.second = popped_tile_i;
-          unary.second = malloc(2*coords_size);
+          unary.second = arena.allocate(2*coords_size);
           T* unary_range = static_cast<T*>(unary.second);
           memcpy(unary_range, top_range, coords_size); 
           memcpy(&unary_range[dim_num], top_range, coords_size); 
@@ -1687,12 +2291,6 @@ int ArrayReadState::sort_fragment_cell_ranges(
 
   // Clean up in case of error
   if(rc != TILEDB_ARS_OK) {
-    while(!pq.empty()) {
-      free(pq.top().second);
-      pq.pop();
-    }
-    for(int i=0; i<fragment_cell_ranges.size(); ++i)
-      free(fragment_cell_ranges[i].second);
     fragment_cell_ranges.clear();
   } else {
     assert(pq.empty()); // Sanity check
@@ -1702,6 +2300,53 @@ int ArrayReadState::sort_fragment_cell_ranges(
   return rc;
 }
 
+int ArrayReadState::view_cells(
+    int attribute_id,
+    const void*& view,
+    size_t& view_size) {
+  // For easy reference
+  int64_t pos = fragment_cell_pos_ranges_vec_pos_[attribute_id];
+  FragmentCellPosRanges& fragment_cell_pos_ranges = 
+      fragment_cell_pos_ranges_vec_[pos];
+  int64_t fragment_cell_pos_ranges_num = fragment_cell_pos_ranges.size();
+  int64_t& i = view_range_pos_[attribute_id];
+
+  // Expose the first non-empty cell range 
+  view = NULL;
+  view_size = 0;
+  while(view_size == 0 && i < fragment_cell_pos_ranges_num) {
+    int fragment_i = fragment_cell_pos_ranges[i].first.first; 
+    int64_t tile_i = fragment_cell_pos_ranges[i].first.second; 
+    const CellPosRange& cell_pos_range = fragment_cell_pos_ranges[i].second; 
+    ++i;
+
+    if(fragment_i == -1) {  // Empty fragment - materialize the empty cells
+      int64_t cell_num = cell_pos_range.second - cell_pos_range.first + 1;
+      view_size = 
+          cell_num * array_->array_schema()->cell_size(attribute_id);
+      void* empty_cells = view_arena_.allocate(view_size);
+      fill_empty_cells(attribute_id, empty_cells, cell_num);
+      view = empty_cells;
+    } else if(fragment_read_states_[fragment_i]->view_cells(
+                  attribute_id,
+                  tile_i,
+                  cell_pos_range,
+                  view,
+                  view_size) != TILEDB_RS_OK) { 
+      return TILEDB_ARS_ERR;
+    }
+  }
+
+  // Move on to the next read round if this one is exhausted
+  if(i == fragment_cell_pos_ranges_num) {
+    ++fragment_cell_pos_ranges_vec_pos_[attribute_id];
+    i = 0;
+  }
+
+  // Success
+  return TILEDB_ARS_OK;
+}
+
 
 
 
@@ -1724,7 +2369,7 @@ bool ArrayReadState::SmallerFragmentCellRange<T>::operator () (
   assert(array_schema_ != NULL);
 
   // Get cell ordering information for the first range endpoints
-  int cmp = array_schema_->cell_order_cmp<T>(
+  int cmp = array_schema_->tile_cell_order_cmp<T>(
       static_cast<const T*>(a.second), 
       static_cast<const T*>(b.second)); 
 
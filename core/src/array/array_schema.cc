@@ -31,7 +31,9 @@
  */
 
 #include "array_schema.h"
+#include "compressor.h"
 #include "constants.h"
+#include "filter.h"
 #include "utils.h"
 #include <algorithm>
 #include <cassert>
@@ -69,7 +71,6 @@
 
 ArraySchema::ArraySchema() {
   cell_num_per_tile_ = -1;
-  coords_for_hilbert_ = NULL;
   domain_ = NULL;
   hilbert_curve_ = NULL;
   tile_extents_ = NULL;
@@ -77,9 +78,6 @@ ArraySchema::ArraySchema() {
 }
 
 ArraySchema::~ArraySchema() {
-  if(coords_for_hilbert_ != NULL)
-    delete [] coords_for_hilbert_;
-
   if(domain_ != NULL)
     free(domain_);
 
@@ -261,7 +259,14 @@ size_t ArraySchema::cell_size(int attribute_id) const {
 int ArraySchema::compression(int attribute_id) const {
   assert(attribute_id >= 0 && attribute_id <= attribute_num_);
 
-  return compression_[attribute_id];
+  return compression_[attribute_id] & TILEDB_COMPRESSION_TYPE_MASK;
+}
+
+int ArraySchema::compression_level(int attribute_id) const {
+  assert(attribute_id >= 0 && attribute_id <= attribute_num_);
+
+  return (compression_[attribute_id] >> TILEDB_COMPRESSION_LEVEL_SHIFT) &
+         TILEDB_COMPRESSION_LEVEL_MAX;
 }
 
 size_t ArraySchema::coords_size() const {
@@ -284,6 +289,12 @@ const void* ArraySchema::domain() const {
   return domain_;
 }
 
+int ArraySchema::filters(int attribute_id) const {
+  assert(attribute_id >= 0 && attribute_id <= attribute_num_);
+
+  return compression_[attribute_id] >> TILEDB_FILTER_SHIFT;
+}
+
 int ArraySchema::get_attribute_ids(
     const std::vector<std::string>& attributes,
     std::vector<int>& attribute_ids) const {
@@ -444,15 +455,38 @@ void ArraySchema::print() const {
   }
   // Compression type
   std::cout << "Compression type:\n";
-  for(int i=0; i<attribute_num_; ++i)
-    if(compression_[i] == TILEDB_GZIP)
-      std::cout << "\t" << attributes_[i] << ": GZIP\n";
-    else if(compression_[i] == TILEDB_NO_COMPRESSION)
-      std::cout << "\t" << attributes_[i] << ": NONE\n";
-  if(compression_[attribute_num_] == TILEDB_GZIP)
-    std::cout << "\tCoordinates: GZIP\n";
-  else if(compression_[attribute_num_] == TILEDB_NO_COMPRESSION)
-    std::cout << "\tCoordinates: NONE\n";
+  for(int i=0; i<=attribute_num_; ++i) {
+    if(i < attribute_num_)
+      std::cout << "\t" << attributes_[i] << ": ";
+    else
+      std::cout << "\tCoordinates: ";
+    if(compression(i) == TILEDB_GZIP)
+      std::cout << "GZIP";
+    else if(compression(i) == TILEDB_LZ4)
+      std::cout << "LZ4";
+    else if(compression(i) == TILEDB_ZSTD)
+      std::cout << "ZSTD";
+    else if(compression(i) == TILEDB_SHUFFLE_LZ4)
+      std::cout << "SHUFFLE_LZ4";
+    else if(compression(i) == TILEDB_NO_COMPRESSION)
+      std::cout << "NONE";
+    if(compression_level(i) != 0)
+      std::cout << " (level " << compression_level(i) << ")";
+    for(int f=filters(i); f != 0; f >>= TILEDB_FILTER_BITS) {
+      int filter = f & TILEDB_FILTER_MASK;
+      if(filter == TILEDB_FILTER_DELTA)
+        std::cout << " + DELTA";
+      else if(filter == TILEDB_FILTER_DOUBLE_DELTA)
+        std::cout << " + DOUBLE_DELTA";
+      else if(filter == TILEDB_FILTER_BYTE_SHUFFLE)
+        std::cout << " + BYTE_SHUFFLE";
+      else if(filter == TILEDB_FILTER_BIT_SHUFFLE)
+        std::cout << " + BIT_SHUFFLE";
+      else if(filter == TILEDB_FILTER_BIT_PACKING)
+        std::cout << " + BIT_PACKING";
+    }
+    std::cout << "\n";
+  }
 }
 
 // ===== FORMAT =====
@@ -479,6 +513,12 @@ void ArraySchema::print() const {
 // type#1(char) type#2(char) ... 
 // cell_val_num#1(int) cell_val_num#2(int) ... 
 // compression#1(char) compression#2(char) ...
+// [filters#1(int) filters#2(int) ...]
+//
+// Each compression byte holds the compression type in its lower bits and the
+// compression level in the bits above TILEDB_COMPRESSION_TYPE_MASK. The filter
+// chains are stored only if some attribute has filters, so that arrays
+// without filters keep the original format.
 int ArraySchema::serialize(
     void*& array_schema_bin,
     size_t& array_schema_bin_size) const {
@@ -580,13 +620,23 @@ int ArraySchema::serialize(
     offset += sizeof(int);
   }
   // Copy compression_
-  char compression; 
+  unsigned char compression; 
   for(int i=0; i<=attribute_num_; ++i) {
-    compression = compression_[i];
+    compression = static_cast<unsigned char>(compression_[i]);
     assert(offset + sizeof(char) <= buffer_size);
     memcpy(buffer + offset, &compression, sizeof(char));
     offset += sizeof(char);
   }
+  // Copy filters
+  if(has_filters()) {
+    int filter_chain;
+    for(int i=0; i<=attribute_num_; ++i) {
+      filter_chain = filters(i);
+      assert(offset + sizeof(int) <= buffer_size);
+      memcpy(buffer + offset, &filter_chain, sizeof(int));
+      offset += sizeof(int);
+    }
+  }
   assert(offset == buffer_size);
 
   // Success
@@ -714,6 +764,12 @@ int ArraySchema::type(int i) const {
     return types_[i];
 }
 
+size_t ArraySchema::type_size(int attribute_id) const {
+  assert(attribute_id >= 0 && attribute_id <= attribute_num_);
+
+  return type_sizes_[attribute_id];
+}
+
 int ArraySchema::var_attribute_num() const {
   int var_attribute_num = 0;
   for(int i=0; i<attribute_num_; ++i)
@@ -758,6 +814,7 @@ bool ArraySchema::var_size(int attribute_id) const {
 // type#1(char) type#2(char) ... 
 // cell_val_num#1(int) cell_val_num#2(int) ... 
 // compression#1(char) compression#2(char) ...
+// [filters#1(int) filters#2(int) ...]
 int ArraySchema::deserialize(
     const void* array_schema_bin, 
     size_t array_schema_bin_size) {
@@ -856,6 +913,7 @@ int ArraySchema::deserialize(
     memcpy(&type, buffer + offset, sizeof(char));
     offset += sizeof(char);
     types_[i] = static_cast<int>(type);
+    type_sizes_[i] = compute_type_size(i);
   }
   // Load cell_val_num_
   cell_val_num_.resize(attribute_num_); 
@@ -865,13 +923,23 @@ int ArraySchema::deserialize(
     offset += sizeof(int);
   }
   // Load compression_
-  char compression;
+  unsigned char compression;
   for(int i=0; i<=attribute_num_; ++i) {
     assert(offset + sizeof(char) <= buffer_size);
     memcpy(&compression, buffer + offset, sizeof(char));
     offset += sizeof(char);
     compression_.push_back(static_cast<int>(compression));
   }
+  // Load filters (absent in arrays without filters)
+  if(offset < buffer_size) {
+    int filter_chain;
+    for(int i=0; i<=attribute_num_; ++i) {
+      assert(offset + sizeof(int) <= buffer_size);
+      memcpy(&filter_chain, buffer + offset, sizeof(int));
+      offset += sizeof(int);
+      compression_[i] |= filter_chain << TILEDB_FILTER_SHIFT;
+    }
+  }
   assert(offset == buffer_size); 
   // Add extra coordinate attribute
   attributes_.push_back(TILEDB_COORDS);
@@ -886,6 +954,9 @@ int ArraySchema::deserialize(
   // Compute tile domain
   compute_tile_domain();
 
+  // Compute tile offsets
+  compute_tile_offsets();
+
   // Initialize Hilbert curve
   init_hilbert_curve();
 
@@ -937,6 +1008,9 @@ int ArraySchema::init(const ArraySchemaC* array_schema_c) {
   // Compute tile domain
   compute_tile_domain();
 
+  // Compute tile offsets
+  compute_tile_offsets();
+
   // Initialize Hilbert curve
   init_hilbert_curve();
 
@@ -1139,11 +1213,38 @@ int ArraySchema::set_compression(int* compression) {
       compression_.push_back(TILEDB_NO_COMPRESSION);
   } else {
     for(int i=0; i<attribute_num_+1; ++i) {
-      if(compression[i] != TILEDB_NO_COMPRESSION &&
-         compression[i] != TILEDB_GZIP) { 
+      int compression_type = compression[i] & TILEDB_COMPRESSION_TYPE_MASK;
+      int compression_level = 
+          (compression[i] >> TILEDB_COMPRESSION_LEVEL_SHIFT) &
+          TILEDB_COMPRESSION_LEVEL_MAX;
+      int filters = compression[i] >> TILEDB_FILTER_SHIFT;
+      if(compression_type != TILEDB_NO_COMPRESSION &&
+         compression_type != TILEDB_GZIP &&
+         compression_type != TILEDB_LZ4 &&
+         compression_type != TILEDB_ZSTD &&
+         compression_type != TILEDB_SHUFFLE_LZ4) { 
         PRINT_ERROR("Cannot set compression; Invalid compression type");
         return TILEDB_AS_ERR;
       }
+      if(compression_type != TILEDB_NO_COMPRESSION &&
+         Compressor::get(compression_type) == NULL) {
+        PRINT_ERROR("Cannot set compression; Compression type not supported "
+                    "by this build");
+        return TILEDB_AS_ERR;
+      }
+      if((compression_type == TILEDB_NO_COMPRESSION && 
+          compression_level != 0) ||
+         (compression_type != TILEDB_NO_COMPRESSION &&
+          compression_level > 
+              Compressor::get(compression_type)->max_level())) {
+        PRINT_ERROR("Cannot set compression; Invalid compression level");
+        return TILEDB_AS_ERR;
+      }
+      if(!FilterPipeline::valid(filters) ||
+         (compression_type == TILEDB_NO_COMPRESSION && filters != 0)) {
+        PRINT_ERROR("Cannot set compression; Invalid filters");
+        return TILEDB_AS_ERR;
+      }
       compression_.push_back(compression[i]);
     }
   }
@@ -1514,9 +1615,9 @@ int64_t ArraySchema::get_tile_pos(
 
   // Invoke the proper function based on the tile order
   if(tile_order_ == TILEDB_ROW_MAJOR)
-    get_tile_pos_row(domain, tile_coords);
+    return get_tile_pos_row(domain, tile_coords);
   else if(tile_order_ == TILEDB_COL_MAJOR)
-    get_tile_pos_col(domain, tile_coords);
+    return get_tile_pos_col(domain, tile_coords);
   else  // Sanity check
     assert(0);
 }
@@ -1541,18 +1642,31 @@ int64_t ArraySchema::hilbert_id(const T* coords) const {
   // For easy reference
   const T* domain = static_cast<const T*>(domain_);
 
-  // Normalize coordinates
+  // Normalize coordinates (into a local buffer, so that concurrent calls
+  // are safe)
+  int coords_for_hilbert[HC_MAX_DIM];
   for(int i = 0; i < dim_num_; ++i) 
-    coords_for_hilbert_[i] = static_cast<int>(coords[i] - domain[2*i]);
+    coords_for_hilbert[i] = static_cast<int>(coords[i] - domain[2*i]);
 
   // Compute Hilber id
   int64_t id;
-  hilbert_curve_->coords_to_hilbert(coords_for_hilbert_, id);
+  hilbert_curve_->coords_to_hilbert(coords_for_hilbert, id);
 
   // Return
   return id;
 }
 
+template<class T>
+void ArraySchema::hilbert_ids(
+    const T* cell_coords, 
+    int64_t cell_num, 
+    int64_t* ids,
+    int thread_num) const {
+  #pragma omp parallel for num_threads(thread_num)
+  for(int64_t i=0; i<cell_num; ++i)
+    ids[i] = hilbert_id<T>(&cell_coords[i*dim_num_]);
+}
+
 template<class T>
 int ArraySchema::tile_cell_order_cmp(
     const T* coords_a, 
@@ -1582,18 +1696,44 @@ int64_t ArraySchema::tile_id(const T* cell_coords) const {
   if(tile_extents == NULL)
     return 0;
 
-  // Calculate tile coordinates
-  T* tile_coords = new T[dim_num_];   
-  for(int i=0; i<dim_num_; ++i)
-    tile_coords[i] = (cell_coords[i] - domain[2*i]) / tile_extents[i]; 
+  // Sum the tile coordinates weighted by the tile offsets, in the same way
+  // as get_tile_pos() does
+  int64_t id = 0;
+  for(int i=0; i<dim_num_; ++i) 
+    id += (cell_coords[i] - domain[2*i]) / tile_extents[i] * tile_offsets_[i];
 
-  int tile_id = get_tile_pos(domain, tile_coords);
+  // Return
+  return id;
+}
 
-  // Clean up
-  delete [] tile_coords;
+template<class T>
+void ArraySchema::tile_ids(
+    const T* cell_coords, 
+    int64_t cell_num, 
+    int64_t* ids,
+    int thread_num) const {
+  // For easy reference
+  const T* domain = static_cast<const T*>(domain_);
+  const T* tile_extents = static_cast<const T*>(tile_extents_);
+  const int64_t* tile_offsets = tile_offsets_.data();
+  int dim_num = dim_num_;
 
-  // Return
-  return tile_id;
+  // Trivial case
+  if(tile_extents == NULL) {
+    std::fill(ids, ids + cell_num, 0);
+    return;
+  }
+
+  // Sum the tile coordinates weighted by the tile offsets, as in tile_id().
+  // The cell loop is also vectorized, where the coordinates type allows it.
+  #pragma omp parallel for simd num_threads(thread_num)
+  for(int64_t i=0; i<cell_num; ++i) {
+    const T* coords = &cell_coords[i*dim_num];
+    int64_t id = 0;
+    for(int j=0; j<dim_num; ++j) 
+      id += (coords[j] - domain[2*j]) / tile_extents[j] * tile_offsets[j];
+    ids[i] = id;
+  }
 }
 
 
@@ -1657,6 +1797,9 @@ size_t ArraySchema::compute_bin_size() const {
   bin_size += attribute_num_ * sizeof(int);
   // Size for compression_
   bin_size += (attribute_num_+1) * sizeof(char);
+  // Size for filters
+  if(has_filters())
+    bin_size += (attribute_num_+1) * sizeof(int);
 
   return bin_size;
 }
@@ -1777,6 +1920,52 @@ void ArraySchema::compute_tile_domain() {
   }
 }
 
+void ArraySchema::compute_tile_offsets() {
+  // For easy reference 
+  int coords_type = types_[attribute_num_];
+
+  // Invoke the proper templated function
+  if(coords_type == TILEDB_INT32)
+    compute_tile_offsets<int>();
+  else if(coords_type == TILEDB_INT64)
+    compute_tile_offsets<int64_t>();
+  else if(coords_type == TILEDB_FLOAT32)
+    compute_tile_offsets<float>();
+  else if(coords_type == TILEDB_FLOAT64)
+    compute_tile_offsets<double>();
+}
+
+template<class T>
+void ArraySchema::compute_tile_offsets() {
+  tile_offsets_.clear();
+  if(tile_extents_ == NULL)
+    return;  
+
+  // For easy reference
+  const T* domain = static_cast<const T*>(domain_);
+  const T* tile_extents = static_cast<const T*>(tile_extents_);
+
+  // Calculate the offsets in the same way as get_tile_pos() does for the
+  // array domain
+  int64_t tile_num; // Per dimension
+  tile_offsets_.resize(dim_num_);
+  if(tile_order_ == TILEDB_COL_MAJOR) {
+    tile_offsets_[0] = 1;
+    for(int i=1; i<dim_num_; ++i) {
+      tile_num = (domain[2*(i-1)+1] - 
+                  domain[2*(i-1)] + 1) / tile_extents[i-1];
+      tile_offsets_[i] = tile_offsets_[i-1] * tile_num;
+    }
+  } else {  // TILEDB_ROW_MAJOR
+    tile_offsets_[dim_num_-1] = 1;
+    for(int i=dim_num_-2; i>=0; --i) {
+      tile_num = (domain[2*(i+1)+1] - 
+                  domain[2*(i+1)] + 1) / tile_extents[i+1];
+      tile_offsets_[i] = tile_offsets_[i+1] * tile_num;
+    }
+  }
+}
+
 size_t ArraySchema::compute_type_size(int i) const {
   // Sanity check
   assert(i>= 0 && i <= attribute_num_);
@@ -1981,15 +2170,19 @@ int64_t ArraySchema::get_tile_pos_row(
   return pos;
 }
 
+bool ArraySchema::has_filters() const {
+  for(int i=0; i<=attribute_num_; ++i)
+    if(filters(i) != 0)
+      return true;
+
+  return false;
+}
+
 void ArraySchema::init_hilbert_curve() {
   // Applicable only to Hilbert cell order
   if(cell_order_ != TILEDB_HILBERT) 
     return;
 
-  // Allocate some space for the Hilbert coordinates
-  if(coords_for_hilbert_ == NULL)
-    coords_for_hilbert_ = new int[dim_num_];
-
   // Compute Hilbert bits, invoking the proper templated function
   if(types_[attribute_num_] == TILEDB_INT32)
     compute_hilbert_bits<int>();
@@ -2108,6 +2301,27 @@ template int64_t ArraySchema::hilbert_id<float>(
 template int64_t ArraySchema::hilbert_id<double>(
     const double* coords) const;
 
+template void ArraySchema::hilbert_ids<int>(
+    const int* cell_coords, 
+    int64_t cell_num, 
+    int64_t* ids,
+    int thread_num) const;
+template void ArraySchema::hilbert_ids<int64_t>(
+    const int64_t* cell_coords, 
+    int64_t cell_num, 
+    int64_t* ids,
+    int thread_num) const;
+template void ArraySchema::hilbert_ids<float>(
+    const float* cell_coords, 
+    int64_t cell_num, 
+    int64_t* ids,
+    int thread_num) const;
+template void ArraySchema::hilbert_ids<double>(
+    const double* cell_coords, 
+    int64_t cell_num, 
+    int64_t* ids,
+    int thread_num) const;
+
 template int ArraySchema::subarray_overlap<int>(
     const int* subarray_a, 
     const int* subarray_b, 
@@ -2147,3 +2361,24 @@ template int64_t ArraySchema::tile_id<float>(
 template int64_t ArraySchema::tile_id<double>(
     const double* cell_coords) const;
 
+template void ArraySchema::tile_ids<int>(
+    const int* cell_coords, 
+    int64_t cell_num, 
+    int64_t* ids,
+    int thread_num) const;
+template void ArraySchema::tile_ids<int64_t>(
+    const int64_t* cell_coords, 
+    int64_t cell_num, 
+    int64_t* ids,
+    int thread_num) const;
+template void ArraySchema::tile_ids<float>(
+    const float* cell_coords, 
+    int64_t cell_num, 
+    int64_t* ids,
+    int thread_num) const;
+template void ArraySchema::tile_ids<double>(
+    const double* cell_coords, 
+    int64_t cell_num, 
+    int64_t* ids,
+    int thread_num) const;
+
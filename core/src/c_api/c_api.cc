@@ -31,9 +31,11 @@
  */
 
 #include "c_api.h"
+#include "array_metadata_cache.h"
 #include "array_schema_c.h"
 #include "storage_manager.h"
 #include <cassert>
+#include <cstddef>
 #include <cstring>
 #include <iostream>
 
@@ -52,6 +54,44 @@
 
 
 
+/* ****************************** */
+/*          LAYOUT CHECKS         */
+/* ****************************** */
+
+// The asynchronous read requests are passed to the storage manager without
+// copying, so TileDB_AIO_Request and AIO_Request must have the same layout
+#define TILEDB_AIO_FIELD_MATCHES(field) \
+    offsetof(TileDB_AIO_Request, field) == offsetof(AIO_Request, field) && \
+    sizeof(((TileDB_AIO_Request*) 0)->field) == \
+    sizeof(((AIO_Request*) 0)->field)
+
+static_assert(
+    sizeof(TileDB_AIO_Request) == sizeof(AIO_Request),
+    "TileDB_AIO_Request and AIO_Request differ in size");
+static_assert(
+    TILEDB_AIO_FIELD_MATCHES(buffers_),
+    "TileDB_AIO_Request and AIO_Request differ in buffers_");
+static_assert(
+    TILEDB_AIO_FIELD_MATCHES(buffer_sizes_),
+    "TileDB_AIO_Request and AIO_Request differ in buffer_sizes_");
+static_assert(
+    TILEDB_AIO_FIELD_MATCHES(completion_handle_),
+    "TileDB_AIO_Request and AIO_Request differ in completion_handle_");
+static_assert(
+    TILEDB_AIO_FIELD_MATCHES(completion_data_),
+    "TileDB_AIO_Request and AIO_Request differ in completion_data_");
+static_assert(
+    TILEDB_AIO_FIELD_MATCHES(status_),
+    "TileDB_AIO_Request and AIO_Request differ in status_");
+static_assert(
+    TILEDB_AIO_FIELD_MATCHES(subarray_),
+    "TileDB_AIO_Request and AIO_Request differ in subarray_");
+
+#undef TILEDB_AIO_FIELD_MATCHES
+
+
+
+
 /* ****************************** */
 /*            CONTEXT             */
 /* ****************************** */
@@ -92,6 +132,31 @@ int tiledb_ctx_finalize(TileDB_CTX* tiledb_ctx) {
 
 
 
+int tiledb_ctx_set_config(
+    TileDB_CTX* tiledb_ctx,
+    const char* parameter,
+    const char* value) {
+  // Sanity check
+  if(tiledb_ctx == NULL || tiledb_ctx->storage_manager_ == NULL) {
+    PRINT_ERROR("Invalid TileDB context");
+    return TILEDB_ERR;
+  }
+  if(parameter == NULL || value == NULL) {
+    PRINT_ERROR("Cannot set configuration parameter; Invalid parameter");
+    return TILEDB_ERR;
+  }
+
+  // Set the parameter
+  if(tiledb_ctx->storage_manager_->config_set_parameter(parameter, value) != 
+     TILEDB_SM_OK)
+    return TILEDB_ERR;
+  else
+    return TILEDB_OK;
+}
+
+
+
+
 /* ****************************** */
 /*          SANITY CHECKS         */
 /* ****************************** */
@@ -290,6 +355,9 @@ int tiledb_array_set_schema(
     for(int i=0; i<attribute_num+1; ++i)
       tiledb_array_schema->compression_[i] = compression[i];
   }
+
+  // Success
+  return TILEDB_OK;
 }
 
 int tiledb_array_create(
@@ -324,6 +392,30 @@ int tiledb_array_create(
     return TILEDB_OK;
 }
 
+int tiledb_array_set_config(
+    TileDB_CTX* tiledb_ctx,
+    const char* array,
+    const char* parameter,
+    const char* value) {
+  // Sanity check
+  if(!sanity_check(tiledb_ctx))
+    return TILEDB_ERR;
+  if(array == NULL || parameter == NULL || value == NULL) {
+    PRINT_ERROR("Cannot set array configuration parameter; "
+                "Invalid parameter");
+    return TILEDB_ERR;
+  }
+
+  // Set the parameter
+  if(tiledb_ctx->storage_manager_->array_config_set(
+         array, 
+         parameter, 
+         value) != TILEDB_SM_OK)
+    return TILEDB_ERR;
+  else
+    return TILEDB_OK;
+}
+
 int tiledb_array_init(
     const TileDB_CTX* tiledb_ctx,
     TileDB_Array** tiledb_array,
@@ -430,7 +522,7 @@ int tiledb_array_load_schema(
     return TILEDB_ERR;
 
   // Get the array schema
-  ArraySchema* array_schema;
+  const ArraySchema* array_schema;
   if(tiledb_ctx->storage_manager_->array_load_schema(array, array_schema) !=
      TILEDB_SM_OK)
     return TILEDB_ERR; 
@@ -454,7 +546,7 @@ int tiledb_array_load_schema(
   tiledb_array_schema->types_ = array_schema_c.types_;
 
   // Clean up
-  delete array_schema;
+  ArrayMetadataCache::instance()->release_array_schema(array_schema);
 
   // Success
   return TILEDB_OK;
@@ -525,6 +617,20 @@ int tiledb_array_write(
     return TILEDB_OK;
 }
 
+int tiledb_array_estimate_result_size(
+    const TileDB_Array* tiledb_array,
+    size_t* buffer_sizes) {
+  // Sanity check
+  if(!sanity_check(tiledb_array))
+    return TILEDB_ERR;
+
+  // Estimate
+  if(tiledb_array->array_->estimate_result_size(buffer_sizes) != TILEDB_AR_OK)
+    return TILEDB_ERR;
+  else 
+    return TILEDB_OK;
+}
+
 int tiledb_array_read(
     const TileDB_Array* tiledb_array,
     void** buffers,
@@ -540,6 +646,52 @@ int tiledb_array_read(
     return TILEDB_OK;
 }
 
+int tiledb_array_read_async(
+    const TileDB_Array* tiledb_array,
+    TileDB_AIO_Request* tiledb_aio_request) {
+  // Sanity check
+  if(!sanity_check(tiledb_array))
+    return TILEDB_ERR;
+
+  // Submit the request (TileDB_AIO_Request has the layout of AIO_Request,
+  // as checked above)
+  StorageManager* storage_manager = 
+      tiledb_array->tiledb_ctx_->storage_manager_;
+  if(storage_manager->array_aio_read(
+         tiledb_array->array_, 
+         (AIO_Request*) tiledb_aio_request) != TILEDB_SM_OK)
+    return TILEDB_ERR;
+  else 
+    return TILEDB_OK;
+}
+
+int tiledb_array_read_views(
+    const TileDB_Array* tiledb_array,
+    const void** views,
+    size_t* view_sizes) {
+  // Sanity check
+  if(!sanity_check(tiledb_array))
+    return TILEDB_ERR;
+
+  // Read views
+  if(tiledb_array->array_->read_views(views, view_sizes) != TILEDB_AR_OK)
+    return TILEDB_ERR;
+  else 
+    return TILEDB_OK;
+}
+
+int tiledb_array_release_views(const TileDB_Array* tiledb_array) {
+  // Sanity check
+  if(!sanity_check(tiledb_array))
+    return TILEDB_ERR;
+
+  // Release views
+  if(tiledb_array->array_->release_views() != TILEDB_AR_OK)
+    return TILEDB_ERR;
+  else 
+    return TILEDB_OK;
+}
+
 int tiledb_array_overflow(
     const TileDB_Array* tiledb_array,
     int attribute_id) {
@@ -557,7 +709,26 @@ int tiledb_array_consolidate(const TileDB_Array* tiledb_array) {
     return TILEDB_ERR;
 
   // Consolidate
-  if(tiledb_array->array_->consolidate() != TILEDB_AR_OK)
+  if(tiledb_array->tiledb_ctx_->storage_manager_->array_consolidate(
+         tiledb_array->array_,
+         NULL) != TILEDB_SM_OK)
+    return TILEDB_ERR;
+  else 
+    return TILEDB_OK;
+}
+
+int tiledb_array_consolidate_with_policy(
+    const TileDB_Array* tiledb_array,
+    const TileDB_ConsolidationPolicy* policy) {
+  // Sanity check
+  if(!sanity_check(tiledb_array))
+    return TILEDB_ERR;
+
+  // Consolidate (TileDB_ConsolidationPolicy has the layout of 
+  // ConsolidationPolicy)
+  if(tiledb_array->tiledb_ctx_->storage_manager_->array_consolidate(
+         tiledb_array->array_,
+         (const ConsolidationPolicy*) policy) != TILEDB_SM_OK)
     return TILEDB_ERR;
   else 
     return TILEDB_OK;
@@ -870,7 +1041,7 @@ int tiledb_metadata_load_schema(
     return TILEDB_ERR;
 
   // Get the array schema
-  ArraySchema* array_schema;
+  const ArraySchema* array_schema;
   if(tiledb_ctx->storage_manager_->metadata_load_schema(
          metadata, 
          array_schema) != TILEDB_SM_OK)
@@ -888,7 +1059,7 @@ int tiledb_metadata_load_schema(
   tiledb_metadata_schema->types_ = metadata_schema_c.types_;
 
   // Clean up
-  delete array_schema;
+  ArrayMetadataCache::instance()->release_array_schema(array_schema);
 
   // Success
   return TILEDB_OK;
@@ -985,7 +1156,8 @@ int tiledb_metadata_consolidate(
     return TILEDB_ERR;
 
   // Consolidate
-  if(tiledb_metadata->metadata_->consolidate() != TILEDB_MT_OK)
+  if(tiledb_metadata->tiledb_ctx_->storage_manager_->metadata_consolidate(
+         tiledb_metadata->metadata_) != TILEDB_SM_OK)
     return TILEDB_ERR;
   else 
     return TILEDB_OK;
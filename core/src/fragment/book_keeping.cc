@@ -36,6 +36,7 @@
 #include <cstring>
 #include <fcntl.h>
 #include <iostream>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -68,8 +69,19 @@
 /* ****************************** */
 
 BookKeeping::BookKeeping(const Fragment* fragment)
-    : fragment_(fragment) {
+    : array_schema_(fragment->array()->array_schema()),
+      dense_(fragment->dense()),
+      fragment_name_(fragment->fragment_name()),
+      mode_(fragment->mode()) {
+  bounding_coords_ = NULL;
+  bounding_coords_allocated_size_ = 0;
+  bounding_coords_num_ = 0;
   domain_ = NULL;
+  map_ = NULL;
+  map_size_ = 0;
+  mbrs_ = NULL;
+  mbrs_allocated_size_ = 0;
+  mbr_num_ = 0;
   non_empty_domain_ = NULL;
 }
 
@@ -80,13 +92,14 @@ BookKeeping::~BookKeeping() {
   if(non_empty_domain_ != NULL)
     free(non_empty_domain_);
 
-  for(int i=0; i<mbrs_.size(); ++i)
-    if(mbrs_[i] != NULL)
-      free(mbrs_[i]);
+  if(mbrs_allocated_size_ != 0)
+    free(mbrs_);
 
-  for(int i=0; i<bounding_coords_.size(); ++i)
-    if(bounding_coords_[i] != NULL)
-      free(bounding_coords_[i]);
+  if(bounding_coords_allocated_size_ != 0)
+    free(bounding_coords_);
+
+  if(map_ != NULL && munmap(map_, map_size_))
+    PRINT_WARNING("Cannot unmap book-keeping file");
 }
 
 
@@ -96,20 +109,21 @@ BookKeeping::~BookKeeping() {
 /*             ACCESSORS          */
 /* ****************************** */
 
-const std::vector<void*>& BookKeeping::bounding_coords() const {
+const ArraySchema* BookKeeping::array_schema() const {
+  return array_schema_;
+}
+
+const void* BookKeeping::bounding_coords() const {
   return bounding_coords_;
 }
 
 int64_t BookKeeping::cell_num(int64_t tile_pos) const {
-  // For easy reference
-  const ArraySchema* array_schema = fragment_->array()->array_schema();
-
-  if(fragment_->dense()) {
-    return array_schema->cell_num_per_tile(); 
+  if(dense_) {
+    return array_schema_->cell_num_per_tile(); 
   } else {
     int64_t tile_num = this->tile_num();
     if(tile_pos != tile_num-1)
-      return array_schema->capacity();
+      return array_schema_->capacity();
     else
       return last_tile_cell_num();
   }
@@ -123,7 +137,7 @@ int64_t BookKeeping::last_tile_cell_num() const {
   return last_tile_cell_num_;
 }
 
-const std::vector<void*>& BookKeeping::mbrs() const {
+const void* BookKeeping::mbrs() const {
   return mbrs_;
 }
 
@@ -132,24 +146,31 @@ const void* BookKeeping::non_empty_domain() const {
 }
 
 int64_t BookKeeping::tile_num() const {
-  if(fragment_->dense()) {
-    const ArraySchema* array_schema = fragment_->array()->array_schema();
-    return array_schema->tile_num(domain_);
+  if(dense_) {
+    return array_schema_->tile_num(domain_);
   } else { 
-    return mbrs_.size();
+    return mbr_num_;
   }
 }
 
-const std::vector<std::vector<off_t> >& BookKeeping::tile_offsets() const {
-  return tile_offsets_;
+const RTree* BookKeeping::rtree() const {
+  return &rtree_;
 }
 
-const std::vector<std::vector<off_t> >& BookKeeping::tile_var_offsets() const {
-  return tile_var_offsets_;
+const off_t* BookKeeping::tile_offsets(int attribute_id) const {
+  return tile_offsets_ptrs_[attribute_id];
 }
 
-const std::vector<std::vector<size_t> >& BookKeeping::tile_var_sizes() const {
-  return tile_var_sizes_;
+const TileStats* BookKeeping::tile_stats(int attribute_id) const {
+  return tile_stats_ptrs_[attribute_id];
+}
+
+const off_t* BookKeeping::tile_var_offsets(int attribute_id) const {
+  return tile_var_offsets_ptrs_[attribute_id];
+}
+
+const size_t* BookKeeping::tile_var_sizes(int attribute_id) const {
+  return tile_var_sizes_ptrs_[attribute_id];
 }
 
 
@@ -161,24 +182,45 @@ const std::vector<std::vector<size_t> >& BookKeeping::tile_var_sizes() const {
 
 void BookKeeping::append_bounding_coords(const void* bounding_coords) {
   // For easy reference
-  const ArraySchema* array_schema = fragment_->array()->array_schema();
-  size_t bounding_coords_size = 2*array_schema->coords_size();
+  size_t bounding_coords_size = 2*array_schema_->coords_size();
+
+  // Expand buffer if necessary
+  if((bounding_coords_num_+1) * bounding_coords_size > 
+     bounding_coords_allocated_size_) {
+    if(bounding_coords_allocated_size_ == 0) {
+      bounding_coords_allocated_size_ = bounding_coords_size;
+      bounding_coords_ = malloc(bounding_coords_allocated_size_);
+    } else {
+      expand_buffer(bounding_coords_, bounding_coords_allocated_size_);
+    }
+  }
 
-  // Copy and append MBR
-  void* new_bounding_coords = malloc(bounding_coords_size);
-  memcpy(new_bounding_coords, bounding_coords, bounding_coords_size);
-  bounding_coords_.push_back(new_bounding_coords);
+  // Copy and append bounding coordinates
+  memcpy(
+      static_cast<char*>(bounding_coords_) + 
+          bounding_coords_num_ * bounding_coords_size, 
+      bounding_coords, 
+      bounding_coords_size);
+  ++bounding_coords_num_;
 }
 
 void BookKeeping::append_mbr(const void* mbr) {
   // For easy reference
-  const ArraySchema* array_schema = fragment_->array()->array_schema();
-  size_t mbr_size = 2*array_schema->coords_size();
+  size_t mbr_size = 2*array_schema_->coords_size();
+
+  // Expand buffer if necessary
+  if((mbr_num_+1) * mbr_size > mbrs_allocated_size_) {
+    if(mbrs_allocated_size_ == 0) {
+      mbrs_allocated_size_ = mbr_size;
+      mbrs_ = malloc(mbrs_allocated_size_);
+    } else {
+      expand_buffer(mbrs_, mbrs_allocated_size_);
+    }
+  }
 
   // Copy and append MBR
-  void* new_mbr = malloc(mbr_size);
-  memcpy(new_mbr, mbr, mbr_size);
-  mbrs_.push_back(new_mbr);
+  memcpy(static_cast<char*>(mbrs_) + mbr_num_ * mbr_size, mbr, mbr_size);
+  ++mbr_num_;
 }
 
 void BookKeeping::append_tile_offset(
@@ -189,6 +231,12 @@ void BookKeeping::append_tile_offset(
   next_tile_offsets_[attribute_id] = new_offset;  
 }
 
+void BookKeeping::append_tile_stats(
+    int attribute_id,
+    const TileStats& stats) {
+  tile_stats_[attribute_id].push_back(stats);
+}
+
 void BookKeeping::append_tile_var_offset(
     int attribute_id,
     size_t step) {
@@ -205,53 +253,70 @@ void BookKeeping::append_tile_var_size(
 }
 
 /* FORMAT:
- * non_empty_domain_size(size_t) non_empty_domain(void*)  
- * mbr_num(int64_t)
- * mbr_#1(void*) mbr_#2(void*) ... 
- * bounding_coords_num(int64_t)
+ * version(int) attribute_num(int)
+ * non_empty_domain_size(size_t) last_tile_cell_num(int64_t)
+ * mbr_num(int64_t) bounding_coords_num(int64_t)
+ * tile_offsets_attr#0_num(int64_t) ... 
+ *     tile_offsets_attr#<attribute_num>_num(int64_t)
+ * tile_var_offsets_attr#0_num(int64_t) ... 
+ *     tile_var_offsets_attr#<attribute_num-1>_num(int64_t)
+ * tile_var_sizes_attr#0_num(int64_t) ... 
+ *     tile_var_sizes_attr#<attribute_num-1>_num(int64_t)
+ * tile_stats_attr#0_num(int64_t) ... 
+ *     tile_stats_attr#<attribute_num-1>_num(int64_t)
+ * non_empty_domain(void*)
+ * mbr_#1(void*) mbr_#2(void*) ...
  * bounding_coords_#1(void*) bounding_coords_#2(void*) ...
- * tile_offsets_attr#0_num(int64_t)
- * tile_offsets_attr#0_#1 (off_t) tile_offsets_attr#0_#2 (off_t) ...
+ * tile_offsets_attr#0_#1(off_t) tile_offsets_attr#0_#2(off_t) ...
  * ...
- * tile_offsets_attr#<attribute_num>_num(int64_t)
  * tile_offsets_attr#<attribute_num>_#1(off_t) 
- *     tile_offsets_attr#<attribute_num>_#2 (off_t) ...
- * tile_var_offsets_attr#0_num(int64_t)
- * tile_var_offsets_attr#0_#1 (off_t) tile_var_offsets_attr#0_#2 (off_t) ...
+ *     tile_offsets_attr#<attribute_num>_#2(off_t) ...
+ * tile_var_offsets_attr#0_#1(off_t) tile_var_offsets_attr#0_#2(off_t) ...
  * ...
- * tile_var_offsets_attr#<attribute_num-1>_num(int64_t)
- * tile_var_offsets_attr#<attribute_num-1>_#1 (off_t) 
- *     tile_var_offsets_attr#<attribute_num-1>_#2 (off_t) ...
- * tile_var_sizes_attr#0_num(int64_t)
- * tile_var_sizes_attr#0_#1(size_t) tile_sizes_attr#0_#2 (size_t) ...
+ * tile_var_offsets_attr#<attribute_num-1>_#1(off_t) 
+ *     tile_var_offsets_attr#<attribute_num-1>_#2(off_t) ...
+ * tile_var_sizes_attr#0_#1(size_t) tile_var_sizes_attr#0_#2(size_t) ...
  * ...
- * tile_var_sizes_attr#<attribute_num-1>_num(int64_t)
- * tile_var_sizes__attr#<attribute_num-1>_#1(size_t) 
- *     tile_var_sizes_attr#<attribute_num-1>_#2 (size_t) ...
- * last_tile_cell_num(int64_t)
+ * tile_var_sizes_attr#<attribute_num-1>_#1(size_t) 
+ *     tile_var_sizes_attr#<attribute_num-1>_#2(size_t) ...
+ * tile_stats_attr#0_#1(TileStats) tile_stats_attr#0_#2(TileStats) ...
+ * ...
+ * tile_stats_attr#<attribute_num-1>_#1(TileStats) 
+ *     tile_stats_attr#<attribute_num-1>_#2(TileStats) ...
+ * rtree_fanout(int) rtree_level_num(int)
+ * rtree_level_#1_node_num(int64_t) rtree_level_#1_mbrs(void*)
+ * ...
+ * rtree_level_#<rtree_level_num>_node_num(int64_t) 
+ *     rtree_level_#<rtree_level_num>_mbrs(void*)
+ *
+ * The file is not compressed, so that it can be memory-mapped. The sizes of
+ * all the sections are multiples of 8 bytes (the coordinates come in pairs of
+ * 4- or 8-byte values), hence every section is properly aligned in memory.
  */
 int BookKeeping::finalize() {
   // Nothing to do in READ mode
-  int mode = fragment_->mode();
-  if(mode == TILEDB_ARRAY_READ)
+  if(mode_ == TILEDB_ARRAY_READ)
     return TILEDB_BK_OK;
 
   // Do nothing if the fragment directory does not exist (fragment empty) 
-  std::string fragment_name = fragment_->fragment_name();
-  if(!is_dir(fragment_name))
+  if(!is_dir(fragment_name_))
     return TILEDB_BK_OK;
 
   // Prepare file name 
-  std::string filename = fragment_name + "/" +
+  std::string filename = fragment_name_ + "/" +
                          TILEDB_BOOK_KEEPING_FILENAME + 
-                         TILEDB_FILE_SUFFIX + TILEDB_GZIP_SUFFIX;
+                         TILEDB_FILE_SUFFIX;
 
   // Open book-keeping file
-  gzFile fd = gzopen(filename.c_str(), "wb");
-  if(fd == NULL) {
+  int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRWXU);
+  if(fd == -1) {
     PRINT_ERROR("Cannot finalize book-keeping; Cannot open file");
     return TILEDB_BK_ERR;
   }
+
+  // Write header
+  if(flush_header(fd) != TILEDB_BK_OK)
+    return TILEDB_BK_ERR;
   
   // Write non-empty domain
   if(flush_non_empty_domain(fd) != TILEDB_BK_OK)
@@ -277,12 +342,17 @@ int BookKeeping::finalize() {
   if(flush_tile_var_sizes(fd) != TILEDB_BK_OK)
     return TILEDB_BK_ERR;
 
-  // Write cell number of the last tile
-  if(flush_last_tile_cell_num(fd) != TILEDB_BK_OK)
+  // Write tile statistics
+  if(flush_tile_stats(fd) != TILEDB_BK_OK)
     return TILEDB_BK_ERR;
 
-  // Close file
-  if(gzclose(fd) != Z_OK) {
+  // Build and write R-tree
+  build_rtree();
+  if(flush_rtree(fd) != TILEDB_BK_OK)
+    return TILEDB_BK_ERR;
+
+  // Sync and close file
+  if(fsync(fd) || close(fd)) {
     PRINT_ERROR("Cannot finalize book-keeping; Cannot close file");
     return TILEDB_BK_ERR;
   }
@@ -293,25 +363,24 @@ int BookKeeping::finalize() {
 
 int BookKeeping::init(const void* non_empty_domain) {
   // For easy reference
-  const ArraySchema* array_schema = fragment_->array()->array_schema();
-  int attribute_num = array_schema->attribute_num();
+  int attribute_num = array_schema_->attribute_num();
 
   // Sanity check
   assert(non_empty_domain_ == NULL);
   assert(domain_ == NULL);
 
   // Set non-empty domain
-  size_t domain_size = 2*array_schema->coords_size();
+  size_t domain_size = 2*array_schema_->coords_size();
   non_empty_domain_ = malloc(domain_size);
   if(non_empty_domain == NULL) 
-    memcpy(non_empty_domain_, array_schema->domain(), domain_size);
+    memcpy(non_empty_domain_, array_schema_->domain(), domain_size);
   else
     memcpy(non_empty_domain_, non_empty_domain, domain_size);
   
   // Set expanded domain
   domain_ = malloc(domain_size);
   memcpy(domain_, non_empty_domain_, domain_size);
-  array_schema->expand_domain(domain_);
+  array_schema_->expand_domain(domain_);
 
   // Set last tile cell number
   last_tile_cell_num_ = 0;
@@ -331,85 +400,97 @@ int BookKeeping::init(const void* non_empty_domain) {
   // Initialize variable tile sizes
   tile_var_sizes_.resize(attribute_num);
 
+  // Initialize tile statistics
+  tile_stats_.resize(attribute_num);
+
   // Success
   return TILEDB_BK_OK;
 }
 
 /* FORMAT:
- * non_empty_domain_size(size_t) non_empty_domain(void*)  
- * mbr_num(int64_t)
- * mbr_#1(void*) mbr_#2(void*) ... 
- * bounding_coords_num(int64_t)
+ * version(int) attribute_num(int)
+ * non_empty_domain_size(size_t) last_tile_cell_num(int64_t)
+ * mbr_num(int64_t) bounding_coords_num(int64_t)
+ * tile_offsets_attr#0_num(int64_t) ... 
+ *     tile_offsets_attr#<attribute_num>_num(int64_t)
+ * tile_var_offsets_attr#0_num(int64_t) ... 
+ *     tile_var_offsets_attr#<attribute_num-1>_num(int64_t)
+ * tile_var_sizes_attr#0_num(int64_t) ... 
+ *     tile_var_sizes_attr#<attribute_num-1>_num(int64_t)
+ * tile_stats_attr#0_num(int64_t) ... 
+ *     tile_stats_attr#<attribute_num-1>_num(int64_t)
+ * non_empty_domain(void*)
+ * mbr_#1(void*) mbr_#2(void*) ...
  * bounding_coords_#1(void*) bounding_coords_#2(void*) ...
- * tile_offsets_attr#0_num(int64_t)
- * tile_offsets_attr#0_#1 (off_t) tile_offsets_attr#0_#2 (off_t) ...
+ * tile_offsets_attr#0_#1(off_t) tile_offsets_attr#0_#2(off_t) ...
  * ...
- * tile_offsets_attr#<attribute_num>_num(int64_t)
  * tile_offsets_attr#<attribute_num>_#1(off_t) 
- *     tile_offsets_attr#<attribute_num>_#2 (off_t) ...
- * tile_var_offsets_attr#0_num(int64_t)
- * tile_var_offsets_attr#0_#1 (off_t) tile_var_offsets_attr#0_#2 (off_t) ...
+ *     tile_offsets_attr#<attribute_num>_#2(off_t) ...
+ * tile_var_offsets_attr#0_#1(off_t) tile_var_offsets_attr#0_#2(off_t) ...
  * ...
- * tile_var_offsets_attr#<attribute_num-1>_num(int64_t)
- * tile_var_offsets_attr#<attribute_num-1>_#1 (off_t) 
- *     tile_var_offsets_attr#<attribute_num-1>_#2 (off_t) ...
- * tile_var_sizes_attr#0_num(int64_t)
- * tile_var_sizes_attr#0_#1(size_t) tile_sizes_attr#0_#2 (size_t) ...
+ * tile_var_offsets_attr#<attribute_num-1>_#1(off_t) 
+ *     tile_var_offsets_attr#<attribute_num-1>_#2(off_t) ...
+ * tile_var_sizes_attr#0_#1(size_t) tile_var_sizes_attr#0_#2(size_t) ...
  * ...
- * tile_var_sizes_attr#<attribute_num-1>_num(int64_t)
- * tile_var_sizes__attr#<attribute_num-1>_#1(size_t) 
- *     tile_var_sizes_attr#<attribute_num-1>_#2 (size_t) ...
- * last_tile_cell_num(int64_t)
+ * tile_var_sizes_attr#<attribute_num-1>_#1(size_t) 
+ *     tile_var_sizes_attr#<attribute_num-1>_#2(size_t) ...
+ * tile_stats_attr#0_#1(TileStats) tile_stats_attr#0_#2(TileStats) ...
+ * ...
+ * tile_stats_attr#<attribute_num-1>_#1(TileStats) 
+ *     tile_stats_attr#<attribute_num-1>_#2(TileStats) ...
+ * rtree_fanout(int) rtree_level_num(int)
+ * rtree_level_#1_node_num(int64_t) rtree_level_#1_mbrs(void*)
+ * ...
+ * rtree_level_#<rtree_level_num>_node_num(int64_t) 
+ *     rtree_level_#<rtree_level_num>_mbrs(void*)
+ *
+ * The file is not compressed, so that it can be memory-mapped. The sizes of
+ * all the sections are multiples of 8 bytes (the coordinates come in pairs of
+ * 4- or 8-byte values), hence every section is properly aligned in memory.
+ * Apart from the current version, only the GZIP-compressed files of the
+ * fragments created before the file was memory-mapped are loaded.
  */
 int BookKeeping::load() {
   // Prepare file name
-  std::string filename = fragment_->fragment_name() + "/" +
+  std::string filename = fragment_name_ + "/" +
                          TILEDB_BOOK_KEEPING_FILENAME + 
-                         TILEDB_FILE_SUFFIX + TILEDB_GZIP_SUFFIX;
+                         TILEDB_FILE_SUFFIX;
+
+  // Fragments created before the current format have a compressed file
+  if(!is_file(filename))
+    return load_gz();
 
   // Open book-keeping file
-  gzFile fd = gzopen(filename.c_str(), "rb");
-  if(fd == NULL) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  if(fd == -1) {
     PRINT_ERROR("Cannot load book-keeping; Cannot open file");
     return TILEDB_BK_ERR;
   }
 
-  // Load non-empty domain
-  if(load_non_empty_domain(fd) != TILEDB_BK_OK)
-    return TILEDB_BK_ERR;
-
-  // Load MBRs
-  if(load_mbrs(fd) != TILEDB_BK_OK)
-    return TILEDB_BK_ERR;
-
-  // Load bounding coordinates
-  if(load_bounding_coords(fd) != TILEDB_BK_OK)
-    return TILEDB_BK_ERR;
-
-  // Load tile offsets
-  if(load_tile_offsets(fd) != TILEDB_BK_OK)
-    return TILEDB_BK_ERR;
-
-  // Load variable tile offsets
-  if(load_tile_var_offsets(fd) != TILEDB_BK_OK)
-    return TILEDB_BK_ERR;
-
-  // Load variable tile sizes
-  if(load_tile_var_sizes(fd) != TILEDB_BK_OK)
+  // Map the file into memory
+  struct stat st;
+  if(fstat(fd, &st)) {
+    close(fd);
+    PRINT_ERROR("Cannot load book-keeping; Cannot get file size");
     return TILEDB_BK_ERR;
-
-  // Load cell number of last tile
-  if(load_last_tile_cell_num(fd) != TILEDB_BK_OK)
+  }
+  map_size_ = st.st_size;
+  map_ = mmap(NULL, map_size_, PROT_READ, MAP_SHARED, fd, 0);
+  if(map_ == MAP_FAILED) {
+    map_ = NULL;
+    close(fd);
+    PRINT_ERROR("Cannot load book-keeping; Memory map error");
     return TILEDB_BK_ERR;
+  }
 
-  // Close file
-  if(gzclose(fd) != Z_OK) {
+  // Close file (the mapping outlives the descriptor)
+  if(close(fd)) {
     PRINT_ERROR("Cannot load book-keeping; Cannot close file");
     return TILEDB_BK_ERR;
   }
 
-  // Success
-  return TILEDB_BK_OK;
+  // Set the book-keeping structures to the file sections
+  return load_sections();
 }
 
 void BookKeeping::set_last_tile_cell_num(int64_t cell_num) {
@@ -423,54 +504,95 @@ void BookKeeping::set_last_tile_cell_num(int64_t cell_num) {
 /*        PRIVATE METHODS         */
 /* ****************************** */
 
+void BookKeeping::build_rtree() {
+  // For easy reference
+  int coords_type = array_schema_->coords_type();
+
+  // Invoke the proper templated function
+  if(coords_type == TILEDB_INT32)
+    build_rtree<int>();
+  else if(coords_type == TILEDB_INT64)
+    build_rtree<int64_t>();
+  else if(coords_type == TILEDB_FLOAT32)
+    build_rtree<float>();
+  else if(coords_type == TILEDB_FLOAT64)
+    build_rtree<double>();
+}
+
+template<class T>
+void BookKeeping::build_rtree() {
+  int dim_num = array_schema_->dim_num();
+  rtree_.build<T>(mbrs_, mbr_num_, dim_num, TILEDB_RTREE_FANOUT);
+}
+
 /* FORMAT:
- * bounding_coords_num(int64_t)
  * bounding_coords_#1(void*) bounding_coords_#2(void*) ...
  */
-int BookKeeping::flush_bounding_coords(gzFile fd) const {
+int BookKeeping::flush_bounding_coords(int fd) const {
   // For easy reference
-  const ArraySchema* array_schema = fragment_->array()->array_schema();
-  size_t bounding_coords_size = 2*array_schema->coords_size();
-  int64_t bounding_coords_num = bounding_coords_.size();
+  size_t bounding_coords_size = 
+      bounding_coords_num_ * 2 * array_schema_->coords_size();
 
-  // Write number of bounding coordinates
-  if(gzwrite(fd, &bounding_coords_num, sizeof(int64_t)) != sizeof(int64_t)) {
-    PRINT_ERROR("Cannot finalize book-keeping; Writing number of bounding "
-                "coordinates failed");
+  // Write bounding coordinates
+  if(::write(fd, bounding_coords_, bounding_coords_size) != 
+     bounding_coords_size) {
+    PRINT_ERROR("Cannot finalize book-keeping; Writing bounding coordinates "
+                "failed");
     return TILEDB_BK_ERR;
   }
 
-  // Write bounding coordinates
-  for(int i=0; i<bounding_coords_num; ++i) {
-    if(gzwrite(fd, bounding_coords_[i], bounding_coords_size) != 
-       bounding_coords_size) {
-      PRINT_ERROR("Cannot finalize book-keeping; Writing bounding coordinates "
-                  "failed");
-      return TILEDB_BK_ERR;
-    }
-  } 
-
   // Success
   return TILEDB_BK_OK;
 }
 
 /* FORMAT:
- * last_tile_cell_num(int64_t) 
+ * version(int) attribute_num(int)
+ * non_empty_domain_size(size_t) last_tile_cell_num(int64_t)
+ * mbr_num(int64_t) bounding_coords_num(int64_t)
+ * tile_offsets_attr#0_num(int64_t) ... 
+ *     tile_offsets_attr#<attribute_num>_num(int64_t)
+ * tile_var_offsets_attr#0_num(int64_t) ... 
+ *     tile_var_offsets_attr#<attribute_num-1>_num(int64_t)
+ * tile_var_sizes_attr#0_num(int64_t) ... 
+ *     tile_var_sizes_attr#<attribute_num-1>_num(int64_t)
+ * tile_stats_attr#0_num(int64_t) ... 
+ *     tile_stats_attr#<attribute_num-1>_num(int64_t)
  */
-int BookKeeping::flush_last_tile_cell_num(gzFile fd) const {
+int BookKeeping::flush_header(int fd) const {
   // For easy reference
-  const ArraySchema* array_schema = fragment_->array()->array_schema();
+  int attribute_num = array_schema_->attribute_num();
+  int version = TILEDB_BK_VERSION;
+  size_t domain_size = (non_empty_domain_ == NULL) ? 0 : 
+      array_schema_->coords_size() * 2;
   int64_t cell_num_per_tile = 
-      fragment_->dense() ? array_schema->cell_num_per_tile() :
-                           array_schema->capacity();
+      dense_ ? array_schema_->cell_num_per_tile() :
+                           array_schema_->capacity();
 
   // Handle the case of zero
   int64_t last_tile_cell_num = 
       (last_tile_cell_num_ == 0) ? cell_num_per_tile : last_tile_cell_num_;
 
-  if(gzwrite(fd, &last_tile_cell_num, sizeof(int64_t)) != sizeof(int64_t)) {
-    PRINT_ERROR("Cannot finalize book-keeping; Writing last tile cell "
-                "number failed");
+  // Serialize header
+  std::vector<int64_t> nums;
+  nums.push_back(last_tile_cell_num);
+  nums.push_back(mbr_num_);
+  nums.push_back(bounding_coords_num_);
+  for(int i=0; i<attribute_num+1; ++i)
+    nums.push_back(tile_offsets_[i].size());
+  for(int i=0; i<attribute_num; ++i)
+    nums.push_back(tile_var_offsets_[i].size());
+  for(int i=0; i<attribute_num; ++i)
+    nums.push_back(tile_var_sizes_[i].size());
+  for(int i=0; i<attribute_num; ++i)
+    nums.push_back(tile_stats_[i].size());
+
+  // Write header
+  size_t nums_size = nums.size() * sizeof(int64_t);
+  if(::write(fd, &version, sizeof(int)) != sizeof(int) ||
+     ::write(fd, &attribute_num, sizeof(int)) != sizeof(int) ||
+     ::write(fd, &domain_size, sizeof(size_t)) != sizeof(size_t) ||
+     ::write(fd, &nums[0], nums_size) != nums_size) {
+    PRINT_ERROR("Cannot finalize book-keeping; Writing header failed");
     return TILEDB_BK_ERR;
   }
 
@@ -479,52 +601,50 @@ int BookKeeping::flush_last_tile_cell_num(gzFile fd) const {
 }
 
 /* FORMAT:
- * mbr_num(int64_t)
  * mbr_#1(void*) mbr_#2(void*) ... 
  */
-int BookKeeping::flush_mbrs(gzFile fd) const {
+int BookKeeping::flush_mbrs(int fd) const {
   // For easy reference
-  const ArraySchema* array_schema = fragment_->array()->array_schema();
-  size_t mbr_size = 2*array_schema->coords_size();
-  int64_t mbr_num = mbrs_.size();
+  size_t mbrs_size = mbr_num_ * 2 * array_schema_->coords_size();
 
-  // Write number of MBRs
-  if(gzwrite(fd, &mbr_num, sizeof(int64_t)) != sizeof(int64_t)) {
-    PRINT_ERROR("Cannot finalize book-keeping; Writing number of MBRs failed");
+  // Write MBRs
+  if(::write(fd, mbrs_, mbrs_size) != mbrs_size) {
+    PRINT_ERROR("Cannot finalize book-keeping; Writing MBRs failed");
     return TILEDB_BK_ERR;
   }
 
-  // Write MBRs
-  for(int i=0; i<mbr_num; ++i) {
-    if(gzwrite(fd, mbrs_[i], mbr_size) != mbr_size) {
-      PRINT_ERROR("Cannot finalize book-keeping; Writing MBR failed");
-      return TILEDB_BK_ERR;
-    }
-  } 
-
   // Success
   return TILEDB_BK_OK;
 }
 
 /* FORMAT:
- * non_empty_domain_size(size_t) non_empty_domain(void*)  
+ * non_empty_domain(void*)  
  */
-int BookKeeping::flush_non_empty_domain(gzFile fd) const {
+int BookKeeping::flush_non_empty_domain(int fd) const {
   size_t domain_size = (non_empty_domain_ == NULL) ? 0 : 
-      fragment_->array()->array_schema()->coords_size() * 2;
+      array_schema_->coords_size() * 2;
 
-  // Write non-empty domain size
-  if(gzwrite(fd, &domain_size, sizeof(size_t)) != sizeof(size_t)) {
-    PRINT_ERROR("Cannot finalize book-keeping; Writing domain size failed");
+  // Write non-empty domain
+  if(::write(fd, non_empty_domain_, domain_size) != domain_size) {
+    PRINT_ERROR("Cannot finalize book-keeping; Writing domain failed");
     return TILEDB_BK_ERR;
   }
 
-  // Write non-empty domain
-  if(non_empty_domain_ != NULL) {
-    if(gzwrite(fd, non_empty_domain_, domain_size) != domain_size) {
-      PRINT_ERROR("Cannot finalize book-keeping; Writing domain failed");
-      return TILEDB_BK_ERR;
-    }
+  // Success
+  return TILEDB_BK_OK;
+}
+
+/* FORMAT:
+ * rtree_fanout(int) rtree_level_num(int)
+ * rtree_level_#1_node_num(int64_t) rtree_level_#1_mbrs(void*)
+ * ...
+ * rtree_level_#<rtree_level_num>_node_num(int64_t) 
+ *     rtree_level_#<rtree_level_num>_mbrs(void*)
+ */
+int BookKeeping::flush_rtree(int fd) const {
+  if(rtree_.flush(fd) != TILEDB_RT_OK) {
+    PRINT_ERROR("Cannot finalize book-keeping; Writing R-tree failed");
+    return TILEDB_BK_ERR;
   }
 
   // Success
@@ -532,35 +652,20 @@ int BookKeeping::flush_non_empty_domain(gzFile fd) const {
 }
 
 /* FORMAT:
- * tile_offsets_attr#0_num(int64_t)
- * tile_offsets_attr#0_#1 (off_t) tile_offsets_attr#0_#2 (off_t) ...
+ * tile_offsets_attr#0_#1(off_t) tile_offsets_attr#0_#2(off_t) ...
  * ...
- * tile_offsets_attr#<attribute_num>_num(int64_t)
- * tile_offsets_attr#<attribute_num>_#1 (off_t)
- * tile_offsets_attr#<attribute_num>_#2 (off_t) ...
+ * tile_offsets_attr#<attribute_num>_#1(off_t)
+ *     tile_offsets_attr#<attribute_num>_#2(off_t) ...
  */
-int BookKeeping::flush_tile_offsets(gzFile fd) const {
+int BookKeeping::flush_tile_offsets(int fd) const {
   // For easy reference
-  const ArraySchema* array_schema = fragment_->array()->array_schema();
-  int attribute_num = array_schema->attribute_num();
-  int64_t tile_offsets_num;
+  int attribute_num = array_schema_->attribute_num();
 
   // Write tile offsets for each attribute
   for(int i=0; i<attribute_num+1; ++i) {
-    // Write number of tile offsets
-    tile_offsets_num = tile_offsets_[i].size(); 
-    if(gzwrite(fd, &tile_offsets_num, sizeof(int64_t)) != sizeof(int64_t)) {
-      PRINT_ERROR("Cannot finalize book-keeping; Writing number of "
-                  "tile offsets failed");
-      return TILEDB_BK_ERR;
-    }
-
-    if(tile_offsets_num == 0)
-      continue;
-
-    // Write tile offsets
-    if(gzwrite(fd, &tile_offsets_[i][0], tile_offsets_num * sizeof(off_t)) !=
-       tile_offsets_num * sizeof(off_t)) {
+    size_t tile_offsets_size = tile_offsets_[i].size() * sizeof(off_t);
+    if(::write(fd, tile_offsets_[i].data(), tile_offsets_size) != 
+       tile_offsets_size) {
       PRINT_ERROR("Cannot finalize book-keeping; Writing tile offsets failed");
       return TILEDB_BK_ERR;
     }
@@ -571,38 +676,45 @@ int BookKeeping::flush_tile_offsets(gzFile fd) const {
 }
 
 /* FORMAT:
- * tile_var_offsets_attr#0_num(int64_t)
- * tile_var_offsets_attr#0_#1 (off_t) tile_var_offsets_attr#0_#2 (off_t) ...
+ * tile_stats_attr#0_#1(TileStats) tile_stats_attr#0_#2(TileStats) ...
  * ...
- * tile_var_offsets_attr#<attribute_num-1>_num(int64_t)
- * tile_var_offsets_attr#<attribute_num-1>_#1 (off_t)
- *     tile_var_offsets_attr#<attribute_num-1>_#2 (off_t) ...
+ * tile_stats_attr#<attribute_num-1>_#1(TileStats)
+ *     tile_stats_attr#<attribute_num-1>_#2(TileStats) ...
  */
-int BookKeeping::flush_tile_var_offsets(gzFile fd) const {
+int BookKeeping::flush_tile_stats(int fd) const {
   // For easy reference
-  const ArraySchema* array_schema = fragment_->array()->array_schema();
-  int attribute_num = array_schema->attribute_num();
-  int64_t tile_var_offsets_num;
+  int attribute_num = array_schema_->attribute_num();
 
-  // Write tile offsets for each attribute
+  // Write tile statistics for each attribute
   for(int i=0; i<attribute_num; ++i) {
-    // Write number of offsets
-    tile_var_offsets_num = tile_var_offsets_[i].size(); 
-    if(gzwrite(fd, &tile_var_offsets_num, sizeof(int64_t)) != sizeof(int64_t)) {
-      PRINT_ERROR("Cannot finalize book-keeping; Writing number of "
-                  "variable tile offsets failed");
+    size_t tile_stats_size = tile_stats_[i].size() * sizeof(TileStats);
+    if(::write(fd, tile_stats_[i].data(), tile_stats_size) != 
+       tile_stats_size) {
+      PRINT_ERROR("Cannot finalize book-keeping; Writing tile statistics "
+                  "failed");
       return TILEDB_BK_ERR;
     }
+  }
 
-    if(tile_var_offsets_num == 0)
-      continue;
+  // Success
+  return TILEDB_BK_OK;
+}
 
-    // Write tile offsets
-    if(gzwrite(
-           fd,  
-           &tile_var_offsets_[i][0], 
-           tile_var_offsets_num * sizeof(off_t)) !=
-       tile_var_offsets_num * sizeof(off_t)) {
+/* FORMAT:
+ * tile_var_offsets_attr#0_#1(off_t) tile_var_offsets_attr#0_#2(off_t) ...
+ * ...
+ * tile_var_offsets_attr#<attribute_num-1>_#1(off_t)
+ *     tile_var_offsets_attr#<attribute_num-1>_#2(off_t) ...
+ */
+int BookKeeping::flush_tile_var_offsets(int fd) const {
+  // For easy reference
+  int attribute_num = array_schema_->attribute_num();
+
+  // Write variable tile offsets for each attribute
+  for(int i=0; i<attribute_num; ++i) {
+    size_t tile_var_offsets_size = tile_var_offsets_[i].size() * sizeof(off_t);
+    if(::write(fd, tile_var_offsets_[i].data(), tile_var_offsets_size) != 
+       tile_var_offsets_size) {
       PRINT_ERROR("Cannot finalize book-keeping; Writing variable tile "
                   "offsets failed");
       return TILEDB_BK_ERR;
@@ -614,38 +726,20 @@ int BookKeeping::flush_tile_var_offsets(gzFile fd) const {
 }
  
 /* FORMAT:
- * tile_var_sizes_attr#0_num(int64_t)
- * tile_var_sizes_attr#0_#1 (size_t) tile_sizes_attr#0_#2 (size_t) ...
+ * tile_var_sizes_attr#0_#1(size_t) tile_var_sizes_attr#0_#2(size_t) ...
  * ...
- * tile_var_sizes_attr#<attribute_num-1>_num(int64_t)
- * tile_var_sizes__attr#<attribute_num-1>_#1(size_t) 
- *     tile_var_sizes_attr#<attribute_num-1>_#2 (size_t) ...
+ * tile_var_sizes_attr#<attribute_num-1>_#1(size_t) 
+ *     tile_var_sizes_attr#<attribute_num-1>_#2(size_t) ...
  */
-int BookKeeping::flush_tile_var_sizes(gzFile fd) const {
+int BookKeeping::flush_tile_var_sizes(int fd) const {
   // For easy reference
-  const ArraySchema* array_schema = fragment_->array()->array_schema();
-  int attribute_num = array_schema->attribute_num();
-  int64_t tile_var_sizes_num;
+  int attribute_num = array_schema_->attribute_num();
 
-  // Write tile sizes for each attribute
+  // Write variable tile sizes for each attribute
   for(int i=0; i<attribute_num; ++i) {
-    // Write number of sizes
-    tile_var_sizes_num = tile_var_sizes_[i].size(); 
-    if(gzwrite(fd, &tile_var_sizes_num, sizeof(int64_t)) != sizeof(int64_t)) {
-      PRINT_ERROR("Cannot finalize book-keeping; Writing number of "
-                  "variable tile sizes failed");
-      return TILEDB_BK_ERR;
-    }
-
-    if(tile_var_sizes_num == 0)
-      continue;
-
-    // Write tile sizes
-    if(gzwrite(
-           fd,  
-           &tile_var_sizes_[i][0], 
-           tile_var_sizes_num * sizeof(size_t)) !=
-       tile_var_sizes_num * sizeof(size_t)) {
+    size_t tile_var_sizes_size = tile_var_sizes_[i].size() * sizeof(size_t);
+    if(::write(fd, tile_var_sizes_[i].data(), tile_var_sizes_size) != 
+       tile_var_sizes_size) {
       PRINT_ERROR("Cannot finalize book-keeping; Writing variable tile "
                   "sizes failed");
       return TILEDB_BK_ERR;
@@ -662,36 +756,133 @@ int BookKeeping::flush_tile_var_sizes(gzFile fd) const {
  */
 int BookKeeping::load_bounding_coords(gzFile fd) {
   // For easy reference
-  const ArraySchema* array_schema = fragment_->array()->array_schema();
-  size_t bounding_coords_size = 2*array_schema->coords_size();
+  size_t bounding_coords_size = 2*array_schema_->coords_size();
 
   // Get number of bounding coordinates
-  int64_t bounding_coords_num;
-  if(gzread(fd, &bounding_coords_num, sizeof(int64_t)) != sizeof(int64_t)) {
+  if(gzread(fd, &bounding_coords_num_, sizeof(int64_t)) != sizeof(int64_t)) {
     PRINT_ERROR("Cannot load book-keeping; Reading number of "
                 "bounding coordinates failed");
     return TILEDB_BK_ERR;
   }
 
   // Get bounding coordinates
-  void* bounding_coords;
-  bounding_coords_.resize(bounding_coords_num);
-  for(int64_t i=0; i<bounding_coords_num; ++i) {
-    bounding_coords = malloc(bounding_coords_size);
-    if(gzread(fd, bounding_coords, bounding_coords_size) != 
-       bounding_coords_size) {
+  bounding_coords_allocated_size_ = 
+      bounding_coords_num_ * bounding_coords_size;
+  if(bounding_coords_allocated_size_ != 0) {
+    bounding_coords_ = malloc(bounding_coords_allocated_size_);
+    if(gzread(fd, bounding_coords_, bounding_coords_allocated_size_) != 
+       bounding_coords_allocated_size_) {
       PRINT_ERROR("Cannot load book-keeping; Reading bounding coordinates "
                   "failed");
-      free(bounding_coords);
       return TILEDB_BK_ERR;
     }
-    bounding_coords_[i] = bounding_coords;
   }
 
   // Success
   return TILEDB_BK_OK;
 }
 
+/* FORMAT:
+ * non_empty_domain_size(size_t) non_empty_domain(void*)  
+ * mbr_num(int64_t)
+ * mbr_#1(void*) mbr_#2(void*) ... 
+ * bounding_coords_num(int64_t)
+ * bounding_coords_#1(void*) bounding_coords_#2(void*) ...
+ * tile_offsets_attr#0_num(int64_t)
+ * tile_offsets_attr#0_#1 (off_t) tile_offsets_attr#0_#2 (off_t) ...
+ * ...
+ * tile_offsets_attr#<attribute_num>_num(int64_t)
+ * tile_offsets_attr#<attribute_num>_#1(off_t) 
+ *     tile_offsets_attr#<attribute_num>_#2 (off_t) ...
+ * tile_var_offsets_attr#0_num(int64_t)
+ * tile_var_offsets_attr#0_#1 (off_t) tile_var_offsets_attr#0_#2 (off_t) ...
+ * ...
+ * tile_var_offsets_attr#<attribute_num-1>_num(int64_t)
+ * tile_var_offsets_attr#<attribute_num-1>_#1 (off_t) 
+ *     tile_var_offsets_attr#<attribute_num-1>_#2 (off_t) ...
+ * tile_var_sizes_attr#0_num(int64_t)
+ * tile_var_sizes_attr#0_#1(size_t) tile_sizes_attr#0_#2 (size_t) ...
+ * ...
+ * tile_var_sizes_attr#<attribute_num-1>_num(int64_t)
+ * tile_var_sizes__attr#<attribute_num-1>_#1(size_t) 
+ *     tile_var_sizes_attr#<attribute_num-1>_#2 (size_t) ...
+ * last_tile_cell_num(int64_t)
+ * rtree_fanout(int) rtree_level_num(int)
+ * rtree_level_#1_node_num(int64_t) rtree_level_#1_mbrs(void*)
+ * ...
+ * rtree_level_#<rtree_level_num>_node_num(int64_t) 
+ *     rtree_level_#<rtree_level_num>_mbrs(void*)
+ */
+int BookKeeping::load_gz() {
+  // Prepare file name
+  std::string filename = fragment_name_ + "/" +
+                         TILEDB_BOOK_KEEPING_FILENAME + 
+                         TILEDB_FILE_SUFFIX + TILEDB_GZIP_SUFFIX;
+
+  // Open book-keeping file
+  gzFile fd = gzopen(filename.c_str(), "rb");
+  if(fd == NULL) {
+    PRINT_ERROR("Cannot load book-keeping; Cannot open file");
+    return TILEDB_BK_ERR;
+  }
+
+  // Load non-empty domain
+  if(load_non_empty_domain(fd) != TILEDB_BK_OK)
+    return TILEDB_BK_ERR;
+
+  // Load MBRs
+  if(load_mbrs(fd) != TILEDB_BK_OK)
+    return TILEDB_BK_ERR;
+
+  // Load bounding coordinates
+  if(load_bounding_coords(fd) != TILEDB_BK_OK)
+    return TILEDB_BK_ERR;
+
+  // Load tile offsets
+  if(load_tile_offsets(fd) != TILEDB_BK_OK)
+    return TILEDB_BK_ERR;
+
+  // Load variable tile offsets
+  if(load_tile_var_offsets(fd) != TILEDB_BK_OK)
+    return TILEDB_BK_ERR;
+
+  // Load variable tile sizes
+  if(load_tile_var_sizes(fd) != TILEDB_BK_OK)
+    return TILEDB_BK_ERR;
+
+  // Load cell number of last tile
+  if(load_last_tile_cell_num(fd) != TILEDB_BK_OK)
+    return TILEDB_BK_ERR;
+
+  // Load R-tree
+  if(load_rtree(fd) != TILEDB_BK_OK)
+    return TILEDB_BK_ERR;
+
+  // Close file
+  if(gzclose(fd) != Z_OK) {
+    PRINT_ERROR("Cannot load book-keeping; Cannot close file");
+    return TILEDB_BK_ERR;
+  }
+
+  // Point to the loaded tile offsets and sizes
+  int attribute_num = array_schema_->attribute_num();
+  tile_offsets_ptrs_.resize(attribute_num+1);
+  for(int i=0; i<attribute_num+1; ++i)
+    tile_offsets_ptrs_[i] = tile_offsets_[i].data();
+  tile_var_offsets_ptrs_.resize(attribute_num);
+  tile_var_sizes_ptrs_.resize(attribute_num);
+  for(int i=0; i<attribute_num; ++i) {
+    tile_var_offsets_ptrs_[i] = tile_var_offsets_[i].data();
+    tile_var_sizes_ptrs_[i] = tile_var_sizes_[i].data();
+  }
+
+  // The compressed format has no tile statistics
+  tile_stats_ptrs_.assign(attribute_num, NULL);
+
+  // Success
+  return TILEDB_BK_OK;
+}
+
 /* FORMAT:
  * last_tile_cell_num (int64_t)  
  */
@@ -713,27 +904,22 @@ int BookKeeping::load_last_tile_cell_num(gzFile fd) {
  */
 int BookKeeping::load_mbrs(gzFile fd) {
   // For easy reference
-  const ArraySchema* array_schema = fragment_->array()->array_schema();
-  size_t mbr_size = 2*array_schema->coords_size();
+  size_t mbr_size = 2*array_schema_->coords_size();
 
   // Get number of MBRs
-  int64_t mbr_num;
-  if(gzread(fd, &mbr_num, sizeof(int64_t)) != sizeof(int64_t)) {
+  if(gzread(fd, &mbr_num_, sizeof(int64_t)) != sizeof(int64_t)) {
     PRINT_ERROR("Cannot load book-keeping; Reading number of MBRs failed");
     return TILEDB_BK_ERR;
   }
 
   // Get MBRs
-  void* mbr;
-  mbrs_.resize(mbr_num);
-  for(int64_t i=0; i<mbr_num; ++i) {
-    mbr = malloc(mbr_size);
-    if(gzread(fd, mbr, mbr_size) != mbr_size) {
-      PRINT_ERROR("Cannot load book-keeping; Reading MBR failed");
-      free(mbr);
+  mbrs_allocated_size_ = mbr_num_ * mbr_size;
+  if(mbrs_allocated_size_ != 0) {
+    mbrs_ = malloc(mbrs_allocated_size_);
+    if(gzread(fd, mbrs_, mbrs_allocated_size_) != mbrs_allocated_size_) {
+      PRINT_ERROR("Cannot load book-keeping; Reading MBRs failed");
       return TILEDB_BK_ERR;
     }
-    mbrs_[i] = mbr;
   }
 
   // Success
@@ -767,9 +953,141 @@ int BookKeeping::load_non_empty_domain(gzFile fd) {
     domain_ = NULL;
   } else { 
     domain_ = malloc(domain_size);
-    const ArraySchema* array_schema = fragment_->array()->array_schema();
     memcpy(domain_, non_empty_domain_, domain_size);
-    array_schema->expand_domain(domain_);
+    array_schema_->expand_domain(domain_);
+  }
+
+  // Success
+  return TILEDB_BK_OK;
+}
+
+/* FORMAT:
+ * rtree_fanout (int) rtree_level_num (int)
+ * rtree_level_#1_node_num (int64_t) rtree_level_#1_mbrs (void*)
+ * ...
+ * rtree_level_#<rtree_level_num>_node_num (int64_t) 
+ *     rtree_level_#<rtree_level_num>_mbrs (void*)
+ */
+int BookKeeping::load_rtree(gzFile fd) {
+  // Get R-tree
+  if(rtree_.load(
+         fd, 
+         array_schema_->dim_num(), 
+         array_schema_->coords_size()) != TILEDB_RT_OK) {
+    PRINT_ERROR("Cannot load book-keeping; Reading R-tree failed");
+    return TILEDB_BK_ERR;
+  }
+
+  // Build the R-tree if the file does not have it
+  if(rtree_.level_num() == 0 && mbr_num_ > 1)
+    build_rtree();
+
+  // Success
+  return TILEDB_BK_OK;
+}
+
+int BookKeeping::load_sections() {
+  // For easy reference
+  int attribute_num = array_schema_->attribute_num();
+  int dim_num = array_schema_->dim_num();
+  size_t coords_size = array_schema_->coords_size();
+  char* map = static_cast<char*>(map_);
+
+  // Check header
+  int version, file_attribute_num;
+  if(map_size_ < 2*sizeof(int)) {
+    PRINT_ERROR("Cannot load book-keeping; File is truncated");
+    return TILEDB_BK_ERR;
+  }
+  memcpy(&version, map, sizeof(int));
+  memcpy(&file_attribute_num, map + sizeof(int), sizeof(int));
+  if(version != TILEDB_BK_VERSION || file_attribute_num != attribute_num) {
+    PRINT_ERROR("Cannot load book-keeping; Unsupported file format");
+    return TILEDB_BK_ERR;
+  }
+  size_t header_size = 
+      2*sizeof(int) + sizeof(size_t) + (4*attribute_num+4)*sizeof(int64_t);
+  if(map_size_ < header_size) {
+    PRINT_ERROR("Cannot load book-keeping; File is truncated");
+    return TILEDB_BK_ERR;
+  }
+
+  // Read header
+  size_t domain_size;
+  size_t offset = 2*sizeof(int);
+  memcpy(&domain_size, map + offset, sizeof(size_t));
+  offset += sizeof(size_t);
+  const int64_t* nums = reinterpret_cast<const int64_t*>(map + offset);
+  last_tile_cell_num_ = nums[0];
+  mbr_num_ = nums[1];
+  bounding_coords_num_ = nums[2];
+  const int64_t* tile_offsets_nums = &nums[3];
+  const int64_t* tile_var_offsets_nums = &tile_offsets_nums[attribute_num+1];
+  const int64_t* tile_var_sizes_nums = &tile_var_offsets_nums[attribute_num];
+  const int64_t* tile_stats_nums = &tile_var_sizes_nums[attribute_num];
+  offset = header_size;
+
+  // Check that the file holds all the sections
+  size_t sections_size = 
+      domain_size + (mbr_num_ + bounding_coords_num_) * 2 * coords_size;
+  for(int i=0; i<attribute_num+1; ++i)
+    sections_size += tile_offsets_nums[i] * sizeof(off_t);
+  for(int i=0; i<attribute_num; ++i) {
+    sections_size += tile_var_offsets_nums[i] * sizeof(off_t);
+    sections_size += tile_var_sizes_nums[i] * sizeof(size_t);
+    sections_size += tile_stats_nums[i] * sizeof(TileStats);
+  }
+  if((domain_size != 0 && domain_size != 2*coords_size) ||
+     header_size + sections_size > map_size_) {
+    PRINT_ERROR("Cannot load book-keeping; File is truncated");
+    return TILEDB_BK_ERR;
+  }
+
+  // Copy the non-empty domain and compute the expanded domain
+  if(domain_size != 0) {
+    non_empty_domain_ = malloc(domain_size);
+    memcpy(non_empty_domain_, map + offset, domain_size);
+    domain_ = malloc(domain_size);
+    memcpy(domain_, non_empty_domain_, domain_size);
+    array_schema_->expand_domain(domain_);
+    offset += domain_size;
+  }
+
+  // The rest of the sections are accessed directly in the mapped file
+  mbrs_ = map + offset;
+  offset += mbr_num_ * 2 * coords_size;
+  bounding_coords_ = map + offset;
+  offset += bounding_coords_num_ * 2 * coords_size;
+  tile_offsets_ptrs_.resize(attribute_num+1);
+  for(int i=0; i<attribute_num+1; ++i) {
+    tile_offsets_ptrs_[i] = reinterpret_cast<const off_t*>(map + offset);
+    offset += tile_offsets_nums[i] * sizeof(off_t);
+  }
+  tile_var_offsets_ptrs_.resize(attribute_num);
+  for(int i=0; i<attribute_num; ++i) {
+    tile_var_offsets_ptrs_[i] = reinterpret_cast<const off_t*>(map + offset);
+    offset += tile_var_offsets_nums[i] * sizeof(off_t);
+  }
+  tile_var_sizes_ptrs_.resize(attribute_num);
+  for(int i=0; i<attribute_num; ++i) {
+    tile_var_sizes_ptrs_[i] = reinterpret_cast<const size_t*>(map + offset);
+    offset += tile_var_sizes_nums[i] * sizeof(size_t);
+  }
+  tile_stats_ptrs_.assign(attribute_num, NULL);
+  for(int i=0; i<attribute_num; ++i) {
+    if(tile_stats_nums[i] != 0)
+      tile_stats_ptrs_[i] = reinterpret_cast<const TileStats*>(map + offset);
+    offset += tile_stats_nums[i] * sizeof(TileStats);
+  }
+
+  // Load R-tree
+  if(rtree_.load(
+         map + offset, 
+         map_size_ - offset, 
+         dim_num, 
+         coords_size) != TILEDB_RT_OK) {
+    PRINT_ERROR("Cannot load book-keeping; Reading R-tree failed");
+    return TILEDB_BK_ERR;
   }
 
   // Success
@@ -786,8 +1104,7 @@ int BookKeeping::load_non_empty_domain(gzFile fd) {
  */
 int BookKeeping::load_tile_offsets(gzFile fd) {
   // For easy reference
-  const ArraySchema* array_schema = fragment_->array()->array_schema();
-  int attribute_num = array_schema->attribute_num();
+  int attribute_num = array_schema_->attribute_num();
   int64_t tile_offsets_num;
 
   // Allocate tile offsets
@@ -828,8 +1145,7 @@ int BookKeeping::load_tile_offsets(gzFile fd) {
  */
 int BookKeeping::load_tile_var_offsets(gzFile fd) {
   // For easy reference
-  const ArraySchema* array_schema = fragment_->array()->array_schema();
-  int attribute_num = array_schema->attribute_num();
+  int attribute_num = array_schema_->attribute_num();
   int64_t tile_var_offsets_num;
 
   // Allocate tile offsets
@@ -874,8 +1190,7 @@ int BookKeeping::load_tile_var_offsets(gzFile fd) {
  */
 int BookKeeping::load_tile_var_sizes(gzFile fd) {
   // For easy reference
-  const ArraySchema* array_schema = fragment_->array()->array_schema();
-  int attribute_num = array_schema->attribute_num();
+  int attribute_num = array_schema_->attribute_num();
   int64_t tile_var_sizes_num;
 
   // Allocate tile sizes
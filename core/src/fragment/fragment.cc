@@ -30,12 +30,20 @@
  * This file implements the Fragment class.
  */
 
+#include "array_metadata_cache.h"
+#include "compressor.h"
 #include "fragment.h"
 #include "utils.h"
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
 #include <cstdio>
 #include <cstring>
+#include <fcntl.h>
 #include <iostream>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 
 
@@ -61,6 +69,15 @@
 
 
 
+/* ****************************** */
+/*         STATIC MEMBERS         */
+/* ****************************** */
+
+std::atomic<int> Fragment::cached_fd_num_(0);
+
+
+
+
 /* ****************************** */
 /*   CONSTRUCTORS & DESTRUCTORS   */
 /* ****************************** */
@@ -70,17 +87,27 @@ Fragment::Fragment(const Array* array)
   read_state_ = NULL;
   write_state_ = NULL;
   book_keeping_ = NULL;
+
+  int attribute_num = array_->array_schema()->attribute_num();
+  fds_.resize(2*(attribute_num+1), -1);
+  file_sizes_.resize(2*(attribute_num+1), -1);
 }
 
 Fragment::~Fragment() {
+  close_files();
+
   if(write_state_ != NULL)
     delete write_state_;
 
   if(read_state_ != NULL)
     delete read_state_;
 
-  if(book_keeping_ != NULL)
-    delete book_keeping_;
+  if(book_keeping_ != NULL) {
+    if(mode_ == TILEDB_ARRAY_READ)
+      ArrayMetadataCache::instance()->release_book_keeping(book_keeping_);
+    else
+      delete book_keeping_;
+  }
 }
 
 
@@ -94,6 +121,10 @@ const Array* Fragment::array() const {
   return array_;
 }
 
+BookKeeping* Fragment::book_keeping() const {
+  return book_keeping_;
+}
+
 int64_t Fragment::cell_num_per_tile() const {
   return (dense_) ? array_->array_schema()->cell_num_per_tile() : 
                     array_->array_schema()->capacity(); 
@@ -103,6 +134,81 @@ bool Fragment::dense() const {
   return dense_;
 }
 
+int Fragment::file_descriptor(
+    int attribute_id, 
+    bool var, 
+    bool& cached) const {
+  // For easy reference
+  const ArraySchema* array_schema = array_->array_schema();
+  int attribute_num = array_schema->attribute_num();
+  int i = (var) ? attribute_num + 1 + attribute_id : attribute_id;
+
+  std::lock_guard<std::mutex> lock(files_mtx_);
+
+  // Return the file descriptor if the file is already open
+  if(fds_[i] != -1) {
+    cached = true;
+    return fds_[i];
+  }
+
+  // Open the file
+  std::string filename = fragment_name_ + "/" + 
+                         array_schema->attribute(attribute_id) +
+                         ((var) ? "_var" : "") + 
+                         TILEDB_FILE_SUFFIX;
+  int fd = open(filename.c_str(), O_RDONLY);
+  if(fd == -1) {
+    PRINT_ERROR(std::string("Cannot open file '") + filename + "'; " + 
+                strerror(errno));
+    return -1;
+  }
+
+  // Get the file size (the file is not modified while it is being read)
+  if(file_sizes_[i] == -1) {
+    struct stat st;
+    if(fstat(fd, &st)) {
+      PRINT_ERROR(std::string("Cannot get size of file '") + filename + 
+                  "'; " + strerror(errno));
+      close(fd);
+      return -1;
+    }
+    file_sizes_[i] = st.st_size;
+  }
+
+  // Keep the file open, unless the fragments of the process already keep
+  // too many files open
+  if(cached_fd_num_.fetch_add(1) < max_cached_fd_num()) {
+    fds_[i] = fd;
+    cached = true;
+  } else {
+    --cached_fd_num_;
+    cached = false;
+  }
+
+  return fd;
+}
+
+off_t Fragment::file_size(int attribute_id, bool var) const {
+  int attribute_num = array_->array_schema()->attribute_num();
+  int i = (var) ? attribute_num + 1 + attribute_id : attribute_id;
+
+  // Open the file once to get its size
+  {
+    std::lock_guard<std::mutex> lock(files_mtx_);
+    if(file_sizes_[i] != -1)
+      return file_sizes_[i];
+  }
+  bool cached;
+  int fd = file_descriptor(attribute_id, var, cached);
+  if(fd == -1)
+    return TILEDB_FG_ERR;
+  if(!cached)
+    close(fd);
+
+  std::lock_guard<std::mutex> lock(files_mtx_);
+  return file_sizes_[i];
+}
+
 const std::string& Fragment::fragment_name() const {
   return fragment_name_;
 }
@@ -111,10 +217,65 @@ int Fragment::mode() const {
   return mode_;
 }
 
+int Fragment::read_from_file(
+    int attribute_id,
+    bool var,
+    off_t offset,
+    void* buffer,
+    size_t length) const {
+  // Get the file descriptor
+  bool cached;
+  int fd = file_descriptor(attribute_id, var, cached);
+  if(fd == -1)
+    return TILEDB_FG_ERR;
+
+  // Read, resuming after partial reads
+  int rc = TILEDB_FG_OK;
+  char* buffer_c = static_cast<char*>(buffer);
+  while(length > 0) {
+    ssize_t bytes_read = pread(fd, buffer_c, length, offset);
+    if(bytes_read == -1 && errno == EINTR)
+      continue;
+    if(bytes_read <= 0) {
+      PRINT_ERROR("Cannot read from file; File reading error");
+      rc = TILEDB_FG_ERR;
+      break;
+    }
+    buffer_c += bytes_read;
+    offset += bytes_read;
+    length -= bytes_read;
+  }
+
+  // Close the file if the fragment does not keep it open
+  if(!cached)
+    close(fd);
+
+  return rc;
+}
+
 ReadState* Fragment::read_state() const {
   return read_state_;
 }
 
+off_t Fragment::size() const {
+  // For easy reference
+  const ArraySchema* array_schema = array_->array_schema();
+  int attribute_num = array_schema->attribute_num();
+
+  // Sum the sizes of the attribute files (including the coordinates file)
+  off_t size = 0;
+  for(int i=0; i<=attribute_num; ++i) {
+    std::string filename = fragment_name_ + "/" + array_schema->attribute(i);
+    if(is_file(filename + TILEDB_FILE_SUFFIX))
+      size += ::file_size(filename + TILEDB_FILE_SUFFIX);
+    if(array_schema->var_size(i) && 
+       is_file(filename + "_var" + TILEDB_FILE_SUFFIX))
+      size += ::file_size(filename + "_var" + TILEDB_FILE_SUFFIX);
+  }
+
+  return size;
+}
+
 size_t Fragment::tile_size(int attribute_id) const {
   // For easy reference
   const ArraySchema* array_schema = array_->array_schema();
@@ -154,7 +315,7 @@ int Fragment::finalize() {
     else 
       return TILEDB_FG_OK;
   } else { // The fragment was opened for reading
-    // Nothing to be done
+    close_files();
     return TILEDB_FG_OK;
   } 
 }
@@ -187,11 +348,28 @@ int Fragment::init(
                 fragment_name_ + "/" + TILEDB_COORDS + TILEDB_FILE_SUFFIX);
   }
 
-  // Initialize book-keeping and write state
-  book_keeping_ = new BookKeeping(this);
+  // Initialize book-keeping and write or read state
   if(mode == TILEDB_ARRAY_WRITE || 
      mode == TILEDB_ARRAY_WRITE_UNSORTED) {
     read_state_ = NULL;
+    // The compression level of the configuration applies to the compressed
+    // attributes whose schema sets none, so it must suit their codecs
+    const ArraySchema* array_schema = array_->array_schema();
+    int compression_level = array_->config()->compression_level();
+    int attribute_num = array_schema->attribute_num();
+    for(int i=0; i<attribute_num+1 && compression_level != 0; ++i) {
+      const Compressor* compressor = 
+          Compressor::get(array_schema->compression(i));
+      if(compressor != NULL && 
+         array_schema->compression_level(i) == 0 &&
+         compression_level > compressor->max_level()) {
+        PRINT_ERROR(std::string("Cannot initialize fragment; Compression "
+                    "level of the configuration is invalid for attribute '") +
+                    array_schema->attribute(i) + "'");
+        return TILEDB_FG_ERR;
+      }
+    }
+    book_keeping_ = new BookKeeping(this);
     if(book_keeping_->init(subarray) != TILEDB_BK_OK) {
       delete book_keeping_;
       book_keeping_ = NULL;
@@ -201,10 +379,16 @@ int Fragment::init(
     write_state_ = new WriteState(this, book_keeping_);
   } else if(mode == TILEDB_ARRAY_READ) {
     write_state_ = NULL;
-    if(book_keeping_->load() != TILEDB_BK_OK) {
-      delete book_keeping_;
-      book_keeping_ = NULL;
-      return TILEDB_FG_ERR;
+    // Reuse the book-keeping loaded by another array if it is cached
+    ArrayMetadataCache* cache = ArrayMetadataCache::instance();
+    book_keeping_ = cache->acquire_book_keeping(fragment_name_);
+    if(book_keeping_ == NULL) {
+      BookKeeping* book_keeping = new BookKeeping(this);
+      if(book_keeping->load() != TILEDB_BK_OK) {
+        delete book_keeping;
+        return TILEDB_FG_ERR;
+      }
+      book_keeping_ = cache->insert_book_keeping(fragment_name_, book_keeping);
     }
     read_state_ = new ReadState(this, book_keeping_);
   }
@@ -236,6 +420,29 @@ int Fragment::write(const void** buffers, const size_t* buffer_sizes) {
 /*         PRIVATE METHODS        */
 /* ****************************** */
 
+void Fragment::close_files() {
+  std::lock_guard<std::mutex> lock(files_mtx_);
+
+  int fd_num = fds_.size();
+  for(int i=0; i<fd_num; ++i) {
+    if(fds_[i] != -1) {
+      close(fds_[i]);
+      fds_[i] = -1;
+      --cached_fd_num_;
+    }
+  }
+}
+
+int Fragment::max_cached_fd_num() {
+  // Leave at least half of the open file limit to the rest of the process
+  struct rlimit rl;
+  if(getrlimit(RLIMIT_NOFILE, &rl) || rl.rlim_cur == RLIM_INFINITY)
+    return TILEDB_MAX_CACHED_FILE_NUM;
+  return std::min(
+             static_cast<rlim_t>(TILEDB_MAX_CACHED_FILE_NUM), 
+             rl.rlim_cur / 2);
+}
+
 int Fragment::rename_fragment() {
   // Do nothing in READ mode
   if(mode_ == TILEDB_ARRAY_READ)
@@ -30,8 +30,11 @@
  * This file implements the ReadState class.
  */
 
+#include "compressor.h"
+#include "filter.h"
 #include "utils.h"
 #include "read_state.h"
+#include "tile_cache.h"
 #include <algorithm>
 #include <cassert>
 #include <cmath>
@@ -63,21 +66,20 @@
 #  define PRINT_WARNING(x) do { } while(0) 
 #endif
 
-#ifdef _TILEDB_USE_MMAP
-#  define READ_FROM_FILE read_from_file_with_mmap 
-#  define READ_TILE_FROM_FILE_CMP_NONE read_tile_from_file_with_mmap_cmp_none
-#  define READ_TILE_FROM_FILE_CMP_GZIP read_tile_from_file_with_mmap_cmp_gzip
-#  define READ_TILE_FROM_FILE_VAR_CMP_NONE \
-       read_tile_from_file_with_mmap_var_cmp_none
-#  define READ_TILE_FROM_FILE_VAR_CMP_GZIP \
-       read_tile_from_file_with_mmap_var_cmp_gzip
-#else
-#  define READ_FROM_FILE read_from_file 
-#  define READ_TILE_FROM_FILE_CMP_NONE read_tile_from_file_cmp_none
-#  define READ_TILE_FROM_FILE_CMP_GZIP read_tile_from_file_cmp_gzip
-#  define READ_TILE_FROM_FILE_VAR_CMP_NONE read_tile_from_file_var_cmp_none
-#  define READ_TILE_FROM_FILE_VAR_CMP_GZIP read_tile_from_file_var_cmp_gzip
-#endif
+/**@{*/
+/** Reads a tile from the file in the I/O mode of the configuration. */
+#define READ_TILE_FROM_FILE(suffix, ...) \
+    ((io_mode_ == TILEDB_IO_MMAP) \
+        ? read_tile_from_file_with_mmap_##suffix(__VA_ARGS__) \
+        : read_tile_from_file_##suffix(__VA_ARGS__))
+#define READ_TILE_FROM_FILE_CMP_NONE(...) \
+    READ_TILE_FROM_FILE(cmp_none, __VA_ARGS__)
+#define READ_TILE_FROM_FILE_CMP(...) READ_TILE_FROM_FILE(cmp, __VA_ARGS__)
+#define READ_TILE_FROM_FILE_VAR_CMP_NONE(...) \
+    READ_TILE_FROM_FILE(var_cmp_none, __VA_ARGS__)
+#define READ_TILE_FROM_FILE_VAR_CMP(...) \
+    READ_TILE_FROM_FILE(var_cmp, __VA_ARGS__)
+/**@}*/
 
 
 
@@ -98,6 +100,7 @@ ReadState::ReadState(
 
   done_ = false;
   fetched_tile_.resize(attribute_num+2);
+  io_mode_ = fragment_->array()->config()->io_mode();
   overflow_.resize(attribute_num+1);
   last_tile_coords_ = NULL;
   map_addr_.resize(attribute_num+2);
@@ -200,7 +203,11 @@ void ReadState::get_bounding_coords(void* bounding_coords) const {
   size_t coords_size = array_schema->coords_size();
   int64_t pos = search_tile_pos_;
   assert(pos != -1);
-  memcpy(bounding_coords, book_keeping_->bounding_coords()[pos], 2*coords_size);
+  memcpy(
+      bounding_coords, 
+      static_cast<const char*>(book_keeping_->bounding_coords()) + 
+          pos * 2 * coords_size, 
+      2*coords_size);
 }
 
 bool ReadState::mbr_overlaps_tile() const {
@@ -249,8 +256,8 @@ int ReadState::copy_cells(
   // Fetch the attribute tile from disk if necessary
   int compression = array_schema->compression(attribute_id);
   int rc;
-  if(compression == TILEDB_GZIP)
-    rc = get_tile_from_disk_cmp_gzip(attribute_id, tile_i);
+  if(compression != TILEDB_NO_COMPRESSION)
+    rc = get_tile_from_disk_cmp(attribute_id, tile_i);
   else
     rc = get_tile_from_disk_cmp_none(attribute_id, tile_i);
   if(rc != TILEDB_RS_OK)
@@ -337,8 +344,8 @@ int ReadState::copy_cells_var(
   // Fetch the attribute tile from disk if necessary
   int compression = array_schema->compression(attribute_id);
   int rc;
-  if(compression == TILEDB_GZIP)
-    rc = get_tile_from_disk_var_cmp_gzip(attribute_id, tile_i);
+  if(compression != TILEDB_NO_COMPRESSION)
+    rc = get_tile_from_disk_var_cmp(attribute_id, tile_i);
   else
     rc = get_tile_from_disk_var_cmp_none(attribute_id, tile_i);
   if(rc != TILEDB_RS_OK)
@@ -432,25 +439,158 @@ int ReadState::copy_cells_var(
   return TILEDB_RS_OK;
 }
 
+template<class T>
+int ReadState::estimate_result_size(
+    int64_t& cell_num,
+    std::vector<size_t>& var_sizes) const {
+  // For easy reference
+  const ArraySchema* array_schema = fragment_->array()->array_schema();
+  int dim_num = array_schema->dim_num();
+  const std::vector<int>& attribute_ids = fragment_->array()->attribute_ids();
+  int attribute_id_num = attribute_ids.size();
+  const T* subarray = static_cast<const T*>(fragment_->array()->subarray());
+
+  // Find the variable-sized attributes present in the fragment. The sizes of
+  // the variable tiles are kept in the book-keeping only for the compressed
+  // ones, so the size of the entire file bounds those of the rest
+  std::vector<int> var_attribute_ids;
+  std::vector<int> var_attribute_ids_cmp_none;
+  for(int i=0; i<attribute_id_num; ++i) { 
+    if(!array_schema->var_size(attribute_ids[i]) ||
+       is_empty_attribute(attribute_ids[i]))
+      continue;
+    if(array_schema->compression(attribute_ids[i]) != TILEDB_NO_COMPRESSION)
+      var_attribute_ids.push_back(attribute_ids[i]);
+    else
+      var_attribute_ids_cmp_none.push_back(attribute_ids[i]);
+  }
+  int var_attribute_id_num = var_attribute_ids.size();
+  int var_attribute_id_num_cmp_none = var_attribute_ids_cmp_none.size();
+
+  cell_num = 0;
+  T* overlap_subarray = new T[2*dim_num];
+  if(fragment_->dense()) {  // DENSE
+    // The fragment holds every cell of its non-empty domain
+    const T* non_empty_domain = 
+        static_cast<const T*>(book_keeping_->non_empty_domain());
+    if(array_schema->subarray_overlap(
+           subarray, 
+           non_empty_domain, 
+           overlap_subarray)) {
+      cell_num = cell_num_in_subarray(overlap_subarray, dim_num);
+
+      // Add the variable tile sizes of the tiles overlapping the subarray, 
+      // whose coordinates are relative to the (expanded) fragment domain
+      if(var_attribute_id_num != 0) {
+        const T* domain = static_cast<const T*>(book_keeping_->domain());
+        const T* tile_extents = 
+            static_cast<const T*>(array_schema->tile_extents());
+        T* tile_coords = new T[dim_num];
+        T* tile_coords_end = new T[dim_num];
+        for(int i=0; i<dim_num; ++i) {
+          tile_coords[i] = 
+              (overlap_subarray[2*i] - domain[2*i]) / tile_extents[i];
+          tile_coords_end[i] = 
+              (overlap_subarray[2*i+1] - domain[2*i]) / tile_extents[i];
+        }
+        for(;;) {
+          int64_t tile_pos = array_schema->get_tile_pos(domain, tile_coords);
+          for(int j=0; j<var_attribute_id_num; ++j) 
+            var_sizes[var_attribute_ids[j]] += 
+                book_keeping_->tile_var_sizes(var_attribute_ids[j])[tile_pos];
+
+          // Advance to the next tile coordinates
+          int i = dim_num-1;
+          while(i >= 0 && tile_coords[i] == tile_coords_end[i]) {
+            tile_coords[i] = 
+                (overlap_subarray[2*i] - domain[2*i]) / tile_extents[i];
+            --i;
+          }
+          if(i < 0)
+            break;
+          ++tile_coords[i];
+        }
+        delete [] tile_coords;
+        delete [] tile_coords_end;
+      }
+    }
+  } else {                  // SPARSE
+    // Add the cells of the tiles whose MBRs overlap the subarray
+    const T* mbrs = static_cast<const T*>(book_keeping_->mbrs());
+    int64_t tile_num = book_keeping_->tile_num();
+    const RTree* rtree = book_keeping_->rtree();
+    int64_t tile_pos = 
+        rtree->next_overlapping_leaf(mbrs, tile_num, subarray, 0, tile_num-1);
+    while(tile_pos != -1) {
+      if(array_schema->subarray_overlap(
+             subarray,
+             &mbrs[2*dim_num*tile_pos],
+             overlap_subarray)) {
+        cell_num += book_keeping_->cell_num(tile_pos);
+        for(int j=0; j<var_attribute_id_num; ++j) 
+          var_sizes[var_attribute_ids[j]] += 
+              book_keeping_->tile_var_sizes(var_attribute_ids[j])[tile_pos];
+      }
+      tile_pos = 
+          rtree->next_overlapping_leaf(
+              mbrs, 
+              tile_num, 
+              subarray, 
+              tile_pos+1, 
+              tile_num-1);
+    }
+  }
+
+  // Clean up
+  delete [] overlap_subarray;
+
+  // Add the file sizes of the uncompressed variable-sized attributes
+  if(cell_num != 0) {
+    for(int j=0; j<var_attribute_id_num_cmp_none; ++j) {
+      off_t file_size = 
+          fragment_->file_size(var_attribute_ids_cmp_none[j], true);
+      if(file_size == TILEDB_FG_ERR)
+        return TILEDB_RS_ERR;
+      var_sizes[var_attribute_ids_cmp_none[j]] += file_size;
+    }
+  }
+
+  // Success
+  return TILEDB_RS_OK;
+}
+
 template<class T>
 int ReadState::get_coords_after(
     const T* coords,
     T* coords_after,
     bool& coords_retrieved) {
+  return get_coords_after(
+             search_tile_pos_, 
+             coords, 
+             coords_after, 
+             coords_retrieved);
+}
+
+template<class T>
+int ReadState::get_coords_after(
+    int64_t tile_i,
+    const T* coords,
+    T* coords_after,
+    bool& coords_retrieved) {
   // For easy reference
   const ArraySchema* array_schema = fragment_->array()->array_schema();
   int attribute_num = array_schema->attribute_num();
   int dim_num = array_schema->dim_num();
-  int64_t cell_num = book_keeping_->cell_num(search_tile_pos_);  
+  int64_t cell_num = book_keeping_->cell_num(tile_i);  
   size_t coords_size = array_schema->coords_size();
 
   // Fetch the coordinates search tile from disk if necessary
   int compression = array_schema->compression(attribute_num);
   int rc;
-  if(compression == TILEDB_GZIP)
-    rc = get_tile_from_disk_cmp_gzip(attribute_num+1, search_tile_pos_);
+  if(compression != TILEDB_NO_COMPRESSION)
+    rc = get_tile_from_disk_cmp(attribute_num+1, tile_i);
   else
-    rc = get_tile_from_disk_cmp_none(attribute_num+1, search_tile_pos_);
+    rc = get_tile_from_disk_cmp_none(attribute_num+1, tile_i);
   if(rc != TILEDB_RS_OK)
     return TILEDB_RS_ERR;
 
@@ -495,8 +635,8 @@ int ReadState::get_enclosing_coords(
   // Fetch the coordinates search tile from disk if necessary
   int compression = array_schema->compression(attribute_num);
   int rc;
-  if(compression == TILEDB_GZIP)
-    rc = get_tile_from_disk_cmp_gzip(attribute_num+1, tile_i);
+  if(compression != TILEDB_NO_COMPRESSION)
+    rc = get_tile_from_disk_cmp(attribute_num+1, tile_i);
   else
     rc = get_tile_from_disk_cmp_none(attribute_num+1, tile_i);
   if(rc != TILEDB_RS_OK)
@@ -557,8 +697,8 @@ int ReadState::get_fragment_cell_pos_range_sparse(
   // Fetch the coordinates search tile from disk if necessary
   int compression = array_schema->compression(attribute_num);
   int rc;
-  if(compression == TILEDB_GZIP)
-    rc = get_tile_from_disk_cmp_gzip(attribute_num+1, tile_i);
+  if(compression != TILEDB_NO_COMPRESSION)
+    rc = get_tile_from_disk_cmp(attribute_num+1, tile_i);
   else
     rc = get_tile_from_disk_cmp_none(attribute_num+1, tile_i);
   if(rc != TILEDB_RS_OK)
@@ -585,7 +725,8 @@ int ReadState::get_fragment_cell_pos_range_sparse(
 template<class T>
 int ReadState::get_fragment_cell_ranges_dense(
     int fragment_i,
-    FragmentCellRanges& fragment_cell_ranges) {
+    FragmentCellRanges& fragment_cell_ranges,
+    Arena& arena) {
   // Trivial cases
   if(done_ || !search_tile_overlap_)
     return TILEDB_RS_OK;
@@ -602,7 +743,7 @@ int ReadState::get_fragment_cell_ranges_dense(
   // Contiguous cells, single cell range
   if(search_tile_overlap_ == 1 || 
      search_tile_overlap_ == 3) {
-    void* cell_range = malloc(cell_range_size);
+    void* cell_range = arena.allocate(cell_range_size);
     T* cell_range_T = static_cast<T*>(cell_range);
     for(int i=0; i<dim_num; ++i) {
       cell_range_T[i] = search_tile_overlap_subarray[2*i];
@@ -622,7 +763,7 @@ int ReadState::get_fragment_cell_ranges_dense(
     if(cell_order == TILEDB_ROW_MAJOR) {           // ROW
       while(coords[0] <= search_tile_overlap_subarray[1]) {
         // Make a cell range representing a slab       
-        void* cell_range = malloc(cell_range_size);
+        void* cell_range = arena.allocate(cell_range_size);
         T* cell_range_T = static_cast<T*>(cell_range);
         for(int i=0; i<dim_num-1; ++i) { 
           cell_range_T[i] = coords[i];
@@ -648,7 +789,7 @@ int ReadState::get_fragment_cell_ranges_dense(
       while(coords[dim_num-1] <=  
             search_tile_overlap_subarray[2*(dim_num-1)+1]) {
         // Make a cell range representing a slab       
-        void* cell_range = malloc(cell_range_size);
+        void* cell_range = arena.allocate(cell_range_size);
         T* cell_range_T = static_cast<T*>(cell_range);
         for(int i=dim_num-1; i>0; --i) { 
           cell_range_T[i] = coords[i];
@@ -684,7 +825,8 @@ int ReadState::get_fragment_cell_ranges_dense(
 template<class T>
 int ReadState::get_fragment_cell_ranges_sparse(
     int fragment_i,
-    FragmentCellRanges& fragment_cell_ranges) {
+    FragmentCellRanges& fragment_cell_ranges,
+    Arena& arena) {
   // Trivial cases
   if(done_ || !search_tile_overlap_ || !mbr_tile_overlap_)
     return TILEDB_RS_OK;
@@ -708,7 +850,8 @@ int ReadState::get_fragment_cell_ranges_sparse(
                fragment_i,
                start_coords,
                end_coords,
-               fragment_cell_ranges); 
+               fragment_cell_ranges,
+               arena); 
 
   // Clean up
   delete [] start_coords;
@@ -723,7 +866,8 @@ int ReadState::get_fragment_cell_ranges_sparse(
     int fragment_i,
     const T* start_coords,
     const T* end_coords,
-    FragmentCellRanges& fragment_cell_ranges) {
+    FragmentCellRanges& fragment_cell_ranges,
+    Arena& arena) {
   // Sanity checks
   assert(search_tile_pos_ >= tile_search_range_[0] &&
          search_tile_pos_ <= tile_search_range_[1]);
@@ -740,7 +884,7 @@ int ReadState::get_fragment_cell_ranges_sparse(
   if(search_tile_overlap_ == 1) {
     FragmentCellRange fragment_cell_range;
     fragment_cell_range.first = FragmentInfo(fragment_i, search_tile_pos_); 
-    fragment_cell_range.second = malloc(2*coords_size);
+    fragment_cell_range.second = arena.allocate(2*coords_size);
     T* cell_range = static_cast<T*>(fragment_cell_range.second);
     memcpy(cell_range, start_coords, coords_size);
     memcpy(&cell_range[dim_num], end_coords, coords_size);
@@ -751,8 +895,8 @@ int ReadState::get_fragment_cell_ranges_sparse(
   // Fetch the coordinates search tile from disk if necessary
   int compression = array_schema->compression(attribute_num);
   int rc;
-  if(compression == TILEDB_GZIP)
-    rc = get_tile_from_disk_cmp_gzip(attribute_num+1, search_tile_pos_);
+  if(compression != TILEDB_NO_COMPRESSION)
+    rc = get_tile_from_disk_cmp(attribute_num+1, search_tile_pos_);
   else
     rc = get_tile_from_disk_cmp_none(attribute_num+1, search_tile_pos_);
   if(rc != TILEDB_RS_OK)
@@ -779,7 +923,7 @@ int ReadState::get_fragment_cell_ranges_sparse(
       if(i-1 == current_end_pos) { // The range needs to be added to the list
         FragmentCellRange fragment_cell_range;
         fragment_cell_range.first = FragmentInfo(fragment_i, search_tile_pos_);
-        fragment_cell_range.second = malloc(2*coords_size);
+        fragment_cell_range.second = arena.allocate(2*coords_size);
         T* cell_range = static_cast<T*>(fragment_cell_range.second);
         memcpy(cell_range, &tile[current_start_pos*dim_num], coords_size);
         memcpy(
@@ -796,7 +940,7 @@ int ReadState::get_fragment_cell_ranges_sparse(
   if(current_end_pos != -2) {
     FragmentCellRange fragment_cell_range;
     fragment_cell_range.first = FragmentInfo(fragment_i, search_tile_pos_);
-    fragment_cell_range.second = malloc(2*coords_size);
+    fragment_cell_range.second = arena.allocate(2*coords_size);
     T* cell_range = static_cast<T*>(fragment_cell_range.second);
     memcpy(cell_range, &tile[current_start_pos*dim_num], coords_size);
     memcpy(&cell_range[dim_num], &tile[current_end_pos*dim_num], coords_size);
@@ -861,6 +1005,15 @@ void ReadState::get_next_overlapping_tile_dense(const T* tile_coords) {
             tile_domain_overlap_subarray, 
             static_cast<T*>(search_tile_overlap_subarray_));
 
+    // The cells of the overlap are contiguous (or all the cells) only with
+    // respect to the entire tile, not to its part in the non-empty domain
+    if(search_tile_overlap_)
+      search_tile_overlap_ =
+          array_schema->subarray_overlap(
+              static_cast<const T*>(search_tile_overlap_subarray_),
+              tile_subarray,
+              query_tile_overlap_subarray);
+
     // Clean up
     delete [] query_tile_overlap_subarray;
   } 
@@ -879,7 +1032,9 @@ void ReadState::get_next_overlapping_tile_sparse() {
   // For easy reference
   const ArraySchema* array_schema = fragment_->array()->array_schema();
   int dim_num = array_schema->dim_num();
-  const std::vector<void*>& mbrs = book_keeping_->mbrs();
+  const T* mbrs = static_cast<const T*>(book_keeping_->mbrs());
+  int64_t mbr_num = book_keeping_->tile_num();
+  const RTree* rtree = book_keeping_->rtree();
   const T* subarray = static_cast<const T*>(fragment_->array()->subarray());
 
   // Update the search tile position
@@ -888,15 +1043,26 @@ void ReadState::get_next_overlapping_tile_sparse() {
   else
     ++search_tile_pos_;
 
-  // Find the position to the next overlapping tile with the query range
+  // Find the position to the next overlapping tile with the query range,
+  // skipping through the R-tree the tiles whose MBRs do not overlap it
   for(;;) {
+    int64_t tile_pos = 
+        rtree->next_overlapping_leaf(
+            mbrs, 
+            mbr_num,
+            subarray, 
+            search_tile_pos_, 
+            tile_search_range_[1]);
+
     // No overlap - exit
-    if(search_tile_pos_ > tile_search_range_[1]) {
+    if(tile_pos == -1) {
+      search_tile_pos_ = tile_search_range_[1] + 1;
       done_ = true;
       return;
     }
+    search_tile_pos_ = tile_pos;
 
-    const T* mbr = static_cast<const T*>(mbrs[search_tile_pos_]);
+    const T* mbr = &mbrs[2*dim_num*search_tile_pos_];
     search_tile_overlap_ = 
         array_schema->subarray_overlap(
             subarray,
@@ -921,7 +1087,9 @@ void ReadState::get_next_overlapping_tile_sparse(
   const ArraySchema* array_schema = fragment_->array()->array_schema();
   int dim_num = array_schema->dim_num();
   size_t coords_size = array_schema->coords_size();
-  const std::vector<void*>& mbrs = book_keeping_->mbrs();
+  const T* mbrs = static_cast<const T*>(book_keeping_->mbrs());
+  const T* bounding_coords = 
+      static_cast<const T*>(book_keeping_->bounding_coords());
   const T* subarray = static_cast<const T*>(fragment_->array()->subarray());
 
   // Compute the tile subarray
@@ -947,11 +1115,8 @@ void ReadState::get_next_overlapping_tile_sparse(
   } else {
     if(!memcmp(last_tile_coords_, tile_coords, coords_size)) {
       // Advance only if the MBR does not exceed the tile
-      const T* bounding_coords = 
-          static_cast<const T*>(
-              book_keeping_->bounding_coords()[search_tile_pos_]);
       if(array_schema->tile_cell_order_cmp(
-             &bounding_coords[dim_num], 
+             &bounding_coords[2*dim_num*search_tile_pos_ + dim_num], 
              tile_subarray_end) <= 0) {
         ++search_tile_pos_;
       } else {
@@ -971,7 +1136,7 @@ void ReadState::get_next_overlapping_tile_sparse(
     }
 
     // Get overlap between MBR and tile subarray
-    const T* mbr = static_cast<const T*>(mbrs[search_tile_pos_]);
+    const T* mbr = &mbrs[2*dim_num*search_tile_pos_];
     mbr_tile_overlap_ = 
         array_schema->subarray_overlap(
             tile_subarray,
@@ -981,11 +1146,8 @@ void ReadState::get_next_overlapping_tile_sparse(
     // No overlap with the tile
     if(!mbr_tile_overlap_) {
       // Check if we need to break or continue
-      const T* bounding_coords = 
-          static_cast<const T*>(
-              book_keeping_->bounding_coords()[search_tile_pos_]);
       if(array_schema->tile_cell_order_cmp(
-             &bounding_coords[dim_num], 
+             &bounding_coords[2*dim_num*search_tile_pos_ + dim_num], 
              tile_subarray_end) > 0) {
         break;
       } else {
@@ -1020,6 +1182,84 @@ void ReadState::get_next_overlapping_tile_sparse(
   delete [] mbr_tile_overlap_subarray;
 }
 
+int ReadState::prefetch_tile(int attribute_id, int64_t tile_i) const {
+  // For easy reference
+  const ArraySchema* array_schema = fragment_->array()->array_schema();
+  bool var_size = array_schema->var_size(attribute_id);
+
+  // Only compressed tiles of non-empty attributes are prefetched
+  if(array_schema->compression(attribute_id) == TILEDB_NO_COMPRESSION ||
+     is_empty_attribute(attribute_id))
+    return TILEDB_RS_OK;
+
+  // Prefetch the tile (holding the variable cell offsets if variable-sized)
+  size_t cell_size = (var_size) ? TILEDB_CELL_VAR_OFFSET_SIZE 
+                                : array_schema->cell_size(attribute_id);
+  size_t tile_size = book_keeping_->cell_num(tile_i) * cell_size;
+  if(prefetch_tile_cmp(
+         book_keeping_->tile_offsets(attribute_id),
+         attribute_id,
+         tile_i,
+         false,
+         tile_size) != TILEDB_RS_OK)
+    return TILEDB_RS_ERR;
+
+  // Prefetch the variable tile
+  if(var_size) {
+    size_t tile_var_size = 
+        book_keeping_->tile_var_sizes(attribute_id)[tile_i];
+    if(tile_var_size == 0u)
+      return TILEDB_RS_OK;
+    if(prefetch_tile_cmp(
+           book_keeping_->tile_var_offsets(attribute_id),
+           attribute_id,
+           tile_i,
+           true,
+           tile_var_size) != TILEDB_RS_OK)
+      return TILEDB_RS_ERR;
+  }
+
+  // Success
+  return TILEDB_RS_OK;
+}
+
+int ReadState::view_cells(
+    int attribute_id,
+    int64_t tile_i,
+    const CellPosRange& cell_pos_range,
+    const void*& view,
+    size_t& view_size) {
+  // Trivial case
+  view = NULL;
+  view_size = 0;
+  if(is_empty_attribute(attribute_id))
+    return TILEDB_RS_OK;
+
+  // For easy reference
+  const ArraySchema* array_schema = fragment_->array()->array_schema();
+  size_t cell_size = array_schema->cell_size(attribute_id);
+
+  // Sanity check
+  assert(!array_schema->var_size(attribute_id));
+
+  // Fetch the attribute tile from disk if necessary
+  int rc;
+  if(array_schema->compression(attribute_id) != TILEDB_NO_COMPRESSION)
+    rc = get_tile_from_disk_cmp(attribute_id, tile_i);
+  else
+    rc = get_tile_from_disk_cmp_none(attribute_id, tile_i);
+  if(rc != TILEDB_RS_OK)
+    return TILEDB_RS_ERR;
+
+  // Point to the cell range inside the tile
+  const char* tile = static_cast<const char*>(tiles_[attribute_id]);
+  view = tile + cell_pos_range.first * cell_size;
+  view_size = (cell_pos_range.second - cell_pos_range.first + 1) * cell_size;
+
+  // Success
+  return TILEDB_RS_OK;
+}
+
 
 
 
@@ -1149,8 +1389,8 @@ void ReadState::compute_tile_search_range_col_or_row() {
   int dim_num = array_schema->dim_num();
   const T* subarray = static_cast<const T*>(fragment_->array()->subarray());
   int64_t tile_num = book_keeping_->tile_num();
-  const std::vector<void*>& bounding_coords = 
-      book_keeping_->bounding_coords();
+  const T* bounding_coords = 
+      static_cast<const T*>(book_keeping_->bounding_coords());
 
   // Calculate subarray coordinates
   T* subarray_min_coords = new T[dim_num];
@@ -1172,8 +1412,8 @@ void ReadState::compute_tile_search_range_col_or_row() {
     med = min + ((max - min) / 2);
 
     // Get info for bounding coordinates
-    tile_start_coords = static_cast<const T*>(bounding_coords[med]);
-    tile_end_coords = &(static_cast<const T*>(bounding_coords[med])[dim_num]);
+    tile_start_coords = &bounding_coords[2*dim_num*med];
+    tile_end_coords = &bounding_coords[2*dim_num*med + dim_num];
 
     // Calculate precedence
     if(array_schema->tile_cell_order_cmp(
@@ -1210,8 +1450,8 @@ void ReadState::compute_tile_search_range_col_or_row() {
       med = min + ((max - min) / 2);
 
       // Get info for bounding coordinates
-      tile_start_coords = static_cast<const T*>(bounding_coords[med]);
-      tile_end_coords = &(static_cast<const T*>(bounding_coords[med])[dim_num]);
+      tile_start_coords = &bounding_coords[2*dim_num*med];
+      tile_end_coords = &bounding_coords[2*dim_num*med + dim_num];
      
       // Calculate precedence
       if(array_schema->tile_cell_order_cmp(
@@ -1255,8 +1495,8 @@ void ReadState::compute_tile_search_range_hil() {
 
   if(is_unary_subarray(subarray, dim_num)) {  // Unary range
     // For easy reference
-    const std::vector<void*>& bounding_coords = 
-        book_keeping_->bounding_coords();
+    const T* bounding_coords = 
+        static_cast<const T*>(book_keeping_->bounding_coords());
 
     // Calculate range coordinates
     T* subarray_coords = new T[dim_num];
@@ -1273,8 +1513,8 @@ void ReadState::compute_tile_search_range_hil() {
       med = min + ((max - min) / 2);
 
       // Get info for bounding coordinates
-      tile_start_coords = static_cast<const T*>(bounding_coords[med]);
-      tile_end_coords = &(static_cast<const T*>(bounding_coords[med])[dim_num]);
+      tile_start_coords = &bounding_coords[2*dim_num*med];
+      tile_end_coords = &bounding_coords[2*dim_num*med + dim_num];
      
       // Calculate precedence
       if(array_schema->tile_cell_order_cmp(
@@ -1312,6 +1552,78 @@ void ReadState::compute_tile_search_range_hil() {
   }
 } 
 
+int ReadState::decompress_tile(
+    int attribute_id,
+    bool var,
+    const void* tile_compressed,
+    size_t tile_compressed_size,
+    void* tile,
+    size_t tile_size) const {
+  // For easy reference
+  const ArraySchema* array_schema = fragment_->array()->array_schema();
+  const Compressor* compressor = 
+      Compressor::get(array_schema->compression(attribute_id));
+  size_t type_size = 
+      (array_schema->var_size(attribute_id) && !var) 
+          ? TILEDB_CELL_VAR_OFFSET_SIZE 
+          : array_schema->type_size(attribute_id);
+  int stride = 
+      (array_schema->var_size(attribute_id)) 
+          ? 1 
+          : array_schema->cell_size(attribute_id) / type_size;
+  FilterPipeline filter_pipeline(
+      array_schema->filters(attribute_id), type_size, stride);
+
+  // Filtered tiles are decompressed into a temporary buffer
+  void* tile_filtered = tile;
+  size_t tile_filtered_allocated_size = tile_size;
+  if(!filter_pipeline.empty()) {
+    tile_filtered_allocated_size = filter_pipeline.filter_bound(tile_size);
+    tile_filtered = malloc(tile_filtered_allocated_size);
+    if(tile_filtered == NULL) {
+      PRINT_ERROR("Cannot decompress tile; Memory allocation failed");
+      return TILEDB_RS_ERR;
+    }
+  }
+
+  // Decompress tile 
+  size_t out_size;
+  int rc = TILEDB_RS_OK;
+  if(compressor == NULL ||
+     compressor->decompress(
+         type_size,
+         tile_compressed, 
+         tile_compressed_size, 
+         tile_filtered,
+         tile_filtered_allocated_size,
+         out_size) != TILEDB_CP_OK) {
+    PRINT_ERROR("Cannot decompress tile");
+    rc = TILEDB_RS_ERR;
+  } else if(filter_pipeline.empty()) { 
+    // Sanity check
+    if(out_size != tile_size) {
+      PRINT_ERROR("Cannot decompress tile; Unexpected tile size");
+      rc = TILEDB_RS_ERR;
+    }
+  } else {
+    // Reverse the filters
+    if(filter_pipeline.unfilter(
+           tile_filtered, 
+           out_size, 
+           tile, 
+           tile_size) != TILEDB_FL_OK) {
+      PRINT_ERROR("Cannot decompress tile; Cannot reverse filters");
+      rc = TILEDB_RS_ERR;
+    }
+  }
+
+  // Clean up
+  if(tile_filtered != tile)
+    free(tile_filtered);
+
+  return rc;
+}
+
 template<class T>
 int64_t ReadState::get_cell_pos_after(const T* coords) const {
   // For easy reference
@@ -1414,7 +1726,7 @@ int64_t ReadState::get_cell_pos_at_or_before(const T* coords) const {
     return med;   // At
 }
 
-int ReadState::get_tile_from_disk_cmp_gzip(int attribute_id, int64_t tile_i) {
+int ReadState::get_tile_from_disk_cmp(int attribute_id, int64_t tile_i) {
   // Return if the tile has already been fetched
   if(tile_i == fetched_tile_[attribute_id])
     return TILEDB_RS_OK;
@@ -1433,47 +1745,67 @@ int ReadState::get_tile_from_disk_cmp_gzip(int attribute_id, int64_t tile_i) {
   size_t full_tile_size = fragment_->tile_size(attribute_id_real);
   int64_t cell_num = book_keeping_->cell_num(tile_i);  
   size_t tile_size = cell_num * cell_size; 
-  const std::vector<std::vector<off_t> >& tile_offsets = 
-      book_keeping_->tile_offsets(); 
+  const off_t* tile_offsets = 
+      book_keeping_->tile_offsets(attribute_id_real); 
   int64_t tile_num = book_keeping_->tile_num();
 
   // Allocate space for the tile if needed
   if(tiles_[attribute_id] == NULL) 
     tiles_[attribute_id] = malloc(full_tile_size);
 
-  // Prepare attribute file name
-  std::string filename = fragment_->fragment_name() + "/" +
-                         array_schema->attribute(attribute_id_real) +
-                         TILEDB_FILE_SUFFIX;
+  // Try to get the decompressed tile from the tile cache
+  TileCache* tile_cache = TileCache::instance();
+  if(tile_cache->get(
+         fragment_->fragment_name(),
+         attribute_id_real,
+         tile_i,
+         false,
+         tiles_[attribute_id],
+         tile_size)) {
+    tiles_sizes_[attribute_id] = tile_size;
+    tiles_offsets_[attribute_id] = 0;
+    fetched_tile_[attribute_id] = tile_i;
+    return TILEDB_RS_OK;
+  }
 
   // Find file offset where the tile begins
-  off_t file_offset = tile_offsets[attribute_id_real][tile_i];
-  off_t file_size = ::file_size(filename);
+  off_t file_offset = tile_offsets[tile_i];
+  off_t file_size = 0;
+  if(tile_i == tile_num-1) {
+    file_size = fragment_->file_size(attribute_id_real, false);
+    if(file_size == TILEDB_FG_ERR)
+      return TILEDB_RS_ERR;
+  }
   size_t tile_compressed_size = 
       (tile_i == tile_num-1) 
-          ? file_size - tile_offsets[attribute_id_real][tile_i] 
-          : tile_offsets[attribute_id_real][tile_i+1] - 
-            tile_offsets[attribute_id_real][tile_i];
+          ? file_size - tile_offsets[tile_i] 
+          : tile_offsets[tile_i+1] - tile_offsets[tile_i];
 
   // Read tile from file
-  if(READ_TILE_FROM_FILE_CMP_GZIP(
+  if(READ_TILE_FROM_FILE_CMP(
          attribute_id, 
          file_offset, 
          tile_compressed_size) != TILEDB_RS_OK)
     return TILEDB_RS_ERR;
 
   // Decompress tile 
-  size_t gunzip_out_size;
-  if(gunzip(
-         static_cast<unsigned char*>(tile_compressed_), 
+  if(decompress_tile(
+         attribute_id_real,
+         false,
+         tile_compressed_, 
          tile_compressed_size, 
-         static_cast<unsigned char*>(tiles_[attribute_id]),
-         full_tile_size,
-         gunzip_out_size) != TILEDB_UT_OK)
+         tiles_[attribute_id],
+         tile_size) != TILEDB_RS_OK)
     return TILEDB_RS_ERR;
 
-  // Sanity check
-  assert(gunzip_out_size == tile_size);
+  // Cache the decompressed tile
+  tile_cache->insert(
+      fragment_->fragment_name(),
+      attribute_id_real,
+      tile_i,
+      false,
+      tiles_[attribute_id],
+      tile_size);
 
   // Set the tile size
   tiles_sizes_[attribute_id] = tile_size;
@@ -1531,7 +1863,7 @@ int ReadState::get_tile_from_disk_cmp_none(int attribute_id, int64_t tile_i) {
   return TILEDB_RS_OK;
 }
 
-int ReadState::get_tile_from_disk_var_cmp_gzip(
+int ReadState::get_tile_from_disk_var_cmp(
     int attribute_id, 
     int64_t tile_i) {
   // Return if the tile has already been fetched
@@ -1550,50 +1882,63 @@ int ReadState::get_tile_from_disk_var_cmp_gzip(
   size_t full_tile_size = fragment_->tile_size(attribute_id);
   int64_t cell_num = book_keeping_->cell_num(tile_i); 
   size_t tile_size = cell_num * cell_size;
-  const std::vector<std::vector<off_t> >& tile_offsets = 
-      book_keeping_->tile_offsets(); 
-  const std::vector<std::vector<off_t> >& tile_var_offsets = 
-      book_keeping_->tile_var_offsets(); 
+  const off_t* tile_offsets = book_keeping_->tile_offsets(attribute_id); 
+  const off_t* tile_var_offsets = 
+      book_keeping_->tile_var_offsets(attribute_id); 
   int64_t tile_num = book_keeping_->tile_num();
 
   // ========== Get tile with variable cell offsets ========== //
 
-  // Prepare attribute file name
-  std::string filename = fragment_->fragment_name() + "/" +
-             array_schema->attribute(attribute_id) +
-             TILEDB_FILE_SUFFIX;
-
-  // Find file offset where the tile begins
-  off_t file_offset = tile_offsets[attribute_id][tile_i];
-  off_t file_size = ::file_size(filename);
-  size_t tile_compressed_size = 
-      (tile_i == tile_num-1) ? file_size - tile_offsets[attribute_id][tile_i]
-                             : tile_offsets[attribute_id][tile_i+1] - 
-                               tile_offsets[attribute_id][tile_i];
-
   // Allocate space for the tile if needed
   if(tiles_[attribute_id] == NULL) 
     tiles_[attribute_id] = malloc(full_tile_size);
 
-  // Read tile from file
-  if(READ_TILE_FROM_FILE_CMP_GZIP(
-         attribute_id, 
-         file_offset, 
-         tile_compressed_size) != TILEDB_RS_OK)
-    return TILEDB_RS_ERR;
+  // Get the tile from the tile cache, or read and decompress it from the file
+  TileCache* tile_cache = TileCache::instance();
+  off_t file_offset, file_size;
+  size_t tile_compressed_size;
+  if(!tile_cache->get(
+          fragment_->fragment_name(),
+          attribute_id,
+          tile_i,
+          false,
+          tiles_[attribute_id],
+          tile_size)) {
+    // Find file offset where the tile begins
+    file_offset = tile_offsets[tile_i];
+    file_size = fragment_->file_size(attribute_id, false);
+    if(file_size == TILEDB_FG_ERR)
+      return TILEDB_RS_ERR;
+    tile_compressed_size = 
+        (tile_i == tile_num-1) ? file_size - tile_offsets[tile_i]
+                               : tile_offsets[tile_i+1] - tile_offsets[tile_i];
 
-  // Decompress tile 
-  size_t gunzip_out_size;
-  if(gunzip(
-         static_cast<unsigned char*>(tile_compressed_), 
-         tile_compressed_size, 
-         static_cast<unsigned char*>(tiles_[attribute_id]),
-         tile_size,
-         gunzip_out_size) != TILEDB_UT_OK)
-    return TILEDB_RS_ERR;
+    // Read tile from file
+    if(READ_TILE_FROM_FILE_CMP(
+           attribute_id, 
+           file_offset, 
+           tile_compressed_size) != TILEDB_RS_OK)
+      return TILEDB_RS_ERR;
 
-  // Sanity check
-  assert(gunzip_out_size == tile_size);
+    // Decompress tile 
+    if(decompress_tile(
+           attribute_id,
+           false,
+           tile_compressed_, 
+           tile_compressed_size, 
+           tiles_[attribute_id],
+           tile_size) != TILEDB_RS_OK)
+      return TILEDB_RS_ERR;
+
+    // Cache the decompressed tile (before the offsets get shifted)
+    tile_cache->insert(
+        fragment_->fragment_name(),
+        attribute_id,
+        tile_i,
+        false,
+        tiles_[attribute_id],
+        tile_size);
+  }
 
   // Set the tile size
   tiles_sizes_[attribute_id] = tile_size;
@@ -1603,21 +1948,8 @@ int ReadState::get_tile_from_disk_var_cmp_gzip(
 
   // ========== Get variable tile ========== //
 
-  // Prepare variable attribute file name
-  filename = fragment_->fragment_name() + "/" +
-             array_schema->attribute(attribute_id) + "_var" +
-             TILEDB_FILE_SUFFIX;
-
-  // Calculate offset and compressed tile size
-  file_offset = tile_var_offsets[attribute_id][tile_i];
-  file_size = ::file_size(filename);
-  tile_compressed_size = 
-      (tile_i == tile_num-1) ? file_size-tile_var_offsets[attribute_id][tile_i]
-                          : tile_var_offsets[attribute_id][tile_i+1] - 
-                            tile_var_offsets[attribute_id][tile_i];
-
   // Get size of decompressed tile
-  size_t tile_var_size = book_keeping_->tile_var_sizes()[attribute_id][tile_i];
+  size_t tile_var_size = book_keeping_->tile_var_sizes(attribute_id)[tile_i];
 
   //Non-empty tile, decompress
   if(tile_var_size > 0u) {
@@ -1633,25 +1965,52 @@ int ReadState::get_tile_from_disk_var_cmp_gzip(
           realloc(tiles_var_[attribute_id], tile_var_size);
       tiles_var_allocated_size_[attribute_id] = tile_var_size;
     }
+  }
+
+  //Non-empty tile missing from the tile cache, read and decompress
+  if(tile_var_size > 0u &&
+     !tile_cache->get(
+          fragment_->fragment_name(),
+          attribute_id,
+          tile_i,
+          true,
+          tiles_var_[attribute_id],
+          tile_var_size)) {
+    // Calculate offset and compressed tile size
+    file_offset = tile_var_offsets[tile_i];
+    file_size = fragment_->file_size(attribute_id, true);
+    if(file_size == TILEDB_FG_ERR)
+      return TILEDB_RS_ERR;
+    tile_compressed_size = 
+        (tile_i == tile_num-1) 
+            ? file_size-tile_var_offsets[tile_i]
+            : tile_var_offsets[tile_i+1] - tile_var_offsets[tile_i];
 
     // Read tile from file
-    if(READ_TILE_FROM_FILE_VAR_CMP_GZIP(
+    if(READ_TILE_FROM_FILE_VAR_CMP(
           attribute_id, 
           file_offset, 
           tile_compressed_size) != TILEDB_RS_OK)
       return TILEDB_RS_ERR;
 
     // Decompress tile 
-    if(gunzip(
-          static_cast<unsigned char*>(tile_compressed_), 
+    if(decompress_tile(
+          attribute_id,
+          true,
+          tile_compressed_, 
           tile_compressed_size, 
-          static_cast<unsigned char*>(tiles_var_[attribute_id]),
-          tile_var_size,
-          gunzip_out_size) != TILEDB_UT_OK)
+          tiles_var_[attribute_id],
+          tile_var_size) != TILEDB_RS_OK)
       return TILEDB_RS_ERR;
 
-    // Sanity check
-    assert(gunzip_out_size == tile_var_size);
+    // Cache the decompressed tile
+    tile_cache->insert(
+        fragment_->fragment_name(),
+        attribute_id,
+        tile_i,
+        true,
+        tiles_var_[attribute_id],
+        tile_var_size);
   }
 
   // Set the variable tile size
@@ -1707,25 +2066,20 @@ int ReadState::get_tile_from_disk_var_cmp_none(
   off_t start_tile_var_offset = tile_s[0]; 
   off_t end_tile_var_offset;
   size_t tile_var_size;
-  std::string filename = 
-        fragment_->fragment_name() + "/" +
-        array_schema->attribute(attribute_id) + 
-        TILEDB_FILE_SUFFIX;
-
   if(tile_i != tile_num - 1) { // Not the last tile
-    if(read_from_file(
-           filename, file_offset + full_tile_size, 
+    if(fragment_->read_from_file(
+           attribute_id,
+           false,
+           file_offset + full_tile_size, 
            &end_tile_var_offset, 
-           TILEDB_CELL_VAR_OFFSET_SIZE) != TILEDB_UT_OK)
+           TILEDB_CELL_VAR_OFFSET_SIZE) != TILEDB_FG_OK)
       return TILEDB_RS_ERR;
     tile_var_size = end_tile_var_offset - tile_s[0];
   } else {                  // Last tile
-    // Prepare variable attribute file name
-    std::string filename = 
-        fragment_->fragment_name() + "/" +
-        array_schema->attribute(attribute_id) + "_var" +
-        TILEDB_FILE_SUFFIX;
-    tile_var_size = file_size(filename) - tile_s[0];
+    off_t file_size = fragment_->file_size(attribute_id, true);
+    if(file_size == TILEDB_FG_ERR)
+      return TILEDB_RS_ERR;
+    tile_var_size = file_size - tile_s[0];
   }
 
   // Read tile from file
@@ -1763,7 +2117,72 @@ bool ReadState::is_empty_attribute(int attribute_id) const {
   return !is_file(filename);
 }
 
-int ReadState::read_tile_from_file_cmp_gzip(
+int ReadState::prefetch_tile_cmp(
+    const off_t* tile_offsets,
+    int attribute_id,
+    int64_t tile_i,
+    bool var,
+    size_t tile_size) const {
+  // Nothing to do if the tile is already cached
+  TileCache* tile_cache = TileCache::instance();
+  if(tile_cache->contains(
+         fragment_->fragment_name(), attribute_id, tile_i, var))
+    return TILEDB_RS_OK;
+
+  // Calculate the compressed tile size
+  int64_t tile_num = book_keeping_->tile_num();
+  off_t file_offset = tile_offsets[tile_i];
+  size_t tile_compressed_size;
+  if(tile_i == tile_num-1) {
+    off_t file_size = fragment_->file_size(attribute_id, var);
+    if(file_size == TILEDB_FG_ERR)
+      return TILEDB_RS_ERR;
+    tile_compressed_size = file_size - file_offset;
+  } else {
+    tile_compressed_size = tile_offsets[tile_i+1] - file_offset;
+  }
+
+  // Read the compressed tile into a private buffer
+  void* tile_compressed = malloc(tile_compressed_size);
+  if(fragment_->read_from_file(
+         attribute_id, 
+         var, 
+         file_offset, 
+         tile_compressed, 
+         tile_compressed_size) != TILEDB_FG_OK) {
+    free(tile_compressed);
+    return TILEDB_RS_ERR;
+  }
+
+  // Decompress tile 
+  void* tile = malloc(tile_size);
+  int rc = decompress_tile(
+               attribute_id,
+               var,
+               tile_compressed, 
+               tile_compressed_size, 
+               tile,
+               tile_size);
+  free(tile_compressed);
+
+  // Cache the decompressed tile
+  if(rc == TILEDB_RS_OK)
+    tile_cache->insert(
+        fragment_->fragment_name(), 
+        attribute_id, 
+        tile_i, 
+        var, 
+        tile, 
+        tile_size);
+
+  // Clean up
+  free(tile);
+
+  // Return
+  return rc;
+}
+
+int ReadState::read_tile_from_file_cmp(
     int attribute_id,
     off_t offset,
     size_t tile_size) {
@@ -1785,15 +2204,13 @@ int ReadState::read_tile_from_file_cmp_gzip(
     tile_compressed_allocated_size_ = tile_max_size;
   }
 
-  // Prepare attribute file name
-  std::string filename = 
-      fragment_->fragment_name() + "/" +
-      fragment_->array()->array_schema()->attribute(attribute_id_real) +
-      TILEDB_FILE_SUFFIX;
-
   // Read from file
-  if(read_from_file(filename, offset, tile_compressed_, tile_size) !=
-     TILEDB_UT_OK)
+  if(fragment_->read_from_file(
+         attribute_id_real, 
+         false, 
+         offset, 
+         tile_compressed_, 
+         tile_size) != TILEDB_FG_OK)
     return TILEDB_RS_ERR;
   else
     return TILEDB_RS_OK;
@@ -1818,21 +2235,19 @@ int ReadState::read_tile_from_file_cmp_none(
     tiles_[attribute_id] = malloc(full_tile_size);
   }
 
-  // Prepare attribute file name
-  std::string filename = 
-      fragment_->fragment_name() + "/" +
-      fragment_->array()->array_schema()->attribute(attribute_id_real) +
-      TILEDB_FILE_SUFFIX;
-
   // Read from file
-  if(read_from_file(filename, offset, tiles_[attribute_id], tile_size) !=
-     TILEDB_UT_OK)
+  if(fragment_->read_from_file(
+         attribute_id_real, 
+         false, 
+         offset, 
+         tiles_[attribute_id], 
+         tile_size) != TILEDB_FG_OK)
     return TILEDB_RS_ERR;
   else
     return TILEDB_RS_OK;
 }
 
-int ReadState::read_tile_from_file_with_mmap_cmp_gzip(
+int ReadState::read_tile_from_file_with_mmap_cmp(
     int attribute_id,
     off_t offset,
     size_t tile_size) {
@@ -1853,20 +2268,15 @@ int ReadState::read_tile_from_file_with_mmap_cmp_gzip(
     }
   }
 
-  // Prepare attribute file name
-  std::string filename = 
-      fragment_->fragment_name() + "/" +
-      fragment_->array()->array_schema()->attribute(attribute_id_real) +
-      TILEDB_FILE_SUFFIX;
-
   // Calculate offset considering the page size
   size_t page_size = sysconf(_SC_PAGE_SIZE);
   off_t start_offset = (offset / page_size) * page_size;
   size_t extra_offset = offset - start_offset;
   size_t new_length = tile_size + extra_offset;
 
-  // Open file
-  int fd = open(filename.c_str(), O_RDONLY);
+  // Get the file descriptor (possibly kept open by the fragment)
+  bool fd_cached;
+  int fd = fragment_->file_descriptor(attribute_id_real, false, fd_cached);
   if(fd == -1) {
     munmap(map_addr_compressed_, map_addr_compressed_length_);
     map_addr_compressed_ = NULL;
@@ -1884,6 +2294,9 @@ int ReadState::read_tile_from_file_with_mmap_cmp_gzip(
                              MAP_SHARED, 
                              fd, 
                              start_offset);
+  // The mapping remains valid after the file is closed
+  if(!fd_cached)
+    close(fd);
   if(map_addr_compressed_ == MAP_FAILED) {
     map_addr_compressed_ = NULL;
     map_addr_compressed_length_ = 0;
@@ -1897,16 +2310,6 @@ int ReadState::read_tile_from_file_with_mmap_cmp_gzip(
   tile_compressed_ = 
       static_cast<char*>(map_addr_compressed_) + extra_offset;
 
-  // Close file
-  if(close(fd)) {
-    munmap(map_addr_compressed_, map_addr_compressed_length_);
-    map_addr_compressed_ = NULL;
-    map_addr_compressed_length_ = 0;
-    tile_compressed_ = NULL;
-    PRINT_ERROR("Cannot read tile from file; File closing error");
-    return TILEDB_RS_ERR;
-  }
-
   return TILEDB_RS_OK;
 }
 
@@ -1931,20 +2334,15 @@ int ReadState::read_tile_from_file_with_mmap_cmp_none(
     }
   }
 
-  // Prepare attribute file name
-  std::string filename = 
-      fragment_->fragment_name() + "/" +
-      fragment_->array()->array_schema()->attribute(attribute_id_real) +
-      TILEDB_FILE_SUFFIX;
-
   // Calculate offset considering the page size
   size_t page_size = sysconf(_SC_PAGE_SIZE);
   off_t start_offset = (offset / page_size) * page_size;
   size_t extra_offset = offset - start_offset;
   size_t new_length = tile_size + extra_offset;
 
-  // Open file
-  int fd = open(filename.c_str(), O_RDONLY);
+  // Get the file descriptor (possibly kept open by the fragment)
+  bool fd_cached;
+  int fd = fragment_->file_descriptor(attribute_id_real, false, fd_cached);
   if(fd == -1) {
     map_addr_[attribute_id] = NULL;
     map_addr_lengths_[attribute_id] = 0;
@@ -1961,6 +2359,9 @@ int ReadState::read_tile_from_file_with_mmap_cmp_none(
   int flags = var_size ? MAP_PRIVATE : MAP_SHARED;
   map_addr_[attribute_id] = 
       mmap(map_addr_[attribute_id], new_length, prot, flags, fd, start_offset);
+  // The mapping remains valid after the file is closed
+  if(!fd_cached)
+    close(fd);
   if(map_addr_[attribute_id] == MAP_FAILED) {
     map_addr_[attribute_id] = NULL;
     map_addr_lengths_[attribute_id] = 0;
@@ -1975,21 +2376,10 @@ int ReadState::read_tile_from_file_with_mmap_cmp_none(
   tiles_[attribute_id] = 
       static_cast<char*>(map_addr_[attribute_id]) + extra_offset;
 
-  // Close file
-  if(close(fd)) {
-    munmap(map_addr_[attribute_id], map_addr_lengths_[attribute_id]);
-    map_addr_[attribute_id] = NULL;
-    map_addr_lengths_[attribute_id] = 0;
-    tiles_[attribute_id] = NULL;
-    tiles_sizes_[attribute_id] = 0;
-    PRINT_ERROR("Cannot read tile from file; File closing error");
-    return TILEDB_RS_ERR;
-  }
-
   return TILEDB_RS_OK;
 }
 
-int ReadState::read_tile_from_file_var_cmp_gzip(
+int ReadState::read_tile_from_file_var_cmp(
     int attribute_id,
     off_t offset,
     size_t tile_size) {
@@ -2005,15 +2395,13 @@ int ReadState::read_tile_from_file_var_cmp_gzip(
     tile_compressed_allocated_size_ = tile_size;
   }
 
-  // Prepare attribute file name
-  std::string filename = 
-      fragment_->fragment_name() + "/" +
-      fragment_->array()->array_schema()->attribute(attribute_id) + "_var" +
-      TILEDB_FILE_SUFFIX;
-
   // Read from file
-  if(read_from_file(filename, offset, tile_compressed_, tile_size) !=
-     TILEDB_UT_OK)
+  if(fragment_->read_from_file(
+         attribute_id, 
+         true, 
+         offset, 
+         tile_compressed_, 
+         tile_size) != TILEDB_FG_OK)
     return TILEDB_RS_ERR;
   else
     return TILEDB_RS_OK;
@@ -2038,21 +2426,19 @@ int ReadState::read_tile_from_file_var_cmp_none(
   // Set the actual variable tile size
   tiles_var_sizes_[attribute_id] = tile_size; 
 
-  // Prepare variable attribute file name
-  std::string filename = 
-      fragment_->fragment_name() + "/" +
-      fragment_->array()->array_schema()->attribute(attribute_id) + "_var" +
-      TILEDB_FILE_SUFFIX;
-
   // Read from file
-  if(read_from_file(filename, offset, tiles_var_[attribute_id], tile_size) !=
-     TILEDB_UT_OK)
+  if(fragment_->read_from_file(
+         attribute_id, 
+         true, 
+         offset, 
+         tiles_var_[attribute_id], 
+         tile_size) != TILEDB_FG_OK)
     return TILEDB_RS_ERR;
   else
    return TILEDB_RS_OK;
 }
 
-int ReadState::read_tile_from_file_with_mmap_var_cmp_gzip(
+int ReadState::read_tile_from_file_with_mmap_var_cmp(
     int attribute_id,
     off_t offset,
     size_t tile_size) {
@@ -2064,20 +2450,15 @@ int ReadState::read_tile_from_file_with_mmap_var_cmp_gzip(
     }
   }
 
-  // Prepare attribute file name
-  std::string filename = 
-      fragment_->fragment_name() + "/" +
-      fragment_->array()->array_schema()->attribute(attribute_id) + "_var" +
-      TILEDB_FILE_SUFFIX;
-
   // Calculate offset considering the page size
   size_t page_size = sysconf(_SC_PAGE_SIZE);
   off_t start_offset = (offset / page_size) * page_size;
   size_t extra_offset = offset - start_offset;
   size_t new_length = tile_size + extra_offset;
 
-  // Open file
-  int fd = open(filename.c_str(), O_RDONLY);
+  // Get the file descriptor (possibly kept open by the fragment)
+  bool fd_cached;
+  int fd = fragment_->file_descriptor(attribute_id, true, fd_cached);
   if(fd == -1) {
     munmap(map_addr_compressed_, map_addr_compressed_length_);
     map_addr_compressed_ = NULL;
@@ -2098,6 +2479,9 @@ int ReadState::read_tile_from_file_with_mmap_var_cmp_gzip(
         MAP_SHARED, 
         fd, 
         start_offset);
+    // The mapping remains valid after the file is closed
+    if(!fd_cached)
+      close(fd);
     if(map_addr_compressed_ == MAP_FAILED) {
       map_addr_compressed_ = NULL;
       map_addr_compressed_length_ = 0;
@@ -2106,6 +2490,8 @@ int ReadState::read_tile_from_file_with_mmap_var_cmp_gzip(
       return TILEDB_RS_ERR;
     }
   } else {
+    if(!fd_cached)
+      close(fd);
     map_addr_var_[attribute_id] = 0;
   }
   map_addr_compressed_length_ = new_length;
@@ -2114,16 +2500,6 @@ int ReadState::read_tile_from_file_with_mmap_var_cmp_gzip(
   tile_compressed_ = 
       static_cast<char*>(map_addr_compressed_) + extra_offset;
 
-  // Close file
-  if(close(fd)) {
-    munmap(map_addr_compressed_, map_addr_compressed_length_);
-    map_addr_compressed_ = NULL;
-    map_addr_compressed_length_ = 0;
-    tile_compressed_ = NULL;
-    PRINT_ERROR("Cannot read tile from file; File closing error");
-    return TILEDB_RS_ERR;
-  }
-
   return TILEDB_RS_OK;
 }
 
@@ -2141,20 +2517,15 @@ int ReadState::read_tile_from_file_with_mmap_var_cmp_none(
     }
   }
 
-  // Prepare attribute file name
-  std::string filename = 
-      fragment_->fragment_name() + "/" +
-      fragment_->array()->array_schema()->attribute(attribute_id) + "_var" +
-      TILEDB_FILE_SUFFIX;
-
   // Calculate offset considering the page size
   size_t page_size = sysconf(_SC_PAGE_SIZE);
   off_t start_offset = (offset / page_size) * page_size;
   size_t extra_offset = offset - start_offset;
   size_t new_length = tile_size + extra_offset;
 
-  // Open file
-  int fd = open(filename.c_str(), O_RDONLY);
+  // Get the file descriptor (possibly kept open by the fragment)
+  bool fd_cached;
+  int fd = fragment_->file_descriptor(attribute_id, true, fd_cached);
   if(fd == -1) {
     map_addr_var_[attribute_id] = NULL;
     map_addr_var_lengths_[attribute_id] = 0;
@@ -2175,6 +2546,9 @@ int ReadState::read_tile_from_file_with_mmap_var_cmp_none(
         MAP_SHARED, 
         fd, 
         start_offset);
+    // The mapping remains valid after the file is closed
+    if(!fd_cached)
+      close(fd);
     if(map_addr_var_[attribute_id] == MAP_FAILED) {
       map_addr_var_[attribute_id] = NULL;
       map_addr_var_lengths_[attribute_id] = 0;
@@ -2184,6 +2558,8 @@ int ReadState::read_tile_from_file_with_mmap_var_cmp_none(
       return TILEDB_RS_ERR;
     }
   } else {
+    if(!fd_cached)
+      close(fd);
     map_addr_var_[attribute_id] = 0;
   }
   map_addr_var_lengths_[attribute_id] = new_length;
@@ -2193,17 +2569,6 @@ int ReadState::read_tile_from_file_with_mmap_var_cmp_none(
       static_cast<char*>(map_addr_var_[attribute_id]) + extra_offset;
   tiles_var_sizes_[attribute_id] = tile_size; 
 
-  // Close file
-  if(close(fd)) {
-    munmap(map_addr_var_[attribute_id], map_addr_var_lengths_[attribute_id]);
-    map_addr_var_[attribute_id] = NULL;
-    map_addr_var_lengths_[attribute_id] = 0;
-    tiles_var_[attribute_id] = NULL;
-    tiles_var_sizes_[attribute_id] = 0;
-    PRINT_ERROR("Cannot read tile from file; File closing error");
-    return TILEDB_RS_ERR;
-  }
-
   // Success
   return TILEDB_RS_OK;
 }
@@ -2237,19 +2602,52 @@ void ReadState::shift_var_offsets(
 
 // Explicit template instantiations
 
+template int ReadState::estimate_result_size<int>(
+    int64_t& cell_num,
+    std::vector<size_t>& var_sizes) const;
+template int ReadState::estimate_result_size<int64_t>(
+    int64_t& cell_num,
+    std::vector<size_t>& var_sizes) const;
+template int ReadState::estimate_result_size<float>(
+    int64_t& cell_num,
+    std::vector<size_t>& var_sizes) const;
+template int ReadState::estimate_result_size<double>(
+    int64_t& cell_num,
+    std::vector<size_t>& var_sizes) const;
+
+template int ReadState::get_coords_after<int>(
+    const int* coords,
+    int* coords_after,
+    bool& coords_retrieved);
+template int ReadState::get_coords_after<int64_t>(
+    const int64_t* coords,
+    int64_t* coords_after,
+    bool& coords_retrieved);
+template int ReadState::get_coords_after<float>(
+    const float* coords,
+    float* coords_after,
+    bool& coords_retrieved);
+template int ReadState::get_coords_after<double>(
+    const double* coords,
+    double* coords_after,
+    bool& coords_retrieved);
 template int ReadState::get_coords_after<int>(
+    int64_t tile_i,
     const int* coords,
     int* coords_after,
     bool& coords_retrieved);
 template int ReadState::get_coords_after<int64_t>(
+    int64_t tile_i,
     const int64_t* coords,
     int64_t* coords_after,
     bool& coords_retrieved);
 template int ReadState::get_coords_after<float>(
+    int64_t tile_i,
     const float* coords,
     float* coords_after,
     bool& coords_retrieved);
 template int ReadState::get_coords_after<double>(
+    int64_t tile_i,
     const double* coords,
     double* coords_after,
     bool& coords_retrieved);
@@ -2316,36 +2714,44 @@ template int ReadState::get_fragment_cell_ranges_sparse<int>(
     int fragment_i,
     const int* start_coords,
     const int* end_coords,
-    FragmentCellRanges& fragment_cell_ranges);
+    FragmentCellRanges& fragment_cell_ranges,
+    Arena& arena);
 template int ReadState::get_fragment_cell_ranges_sparse<int64_t>(
     int fragment_i,
     const int64_t* start_coords,
     const int64_t* end_coords,
-    FragmentCellRanges& fragment_cell_ranges);
+    FragmentCellRanges& fragment_cell_ranges,
+    Arena& arena);
 template int ReadState::get_fragment_cell_ranges_sparse<float>(
     int fragment_i,
     const float* start_coords,
     const float* end_coords,
-    FragmentCellRanges& fragment_cell_ranges);
+    FragmentCellRanges& fragment_cell_ranges,
+    Arena& arena);
 template int ReadState::get_fragment_cell_ranges_sparse<double>(
     int fragment_i,
     const double* start_coords,
     const double* end_coords,
-    FragmentCellRanges& fragment_cell_ranges);
+    FragmentCellRanges& fragment_cell_ranges,
+    Arena& arena);
 
 template int ReadState::get_fragment_cell_ranges_sparse<int>(
     int fragment_i,
-    FragmentCellRanges& fragment_cell_ranges);
+    FragmentCellRanges& fragment_cell_ranges,
+    Arena& arena);
 template int ReadState::get_fragment_cell_ranges_sparse<int64_t>(
     int fragment_i,
-    FragmentCellRanges& fragment_cell_ranges);
+    FragmentCellRanges& fragment_cell_ranges,
+    Arena& arena);
 
 template int ReadState::get_fragment_cell_ranges_dense<int>(
     int fragment_i,
-    FragmentCellRanges& fragment_cell_ranges);
+    FragmentCellRanges& fragment_cell_ranges,
+    Arena& arena);
 template int ReadState::get_fragment_cell_ranges_dense<int64_t>(
     int fragment_i,
-    FragmentCellRanges& fragment_cell_ranges);
+    FragmentCellRanges& fragment_cell_ranges,
+    Arena& arena);
 
 template void ReadState::get_next_overlapping_tile_dense<int>(
     const int* tile_coords);
@@ -0,0 +1,385 @@
+/**
+ * @file   rtree.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2016 MIT and Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file implements the RTree class.
+ */
+
+#include "rtree.h"
+#include "utils.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+
+
+
+
+/* ****************************** */
+/*             MACROS             */
+/* ****************************** */
+
+#if VERBOSE == 1
+#  define PRINT_ERROR(x) std::cerr << "[TileDB] Error: " << x << ".\n" 
+#  define PRINT_WARNING(x) std::cerr << "[TileDB] Warning: " \
+                                     << x << ".\n"
+#elif VERBOSE == 2
+#  define PRINT_ERROR(x) std::cerr << "[TileDB::RTree] Error: " \
+                                   << x << ".\n" 
+#  define PRINT_WARNING(x) std::cerr << "[TileDB::RTree] Warning: " \
+                                     << x << ".\n"
+#else
+#  define PRINT_ERROR(x) do { } while(0) 
+#  define PRINT_WARNING(x) do { } while(0) 
+#endif
+
+
+
+
+/* ****************************** */
+/*   CONSTRUCTORS & DESTRUCTORS   */
+/* ****************************** */
+
+RTree::RTree() {
+  dim_num_ = 0;
+  fanout_ = 0;
+  mbr_size_ = 0;
+}
+
+RTree::~RTree() {
+  clear();
+}
+
+
+
+
+/* ****************************** */
+/*            ACCESSORS           */
+/* ****************************** */
+
+/* FORMAT:
+ * fanout(int) level_num(int)
+ * level_#1_node_num(int64_t) level_#1_mbrs(void*)
+ * ...
+ * level_#<level_num>_node_num(int64_t) level_#<level_num>_mbrs(void*)
+ */
+int RTree::flush(int fd) const {
+  // Write fanout and number of levels
+  int level_num = levels_.size();
+  if(::write(fd, &fanout_, sizeof(int)) != sizeof(int) ||
+     ::write(fd, &level_num, sizeof(int)) != sizeof(int)) {
+    PRINT_ERROR("Cannot flush R-tree; Writing tree header failed");
+    return TILEDB_RT_ERR;
+  }
+
+  // Write the nodes of each level
+  for(int i=0; i<level_num; ++i) {
+    size_t level_size = node_nums_[i] * mbr_size_;
+    if(::write(fd, &node_nums_[i], sizeof(int64_t)) != sizeof(int64_t) ||
+       ::write(fd, levels_[i], level_size) != level_size) {
+      PRINT_ERROR("Cannot flush R-tree; Writing tree level failed");
+      return TILEDB_RT_ERR;
+    }
+  }
+
+  // Success
+  return TILEDB_RT_OK;
+}
+
+int RTree::level_num() const {
+  return levels_.size();
+}
+
+template<class T>
+int64_t RTree::next_overlapping_leaf(
+    const void* mbrs,
+    int64_t mbr_num,
+    const T* subarray,
+    int64_t pos,
+    int64_t end) const {
+  // For easy reference
+  int level_num = levels_.size();
+
+  // Climb from the leaf as long as it is the first child of its parent, so
+  // that the current node covers no leaf before the range
+  int level = 0;
+  int64_t node = pos;
+  int64_t span = 1;
+  while(level < level_num && node % fanout_ == 0) {
+    node /= fanout_;
+    span *= fanout_;
+    ++level;
+  }
+
+  // Traverse the nodes in leaf order, descending only into overlapping nodes
+  const T* level_mbrs;
+  for(;;) {
+    // The first leaf under the node is past the range
+    if(node * span > end || node * span >= mbr_num)
+      return -1;
+
+    level_mbrs = static_cast<const T*>((level == 0) ? mbrs : levels_[level-1]);
+    if(overlap(subarray, &level_mbrs[2*dim_num_*node], dim_num_)) {
+      if(level == 0)   // Found
+        return node;
+
+      // Descend to the first child
+      node *= fanout_;
+      span /= fanout_;
+      --level;
+    } else {
+      // Proceed to the next node, climbing after the last child of a parent
+      ++node;
+      while(level < level_num && node % fanout_ == 0) {
+        node /= fanout_;
+        span *= fanout_;
+        ++level;
+      }
+    }
+  }
+}
+
+
+
+
+/* ****************************** */
+/*            MUTATORS            */
+/* ****************************** */
+
+template<class T>
+void RTree::build(
+    const void* mbrs, 
+    int64_t mbr_num, 
+    int dim_num, 
+    int fanout) {
+  // Initialize
+  clear();
+  dim_num_ = dim_num;
+  fanout_ = fanout;
+  mbr_size_ = 2 * dim_num * sizeof(T);
+
+  // Create levels until there is a single root
+  int64_t child_num = mbr_num;
+  const T* children = static_cast<const T*>(mbrs);
+  while(child_num > 1) {
+    int64_t node_num = (child_num + fanout - 1) / fanout;
+    T* level = static_cast<T*>(malloc(node_num * mbr_size_));
+
+    // Each node covers the MBRs of its children
+    for(int64_t i=0; i<child_num; ++i) {
+      const T* child = &children[2*dim_num*i];
+      T* node = &level[2*dim_num*(i / fanout)];
+
+      if(i % fanout == 0) {
+        memcpy(node, child, mbr_size_);
+      } else {
+        for(int j=0; j<dim_num; ++j) {
+          if(child[2*j] < node[2*j])
+            node[2*j] = child[2*j];
+          if(child[2*j+1] > node[2*j+1])
+            node[2*j+1] = child[2*j+1];
+        }
+      }
+    }
+
+    levels_.push_back(level);
+    node_nums_.push_back(node_num);
+    children = level;
+    child_num = node_num;
+  }
+}
+
+/* FORMAT:
+ * fanout(int) level_num(int)
+ * level_#1_node_num(int64_t) level_#1_mbrs(void*)
+ * ...
+ * level_#<level_num>_node_num(int64_t) level_#<level_num>_mbrs(void*)
+ */
+int RTree::load(
+    const void* buffer, 
+    size_t buffer_size, 
+    int dim_num, 
+    size_t coords_size) {
+  // Initialize
+  clear();
+  dim_num_ = dim_num;
+  mbr_size_ = 2 * coords_size;
+
+  // Read fanout and number of levels
+  const char* buffer_c = static_cast<const char*>(buffer);
+  int level_num;
+  if(buffer_size < 2*sizeof(int)) {
+    PRINT_ERROR("Cannot load R-tree; Reading tree header failed");
+    return TILEDB_RT_ERR;
+  }
+  memcpy(&fanout_, buffer_c, sizeof(int));
+  memcpy(&level_num, buffer_c + sizeof(int), sizeof(int));
+  if(fanout_ < 2 || level_num < 0) {
+    PRINT_ERROR("Cannot load R-tree; Reading tree header failed");
+    return TILEDB_RT_ERR;
+  }
+  size_t offset = 2*sizeof(int);
+
+  // Read the nodes of each level
+  int64_t node_num;
+  for(int i=0; i<level_num; ++i) {
+    if(offset + sizeof(int64_t) > buffer_size) {
+      PRINT_ERROR("Cannot load R-tree; Reading tree level failed");
+      return TILEDB_RT_ERR;
+    }
+    memcpy(&node_num, buffer_c + offset, sizeof(int64_t));
+    offset += sizeof(int64_t);
+    size_t level_size = node_num * mbr_size_;
+    if(node_num <= 0 || offset + level_size > buffer_size) {
+      PRINT_ERROR("Cannot load R-tree; Reading tree level failed");
+      return TILEDB_RT_ERR;
+    }
+    void* level = malloc(level_size);
+    memcpy(level, buffer_c + offset, level_size);
+    offset += level_size;
+    levels_.push_back(level);
+    node_nums_.push_back(node_num);
+  }
+
+  // Success
+  return TILEDB_RT_OK;
+}
+
+/* FORMAT:
+ * fanout(int) level_num(int)
+ * level_#1_node_num(int64_t) level_#1_mbrs(void*)
+ * ...
+ * level_#<level_num>_node_num(int64_t) level_#<level_num>_mbrs(void*)
+ */
+int RTree::load(gzFile fd, int dim_num, size_t coords_size) {
+  // Initialize
+  clear();
+  dim_num_ = dim_num;
+  mbr_size_ = 2 * coords_size;
+
+  // Read fanout - the tree is absent in fragments written before it was
+  // introduced, in which case the tree is left empty
+  int rc = gzread(fd, &fanout_, sizeof(int));
+  if(rc == 0)
+    return TILEDB_RT_OK;
+
+  // Read number of levels
+  int level_num;
+  if(rc != sizeof(int) || 
+     gzread(fd, &level_num, sizeof(int)) != sizeof(int) || 
+     fanout_ < 2 || level_num < 0) {
+    PRINT_ERROR("Cannot load R-tree; Reading tree header failed");
+    return TILEDB_RT_ERR;
+  }
+
+  // Read the nodes of each level
+  int64_t node_num;
+  for(int i=0; i<level_num; ++i) {
+    if(gzread(fd, &node_num, sizeof(int64_t)) != sizeof(int64_t) ||
+       node_num <= 0) {
+      PRINT_ERROR("Cannot load R-tree; Reading tree level failed");
+      return TILEDB_RT_ERR;
+    }
+    size_t level_size = node_num * mbr_size_;
+    void* level = malloc(level_size);
+    if(gzread(fd, level, level_size) != level_size) {
+      PRINT_ERROR("Cannot load R-tree; Reading tree level failed");
+      free(level);
+      return TILEDB_RT_ERR;
+    }
+    levels_.push_back(level);
+    node_nums_.push_back(node_num);
+  }
+
+  // Success
+  return TILEDB_RT_OK;
+}
+
+
+
+
+/* ****************************** */
+/*         PRIVATE METHODS        */
+/* ****************************** */
+
+void RTree::clear() {
+  for(int i=0; i<levels_.size(); ++i)
+    free(levels_[i]);
+  levels_.clear();
+  node_nums_.clear();
+}
+
+
+
+
+// Explicit template instantiations
+template int64_t RTree::next_overlapping_leaf<int>(
+    const void* mbrs,
+    int64_t mbr_num,
+    const int* subarray,
+    int64_t pos,
+    int64_t end) const;
+template int64_t RTree::next_overlapping_leaf<int64_t>(
+    const void* mbrs,
+    int64_t mbr_num,
+    const int64_t* subarray,
+    int64_t pos,
+    int64_t end) const;
+template int64_t RTree::next_overlapping_leaf<float>(
+    const void* mbrs,
+    int64_t mbr_num,
+    const float* subarray,
+    int64_t pos,
+    int64_t end) const;
+template int64_t RTree::next_overlapping_leaf<double>(
+    const void* mbrs,
+    int64_t mbr_num,
+    const double* subarray,
+    int64_t pos,
+    int64_t end) const;
+
+template void RTree::build<int>(
+    const void* mbrs, 
+    int64_t mbr_num, 
+    int dim_num, 
+    int fanout);
+template void RTree::build<int64_t>(
+    const void* mbrs, 
+    int64_t mbr_num, 
+    int dim_num, 
+    int fanout);
+template void RTree::build<float>(
+    const void* mbrs, 
+    int64_t mbr_num, 
+    int dim_num, 
+    int fanout);
+template void RTree::build<double>(
+    const void* mbrs, 
+    int64_t mbr_num, 
+    int dim_num, 
+    int fanout);
@@ -0,0 +1,198 @@
+/**
+ * @file   tile_cache.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2016 MIT and Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file implements the TileCache class.
+ */
+
+#include "constants.h"
+#include "tile_cache.h"
+#include <cstdlib>
+#include <cstring>
+
+
+
+
+/* ****************************** */
+/*   CONSTRUCTORS & DESTRUCTORS   */
+/* ****************************** */
+
+TileCache::TileCache() {
+  capacity_ = TILEDB_TILE_CACHE_SIZE;
+  size_ = 0;
+}
+
+TileCache::~TileCache() {
+  clear();
+}
+
+
+
+
+/* ****************************** */
+/*            ACCESSORS           */
+/* ****************************** */
+
+TileCache* TileCache::instance() {
+  static TileCache tile_cache;
+  return &tile_cache;
+}
+
+size_t TileCache::capacity() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return capacity_;
+}
+
+bool TileCache::contains(
+    const std::string& fragment_name,
+    int attribute_id,
+    int64_t tile_i,
+    bool var) const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return tile_map_.find(TileKey(fragment_name, attribute_id, tile_i, var)) !=
+         tile_map_.end();
+}
+
+bool TileCache::get(
+    const std::string& fragment_name,
+    int attribute_id,
+    int64_t tile_i,
+    bool var,
+    void* tile,
+    size_t tile_size) {
+  std::lock_guard<std::mutex> lock(mtx_);
+
+  // Trivial case
+  if(capacity_ == 0 || tile_map_.empty())
+    return false;
+
+  // Search for the tile
+  TileMap::iterator it =
+      tile_map_.find(TileKey(fragment_name, attribute_id, tile_i, var));
+  if(it == tile_map_.end() || it->second->tile_size_ != tile_size)
+    return false;
+
+  // Copy the tile and mark it as the most recently used
+  memcpy(tile, it->second->tile_, tile_size);
+  tile_list_.splice(tile_list_.begin(), tile_list_, it->second);
+
+  // Success
+  return true;
+}
+
+size_t TileCache::size() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return size_;
+}
+
+
+
+
+/* ****************************** */
+/*            MUTATORS            */
+/* ****************************** */
+
+void TileCache::clear() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  evict(0);
+}
+
+void TileCache::insert(
+    const std::string& fragment_name,
+    int attribute_id,
+    int64_t tile_i,
+    bool var,
+    const void* tile,
+    size_t tile_size) {
+  std::lock_guard<std::mutex> lock(mtx_);
+
+  // Do not cache tiles that do not fit
+  if(tile_size == 0 || tile_size > capacity_)
+    return;
+
+  // Do nothing if the tile is already cached
+  TileKey key(fragment_name, attribute_id, tile_i, var);
+  if(tile_map_.find(key) != tile_map_.end())
+    return;
+
+  // Make room for the new tile
+  evict(capacity_ - tile_size);
+
+  // Insert a copy of the tile
+  TileEntry tile_entry;
+  tile_entry.key_ = key;
+  tile_entry.tile_ = malloc(tile_size);
+  if(tile_entry.tile_ == NULL) // Caching is best-effort
+    return;
+  memcpy(tile_entry.tile_, tile, tile_size);
+  tile_entry.tile_size_ = tile_size;
+  tile_list_.push_front(tile_entry);
+  tile_map_[key] = tile_list_.begin();
+  size_ += tile_size;
+}
+
+void TileCache::invalidate(const std::string& dir) {
+  std::lock_guard<std::mutex> lock(mtx_);
+
+  TileList::iterator it = tile_list_.begin();
+  while(it != tile_list_.end()) {
+    const std::string& fragment_name = std::get<0>(it->key_);
+    if(fragment_name == dir ||
+       (fragment_name.size() > dir.size() &&
+        fragment_name.compare(0, dir.size(), dir) == 0 &&
+        fragment_name[dir.size()] == '/'))
+      remove(it++);
+    else
+      ++it;
+  }
+}
+
+void TileCache::set_capacity(size_t capacity) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  capacity_ = capacity;
+  evict(capacity_);
+}
+
+
+
+
+/* ****************************** */
+/*         PRIVATE METHODS        */
+/* ****************************** */
+
+void TileCache::evict(size_t size) {
+  while(size_ > size && !tile_list_.empty())
+    remove(--tile_list_.end());
+}
+
+void TileCache::remove(TileList::iterator it) {
+  size_ -= it->tile_size_;
+  free(it->tile_);
+  tile_map_.erase(it->key_);
+  tile_list_.erase(it);
+}
@@ -30,14 +30,18 @@
  * This file implements the WriteState class.
  */
 
+#include "compressor.h"
 #include "constants.h"
+#include "filter.h"
 #include "utils.h"
 #include "write_state.h"
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstring>
 #include <fcntl.h>
 #include <iostream>
+#include <limits>
 #include <unistd.h>
 
 
@@ -61,14 +65,6 @@
 #  define PRINT_WARNING(x) do { } while(0) 
 #endif
 
-#ifdef GNU_PARALLEL
-  #include <parallel/algorithm>
-  #define SORT(first, last, comp) __gnu_parallel::sort((first), (last), (comp))
-#else
-  #include <algorithm>
-  #define SORT(first, last, comp) std::sort((first), (last), (comp))
-#endif
-
 
 
 
@@ -91,6 +87,11 @@ WriteState::WriteState(
   for(int i=0; i<attribute_num+1; ++i)
     tile_cell_num_[i] = 0;
 
+  // Initialize the statistics of the current uncompressed tiles
+  tile_stats_.resize(attribute_num);
+  for(int i=0; i<attribute_num; ++i)
+    memset(&tile_stats_[i], 0, sizeof(TileStats));
+
   // Initialize current tiles
   tiles_.resize(attribute_num+1);
   for(int i=0; i<attribute_num+1; ++i)
@@ -101,9 +102,8 @@ WriteState::WriteState(
   for(int i=0; i<attribute_num; ++i)
     tiles_var_[i] = NULL;
 
-  // Initialize tile buffer used in compression
-  tile_compressed_ = NULL;
-  tile_compressed_allocated_size_ = 0;
+  // Initialize the tiles awaiting compression
+  pending_tiles_size_ = 0;
 
   // Initialize current tile offsets
   tile_offsets_.resize(attribute_num+1);
@@ -143,9 +143,13 @@ WriteState::~WriteState() {
     if(tiles_var_[i] != NULL)
       free(tiles_var_[i]);
 
-  // Free current compressed tile buffer
-  if(tile_compressed_ != NULL)
-    free(tile_compressed_);
+  // Free the tiles that were never flushed (e.g., due to an error)
+  for(int i=0; i<pending_tiles_.size(); ++i) {
+    if(pending_tiles_[i].tile_ != NULL)
+      free(pending_tiles_[i].tile_);
+    if(pending_tiles_[i].tile_compressed_ != NULL)
+      free(pending_tiles_[i].tile_compressed_);
+  }
 
   // Free current MBR
   if(mbr_ != NULL)
@@ -175,6 +179,19 @@ int WriteState::finalize() {
     tile_cell_num_[attribute_num] = 0;
   }
 
+  // Send the statistics of the last uncompressed tiles to book-keeping
+  for(int i=0; i<attribute_num; ++i) {
+    if(tile_cell_num_[i] != 0) {
+      book_keeping_->append_tile_stats(i, tile_stats_[i]);
+      memset(&tile_stats_[i], 0, sizeof(TileStats));
+      tile_cell_num_[i] = 0;
+    }
+  }
+
+  // Write the tiles that still await compression
+  if(flush_pending_tiles() != TILEDB_WS_OK)
+    return TILEDB_WS_ERR;
+
   // Success
   return TILEDB_WS_OK;
 }
@@ -182,27 +199,29 @@ int WriteState::finalize() {
 int WriteState::write(const void** buffers, const size_t* buffer_sizes) {
   // Create fragment directory if it does not exist
   std::string fragment_name = fragment_->fragment_name();
-  if(!is_dir(fragment_name)) {
-    if(create_dir(fragment_name) != TILEDB_UT_OK)
-      return TILEDB_WS_ERR;
-    // For variable length attributes, ensure an empty file exists
-    // This is because if the current fragment contains no valid values for this
-    // attribute, then the file never gets created. This messes up querying
-    // functions
-    const ArraySchema* array_schema = fragment_->array()->array_schema();
-    const std::vector<int>& attribute_ids = fragment_->array()->attribute_ids();
-    const std::string file_prefix = fragment_->fragment_name() + "/";
-    std::string filename = "";
-    // Go over var length attributes
-    for(int i=0; i<attribute_ids.size(); ++i) {
-      if(array_schema->var_size(attribute_ids[i])) {
-        filename = file_prefix + array_schema->attribute(attribute_ids[i]) + 
-                   "_var" + TILEDB_FILE_SUFFIX;
-        FILE* fptr = fopen(filename.c_str(), "a");
-        if(fptr == 0)
-          return TILEDB_WS_ERR;
-        fclose(fptr);
-      }
+  if(!is_dir(fragment_name) && create_dir(fragment_name) != TILEDB_UT_OK)
+    return TILEDB_WS_ERR;
+
+  // For variable length attributes, ensure an empty file exists
+  // This is because if the current fragment contains no valid values for this
+  // attribute, then the file never gets created. This messes up querying
+  // functions. Note that the directory may have been created before the
+  // first write (e.g., holding the sorted runs of unsorted writes)
+  const ArraySchema* array_schema = fragment_->array()->array_schema();
+  const std::vector<int>& attribute_ids = fragment_->array()->attribute_ids();
+  const std::string file_prefix = fragment_name + "/";
+  std::string filename = "";
+  // Go over var length attributes
+  for(int i=0; i<attribute_ids.size(); ++i) {
+    if(array_schema->var_size(attribute_ids[i])) {
+      filename = file_prefix + array_schema->attribute(attribute_ids[i]) + 
+                 "_var" + TILEDB_FILE_SUFFIX;
+      if(is_file(filename))
+        continue;
+      FILE* fptr = fopen(filename.c_str(), "a");
+      if(fptr == 0)
+        return TILEDB_WS_ERR;
+      fclose(fptr);
     }
   }
 
@@ -229,114 +248,137 @@ int WriteState::write(const void** buffers, const size_t* buffer_sizes) {
 
 int WriteState::compress_and_write_tile(int attribute_id) {
   // For easy reference
-  const ArraySchema* array_schema = fragment_->array()->array_schema();
-  unsigned char* tile = static_cast<unsigned char*>(tiles_[attribute_id]);
   size_t tile_size = tile_offsets_[attribute_id];
 
   // Trivial case - No in-memory tile
   if(tile_size == 0)
     return TILEDB_WS_OK;
 
-  // Allocate space to store the compressed tile
-  if(tile_compressed_ == NULL) {
-    tile_compressed_allocated_size_ = 
-        tile_size + 6 + 5*(ceil(tile_size/16834.0));
-    tile_compressed_ = malloc(tile_compressed_allocated_size_); 
-  }
-
-  // Expand comnpressed tile if necessary
-  if(tile_size + 6 + 5*(ceil(tile_size/16834.0)) > 
-     tile_compressed_allocated_size_) {
-    tile_compressed_allocated_size_ = 
-        tile_size + 6 + 5*(ceil(tile_size/16834.0));
-    tile_compressed_ = 
-        realloc(tile_compressed_, tile_compressed_allocated_size_);
-  }
+  // Schedule the tile for compression
+  return enqueue_tile(attribute_id, false, tiles_[attribute_id], tile_size);
+}
 
+int WriteState::compress_and_write_tile_var(int attribute_id) {
   // For easy reference
-  unsigned char* tile_compressed = 
-      static_cast<unsigned char*>(tile_compressed_);
-
-  // Compress tile
-  ssize_t tile_compressed_size = 
-      gzip(tile, tile_size, tile_compressed, tile_compressed_allocated_size_);
-  if(tile_compressed_size == static_cast<ssize_t>(TILEDB_UT_ERR))
-    return TILEDB_WS_ERR;
-
-  // Get the attribute file name
-  std::string filename = fragment_->fragment_name() + "/" + 
-      array_schema->attribute(attribute_id) + 
-      TILEDB_FILE_SUFFIX;
-
-  // Write segment to file
-  if(write_to_file(
-         filename.c_str(),
-         tile_compressed_,
-         tile_compressed_size) != TILEDB_UT_OK)
-    return TILEDB_WS_ERR;
+  size_t tile_size = tiles_var_offsets_[attribute_id];
 
-  // Append offset to book-keeping
-  book_keeping_->append_tile_offset(attribute_id, tile_compressed_size);
+  // Trivial case - No in-memory tile (it must still be recorded in order)
+  if(tile_size == 0)
+    return enqueue_tile(attribute_id, true, NULL, 0);
 
-  // Success
-  return TILEDB_WS_OK;
+  // Schedule the tile for compression
+  return enqueue_tile(attribute_id, true, tiles_var_[attribute_id], tile_size);
 }
 
-int WriteState::compress_and_write_tile_var(int attribute_id) {
+void WriteState::compute_tile_stats(
+    int attribute_id,
+    const void* tile,
+    size_t tile_size,
+    TileStats& tile_stats) const {
   // For easy reference
   const ArraySchema* array_schema = fragment_->array()->array_schema();
-  unsigned char* tile = static_cast<unsigned char*>(tiles_var_[attribute_id]);
-  size_t tile_size = tiles_var_offsets_[attribute_id];
+  int type = array_schema->type(attribute_id);
 
-  // Trivial case - No in-memory tile
-  if(tile_size == 0) {
-    // Append offset to book-keeping
-    book_keeping_->append_tile_var_offset(attribute_id, 0u);
-    book_keeping_->append_tile_var_size(attribute_id, 0u);
-    return TILEDB_WS_OK;
-  }
+  // Invoke the proper templated function
+  if(type == TILEDB_INT32)
+    compute_tile_stats<int>(
+        static_cast<const int*>(tile), 
+        tile_size / sizeof(int), 
+        TILEDB_EMPTY_INT32,
+        tile_stats);
+  else if(type == TILEDB_INT64)
+    compute_tile_stats<int64_t>(
+        static_cast<const int64_t*>(tile), 
+        tile_size / sizeof(int64_t), 
+        TILEDB_EMPTY_INT64,
+        tile_stats);
+  else if(type == TILEDB_FLOAT32)
+    compute_tile_stats<float>(
+        static_cast<const float*>(tile), 
+        tile_size / sizeof(float), 
+        TILEDB_EMPTY_FLOAT32,
+        tile_stats);
+  else if(type == TILEDB_FLOAT64)
+    compute_tile_stats<double>(
+        static_cast<const double*>(tile), 
+        tile_size / sizeof(double), 
+        TILEDB_EMPTY_FLOAT64,
+        tile_stats);
+  else if(type == TILEDB_CHAR)
+    compute_tile_stats<char>(
+        static_cast<const char*>(tile), 
+        tile_size / sizeof(char), 
+        TILEDB_EMPTY_CHAR,
+        tile_stats);
+}
 
-  // Allocate space to store the compressed tile
-  if(tile_compressed_ == NULL) {
-    tile_compressed_allocated_size_ = 
-        tile_size + 6 + 5*(ceil(tile_size/16834.0));
-    tile_compressed_ = malloc(tile_compressed_allocated_size_); 
+template<class T>
+void WriteState::compute_tile_stats(
+    const T* values,
+    int64_t value_num,
+    T empty,
+    TileStats& tile_stats) const {
+  // Skip the empty and NaN values
+  int64_t count = 0;
+  T min = T(), max = T();
+  uint64_t sum_int = 0;
+  double sum_real = 0;
+  for(int64_t i=0; i<value_num; ++i) {
+    T value = values[i];
+    if(value == empty || value != value)
+      continue;
+    if(count == 0 || value < min)
+      min = value;
+    if(count == 0 || value > max)
+      max = value;
+    if(std::numeric_limits<T>::is_integer)
+      sum_int += uint64_t(int64_t(value));
+    else 
+      sum_real += value;
+    ++count;
   }
 
-  // Expand comnpressed tile if necessary
-  if(tile_size + 6 + 5*(ceil(tile_size/16834.0)) > 
-     tile_compressed_allocated_size_) {
-    tile_compressed_allocated_size_ = 
-        tile_size + 6 + 5*(ceil(tile_size/16834.0));
-    tile_compressed_ = 
-        realloc(tile_compressed_, tile_compressed_allocated_size_);
+  // Store the statistics
+  tile_stats.count_ = count;
+  if(std::numeric_limits<T>::is_integer) {
+    tile_stats.min_.int_ = int64_t(min);
+    tile_stats.max_.int_ = int64_t(max);
+    tile_stats.sum_.int_ = int64_t(sum_int);
+  } else {
+    tile_stats.min_.real_ = double(min);
+    tile_stats.max_.real_ = double(max);
+    tile_stats.sum_.real_ = sum_real;
   }
+}
 
-  // For easy reference
-  unsigned char* tile_compressed = 
-      static_cast<unsigned char*>(tile_compressed_);
-
-  // Compress tile
-  ssize_t tile_compressed_size = 
-      gzip(tile, tile_size, tile_compressed, tile_compressed_allocated_size_);
-  if(tile_compressed_size == TILEDB_UT_ERR) 
-    return TILEDB_WS_ERR;
-
-  // Get the attribute file name
-  std::string filename = fragment_->fragment_name() + "/" + 
-      array_schema->attribute(attribute_id) + "_var" + 
-      TILEDB_FILE_SUFFIX;
-
-  // Write segment to file
-  if(write_to_file(
-         filename.c_str(),
-         tile_compressed_,
-         tile_compressed_size) != TILEDB_UT_OK)
-    return TILEDB_WS_ERR;
+int WriteState::enqueue_tile(
+    int attribute_id,
+    bool var,
+    const void* tile,
+    size_t tile_size) {
+  // Copy the tile, as the caller will reuse its tile buffer
+  PendingTile pending_tile;
+  pending_tile.attribute_id_ = attribute_id;
+  pending_tile.tile_ = NULL;
+  pending_tile.tile_compressed_ = NULL;
+  pending_tile.tile_compressed_size_ = 0;
+  pending_tile.tile_size_ = tile_size;
+  pending_tile.var_ = var;
+  memset(&pending_tile.tile_stats_, 0, sizeof(TileStats));
+  if(tile_size != 0) {
+    pending_tile.tile_ = malloc(tile_size);
+    if(pending_tile.tile_ == NULL) {
+      PRINT_ERROR("Cannot compress tile; Memory allocation failed");
+      return TILEDB_WS_ERR;
+    }
+    memcpy(pending_tile.tile_, tile, tile_size);
+  }
+  pending_tiles_.push_back(pending_tile);
+  pending_tiles_size_ += tile_size;
 
-  // Append offset to book-keeping
-  book_keeping_->append_tile_var_offset(attribute_id, tile_compressed_size);
-  book_keeping_->append_tile_var_size(attribute_id, tile_size);
+  // Flush the pending tiles if the batch is full
+  if(pending_tiles_size_ >= TILEDB_COMPRESSION_BATCH_SIZE)
+    return flush_pending_tiles();
 
   // Success
   return TILEDB_WS_OK;
@@ -361,6 +403,197 @@ void WriteState::expand_mbr(const T* coords) {
   }
 }
 
+int WriteState::flush_pending_tiles() {
+  // Trivial case
+  if(pending_tiles_.size() == 0)
+    return TILEDB_WS_OK;
+
+  // For easy reference
+  const ArraySchema* array_schema = fragment_->array()->array_schema();
+  const Config* config = fragment_->array()->config();
+  int64_t pending_tile_num = pending_tiles_.size();
+
+  // Filter and compress the tiles in parallel
+  #pragma omp parallel for schedule(dynamic) num_threads(config->thread_num())
+  for(int64_t i=0; i<pending_tile_num; ++i) {
+    PendingTile& pending_tile = pending_tiles_[i];
+    int attribute_id = pending_tile.attribute_id_;
+    if(pending_tile.tile_size_ == 0)
+      continue;
+    const Compressor* compressor = 
+        Compressor::get(array_schema->compression(attribute_id));
+    if(compressor == NULL) {
+      pending_tile.tile_compressed_size_ = TILEDB_CP_ERR;
+      continue;
+    }
+    size_t type_size = 
+        (array_schema->var_size(attribute_id) && !pending_tile.var_)
+            ? TILEDB_CELL_VAR_OFFSET_SIZE 
+            : array_schema->type_size(attribute_id);
+    int stride = 
+        (array_schema->var_size(attribute_id)) 
+            ? 1 
+            : array_schema->cell_size(attribute_id) / type_size;
+
+    // Compute the tile statistics
+    const void* tile = pending_tile.tile_;
+    size_t tile_size = pending_tile.tile_size_;
+    if(!pending_tile.var_ && has_tile_stats(attribute_id))
+      compute_tile_stats(
+          attribute_id, 
+          tile, 
+          tile_size, 
+          pending_tile.tile_stats_);
+
+    // Filter the tile
+    void* tile_filtered = NULL;
+    FilterPipeline filter_pipeline(
+        array_schema->filters(attribute_id), type_size, stride);
+    if(!filter_pipeline.empty()) {
+      size_t tile_filtered_allocated_size = 
+          filter_pipeline.filter_bound(tile_size);
+      tile_filtered = malloc(tile_filtered_allocated_size);
+      ssize_t tile_filtered_size = 
+          (tile_filtered == NULL) 
+              ? TILEDB_FL_ERR 
+              : filter_pipeline.filter(
+                    tile, 
+                    tile_size, 
+                    tile_filtered, 
+                    tile_filtered_allocated_size);
+      if(tile_filtered_size == TILEDB_FL_ERR) {
+        if(tile_filtered != NULL)
+          free(tile_filtered);
+        pending_tile.tile_compressed_size_ = TILEDB_CP_ERR;
+        continue;
+      }
+      tile = tile_filtered;
+      tile_size = tile_filtered_size;
+    }
+
+    // Compress the tile, with the level of the configuration unless the
+    // schema sets one
+    int compression_level = array_schema->compression_level(attribute_id);
+    if(compression_level == 0)
+      compression_level = config->compression_level();
+    size_t tile_compressed_allocated_size = 
+        compressor->compress_bound(tile_size);
+    pending_tile.tile_compressed_ = malloc(tile_compressed_allocated_size);
+    if(pending_tile.tile_compressed_ == NULL) 
+      pending_tile.tile_compressed_size_ = TILEDB_CP_ERR;
+    else
+      pending_tile.tile_compressed_size_ = 
+          compressor->compress(
+              compression_level,
+              type_size,
+              tile,
+              tile_size,
+              pending_tile.tile_compressed_,
+              tile_compressed_allocated_size);
+
+    // Clean up
+    if(tile_filtered != NULL)
+      free(tile_filtered);
+  }
+
+  // Append the compressed tiles to their files in order
+  int rc = TILEDB_WS_OK;
+  for(int64_t i=0; i<pending_tile_num; ++i) {
+    PendingTile& pending_tile = pending_tiles_[i];
+    int attribute_id = pending_tile.attribute_id_;
+
+    if(rc == TILEDB_WS_OK) {
+      if(pending_tile.tile_size_ == 0) { // Empty variable tile
+        book_keeping_->append_tile_var_offset(attribute_id, 0u);
+        book_keeping_->append_tile_var_size(attribute_id, 0u);
+      } else if(pending_tile.tile_compressed_size_ == TILEDB_CP_ERR) {
+        PRINT_ERROR("Cannot compress tile");
+        rc = TILEDB_WS_ERR;
+      } else {
+        // Get the attribute file name
+        std::string filename = fragment_->fragment_name() + "/" + 
+            array_schema->attribute(attribute_id) + 
+            ((pending_tile.var_) ? "_var" : "") + 
+            TILEDB_FILE_SUFFIX;
+
+        // Write segment to file and append offset to book-keeping
+        if(write_to_file(
+               filename.c_str(),
+               pending_tile.tile_compressed_,
+               pending_tile.tile_compressed_size_) != TILEDB_UT_OK) {
+          rc = TILEDB_WS_ERR;
+        } else if(!pending_tile.var_) {
+          book_keeping_->append_tile_offset(
+              attribute_id, 
+              pending_tile.tile_compressed_size_);
+          if(has_tile_stats(attribute_id))
+            book_keeping_->append_tile_stats(
+                attribute_id, 
+                pending_tile.tile_stats_);
+        } else {
+          book_keeping_->append_tile_var_offset(
+              attribute_id, 
+              pending_tile.tile_compressed_size_);
+          book_keeping_->append_tile_var_size(
+              attribute_id, 
+              pending_tile.tile_size_);
+        }
+      }
+    }
+
+    // Clean up
+    if(pending_tile.tile_ != NULL)
+      free(pending_tile.tile_);
+    if(pending_tile.tile_compressed_ != NULL)
+      free(pending_tile.tile_compressed_);
+  }
+  pending_tiles_.clear();
+  pending_tiles_size_ = 0;
+
+  // Return
+  return rc;
+}
+
+bool WriteState::has_tile_stats(int attribute_id) const {
+  // For easy reference
+  const ArraySchema* array_schema = fragment_->array()->array_schema();
+
+  return attribute_id != array_schema->attribute_num() &&
+         !array_schema->var_size(attribute_id);
+}
+
+void WriteState::merge_tile_stats(
+    int attribute_id,
+    const TileStats& stats,
+    TileStats& tile_stats) const {
+  // Trivial case
+  if(stats.count_ == 0)
+    return;
+
+  // For easy reference
+  const ArraySchema* array_schema = fragment_->array()->array_schema();
+  int type = array_schema->type(attribute_id);
+
+  // The first values of the tile
+  if(tile_stats.count_ == 0) {
+    tile_stats = stats;
+    return;
+  }
+
+  // Merge
+  tile_stats.count_ += stats.count_;
+  if(type == TILEDB_FLOAT32 || type == TILEDB_FLOAT64) {
+    tile_stats.min_.real_ = std::min(tile_stats.min_.real_, stats.min_.real_);
+    tile_stats.max_.real_ = std::max(tile_stats.max_.real_, stats.max_.real_);
+    tile_stats.sum_.real_ += stats.sum_.real_;
+  } else {
+    tile_stats.min_.int_ = std::min(tile_stats.min_.int_, stats.min_.int_);
+    tile_stats.max_.int_ = std::max(tile_stats.max_.int_, stats.max_.int_);
+    tile_stats.sum_.int_ = int64_t(
+        uint64_t(tile_stats.sum_.int_) + uint64_t(stats.sum_.int_));
+  }
+}
+
 void WriteState::shift_var_offsets(
     int attribute_id,
     size_t buffer_var_size,
@@ -413,63 +646,61 @@ void WriteState::sort_cell_pos(
   size_t coords_size = array_schema->coords_size();
   int64_t buffer_cell_num = buffer_size / coords_size;
   int cell_order = array_schema->cell_order();
+  int thread_num = fragment_->array()->config()->thread_num();
   const T* buffer_T = static_cast<const T*>(buffer);
 
   // Populate cell_pos
   cell_pos.resize(buffer_cell_num);
-  for(int i=0; i<buffer_cell_num; ++i)
+  for(int64_t i=0; i<buffer_cell_num; ++i)
     cell_pos[i] = i;
 
-  // Invoke the proper sort function, based on the cell order
-  if(array_schema->tile_extents() == NULL)  {    // NO TILE GRID
-    if(cell_order == TILEDB_ROW_MAJOR) {
-      // Sort cell positions
-      SORT(
-          cell_pos.begin(), 
-          cell_pos.end(), 
-          SmallerRow<T>(buffer_T, dim_num)); 
-    } else if(cell_order == TILEDB_COL_MAJOR) {
-      // Sort cell positions
-      SORT(
-          cell_pos.begin(), 
-          cell_pos.end(), 
-          SmallerCol<T>(buffer_T, dim_num)); 
-    } else if(cell_order == TILEDB_HILBERT) {
-      // Get hilbert ids
-      std::vector<int64_t> ids;
-      ids.resize(buffer_cell_num);
-      for(int i=0; i<buffer_cell_num; ++i) 
-        ids[i] = array_schema->hilbert_id<T>(&buffer_T[i * dim_num]); 
- 
-      // Sort cell positions
-      SORT(
-          cell_pos.begin(), 
-          cell_pos.end(), 
-          SmallerIdRow<T>(buffer_T, dim_num, ids)); 
+  // Sort on each coordinate, from the least to the most significant one in
+  // the cell order. Since radix sort is stable, the cells end up sorted on
+  // all the coordinates. 
+  std::vector<uint64_t> keys;
+  keys.resize(buffer_cell_num);
+  for(int d=0; d<dim_num; ++d) {
+    int dim;
+    if(cell_order == TILEDB_COL_MAJOR) {
+      dim = d;
+    } else if(cell_order == TILEDB_ROW_MAJOR || 
+              cell_order == TILEDB_HILBERT) {
+      dim = dim_num - 1 - d;
     } else {
       assert(0); // The code should never reach here
+      return;
     }
-  } else {                                       // TILE GRID
-    // Get tile ids
-    std::vector<int64_t> ids;
+
+    #pragma omp parallel for num_threads(thread_num)
+    for(int64_t i=0; i<buffer_cell_num; ++i)
+      keys[i] = radix_key<T>(buffer_T[cell_pos[i] * dim_num + dim]);
+    radix_sort(keys, cell_pos, thread_num);
+  }
+
+  // Finally sort on the tile ids or, in the absence of a tile grid, on the
+  // Hilbert ids
+  std::vector<int64_t> ids;
+  if(array_schema->tile_extents() != NULL) {          // TILE GRID
+    assert(cell_order != TILEDB_HILBERT);
     ids.resize(buffer_cell_num);
-    for(int i=0; i<buffer_cell_num; ++i) 
-      ids[i] = array_schema->tile_id<T>(&buffer_T[i * dim_num]); 
- 
-    // Sort cell positions
-    if(cell_order == TILEDB_ROW_MAJOR) {
-      SORT(
-          cell_pos.begin(), 
-          cell_pos.end(), 
-          SmallerIdRow<T>(buffer_T, dim_num, ids)); 
-    } else if(cell_order == TILEDB_COL_MAJOR) {
-       SORT(
-          cell_pos.begin(), 
-          cell_pos.end(), 
-          SmallerIdCol<T>(buffer_T, dim_num, ids));
-    } else {
-      assert(0); // The code should never reach here
-    }
+    array_schema->tile_ids<T>(
+        buffer_T, 
+        buffer_cell_num, 
+        &ids[0], 
+        thread_num);
+  } else if(cell_order == TILEDB_HILBERT) {           // NO TILE GRID
+    ids.resize(buffer_cell_num);
+    array_schema->hilbert_ids<T>(
+        buffer_T, 
+        buffer_cell_num, 
+        &ids[0], 
+        thread_num);
+  }
+  if(!ids.empty()) {
+    #pragma omp parallel for num_threads(thread_num)
+    for(int64_t i=0; i<buffer_cell_num; ++i) 
+      keys[i] = radix_key<int64_t>(ids[cell_pos[i]]);
+    radix_sort(keys, cell_pos, thread_num);
   }
 }
 
@@ -536,6 +767,43 @@ void WriteState::update_book_keeping(
   }
 }
 
+void WriteState::update_tile_stats(
+    int attribute_id,
+    const void* buffer,
+    size_t buffer_size) {
+  // For easy reference
+  const ArraySchema* array_schema = fragment_->array()->array_schema();
+  size_t cell_size = array_schema->cell_size(attribute_id);
+  int64_t cell_num_per_tile = fragment_->tile_size(attribute_id) / cell_size;
+  int64_t buffer_cell_num = buffer_size / cell_size;
+  const char* buffer_c = static_cast<const char*>(buffer);
+  int64_t& tile_cell_num = tile_cell_num_[attribute_id];
+  TileStats& tile_stats = tile_stats_[attribute_id];
+  TileStats stats;
+
+  // Go over the cells tile by tile
+  for(int64_t i = 0; i<buffer_cell_num; ) {
+    int64_t cell_num = std::min(
+                           cell_num_per_tile - tile_cell_num, 
+                           buffer_cell_num - i); 
+    compute_tile_stats(
+        attribute_id, 
+        buffer_c + i*cell_size, 
+        cell_num*cell_size, 
+        stats);
+    merge_tile_stats(attribute_id, stats, tile_stats);
+    tile_cell_num += cell_num;
+    i += cell_num;
+
+    // Send the statistics of a full tile to book-keeping
+    if(tile_cell_num == cell_num_per_tile) {
+      book_keeping_->append_tile_stats(attribute_id, tile_stats);
+      memset(&tile_stats, 0, sizeof(TileStats));
+      tile_cell_num = 0;
+    }
+  }
+}
+
 int WriteState::write_last_tile() {
   // For easy reference
   const ArraySchema* array_schema = fragment_->array()->array_schema();
@@ -550,7 +818,7 @@ int WriteState::write_last_tile() {
   // Flush the last tile for each compressed attribute (it is still in main
   // memory
   for(int i=0; i<attribute_num+1; ++i) {
-    if(array_schema->compression(i) == TILEDB_GZIP) {
+    if(array_schema->compression(i) != TILEDB_NO_COMPRESSION) {
       if(compress_and_write_tile(i) != TILEDB_WS_OK)
         return TILEDB_WS_ERR;
       if(array_schema->var_size(i)) {
@@ -613,8 +881,8 @@ int WriteState::write_dense_attr(
   // No compression
   if(compression == TILEDB_NO_COMPRESSION)
     return write_dense_attr_cmp_none(attribute_id, buffer, buffer_size);
-  else // GZIP
-    return write_dense_attr_cmp_gzip(attribute_id, buffer, buffer_size);
+  else // COMPRESSION
+    return write_dense_attr_cmp(attribute_id, buffer, buffer_size);
 }
 
 int WriteState::write_dense_attr_cmp_none(
@@ -624,6 +892,10 @@ int WriteState::write_dense_attr_cmp_none(
   // For easy reference
   const ArraySchema* array_schema = fragment_->array()->array_schema();
 
+  // Update the tile statistics
+  if(has_tile_stats(attribute_id))
+    update_tile_stats(attribute_id, buffer, buffer_size);
+
   // Write buffer to file 
   std::string filename = fragment_->fragment_name() + "/" + 
       array_schema->attribute(attribute_id) + 
@@ -634,7 +906,7 @@ int WriteState::write_dense_attr_cmp_none(
     return TILEDB_WS_OK;
 }
 
-int WriteState::write_dense_attr_cmp_gzip(
+int WriteState::write_dense_attr_cmp(
     int attribute_id,
     const void* buffer,
     size_t buffer_size) {
@@ -724,8 +996,8 @@ int WriteState::write_dense_attr_var(
                buffer_size,
                buffer_var,  
                buffer_var_size);
-  else // GZIP
-    return write_dense_attr_var_cmp_gzip(
+  else // COMPRESSION
+    return write_dense_attr_var_cmp(
                attribute_id, 
                buffer,  
                buffer_size,
@@ -780,7 +1052,7 @@ int WriteState::write_dense_attr_var_cmp_none(
     return TILEDB_WS_OK;
 }
 
-int WriteState::write_dense_attr_var_cmp_gzip(
+int WriteState::write_dense_attr_var_cmp(
     int attribute_id,
     const void* buffer,
     size_t buffer_size,
@@ -1018,8 +1290,8 @@ int WriteState::write_sparse_attr(
   // No compression
   if(compression == TILEDB_NO_COMPRESSION)
     return write_sparse_attr_cmp_none(attribute_id, buffer, buffer_size);
-  else // GZIP
-    return write_sparse_attr_cmp_gzip(attribute_id, buffer, buffer_size);
+  else // COMPRESSION
+    return write_sparse_attr_cmp(attribute_id, buffer, buffer_size);
 }
 
 int WriteState::write_sparse_attr_cmp_none(
@@ -1035,6 +1307,8 @@ int WriteState::write_sparse_attr_cmp_none(
   // Update book-keeping
   if(attribute_id == attribute_num) 
     update_book_keeping(buffer, buffer_size);
+  else if(has_tile_stats(attribute_id))
+    update_tile_stats(attribute_id, buffer, buffer_size);
 
   // Write buffer to file 
   std::string filename = fragment_->fragment_name() + "/" + 
@@ -1046,7 +1320,7 @@ int WriteState::write_sparse_attr_cmp_none(
     return TILEDB_WS_OK;
 }
 
-int WriteState::write_sparse_attr_cmp_gzip(
+int WriteState::write_sparse_attr_cmp(
     int attribute_id,
     const void* buffer,
     size_t buffer_size) {
@@ -1142,8 +1416,8 @@ int WriteState::write_sparse_attr_var(
                buffer_size,
                buffer_var,  
                buffer_var_size);
-  else // GZIP
-    return write_sparse_attr_var_cmp_gzip(
+  else // COMPRESSION
+    return write_sparse_attr_var_cmp(
                attribute_id, 
                buffer,  
                buffer_size,
@@ -1201,7 +1475,7 @@ int WriteState::write_sparse_attr_var_cmp_none(
     return TILEDB_WS_OK;
 }
 
-int WriteState::write_sparse_attr_var_cmp_gzip(
+int WriteState::write_sparse_attr_var_cmp(
     int attribute_id,
     const void* buffer,
     size_t buffer_size,
@@ -1427,16 +1701,17 @@ int WriteState::write_sparse_unsorted(
       buffer_sizes[coords_buffer_i], 
       cell_pos);
 
-  // Write each attribute individually
+  // Write the fixed-sized attributes together, and each variable-sized 
+  // attribute individually
+  std::vector<int> fixed_attribute_ids;
+  std::vector<const void*> fixed_buffers;
+  std::vector<size_t> fixed_buffer_sizes;
   buffer_i=0; 
   for(int i=0; i<attribute_id_num; ++i) {
     if(!array_schema->var_size(attribute_ids[i])) { // FIXED CELLS
-      if(write_sparse_unsorted_attr(
-             attribute_ids[i], 
-             buffers[buffer_i], 
-             buffer_sizes[buffer_i],
-             cell_pos) != TILEDB_WS_OK)
-        return TILEDB_WS_ERR;
+      fixed_attribute_ids.push_back(attribute_ids[i]);
+      fixed_buffers.push_back(buffers[buffer_i]);
+      fixed_buffer_sizes.push_back(buffer_sizes[buffer_i]);
       ++buffer_i;
     } else {                                        // VARIABLE-SIZED CELLS
       if(write_sparse_unsorted_attr_var(
@@ -1450,161 +1725,110 @@ int WriteState::write_sparse_unsorted(
       buffer_i += 2;
     }
   }
+  if(write_sparse_unsorted_attrs(
+         fixed_attribute_ids, 
+         fixed_buffers, 
+         fixed_buffer_sizes, 
+         cell_pos) != TILEDB_WS_OK)
+    return TILEDB_WS_ERR;
 
   // Success
   return TILEDB_WS_OK;
 }
 
-int WriteState::write_sparse_unsorted_attr(
-    int attribute_id,
-    const void* buffer,
-    size_t buffer_size,
+int WriteState::write_sparse_unsorted_attrs(
+    const std::vector<int>& attribute_ids,
+    const std::vector<const void*>& buffers,
+    const std::vector<size_t>& buffer_sizes,
     const std::vector<int64_t>& cell_pos) {
   // For easy reference
   const ArraySchema* array_schema = fragment_->array()->array_schema();
-  int compression = array_schema->compression(attribute_id);
-
-  // No compression
-  if(compression == TILEDB_NO_COMPRESSION)
-    return write_sparse_unsorted_attr_cmp_none(
-               attribute_id, 
-               buffer, 
-               buffer_size,
-               cell_pos);
-  else // GZIP
-    return write_sparse_unsorted_attr_cmp_gzip(
-               attribute_id,
-               buffer, 
-               buffer_size,
-               cell_pos);
-}
-
-int WriteState::write_sparse_unsorted_attr_cmp_none(
-    int attribute_id,
-    const void* buffer,
-    size_t buffer_size,
-    const std::vector<int64_t>& cell_pos) {
-  // For easy reference
-  const ArraySchema* array_schema = fragment_->array()->array_schema();
-  size_t cell_size = array_schema->cell_size(attribute_id); 
-  const char* buffer_c = static_cast<const char*>(buffer); 
+  int attribute_id_num = attribute_ids.size();
+  int64_t cell_num = cell_pos.size();
 
-  // Check number of cells in buffer
-  int64_t buffer_cell_num = buffer_size / cell_size;
-  if(buffer_cell_num != cell_pos.size()) {
-    PRINT_ERROR(std::string("Cannot write sparse unsorted; Invalid number of "
-                "cells in attribute '") + 
-                array_schema->attribute(attribute_id) + "'");
-    return TILEDB_WS_ERR;
-  }
-
-  // Allocate a local buffer to hold the sorted cells
-  char* sorted_buffer = new char[TILEDB_SORTED_BUFFER_SIZE]; 
-  size_t sorted_buffer_size = 0;
-
-  // Sort and write attribute values in batches
-  for(int64_t i=0; i<buffer_cell_num; ++i) {
-    // Write batch
-    if(sorted_buffer_size + cell_size > TILEDB_SORTED_BUFFER_SIZE) {
-      if(write_sparse_attr_cmp_none(
-             attribute_id,
-             sorted_buffer, 
-             sorted_buffer_size) != TILEDB_WS_OK) {
-        delete [] sorted_buffer;
-        return TILEDB_WS_ERR;
-      } else {
-        sorted_buffer_size = 0;
-      }
-    }
-
-    // Keep on copying the cells in the sorted order in the sorted buffer
-    memcpy(
-        sorted_buffer + sorted_buffer_size, 
-        buffer_c + cell_pos[i] * cell_size, 
-        cell_size);
-    sorted_buffer_size += cell_size;
-  }
-
-  // Write final batch
-  if(sorted_buffer_size != 0) {
-    if(write_sparse_attr_cmp_none(
-           attribute_id, 
-           sorted_buffer, 
-           sorted_buffer_size) != TILEDB_WS_OK) {
-      delete [] sorted_buffer;
+  // Check number of cells in buffers
+  std::vector<size_t> cell_sizes(attribute_id_num);
+  size_t cells_size = 0;
+  for(int i=0; i<attribute_id_num; ++i) {
+    cell_sizes[i] = array_schema->cell_size(attribute_ids[i]);
+    if(buffer_sizes[i] / cell_sizes[i] != cell_num) {
+      PRINT_ERROR(std::string("Cannot write sparse unsorted; Invalid number of "
+                  "cells in attribute '") + 
+                  array_schema->attribute(attribute_ids[i]) + "'");
       return TILEDB_WS_ERR;
     }
+    cells_size += cell_sizes[i];
   }
 
-  // Clean up
-  delete [] sorted_buffer;
-
-  // Success
-  return TILEDB_WS_OK;
-}
-
-int WriteState::write_sparse_unsorted_attr_cmp_gzip(
-    int attribute_id,
-    const void* buffer,
-    size_t buffer_size,
-    const std::vector<int64_t>& cell_pos) {
-  // For easy reference
-  const ArraySchema* array_schema = fragment_->array()->array_schema();
-  size_t cell_size = array_schema->cell_size(attribute_id); 
-  const char* buffer_c = static_cast<const char*>(buffer); 
+  // Trivial case
+  if(attribute_id_num == 0 || cell_num == 0)
+    return TILEDB_WS_OK;
 
-  // Check number of cells in buffer
-  int64_t buffer_cell_num = buffer_size / cell_size;
-  if(buffer_cell_num != cell_pos.size()) {
-    PRINT_ERROR(std::string("Cannot write sparse unsorted; Invalid number of "
-                "cells in attribute '") + 
-                array_schema->attribute(attribute_id) + "'");
-    return TILEDB_WS_ERR;
+  // Allocate a local buffer to hold a batch of sorted cells of every 
+  // attribute
+  int thread_num = fragment_->array()->config()->thread_num();
+  size_t sorted_buffer_size_max = 
+      fragment_->array()->config()->sorted_buffer_size();
+  int64_t batch_cell_num = std::min<int64_t>(
+                               cell_num,
+                               std::max<int64_t>(
+                                   1, 
+                                   sorted_buffer_size_max / cells_size));
+  char* sorted_buffer = new char[batch_cell_num * cells_size];
+  std::vector<char*> sorted_buffers(attribute_id_num);
+  std::vector<int64_t> block_cell_nums(attribute_id_num);
+  sorted_buffers[0] = sorted_buffer;
+  for(int i=0; i<attribute_id_num; ++i) {
+    if(i > 0)
+      sorted_buffers[i] = sorted_buffers[i-1] + batch_cell_num*cell_sizes[i-1];
+    block_cell_nums[i] = std::max<int64_t>(
+                             1, 
+                             TILEDB_GATHER_BLOCK_SIZE / cell_sizes[i]);
   }
 
-  // Allocate a local buffer to hold the sorted cells
-  char* sorted_buffer = new char[TILEDB_SORTED_BUFFER_SIZE]; 
-  size_t sorted_buffer_size = 0;
-
   // Sort and write attribute values in batches
-  for(int64_t i=0; i<buffer_cell_num; ++i) {
-    // Write batch
-    if(sorted_buffer_size + cell_size > TILEDB_SORTED_BUFFER_SIZE) {
-      if(write_sparse_attr_cmp_gzip(
-             attribute_id,
-             sorted_buffer, 
-             sorted_buffer_size) != TILEDB_WS_OK) {
-        delete [] sorted_buffer;
-        return TILEDB_WS_ERR;
-      } else {
-        sorted_buffer_size = 0;
-      }
+  int rc = TILEDB_WS_OK;
+  std::vector<std::pair<int, int64_t> > blocks;
+  for(int64_t first=0; first<cell_num && rc == TILEDB_WS_OK; 
+      first += batch_cell_num) {
+    int64_t batch_num = std::min(batch_cell_num, cell_num - first);
+
+    // Gather the blocks of sorted cells of all attributes in parallel
+    blocks.clear();
+    for(int i=0; i<attribute_id_num; ++i) 
+      for(int64_t j=0; j<batch_num; j+=block_cell_nums[i]) 
+        blocks.push_back(std::pair<int, int64_t>(i, j));
+    int64_t block_num = blocks.size();
+    #pragma omp parallel for schedule(dynamic) if(block_num > 1) \
+        num_threads(thread_num)
+    for(int64_t b=0; b<block_num; ++b) {
+      int i = blocks[b].first;
+      int64_t j = blocks[b].second;
+      gather_cells(
+          buffers[i], 
+          cell_sizes[i], 
+          &cell_pos[first + j], 
+          std::min(block_cell_nums[i], batch_num - j),
+          sorted_buffers[i] + j*cell_sizes[i]);
     }
 
-    // Keep on copying the cells in the sorted order in the sorted buffer
-    memcpy(
-        sorted_buffer + sorted_buffer_size, 
-        buffer_c + cell_pos[i] * cell_size, 
-        cell_size);
-    sorted_buffer_size += cell_size;
-  }
-
-  // Write final batch
-  if(sorted_buffer_size != 0) {
-    if(write_sparse_attr_cmp_gzip(
-           attribute_id, 
-           sorted_buffer, 
-           sorted_buffer_size) != TILEDB_WS_OK) {
-      delete [] sorted_buffer;
-      return TILEDB_WS_ERR;
+    // Write the batch of each attribute
+    for(int i=0; i<attribute_id_num; ++i) {
+      if(write_sparse_attr(
+             attribute_ids[i], 
+             sorted_buffers[i], 
+             batch_num*cell_sizes[i]) != TILEDB_WS_OK) {
+        rc = TILEDB_WS_ERR;
+        break;
+      }
     }
   }
 
   // Clean up
   delete [] sorted_buffer;
 
-  // Success
-  return TILEDB_WS_OK;
+  // Return
+  return rc;
 } 
 
 int WriteState::write_sparse_unsorted_attr_var(
@@ -1627,8 +1851,8 @@ int WriteState::write_sparse_unsorted_attr_var(
                buffer_var, 
                buffer_var_size,
                cell_pos);
-  else // GZIP
-    return write_sparse_unsorted_attr_var_cmp_gzip(
+  else // COMPRESSION
+    return write_sparse_unsorted_attr_var_cmp(
                attribute_id, 
                buffer,
                buffer_size,
@@ -1662,9 +1886,12 @@ int WriteState::write_sparse_unsorted_attr_var_cmp_none(
   }
 
   // Allocate a local buffer to hold the sorted cells
-  char* sorted_buffer = new char[TILEDB_SORTED_BUFFER_SIZE]; 
+  size_t sorted_buffer_size_max = 
+      std::max(fragment_->array()->config()->sorted_buffer_size(), cell_size);
+  char* sorted_buffer = new char[sorted_buffer_size_max]; 
   size_t sorted_buffer_size = 0;
-  char* sorted_buffer_var = new char[TILEDB_SORTED_BUFFER_VAR_SIZE]; 
+  size_t sorted_buffer_var_size_max = sorted_buffer_size_max;
+  char* sorted_buffer_var = new char[sorted_buffer_var_size_max]; 
   size_t sorted_buffer_var_size = 0;
 
   // Sort and write attribute values in batches
@@ -1675,8 +1902,10 @@ int WriteState::write_sparse_unsorted_attr_var_cmp_none(
                         : buffer_s[cell_pos[i]+1] - buffer_s[cell_pos[i]]; 
 
     // Write batch
-    if(sorted_buffer_size + cell_size > TILEDB_SORTED_BUFFER_SIZE ||
-       sorted_buffer_var_size + cell_var_size > TILEDB_SORTED_BUFFER_VAR_SIZE) {
+    if(sorted_buffer_size != 0 &&
+       (sorted_buffer_size + cell_size > sorted_buffer_size_max ||
+        sorted_buffer_var_size + cell_var_size > 
+            sorted_buffer_var_size_max)) {
       if(write_sparse_attr_var_cmp_none(
              attribute_id,
              sorted_buffer, 
@@ -1692,6 +1921,13 @@ int WriteState::write_sparse_unsorted_attr_var_cmp_none(
       sorted_buffer_var_size = 0;
     } 
 
+    // Grow the variable buffer if the cell does not fit in it alone
+    if(cell_var_size > sorted_buffer_var_size_max) {
+      delete [] sorted_buffer_var;
+      sorted_buffer_var_size_max = cell_var_size;
+      sorted_buffer_var = new char[sorted_buffer_var_size_max];
+    }
+
     // Keep on copying the cells in sorted order in the sorted buffer
     memcpy(
         sorted_buffer + sorted_buffer_size, 
@@ -1729,7 +1965,7 @@ int WriteState::write_sparse_unsorted_attr_var_cmp_none(
   return TILEDB_WS_OK;
 }
 
-int WriteState::write_sparse_unsorted_attr_var_cmp_gzip(
+int WriteState::write_sparse_unsorted_attr_var_cmp(
     int attribute_id,
     const void* buffer,
     size_t buffer_size,
@@ -1755,9 +1991,12 @@ int WriteState::write_sparse_unsorted_attr_var_cmp_gzip(
   }
 
   // Allocate a local buffer to hold the sorted cells
-  char* sorted_buffer = new char[TILEDB_SORTED_BUFFER_SIZE]; 
+  size_t sorted_buffer_size_max = 
+      std::max(fragment_->array()->config()->sorted_buffer_size(), cell_size);
+  char* sorted_buffer = new char[sorted_buffer_size_max]; 
   size_t sorted_buffer_size = 0;
-  char* sorted_buffer_var = new char[TILEDB_SORTED_BUFFER_VAR_SIZE]; 
+  size_t sorted_buffer_var_size_max = sorted_buffer_size_max;
+  char* sorted_buffer_var = new char[sorted_buffer_var_size_max]; 
   size_t sorted_buffer_var_size = 0;
 
   // Sort and write attribute values in batches
@@ -1768,9 +2007,11 @@ int WriteState::write_sparse_unsorted_attr_var_cmp_gzip(
                         : buffer_s[cell_pos[i]+1] - buffer_s[cell_pos[i]]; 
 
     // Write batch
-    if(sorted_buffer_size + cell_size > TILEDB_SORTED_BUFFER_SIZE ||
-       sorted_buffer_var_size + cell_var_size > TILEDB_SORTED_BUFFER_VAR_SIZE) {
-      if(write_sparse_attr_var_cmp_gzip(
+    if(sorted_buffer_size != 0 &&
+       (sorted_buffer_size + cell_size > sorted_buffer_size_max ||
+        sorted_buffer_var_size + cell_var_size > 
+            sorted_buffer_var_size_max)) {
+      if(write_sparse_attr_var_cmp(
              attribute_id,
              sorted_buffer, 
              sorted_buffer_size,
@@ -1785,6 +2026,13 @@ int WriteState::write_sparse_unsorted_attr_var_cmp_gzip(
       sorted_buffer_var_size = 0;
     } 
 
+    // Grow the variable buffer if the cell does not fit in it alone
+    if(cell_var_size > sorted_buffer_var_size_max) {
+      delete [] sorted_buffer_var;
+      sorted_buffer_var_size_max = cell_var_size;
+      sorted_buffer_var = new char[sorted_buffer_var_size_max];
+    }
+
     // Keep on copying the cells in sorted order in the sorted buffer
     memcpy(
         sorted_buffer + sorted_buffer_size, 
@@ -1802,7 +2050,7 @@ int WriteState::write_sparse_unsorted_attr_var_cmp_gzip(
 
   // Write final batch
   if(sorted_buffer_size != 0) {
-    if(write_sparse_attr_var_cmp_gzip(
+    if(write_sparse_attr_var_cmp(
            attribute_id, 
            sorted_buffer, 
            sorted_buffer_size,
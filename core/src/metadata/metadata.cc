@@ -125,8 +125,10 @@ int Metadata::read(const char* key, void** buffers, size_t* buffer_sizes) {
 /*            MUTATORS            */
 /* ****************************** */
 
-int Metadata::consolidate() {
-  if(array_->consolidate() != TILEDB_AR_OK)
+int Metadata::consolidate(
+    const ConsolidationPolicy* policy,
+    size_t buffer_size) {
+  if(array_->consolidate(policy, buffer_size) != TILEDB_AR_OK)
     return TILEDB_MT_ERR;
   else
     return TILEDB_MT_OK;
@@ -148,7 +150,8 @@ int Metadata::init(
     const ArraySchema* array_schema,
     int mode,
     const char** attributes,
-    int attribute_num) {
+    int attribute_num,
+    const Config* config) {
   // Sanity check on mode
   if(mode != TILEDB_METADATA_READ &&
      mode != TILEDB_METADATA_WRITE) {
@@ -199,7 +202,8 @@ int Metadata::init(
               array_mode, 
               (const char**) array_attributes, 
               array_attribute_num, 
-              NULL);
+              NULL,
+              config);
 
   // Clean up
   for(int i=0; i<array_attribute_num; ++i) 
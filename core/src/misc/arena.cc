@@ -0,0 +1,85 @@
+/**
+ * @file   arena.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2016 MIT and Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file implements class Arena.
+ */
+
+
+#include "arena.h"
+#include "constants.h"
+#include <algorithm>
+#include <inttypes.h>
+
+
+
+
+/* ****************************** */
+/*   CONSTRUCTORS & DESTRUCTORS   */
+/* ****************************** */
+
+Arena::Arena() {
+  block_ = -1;
+  offset_ = 0;
+}
+
+
+
+
+/* ****************************** */
+/*             MUTATORS           */
+/* ****************************** */
+
+void* Arena::allocate(size_t size) {
+  // Round the size up, so that the next object stays aligned
+  size = (size + sizeof(int64_t) - 1) / sizeof(int64_t) * sizeof(int64_t);
+
+  // Move to the next block if the object does not fit in the current one,
+  // allocating a new block (large enough for the object) if needed
+  if(block_ == -1 || offset_ + size > blocks_[block_].size()) {
+    ++block_;
+    offset_ = 0;
+    if(block_ == int(blocks_.size())) {
+      blocks_.push_back(std::vector<char>());
+      blocks_[block_].resize(std::max<size_t>(size, TILEDB_ARENA_BLOCK_SIZE));
+    } else if(blocks_[block_].size() < size) {
+      blocks_[block_].resize(size);
+    }
+  }
+
+  // Bump
+  void* object = &blocks_[block_][offset_];
+  offset_ += size;
+
+  return object;
+}
+
+void Arena::reset() {
+  block_ = -1;
+  offset_ = 0;
+}
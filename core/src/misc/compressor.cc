@@ -0,0 +1,403 @@
+/**
+ * @file   compressor.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2016 MIT and Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file implements class Compressor and the supported codecs.
+ */
+
+#include "compressor.h"
+#include "constants.h"
+#include "utils.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <zlib.h>
+#ifdef HAVE_LZ4
+#  include <lz4.h>
+#endif
+#ifdef HAVE_ZSTD
+#  include <zstd.h>
+#endif
+
+
+
+
+/* ****************************** */
+/*             MACROS             */
+/* ****************************** */
+
+#if VERBOSE == 1
+#  define PRINT_ERROR(x) std::cerr << "[TileDB] Error: " << x << ".\n" 
+#  define PRINT_WARNING(x) std::cerr << "[TileDB] Warning: " \
+                                     << x << ".\n"
+#elif VERBOSE == 2
+#  define PRINT_ERROR(x) std::cerr << "[TileDB::Compressor] Error: " \
+                                   << x << ".\n" 
+#  define PRINT_WARNING(x) std::cerr << "[TileDB::Compressor] Warning: " \
+                                     << x << ".\n"
+#else
+#  define PRINT_ERROR(x) do { } while(0) 
+#  define PRINT_WARNING(x) do { } while(0) 
+#endif
+
+
+
+
+/* ****************************** */
+/*   CONSTRUCTORS & DESTRUCTORS   */
+/* ****************************** */
+
+Compressor::~Compressor() {
+}
+
+
+
+
+/* ****************************** */
+/*           ACCESSORS            */
+/* ****************************** */
+
+const Compressor* Compressor::get(int compression) {
+  // The registered codecs
+  static const GzipCompressor gzip_compressor;
+#ifdef HAVE_LZ4
+  static const LZ4Compressor lz4_compressor;
+  static const ShuffleLZ4Compressor shuffle_lz4_compressor;
+#endif
+#ifdef HAVE_ZSTD
+  static const ZstdCompressor zstd_compressor;
+#endif
+
+  // Return the codec for the input compression type
+  switch(compression) {
+    case TILEDB_GZIP:
+      return &gzip_compressor;
+#ifdef HAVE_LZ4
+    case TILEDB_LZ4:
+      return &lz4_compressor;
+    case TILEDB_SHUFFLE_LZ4:
+      return &shuffle_lz4_compressor;
+#endif
+#ifdef HAVE_ZSTD
+    case TILEDB_ZSTD:
+      return &zstd_compressor;
+#endif
+    default:
+      return NULL;
+  }
+}
+
+int Compressor::max_supported_level() {
+  const int compressions[] = 
+      { TILEDB_GZIP, TILEDB_LZ4, TILEDB_ZSTD, TILEDB_SHUFFLE_LZ4 };
+  int max_level = 0;
+  for(int i=0; i<4; ++i) {
+    const Compressor* compressor = get(compressions[i]);
+    if(compressor != NULL)
+      max_level = std::max(max_level, compressor->max_level());
+  }
+
+  return max_level;
+}
+
+
+
+
+/* ****************************** */
+/*              GZIP              */
+/* ****************************** */
+
+size_t GzipCompressor::compress_bound(size_t in_size) const {
+  return compressBound(in_size);
+}
+
+int GzipCompressor::max_level() const {
+  return Z_BEST_COMPRESSION;
+}
+
+ssize_t GzipCompressor::compress(
+    int level,
+    size_t type_size,
+    const void* in,
+    size_t in_size,
+    void* out,
+    size_t out_size) const {
+  ssize_t rc = gzip(
+                   static_cast<unsigned char*>(const_cast<void*>(in)),
+                   in_size,
+                   static_cast<unsigned char*>(out),
+                   out_size,
+                   (level == 0) ? Z_DEFAULT_COMPRESSION : level);
+
+  return (rc == TILEDB_UT_ERR) ? TILEDB_CP_ERR : rc;
+}
+
+int GzipCompressor::decompress(
+    size_t type_size,
+    const void* in,
+    size_t in_size,
+    void* out,
+    size_t avail_out,
+    size_t& out_size) const {
+  if(gunzip(
+         static_cast<unsigned char*>(const_cast<void*>(in)),
+         in_size,
+         static_cast<unsigned char*>(out),
+         avail_out,
+         out_size) != TILEDB_UT_OK)
+    return TILEDB_CP_ERR;
+  else
+    return TILEDB_CP_OK;
+}
+
+
+
+
+#ifdef HAVE_LZ4
+/* ****************************** */
+/*               LZ4              */
+/* ****************************** */
+
+size_t LZ4Compressor::compress_bound(size_t in_size) const {
+  return LZ4_compressBound(in_size);
+}
+
+int LZ4Compressor::max_level() const {
+  // Any acceleration factor is valid, so the level field bounds it
+  return TILEDB_COMPRESSION_LEVEL_MAX;
+}
+
+ssize_t LZ4Compressor::compress(
+    int level,
+    size_t type_size,
+    const void* in,
+    size_t in_size,
+    void* out,
+    size_t out_size) const {
+  // LZ4 handles buffers up to LZ4_MAX_INPUT_SIZE
+  if(in_size > LZ4_MAX_INPUT_SIZE) {
+    PRINT_ERROR("Cannot compress with LZ4; Input buffer too large");
+    return TILEDB_CP_ERR;
+  }
+
+  int rc = LZ4_compress_fast(
+               static_cast<const char*>(in), 
+               static_cast<char*>(out), 
+               in_size, 
+               out_size,
+               (level == 0) ? 1 : level);
+  if(rc <= 0) {
+    PRINT_ERROR("Cannot compress with LZ4");
+    return TILEDB_CP_ERR;
+  }
+
+  return rc;
+}
+
+int LZ4Compressor::decompress(
+    size_t type_size,
+    const void* in,
+    size_t in_size,
+    void* out,
+    size_t avail_out,
+    size_t& out_size) const {
+  int rc = LZ4_decompress_safe(
+               static_cast<const char*>(in), 
+               static_cast<char*>(out), 
+               in_size, 
+               avail_out);
+  if(rc < 0) {
+    PRINT_ERROR("Cannot decompress with LZ4");
+    return TILEDB_CP_ERR;
+  }
+
+  out_size = rc;
+  return TILEDB_CP_OK;
+}
+
+
+
+
+/* ****************************** */
+/*       BYTE-SHUFFLE + LZ4       */
+/* ****************************** */
+
+size_t ShuffleLZ4Compressor::compress_bound(size_t in_size) const {
+  return LZ4_compressBound(in_size);
+}
+
+int ShuffleLZ4Compressor::max_level() const {
+  return TILEDB_COMPRESSION_LEVEL_MAX;
+}
+
+ssize_t ShuffleLZ4Compressor::compress(
+    int level,
+    size_t type_size,
+    const void* in,
+    size_t in_size,
+    void* out,
+    size_t out_size) const {
+  // Shuffle the bytes of the values
+  void* shuffled = malloc(in_size);
+  if(shuffled == NULL) {
+    PRINT_ERROR("Cannot compress with shuffle-LZ4; Memory allocation failed");
+    return TILEDB_CP_ERR;
+  }
+  byte_shuffle(type_size, in, in_size, shuffled);
+
+  // Compress
+  LZ4Compressor lz4_compressor;
+  ssize_t rc = lz4_compressor.compress(
+                   level, type_size, shuffled, in_size, out, out_size);
+
+  // Clean up
+  free(shuffled);
+
+  return rc;
+}
+
+int ShuffleLZ4Compressor::decompress(
+    size_t type_size,
+    const void* in,
+    size_t in_size,
+    void* out,
+    size_t avail_out,
+    size_t& out_size) const {
+  // Decompress
+  void* shuffled = malloc(avail_out);
+  if(shuffled == NULL) {
+    PRINT_ERROR(
+        "Cannot decompress with shuffle-LZ4; Memory allocation failed");
+    return TILEDB_CP_ERR;
+  }
+  LZ4Compressor lz4_compressor;
+  int rc = lz4_compressor.decompress(
+               type_size, in, in_size, shuffled, avail_out, out_size);
+
+  // Restore the bytes of the values
+  if(rc == TILEDB_CP_OK)
+    byte_unshuffle(type_size, shuffled, out_size, out);
+
+  // Clean up
+  free(shuffled);
+
+  return rc;
+}
+#endif
+
+
+
+
+#ifdef HAVE_ZSTD
+/* ****************************** */
+/*              ZSTD              */
+/* ****************************** */
+
+size_t ZstdCompressor::compress_bound(size_t in_size) const {
+  return ZSTD_compressBound(in_size);
+}
+
+int ZstdCompressor::max_level() const {
+  return ZSTD_maxCLevel();
+}
+
+ssize_t ZstdCompressor::compress(
+    int level,
+    size_t type_size,
+    const void* in,
+    size_t in_size,
+    void* out,
+    size_t out_size) const {
+  size_t rc = ZSTD_compress(out, out_size, in, in_size, level);
+  if(ZSTD_isError(rc)) {
+    PRINT_ERROR(std::string("Cannot compress with Zstd; ") + 
+                ZSTD_getErrorName(rc));
+    return TILEDB_CP_ERR;
+  }
+
+  return rc;
+}
+
+int ZstdCompressor::decompress(
+    size_t type_size,
+    const void* in,
+    size_t in_size,
+    void* out,
+    size_t avail_out,
+    size_t& out_size) const {
+  size_t rc = ZSTD_decompress(out, avail_out, in, in_size);
+  if(ZSTD_isError(rc)) {
+    PRINT_ERROR(std::string("Cannot decompress with Zstd; ") + 
+                ZSTD_getErrorName(rc));
+    return TILEDB_CP_ERR;
+  }
+
+  out_size = rc;
+  return TILEDB_CP_OK;
+}
+#endif
+
+
+
+
+/* ****************************** */
+/*            FUNCTIONS           */
+/* ****************************** */
+
+void byte_shuffle(size_t type_size, const void* in, size_t size, void* out) {
+  // For easy reference
+  const char* in_c = static_cast<const char*>(in);
+  char* out_c = static_cast<char*>(out);
+  size_t value_num = (type_size == 0) ? 0 : size / type_size;
+
+  // Shuffle the bytes of the full values
+  for(size_t i=0; i<value_num; ++i) 
+    for(size_t j=0; j<type_size; ++j) 
+      out_c[j*value_num + i] = in_c[i*type_size + j];
+
+  // Copy the trailing bytes
+  size_t shuffled_size = value_num * type_size;
+  memcpy(out_c + shuffled_size, in_c + shuffled_size, size - shuffled_size);
+}
+
+void byte_unshuffle(size_t type_size, const void* in, size_t size, void* out) {
+  // For easy reference
+  const char* in_c = static_cast<const char*>(in);
+  char* out_c = static_cast<char*>(out);
+  size_t value_num = (type_size == 0) ? 0 : size / type_size;
+
+  // Restore the bytes of the full values
+  for(size_t i=0; i<value_num; ++i) 
+    for(size_t j=0; j<type_size; ++j) 
+      out_c[i*type_size + j] = in_c[j*value_num + i];
+
+  // Copy the trailing bytes
+  size_t shuffled_size = value_num * type_size;
+  memcpy(out_c + shuffled_size, in_c + shuffled_size, size - shuffled_size);
+}
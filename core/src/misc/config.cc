@@ -0,0 +1,183 @@
+/**
+ * @file   config.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2016 MIT and Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file implements class Config.
+ */
+
+
+#include "compressor.h"
+#include "config.h"
+#include "constants.h"
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+
+
+
+/* ****************************** */
+/*             MACROS             */
+/* ****************************** */
+
+#if VERBOSE == 1
+#  define PRINT_ERROR(x) std::cerr << "[TileDB] Error: " << x << ".\n" 
+#elif VERBOSE == 2
+#  define PRINT_ERROR(x) std::cerr << "[TileDB::Config] Error: " \
+                                   << x << ".\n" 
+#else
+#  define PRINT_ERROR(x) do { } while(0) 
+#endif
+
+#ifdef _TILEDB_USE_MMAP
+#  define TILEDB_IO_MODE TILEDB_IO_MMAP
+#else
+#  define TILEDB_IO_MODE TILEDB_IO_READ
+#endif
+
+
+
+
+/* ****************************** */
+/*   CONSTRUCTORS & DESTRUCTORS   */
+/* ****************************** */
+
+Config::Config() {
+  set_default();
+}
+
+
+
+
+/* ****************************** */
+/*            ACCESSORS           */
+/* ****************************** */
+
+int Config::compression_level() const {
+  return compression_level_;
+}
+
+bool Config::has_parameter(const std::string& parameter) {
+  return parameter == TILEDB_CF_COMPRESSION_LEVEL ||
+         parameter == TILEDB_CF_IO_MODE ||
+         parameter == TILEDB_CF_SORTED_BUFFER_SIZE ||
+         parameter == TILEDB_CF_THREAD_NUM ||
+         parameter == TILEDB_CF_UNSORTED_MERGE_BUFFER_SIZE;
+}
+
+int Config::io_mode() const {
+  return io_mode_;
+}
+
+size_t Config::sorted_buffer_size() const {
+  return sorted_buffer_size_;
+}
+
+int Config::thread_num() const {
+  if(thread_num_ > 0)
+    return thread_num_;
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+size_t Config::unsorted_merge_buffer_size() const {
+  return unsorted_merge_buffer_size_;
+}
+
+
+
+
+/* ****************************** */
+/*             MUTATORS           */
+/* ****************************** */
+
+int Config::set(const std::string& parameter, const std::string& value) {
+  bool valid;
+  char* end;
+  errno = 0;
+
+  if(parameter == TILEDB_CF_COMPRESSION_LEVEL) {
+    long compression_level = strtol(value.c_str(), &end, 10);
+    valid = !errno && *end == '\0' && value != "" &&
+            compression_level >= 0 && 
+            compression_level <= Compressor::max_supported_level();
+    if(valid)
+      compression_level_ = compression_level;
+  } else if(parameter == TILEDB_CF_IO_MODE) {
+    valid = (value == "read" || value == "mmap");
+    if(valid)
+      io_mode_ = (value == "mmap") ? TILEDB_IO_MMAP : TILEDB_IO_READ;
+  } else if(parameter == TILEDB_CF_SORTED_BUFFER_SIZE) {
+    unsigned long long sorted_buffer_size = strtoull(value.c_str(), &end, 10);
+    valid = !errno && *end == '\0' && value != "" && value[0] != '-' &&
+            sorted_buffer_size != 0;
+    if(valid)
+      sorted_buffer_size_ = sorted_buffer_size;
+  } else if(parameter == TILEDB_CF_THREAD_NUM) {
+    long thread_num = strtol(value.c_str(), &end, 10);
+    valid = !errno && *end == '\0' && value != "" &&
+            thread_num >= 0 && thread_num <= INT_MAX;
+    if(valid)
+      thread_num_ = thread_num;
+  } else if(parameter == TILEDB_CF_UNSORTED_MERGE_BUFFER_SIZE) {
+    unsigned long long unsorted_merge_buffer_size = 
+        strtoull(value.c_str(), &end, 10);
+    valid = !errno && *end == '\0' && value != "" && value[0] != '-';
+    if(valid)
+      unsorted_merge_buffer_size_ = unsorted_merge_buffer_size;
+  } else {
+    PRINT_ERROR(std::string("Cannot set configuration parameter; "
+                "Unknown parameter '") + parameter + "'");
+    return TILEDB_CF_ERR;
+  }
+
+  if(!valid) {
+    PRINT_ERROR(std::string("Cannot set configuration parameter; "
+                "Invalid value '") + value + "' for parameter '" + 
+                parameter + "'");
+    return TILEDB_CF_ERR;
+  }
+
+  // Success
+  return TILEDB_CF_OK;
+}
+
+void Config::set_default() {
+  compression_level_ = 0;
+  io_mode_ = TILEDB_IO_MODE;
+  sorted_buffer_size_ = TILEDB_SORTED_BUFFER_SIZE;
+  thread_num_ = TILEDB_THREAD_NUM;
+  unsorted_merge_buffer_size_ = TILEDB_UNSORTED_MERGE_BUFFER_SIZE;
+}
@@ -0,0 +1,483 @@
+/**
+ * @file   filter.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2016 MIT and Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file implements class FilterPipeline.
+ */
+
+#include "compressor.h"
+#include "constants.h"
+#include "filter.h"
+#include <cstdlib>
+#include <cstring>
+#include <inttypes.h>
+#include <iostream>
+#include <type_traits>
+
+
+
+
+/* ****************************** */
+/*             MACROS             */
+/* ****************************** */
+
+#if VERBOSE == 1
+#  define PRINT_ERROR(x) std::cerr << "[TileDB] Error: " << x << ".\n"
+#  define PRINT_WARNING(x) std::cerr << "[TileDB] Warning: " \
+                                     << x << ".\n"
+#elif VERBOSE == 2
+#  define PRINT_ERROR(x) std::cerr << "[TileDB::FilterPipeline] Error: " \
+                                   << x << ".\n"
+#  define PRINT_WARNING(x) std::cerr << "[TileDB::FilterPipeline] Warning: " \
+                                     << x << ".\n"
+#else
+#  define PRINT_ERROR(x) do { } while(0)
+#  define PRINT_WARNING(x) do { } while(0)
+#endif
+
+
+
+
+/* ****************************** */
+/*   CONSTRUCTORS & DESTRUCTORS   */
+/* ****************************** */
+
+FilterPipeline::FilterPipeline(int filters, size_t type_size, int stride) {
+  for(int i=0; i<TILEDB_FILTER_MAX_NUM; ++i) {
+    int filter = (filters >> (i * TILEDB_FILTER_BITS)) & TILEDB_FILTER_MASK;
+    if(filter == TILEDB_FILTER_NONE)
+      break;
+    filters_.push_back(filter);
+  }
+  stride_ = (stride > 0) ? stride : 1;
+  type_size_ = type_size;
+}
+
+
+
+
+/* ****************************** */
+/*           ACCESSORS            */
+/* ****************************** */
+
+bool FilterPipeline::empty() const {
+  return filters_.empty();
+}
+
+ssize_t FilterPipeline::filter(
+    const void* tile,
+    size_t tile_size,
+    void* out,
+    size_t out_size) const {
+  // Sanity check
+  if(out_size < filter_bound(tile_size)) {
+    PRINT_ERROR("Cannot filter tile; Output buffer too small");
+    return TILEDB_FL_ERR;
+  }
+
+  // Trivial case
+  int filter_num = filters_.size();
+  if(filter_num == 0) {
+    memcpy(out, tile, tile_size);
+    return tile_size;
+  }
+
+  // Allocate a scratch buffer for the intermediate results
+  void* scratch = NULL;
+  if(filter_num > 1) {
+    scratch = malloc(out_size);
+    if(scratch == NULL) {
+      PRINT_ERROR("Cannot filter tile; Memory allocation failed");
+      return TILEDB_FL_ERR;
+    }
+  }
+
+  // Apply the filters, alternating between the scratch and output buffers so
+  // that the last filter writes into the output buffer
+  const void* in = tile;
+  size_t in_size = tile_size;
+  for(int i=0; i<filter_num; ++i) {
+    void* filter_out = ((filter_num - i) % 2 == 1) ? out : scratch;
+    in_size = apply_filter(filters_[i], in, in_size, filter_out);
+    in = filter_out;
+  }
+
+  // Clean up
+  if(scratch != NULL)
+    free(scratch);
+
+  return in_size;
+}
+
+size_t FilterPipeline::filter_bound(size_t tile_size) const {
+  // Only bit-packing may grow the tile, by its header
+  for(int i=0; i<int(filters_.size()); ++i)
+    if(filters_[i] == TILEDB_FILTER_BIT_PACKING)
+      return tile_size + type_size_ + 1;
+
+  return tile_size;
+}
+
+int FilterPipeline::unfilter(
+    const void* in,
+    size_t in_size,
+    void* tile,
+    size_t tile_size) const {
+  // Trivial case
+  int filter_num = filters_.size();
+  if(filter_num == 0) {
+    if(in_size != tile_size) {
+      PRINT_ERROR("Cannot unfilter tile; Unexpected tile size");
+      return TILEDB_FL_ERR;
+    }
+    memcpy(tile, in, tile_size);
+    return TILEDB_FL_OK;
+  }
+
+  // Allocate two scratch buffers for the intermediate results
+  size_t scratch_size = filter_bound(tile_size);
+  char* scratch = NULL;
+  if(filter_num > 1) {
+    scratch = static_cast<char*>(malloc(2 * scratch_size));
+    if(scratch == NULL) {
+      PRINT_ERROR("Cannot unfilter tile; Memory allocation failed");
+      return TILEDB_FL_ERR;
+    }
+  }
+
+  // Reverse the filters, alternating between the scratch buffers, so that
+  // the first filter is reversed into the output buffer. The intermediate
+  // results may be larger than the tile (if they are bit-packed), hence they
+  // never go to the output buffer. All filters but bit-packing preserve the
+  // size, so a bit-packed buffer is always unpacked into the tile size.
+  int rc = TILEDB_FL_OK;
+  for(int i=filter_num-1; i>=0; --i) {
+    void* filter_out = (i == 0) ? tile : scratch + (i % 2) * scratch_size;
+    size_t out_size =
+        (filters_[i] == TILEDB_FILTER_BIT_PACKING) ? tile_size : in_size;
+    if((i == 0 && out_size != tile_size) || out_size > scratch_size) {
+      PRINT_ERROR("Cannot unfilter tile; Unexpected tile size");
+      rc = TILEDB_FL_ERR;
+      break;
+    }
+    if(reverse_filter(filters_[i], in, in_size, filter_out, out_size) !=
+       TILEDB_FL_OK) {
+      rc = TILEDB_FL_ERR;
+      break;
+    }
+    in = filter_out;
+    in_size = out_size;
+  }
+
+  // Clean up
+  if(scratch != NULL)
+    free(scratch);
+
+  return rc;
+}
+
+bool FilterPipeline::valid(int filters) {
+  // The chain must fit in TILEDB_FILTER_MAX_NUM positions
+  if(filters < 0 ||
+     (filters >> (TILEDB_FILTER_MAX_NUM * TILEDB_FILTER_BITS)) != 0)
+    return false;
+
+  int bit_packing_num = 0;
+  bool ended = false;
+  for(int i=0; i<TILEDB_FILTER_MAX_NUM; ++i) {
+    int filter = (filters >> (i * TILEDB_FILTER_BITS)) & TILEDB_FILTER_MASK;
+    if(filter == TILEDB_FILTER_NONE) {
+      ended = true;
+    } else if(ended ||                     // Gap in the chain
+              filter > TILEDB_FILTER_BIT_PACKING) {
+      return false;
+    } else if(filter == TILEDB_FILTER_BIT_PACKING) {
+      ++bit_packing_num;
+    }
+  }
+
+  return bit_packing_num <= 1;
+}
+
+
+
+
+/* ****************************** */
+/*         PRIVATE METHODS        */
+/* ****************************** */
+
+size_t FilterPipeline::apply_filter(
+    int filter,
+    const void* in,
+    size_t in_size,
+    void* out) const {
+  // Byte shuffling is independent of the value type
+  if(filter == TILEDB_FILTER_BYTE_SHUFFLE) {
+    byte_shuffle(type_size_, in, in_size, out);
+    return in_size;
+  }
+
+  // Invoke the proper templated function
+  if(type_size_ == sizeof(uint16_t))
+    return apply_filter<uint16_t>(filter, in, in_size, out, stride_);
+  else if(type_size_ == sizeof(uint32_t))
+    return apply_filter<uint32_t>(filter, in, in_size, out, stride_);
+  else if(type_size_ == sizeof(uint64_t))
+    return apply_filter<uint64_t>(filter, in, in_size, out, stride_);
+  else  // Other sizes are filtered byte by byte
+    return apply_filter<uint8_t>(
+               filter, in, in_size, out, stride_ * type_size_);
+}
+
+template<class T>
+size_t FilterPipeline::apply_filter(
+    int filter,
+    const void* in,
+    size_t in_size,
+    void* out,
+    int stride) const {
+  // For easy reference
+  typedef typename std::make_signed<T>::type S;
+  const T* in_v = static_cast<const T*>(in);
+  T* out_v = static_cast<T*>(out);
+  size_t value_num = in_size / sizeof(T);
+  size_t values_size = value_num * sizeof(T);
+  size_t trailing_size = in_size - values_size;
+  const int bit_num = 8 * sizeof(T);
+  size_t s = stride;
+
+  if(filter == TILEDB_FILTER_DELTA) {
+    for(size_t i=0; i<value_num; ++i)
+      out_v[i] = (i < s) ? in_v[i] : T(in_v[i] - in_v[i-s]);
+  } else if(filter == TILEDB_FILTER_DOUBLE_DELTA) {
+    for(size_t i=0; i<value_num; ++i) {
+      if(i < s)
+        out_v[i] = in_v[i];
+      else if(i < 2*s)
+        out_v[i] = in_v[i] - in_v[i-s];
+      else
+        out_v[i] = in_v[i] - T(2*in_v[i-s]) + in_v[i-2*s];
+    }
+  } else if(filter == TILEDB_FILTER_BIT_SHUFFLE) {
+    // Only groups of 8 values are shuffled, so that each bit plane takes an
+    // integral number of bytes
+    size_t shuffled_num = value_num - value_num % 8;
+    size_t plane_size = shuffled_num / 8;
+    unsigned char* out_c = static_cast<unsigned char*>(out);
+    memset(out_c, 0, shuffled_num * sizeof(T));
+    for(size_t i=0; i<shuffled_num; ++i) {
+      T value = in_v[i];
+      for(int j=0; j<bit_num; ++j)
+        if((value >> j) & 1)
+          out_c[j*plane_size + i/8] |= (unsigned char) (1 << (i%8));
+    }
+    memcpy(
+        out_c + shuffled_num * sizeof(T),
+        in_v + shuffled_num,
+        (value_num - shuffled_num) * sizeof(T));
+  } else if(filter == TILEDB_FILTER_BIT_PACKING) {
+    // Find the frame of reference and the number of bits per value
+    S min = 0, max = 0;
+    for(size_t i=0; i<value_num; ++i) {
+      S value = S(in_v[i]);
+      if(i == 0 || value < min)
+        min = value;
+      if(i == 0 || value > max)
+        max = value;
+    }
+    T range = T(max) - T(min);
+    unsigned char bits = 0;
+    while(bits < bit_num && (range >> bits) != 0)
+      ++bits;
+
+    // Header: the minimum value and the number of bits per value
+    unsigned char* out_c = static_cast<unsigned char*>(out);
+    memcpy(out_c, &min, sizeof(T));
+    out_c[sizeof(T)] = bits;
+    out_c += sizeof(T) + 1;
+
+    // Pack the differences from the minimum
+    size_t packed_size = (value_num * bits + 7) / 8;
+    memset(out_c, 0, packed_size);
+    size_t bit_pos = 0;
+    for(size_t i=0; i<value_num; ++i) {
+      T diff = in_v[i] - T(min);
+      for(int b=0; b<bits; ) {
+        int byte_bit = bit_pos % 8;
+        int take = 8 - byte_bit;
+        if(take > bits - b)
+          take = bits - b;
+        out_c[bit_pos / 8] |=
+            (unsigned char) (((diff >> b) & ((1u << take) - 1)) << byte_bit);
+        b += take;
+        bit_pos += take;
+      }
+    }
+
+    // Copy the trailing bytes
+    memcpy(
+        out_c + packed_size,
+        static_cast<const char*>(in) + values_size,
+        trailing_size);
+
+    return sizeof(T) + 1 + packed_size + trailing_size;
+  }
+
+  // Copy the trailing bytes (for the size-preserving filters)
+  memcpy(
+      static_cast<char*>(out) + values_size,
+      static_cast<const char*>(in) + values_size,
+      trailing_size);
+
+  return in_size;
+}
+
+int FilterPipeline::reverse_filter(
+    int filter,
+    const void* in,
+    size_t in_size,
+    void* out,
+    size_t out_size) const {
+  // Byte shuffling is independent of the value type
+  if(filter == TILEDB_FILTER_BYTE_SHUFFLE) {
+    byte_unshuffle(type_size_, in, in_size, out);
+    return TILEDB_FL_OK;
+  }
+
+  // Invoke the proper templated function
+  if(type_size_ == sizeof(uint16_t))
+    return reverse_filter<uint16_t>(
+               filter, in, in_size, out, out_size, stride_);
+  else if(type_size_ == sizeof(uint32_t))
+    return reverse_filter<uint32_t>(
+               filter, in, in_size, out, out_size, stride_);
+  else if(type_size_ == sizeof(uint64_t))
+    return reverse_filter<uint64_t>(
+               filter, in, in_size, out, out_size, stride_);
+  else  // Other sizes are filtered byte by byte
+    return reverse_filter<uint8_t>(
+               filter, in, in_size, out, out_size, stride_ * type_size_);
+}
+
+template<class T>
+int FilterPipeline::reverse_filter(
+    int filter,
+    const void* in,
+    size_t in_size,
+    void* out,
+    size_t out_size,
+    int stride) const {
+  // For easy reference
+  const T* in_v = static_cast<const T*>(in);
+  T* out_v = static_cast<T*>(out);
+  size_t value_num = out_size / sizeof(T);
+  size_t values_size = value_num * sizeof(T);
+  size_t trailing_size = out_size - values_size;
+  const int bit_num = 8 * sizeof(T);
+  size_t s = stride;
+
+  if(filter == TILEDB_FILTER_DELTA) {
+    for(size_t i=0; i<value_num; ++i)
+      out_v[i] = (i < s) ? in_v[i] : T(in_v[i] + out_v[i-s]);
+  } else if(filter == TILEDB_FILTER_DOUBLE_DELTA) {
+    for(size_t i=0; i<value_num; ++i) {
+      if(i < s)
+        out_v[i] = in_v[i];
+      else if(i < 2*s)
+        out_v[i] = in_v[i] + out_v[i-s];
+      else
+        out_v[i] = in_v[i] + T(2*out_v[i-s]) - out_v[i-2*s];
+    }
+  } else if(filter == TILEDB_FILTER_BIT_SHUFFLE) {
+    size_t shuffled_num = value_num - value_num % 8;
+    size_t plane_size = shuffled_num / 8;
+    const unsigned char* in_c = static_cast<const unsigned char*>(in);
+    for(size_t i=0; i<shuffled_num; ++i) {
+      T value = 0;
+      for(int j=0; j<bit_num; ++j)
+        if((in_c[j*plane_size + i/8] >> (i%8)) & 1)
+          value |= T(1) << j;
+      out_v[i] = value;
+    }
+    memcpy(
+        out_v + shuffled_num,
+        in_c + shuffled_num * sizeof(T),
+        (value_num - shuffled_num) * sizeof(T));
+  } else if(filter == TILEDB_FILTER_BIT_PACKING) {
+    // Read the header
+    const unsigned char* in_c = static_cast<const unsigned char*>(in);
+    if(in_size < sizeof(T) + 1) {
+      PRINT_ERROR("Cannot unpack tile; Invalid header");
+      return TILEDB_FL_ERR;
+    }
+    T min;
+    memcpy(&min, in_c, sizeof(T));
+    int bits = in_c[sizeof(T)];
+    in_c += sizeof(T) + 1;
+
+    // Sanity check
+    size_t packed_size = (value_num * bits + 7) / 8;
+    if(bits > bit_num ||
+       in_size != sizeof(T) + 1 + packed_size + trailing_size) {
+      PRINT_ERROR("Cannot unpack tile; Unexpected tile size");
+      return TILEDB_FL_ERR;
+    }
+
+    // Unpack the differences from the minimum
+    size_t bit_pos = 0;
+    for(size_t i=0; i<value_num; ++i) {
+      T diff = 0;
+      for(int b=0; b<bits; ) {
+        int byte_bit = bit_pos % 8;
+        int take = 8 - byte_bit;
+        if(take > bits - b)
+          take = bits - b;
+        diff |= T((in_c[bit_pos / 8] >> byte_bit) & ((1u << take) - 1)) << b;
+        b += take;
+        bit_pos += take;
+      }
+      out_v[i] = min + diff;
+    }
+
+    // Copy the trailing bytes
+    memcpy(
+        static_cast<char*>(out) + values_size,
+        in_c + packed_size,
+        trailing_size);
+
+    return TILEDB_FL_OK;
+  }
+
+  // Copy the trailing bytes (for the size-preserving filters)
+  memcpy(
+      static_cast<char*>(out) + values_size,
+      static_cast<const char*>(in) + values_size,
+      trailing_size);
+
+  return TILEDB_FL_OK;
+}
@@ -58,44 +58,48 @@ HilbertCurve::~HilbertCurve() {
 /* ****************************** */
 
 void HilbertCurve::coords_to_hilbert(const int* coords, int64_t& hilbert) {
-  // Copy coords to temporary storage
-  memcpy(temp_, coords, dim_num_ * sizeof(int));
+  // Copy coords to temporary storage (local, so that concurrent calls on
+  // the same object are safe)
+  int temp[HC_MAX_DIM];
+  memcpy(temp, coords, dim_num_ * sizeof(int));
 
   // Convert coords to the transpose form of the hilbert value
-  AxestoTranspose(temp_, bits_, dim_num_);
+  AxestoTranspose(temp, bits_, dim_num_);
 
   // Convert the hilbert transpose form into an int64_t hilbert value
   hilbert = 0; 
-  int64_t c = 1; // This is a bit shifted from right to left over temp_[i]
+  int64_t c = 1; // This is a bit shifted from right to left over temp[i]
   int64_t h = 1; // This is a bit shifted from right to left over hilbert
   for(int j=0; j<bits_; ++j, c <<= 1) {
     for(int i=dim_num_-1; i>=0; --i, h <<= 1) {
-      if(temp_[i] & c)
+      if(temp[i] & c)
         hilbert |= h; 
     } 
   }
 }
 
 void HilbertCurve::hilbert_to_coords(int64_t hilbert, int* coords) {
-  // Initialization
+  // Initialization (of local temporary storage, so that concurrent calls on
+  // the same object are safe)
+  int temp[HC_MAX_DIM];
   for(int i=0; i<dim_num_; ++i) 
-    temp_[i] = 0;
+    temp[i] = 0;
 
   // Convert the int64_t hilbert value to its transpose form
-  int64_t c = 1; // This is a bit shifted from right to left over temp_[i]
+  int64_t c = 1; // This is a bit shifted from right to left over temp[i]
   int64_t h = 1; // This is a bit shifted from right to left over hilbert
   for(int j=0; j<bits_; ++j, c <<= 1) {
     for(int i=dim_num_-1; i>=0; --i, h <<= 1) {
       if(hilbert & h)
-        temp_[i] |= c; 
+        temp[i] |= c; 
     } 
   }
 
   // Convert coords to the transpose form of the hilbert value
-  TransposetoAxes(temp_, bits_, dim_num_);
+  TransposetoAxes(temp, bits_, dim_num_);
 
   // Copy from the temporary storage to the (output) coords
-  memcpy(coords, temp_, dim_num_ * sizeof(int));
+  memcpy(coords, temp, dim_num_ * sizeof(int));
 }
 
 
@@ -0,0 +1,100 @@
+/**
+ * @file   thread_pool.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2016 MIT and Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file implements class ThreadPool.
+ */
+
+#include "thread_pool.h"
+
+
+
+
+/* ****************************** */
+/*   CONSTRUCTORS & DESTRUCTORS   */
+/* ****************************** */
+
+ThreadPool::ThreadPool(int thread_num) {
+  stop_ = false;
+  thread_num_ = (thread_num > 0) ? thread_num : 1;
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+
+  for(int i=0; i<int(threads_.size()); ++i)
+    threads_[i].join();
+}
+
+
+
+
+/* ****************************** */
+/*            MUTATORS            */
+/* ****************************** */
+
+void ThreadPool::schedule(const std::function<void()>& task) {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    tasks_.push_back(task);
+
+    // Spawn the workers upon the first task
+    if(threads_.empty())
+      for(int i=0; i<thread_num_; ++i)
+        threads_.push_back(std::thread(&ThreadPool::worker, this));
+  }
+  cv_.notify_one();
+}
+
+
+
+
+/* ****************************** */
+/*         PRIVATE METHODS        */
+/* ****************************** */
+
+void ThreadPool::worker() {
+  for(;;) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mtx_);
+      cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+
+      // The pending tasks are drained before stopping
+      if(tasks_.empty())
+        return;
+      task = tasks_.front();
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
@@ -38,6 +38,7 @@
 #include <dirent.h>
 #include <fcntl.h>
 #include <iostream>
+#include <limits>
 #include <set>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -339,6 +340,41 @@ off_t file_size(const std::string& filename) {
   return file_size;
 }
 
+template<class T>
+void fill_values(T* buffer, T value, int64_t value_num) {
+  for(int64_t i=0; i<value_num; ++i) 
+    buffer[i] = value;
+}
+
+void gather_cells(
+    const void* cells,
+    size_t cell_size,
+    const int64_t* cell_pos,
+    int64_t cell_num,
+    void* sorted_cells) {
+  // Cells of 4, 8 and 16 bytes are copied with a constant size, which the
+  // compiler turns into plain moves. The buffers may be unaligned (e.g., for
+  // char cells), so they are never accessed through wider pointers.
+  const char* cells_c = static_cast<const char*>(cells);
+  char* sorted_cells_c = static_cast<char*>(sorted_cells);
+  if(cell_size == 4) {
+    for(int64_t i=0; i<cell_num; ++i) 
+      memcpy(sorted_cells_c + 4*i, cells_c + 4*cell_pos[i], 4);
+  } else if(cell_size == 8) {
+    for(int64_t i=0; i<cell_num; ++i) 
+      memcpy(sorted_cells_c + 8*i, cells_c + 8*cell_pos[i], 8);
+  } else if(cell_size == 16) {
+    for(int64_t i=0; i<cell_num; ++i) 
+      memcpy(sorted_cells_c + 16*i, cells_c + 16*cell_pos[i], 16);
+  } else {
+    for(int64_t i=0; i<cell_num; ++i) 
+      memcpy(
+          sorted_cells_c + i*cell_size, 
+          cells_c + cell_pos[i]*cell_size, 
+          cell_size);
+  }
+}
+
 std::vector<std::string> get_dirs(const std::string& dir) {
   std::vector<std::string> dirs;
   std::string new_dir; 
@@ -390,7 +426,8 @@ ssize_t gzip(
     unsigned char* in, 
     size_t in_size,
     unsigned char* out, 
-    size_t out_size) {
+    size_t out_size,
+    int level) {
 
   ssize_t ret;
   unsigned have;
@@ -400,7 +437,7 @@ ssize_t gzip(
   strm.zalloc = Z_NULL;
   strm.zfree = Z_NULL;
   strm.opaque = Z_NULL;
-  ret = deflateInit(&strm, Z_DEFAULT_COMPRESSION);
+  ret = deflateInit(&strm, level);
 
   if(ret != Z_OK) {
     PRINT_ERROR("Cannot compress with GZIP");
@@ -585,6 +622,16 @@ bool is_workspace(const std::string& dir) {
     return false;
 }
 
+template<class T>
+bool overlap(const T* subarray_a, const T* subarray_b, int dim_num) {
+  for(int i=0; i<dim_num; ++i)
+    if(subarray_a[2*i] > subarray_b[2*i+1] || 
+       subarray_a[2*i+1] < subarray_b[2*i])
+      return false;
+
+  return true;
+}
+
 std::string parent_dir(const std::string& dir) {
   // Get real dir
   std::string real_dir = ::real_dir(dir);
@@ -655,6 +702,114 @@ void purge_dots_from_path(std::string& path) {
     path += ((i != 0) ? "/" : "") + final_tokens[i]; 
 }
 
+template<class T>
+uint64_t radix_key(T value) {
+  // Integers: flip the sign bit
+  if(std::numeric_limits<T>::is_integer) {
+    if(sizeof(T) == sizeof(uint32_t))
+      return (uint32_t) value ^ 0x80000000u;
+    else
+      return (uint64_t) value ^ 0x8000000000000000ull;
+  }
+
+  // Floating point numbers (where -0 equals 0): flip all bits of negatives, 
+  // and the sign bit of positives
+  if(value == 0)
+    value = 0;
+  if(sizeof(T) == sizeof(uint32_t)) {
+    uint32_t bits = 0;
+    memcpy(&bits, &value, sizeof(T));
+    return (bits & 0x80000000u) ? (uint32_t) ~bits : bits ^ 0x80000000u;
+  } else {
+    uint64_t bits = 0;
+    memcpy(&bits, &value, sizeof(T));
+    return (bits & 0x8000000000000000ull) ? ~bits 
+                                          : bits ^ 0x8000000000000000ull;
+  }
+}
+
+void radix_sort(
+    std::vector<uint64_t>& keys, 
+    std::vector<int64_t>& values,
+    int thread_num) {
+  // For easy reference
+  int64_t key_num = keys.size();
+  assert(values.size() == key_num);
+
+  // Trivial case
+  if(key_num <= 1)
+    return;
+
+  // Find the key range, which determines the bytes to be sorted on
+  uint64_t min_key = keys[0], max_key = keys[0];
+  #pragma omp parallel for reduction(min:min_key) reduction(max:max_key) \
+      num_threads(thread_num)
+  for(int64_t i=1; i<key_num; ++i) {
+    min_key = std::min(min_key, keys[i]);
+    max_key = std::max(max_key, keys[i]);
+  }
+  int byte_num = 0;
+  for(uint64_t range = max_key - min_key; range != 0; range >>= 8)
+    ++byte_num;
+
+  // Split the keys into chunks, each histogrammed and scattered by a thread
+  int chunk_num = std::min<int64_t>(
+                      TILEDB_RADIX_SORT_MAX_CHUNK_NUM,
+                      std::max<int64_t>(
+                          1, 
+                          key_num / TILEDB_RADIX_SORT_MIN_CHUNK_SIZE));
+  int64_t chunk_size = (key_num + chunk_num - 1) / chunk_num;
+  std::vector<int64_t> offsets(chunk_num * 256);
+  std::vector<uint64_t> keys_tmp(key_num);
+  std::vector<int64_t> values_tmp(key_num);
+
+  // One counting sort pass per byte, from the least significant one
+  for(int b=0; b<byte_num; ++b) {
+    int shift = 8 * b;
+
+    // Count the occurrences of each byte value in each chunk
+    std::fill(offsets.begin(), offsets.end(), 0);
+    #pragma omp parallel for if(chunk_num > 1) num_threads(thread_num)
+    for(int c=0; c<chunk_num; ++c) {
+      int64_t* chunk_offsets = &offsets[c * 256];
+      int64_t end = std::min(key_num, (c + 1) * chunk_size);
+      for(int64_t i = c * chunk_size; i<end; ++i) 
+        ++chunk_offsets[((keys[i] - min_key) >> shift) & 0xff];
+    }
+
+    // Compute where each chunk places each byte value, skipping the pass if
+    // all the keys have the same byte value
+    int64_t offset = 0;
+    bool skip = false;
+    for(int v=0; v<256 && !skip; ++v) {
+      int64_t value_offset = offset;
+      for(int c=0; c<chunk_num; ++c) {
+        int64_t count = offsets[c * 256 + v];
+        offsets[c * 256 + v] = offset;
+        offset += count;
+      }
+      skip = (offset - value_offset == key_num);
+    }
+    if(skip)
+      continue;
+
+    // Scatter the keys and values
+    #pragma omp parallel for if(chunk_num > 1) num_threads(thread_num)
+    for(int c=0; c<chunk_num; ++c) {
+      int64_t* chunk_offsets = &offsets[c * 256];
+      int64_t end = std::min(key_num, (c + 1) * chunk_size);
+      for(int64_t i = c * chunk_size; i<end; ++i) {
+        int64_t& pos = chunk_offsets[((keys[i] - min_key) >> shift) & 0xff];
+        keys_tmp[pos] = keys[i];
+        values_tmp[pos] = values[i];
+        ++pos;
+      }
+    }
+    keys.swap(keys_tmp);
+    values.swap(values_tmp);
+  }
+}
+
 int read_from_file(
     const std::string& filename,
     off_t offset,
@@ -975,6 +1130,21 @@ template void expand_mbr<double>(
     const double* coords, 
     int dim_num);
 
+template void fill_values<int>(int* buffer, int value, int64_t value_num);
+template void fill_values<int64_t>(
+    int64_t* buffer, 
+    int64_t value, 
+    int64_t value_num);
+template void fill_values<float>(
+    float* buffer, 
+    float value, 
+    int64_t value_num);
+template void fill_values<double>(
+    double* buffer, 
+    double value, 
+    int64_t value_num);
+template void fill_values<char>(char* buffer, char value, int64_t value_num);
+
 template bool has_duplicates<std::string>(const std::vector<std::string>& v);
 
 template bool inside_subarray<int>(
@@ -1003,3 +1173,25 @@ template bool is_unary_subarray<int64_t>(const int64_t* subarray, int dim_num);
 template bool is_unary_subarray<float>(const float* subarray, int dim_num);
 template bool is_unary_subarray<double>(const double* subarray, int dim_num);
 
+template bool overlap<int>(
+    const int* subarray_a, 
+    const int* subarray_b, 
+    int dim_num);
+template bool overlap<int64_t>(
+    const int64_t* subarray_a, 
+    const int64_t* subarray_b, 
+    int dim_num);
+template bool overlap<float>(
+    const float* subarray_a, 
+    const float* subarray_b, 
+    int dim_num);
+template bool overlap<double>(
+    const double* subarray_a, 
+    const double* subarray_b, 
+    int dim_num);
+
+template uint64_t radix_key<int>(int value);
+template uint64_t radix_key<int64_t>(int64_t value);
+template uint64_t radix_key<float>(float value);
+template uint64_t radix_key<double>(double value);
+
@@ -35,11 +35,15 @@
 #include <cstring>
 #include <dirent.h>
 #include <fcntl.h>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <utils.h>
+#include "array_metadata_cache.h"
+#include "tile_cache.h"
 
 /* ****************************** */
 /*             MACROS             */
@@ -67,9 +71,14 @@
 /* ****************************** */
 
 StorageManager::StorageManager() {
+  aio_thread_num_ = TILEDB_AIO_THREAD_NUM;
+  aio_thread_pool_ = NULL;
+  consolidation_buffer_size_ = TILEDB_CONSOLIDATION_BUFFER_SIZE;
 }
 
 StorageManager::~StorageManager() {
+  if(aio_thread_pool_ != NULL)
+    delete aio_thread_pool_;
 }
 
 
@@ -79,6 +88,129 @@ StorageManager::~StorageManager() {
 /*             MUTATORS           */
 /* ****************************** */
 
+int StorageManager::config_set_parameter(
+    const std::string& parameter,
+    const std::string& value) {
+  // Sanity check
+  if(value == "") {
+    PRINT_ERROR(std::string("Cannot set configuration parameter; "
+                "Missing value for parameter '") + parameter + "'");
+    return TILEDB_SM_ERR;
+  }
+
+  // The parameters tuning the arrays
+  if(Config::has_parameter(parameter)) {
+    if(config_.set(parameter, value) != TILEDB_CF_OK)
+      return TILEDB_SM_ERR;
+    else
+      return TILEDB_SM_OK;
+  }
+
+  // The parameters of the context
+  if(parameter == TILEDB_SM_CONFIG_TILE_CACHE_SIZE) {
+    char* end;
+    errno = 0;
+    unsigned long long tile_cache_size = strtoull(value.c_str(), &end, 10);
+    if(errno || *end != '\0' || value[0] == '-') {
+      PRINT_ERROR(std::string("Cannot set configuration parameter; "
+                  "Invalid value '") + value + "' for parameter '" + 
+                  parameter + "'");
+      return TILEDB_SM_ERR;
+    }
+    TileCache::instance()->set_capacity(tile_cache_size);
+  } else if(parameter == TILEDB_SM_CONFIG_ARRAY_METADATA_CACHE_SIZE) {
+    char* end;
+    errno = 0;
+    unsigned long long array_metadata_cache_size = 
+        strtoull(value.c_str(), &end, 10);
+    if(errno || *end != '\0' || value[0] == '-') {
+      PRINT_ERROR(std::string("Cannot set configuration parameter; "
+                  "Invalid value '") + value + "' for parameter '" + 
+                  parameter + "'");
+      return TILEDB_SM_ERR;
+    }
+    ArrayMetadataCache::instance()->set_capacity(array_metadata_cache_size);
+  } else if(parameter == TILEDB_SM_CONFIG_AIO_THREAD_NUM) {
+    char* end;
+    errno = 0;
+    long aio_thread_num = strtol(value.c_str(), &end, 10);
+    if(errno || *end != '\0' || aio_thread_num <= 0 || 
+       aio_thread_num > INT_MAX) {
+      PRINT_ERROR(std::string("Cannot set configuration parameter; "
+                  "Invalid value '") + value + "' for parameter '" + 
+                  parameter + "'");
+      return TILEDB_SM_ERR;
+    }
+    aio_thread_num_ = aio_thread_num;
+
+    // Replace the asynchronous I/O threads, once the pending requests 
+    // are served
+    if(aio_thread_pool_ != NULL) {
+      delete aio_thread_pool_;
+      aio_thread_pool_ = new ThreadPool(aio_thread_num_);
+    }
+  } else if(parameter == TILEDB_SM_CONFIG_CONSOLIDATION_BUFFER_SIZE) {
+    char* end;
+    errno = 0;
+    unsigned long long consolidation_buffer_size = 
+        strtoull(value.c_str(), &end, 10);
+    if(errno || *end != '\0' || value[0] == '-' || 
+       consolidation_buffer_size == 0) {
+      PRINT_ERROR(std::string("Cannot set configuration parameter; "
+                  "Invalid value '") + value + "' for parameter '" + 
+                  parameter + "'");
+      return TILEDB_SM_ERR;
+    }
+    consolidation_buffer_size_ = consolidation_buffer_size;
+  } else if(parameter == TILEDB_SM_CONFIG_CONSOLIDATION_MODE) {
+    if(value == "all") {
+      consolidation_policy_.mode_ = TILEDB_CONSOLIDATION_ALL;
+    } else if(value == "tiered") {
+      consolidation_policy_.mode_ = TILEDB_CONSOLIDATION_TIERED;
+    } else {
+      PRINT_ERROR(std::string("Cannot set configuration parameter; "
+                  "Invalid value '") + value + "' for parameter '" + 
+                  parameter + "'");
+      return TILEDB_SM_ERR;
+    }
+  } else if(parameter == TILEDB_SM_CONFIG_CONSOLIDATION_TIER_SIZE_RATIO) {
+    char* end;
+    errno = 0;
+    double tier_size_ratio = strtod(value.c_str(), &end);
+    if(errno || *end != '\0' || !(tier_size_ratio >= 1)) {
+      PRINT_ERROR(std::string("Cannot set configuration parameter; "
+                  "Invalid value '") + value + "' for parameter '" + 
+                  parameter + "'");
+      return TILEDB_SM_ERR;
+    }
+    consolidation_policy_.tier_size_ratio_ = tier_size_ratio;
+  } else if(
+      parameter == TILEDB_SM_CONFIG_CONSOLIDATION_TIER_MIN_FRAGMENT_NUM ||
+      parameter == TILEDB_SM_CONFIG_CONSOLIDATION_TIER_MAX_FRAGMENT_NUM) {
+    char* end;
+    errno = 0;
+    long fragment_num = strtol(value.c_str(), &end, 10);
+    if(errno || *end != '\0' || fragment_num < 2 || 
+       fragment_num > INT_MAX) {
+      PRINT_ERROR(std::string("Cannot set configuration parameter; "
+                  "Invalid value '") + value + "' for parameter '" + 
+                  parameter + "'");
+      return TILEDB_SM_ERR;
+    }
+    if(parameter == TILEDB_SM_CONFIG_CONSOLIDATION_TIER_MIN_FRAGMENT_NUM)
+      consolidation_policy_.tier_min_fragment_num_ = fragment_num;
+    else
+      consolidation_policy_.tier_max_fragment_num_ = fragment_num;
+  } else {
+    PRINT_ERROR(std::string("Cannot set configuration parameter; "
+                "Unknown parameter '") + parameter + "'");
+    return TILEDB_SM_ERR;
+  }
+
+  // Success
+  return TILEDB_SM_OK;
+}
+
 int StorageManager::init(const char* config_filename) {
   // Set configuration parameters
   if(config_filename == NULL)
@@ -86,6 +218,9 @@ int StorageManager::init(const char* config_filename) {
   else if(config_set(config_filename) != TILEDB_SM_OK)
     return TILEDB_SM_ERR;
 
+  // Create the asynchronous I/O threads (spawned upon the first request)
+  aio_thread_pool_ = new ThreadPool(aio_thread_num_);
+
   // Set the TileDB home directory
   tiledb_home_ = TILEDB_HOME;
   if(tiledb_home_ == "") {
@@ -252,6 +387,70 @@ int StorageManager::group_create(const std::string& group) const {
 /*             ARRAY              */
 /* ****************************** */
 
+int StorageManager::array_aio_read(
+    Array* array, 
+    AIO_Request* aio_request) const {
+  // Sanity check
+  if(array == NULL) {
+    PRINT_ERROR("Cannot submit asynchronous read; Invalid array");
+    return TILEDB_SM_ERR;
+  }
+
+  // Submit the request
+  if(array->aio_read(aio_request, aio_thread_pool_) != TILEDB_AR_OK)
+    return TILEDB_SM_ERR;
+  else
+    return TILEDB_SM_OK;
+}
+
+int StorageManager::array_config_set(
+    const char* array_dir,
+    const std::string& parameter,
+    const std::string& value) {
+  // Check the parameter and its value
+  Config config;
+  if(!Config::has_parameter(parameter)) {
+    PRINT_ERROR(std::string("Cannot set array configuration parameter; "
+                "Parameter '") + parameter + "' cannot be set per array");
+    return TILEDB_SM_ERR;
+  }
+  if(config.set(parameter, value) != TILEDB_CF_OK)
+    return TILEDB_SM_ERR;
+
+  // Check if the array exists
+  std::string real_array_dir = ::real_dir(array_dir);
+  if(!is_array(real_array_dir) && !is_metadata(real_array_dir)) {
+    PRINT_ERROR(std::string("Cannot set array configuration parameter; "
+                "Array '") + real_array_dir + "' does not exist");
+    return TILEDB_SM_ERR;
+  }
+
+  // Keep the override
+  array_config_params_[real_array_dir].push_back(
+      std::pair<std::string, std::string>(parameter, value));
+
+  // Success
+  return TILEDB_SM_OK;
+}
+
+int StorageManager::array_consolidate(
+    Array* array,
+    const ConsolidationPolicy* policy) const {
+  // Sanity check
+  if(array == NULL) {
+    PRINT_ERROR("Cannot consolidate array; Invalid array");
+    return TILEDB_SM_ERR;
+  }
+
+  // Consolidate
+  if(policy == NULL)
+    policy = &consolidation_policy_;
+  if(array->consolidate(policy, consolidation_buffer_size_) != TILEDB_AR_OK)
+    return TILEDB_SM_ERR;
+  else
+    return TILEDB_SM_OK;
+}
+
 int StorageManager::array_create(const ArraySchemaC* array_schema_c) const {
   // Initialize array schema
   ArraySchema* array_schema = new ArraySchema();
@@ -333,7 +532,7 @@ int StorageManager::array_create(const ArraySchema* array_schema) const {
 
 int StorageManager::array_load_schema(
     const char* array_dir,
-    ArraySchema*& array_schema) const {
+    const ArraySchema*& array_schema) const {
   // Get real array path
   std::string real_array_dir = ::real_dir(array_dir);
 
@@ -344,8 +543,19 @@ int StorageManager::array_load_schema(
     return TILEDB_SM_ERR;
   }
 
-  // Open array schema file
+  // Look up the array schema in the cache
   std::string filename = real_array_dir + "/" + TILEDB_ARRAY_SCHEMA_FILENAME;
+  struct stat st;
+  if(stat(filename.c_str(), &st) == 0) {
+    array_schema = 
+        ArrayMetadataCache::instance()->acquire_array_schema(
+            real_array_dir, 
+            st);
+    if(array_schema != NULL)
+      return TILEDB_SM_OK;
+  }
+
+  // Open array schema file
   int fd = ::open(filename.c_str(), O_RDONLY);
   if(fd == -1) {
     PRINT_ERROR("Cannot load schema; File opening error");
@@ -353,7 +563,6 @@ int StorageManager::array_load_schema(
   }
 
   // Initialize buffer
-  struct stat st;
   fstat(fd, &st);
   ssize_t buffer_size = st.st_size;
   if(buffer_size == 0) {
@@ -371,21 +580,27 @@ int StorageManager::array_load_schema(
   } 
 
   // Initialize array schema
-  array_schema = new ArraySchema();
-  if(array_schema->deserialize(buffer, buffer_size) != TILEDB_AS_OK) {
+  ArraySchema* new_array_schema = new ArraySchema();
+  if(new_array_schema->deserialize(buffer, buffer_size) != TILEDB_AS_OK) {
     free(buffer);
-    delete array_schema;
+    delete new_array_schema;
     return TILEDB_SM_ERR;
   }
 
   // Clean up
   free(buffer);
   if(::close(fd)) {
-    delete array_schema;
+    delete new_array_schema;
     PRINT_ERROR("Cannot load array schema; File closing error");
     return TILEDB_SM_ERR;
   }
 
+  // Cache the array schema
+  array_schema = ArrayMetadataCache::instance()->insert_array_schema(
+                     real_array_dir, 
+                     st,
+                     new_array_schema);
+
   // Success
   return TILEDB_SM_OK;
 }
@@ -398,14 +613,21 @@ int StorageManager::array_init(
     const char** attributes,
     int attribute_num)  const {
   // Load array schema
-  ArraySchema* array_schema;
+  const ArraySchema* array_schema;
   if(array_load_schema(array_dir, array_schema) != TILEDB_SM_OK)
     return TILEDB_SM_ERR;
 
   // Create Array object
+  Config config;
+  array_config_get(array_dir, config);
   array = new Array();
-  if(array->init(array_schema, mode, attributes, attribute_num, subarray) !=
-     TILEDB_AR_OK) {
+  if(array->init(
+         array_schema, 
+         mode, 
+         attributes, 
+         attribute_num, 
+         subarray, 
+         &config) != TILEDB_AR_OK) {
     delete array;
     array = NULL;
     return TILEDB_SM_ERR;
@@ -439,18 +661,21 @@ int StorageManager::array_iterator_init(
     void** buffers,
     size_t* buffer_sizes)  const {
   // Load array schema
-  ArraySchema* array_schema;
+  const ArraySchema* array_schema;
   if(array_load_schema(array_dir, array_schema) != TILEDB_SM_OK)
     return TILEDB_SM_ERR;
 
   // Create Array object
+  Config config;
+  array_config_get(array_dir, config);
   Array* array = new Array();
   if(array->init(
          array_schema, 
          TILEDB_ARRAY_READ, 
          attributes, 
          attribute_num, 
-         subarray) != TILEDB_AR_OK) {
+         subarray,
+         &config) != TILEDB_AR_OK) {
     delete array;
     array_it = NULL;
     return TILEDB_SM_ERR;
@@ -493,6 +718,22 @@ int StorageManager::array_iterator_finalize(
 /*            METADATA            */
 /* ****************************** */
 
+int StorageManager::metadata_consolidate(Metadata* metadata) const {
+  // Sanity check
+  if(metadata == NULL) {
+    PRINT_ERROR("Cannot consolidate metadata; Invalid metadata");
+    return TILEDB_SM_ERR;
+  }
+
+  // Consolidate
+  if(metadata->consolidate(
+         &consolidation_policy_, 
+         consolidation_buffer_size_) != TILEDB_MT_OK)
+    return TILEDB_SM_ERR;
+  else
+    return TILEDB_SM_OK;
+}
+
 int StorageManager::metadata_create(
     const MetadataSchemaC* metadata_schema_c) const {
   // Initialize array schema
@@ -576,7 +817,7 @@ int StorageManager::metadata_create(const ArraySchema* array_schema) const {
 
 int StorageManager::metadata_load_schema(
     const char* metadata_dir,
-    ArraySchema*& array_schema) const {
+    const ArraySchema*& array_schema) const {
   // Get real array path
   std::string real_metadata_dir = ::real_dir(metadata_dir);
 
@@ -587,9 +828,20 @@ int StorageManager::metadata_load_schema(
     return TILEDB_SM_ERR;
   }
 
-  // Open array schema file
+  // Look up the metadata schema in the cache
   std::string filename = 
       real_metadata_dir + "/" + TILEDB_METADATA_SCHEMA_FILENAME;
+  struct stat st;
+  if(stat(filename.c_str(), &st) == 0) {
+    array_schema = 
+        ArrayMetadataCache::instance()->acquire_array_schema(
+            real_metadata_dir, 
+            st);
+    if(array_schema != NULL)
+      return TILEDB_SM_OK;
+  }
+
+  // Open array schema file
   int fd = ::open(filename.c_str(), O_RDONLY);
   if(fd == -1) {
     PRINT_ERROR("Cannot load metadata schema; File opening error");
@@ -597,7 +849,6 @@ int StorageManager::metadata_load_schema(
   }
 
   // Initialize buffer
-  struct stat st;
   fstat(fd, &st);
   ssize_t buffer_size = st.st_size;
   if(buffer_size == 0) {
@@ -615,21 +866,27 @@ int StorageManager::metadata_load_schema(
   } 
 
   // Initialize array schema
-  array_schema = new ArraySchema();
-  if(array_schema->deserialize(buffer, buffer_size) == TILEDB_AS_ERR) {
+  ArraySchema* new_array_schema = new ArraySchema();
+  if(new_array_schema->deserialize(buffer, buffer_size) == TILEDB_AS_ERR) {
     free(buffer);
-    delete array_schema;
+    delete new_array_schema;
     return TILEDB_SM_ERR;
   }
 
   // Clean up
   free(buffer);
   if(::close(fd)) {
-    delete array_schema;
+    delete new_array_schema;
     PRINT_ERROR("Cannot load metadata schema; File closing error");
     return TILEDB_SM_ERR;
   }
 
+  // Cache the array schema
+  array_schema = ArrayMetadataCache::instance()->insert_array_schema(
+                     real_metadata_dir, 
+                     st,
+                     new_array_schema);
+
   // Success
   return TILEDB_SM_OK;
 }
@@ -641,13 +898,20 @@ int StorageManager::metadata_init(
     const char** attributes,
     int attribute_num)  const {
   // Load metadata schema
-  ArraySchema* array_schema;
+  const ArraySchema* array_schema;
   if(metadata_load_schema(metadata_dir, array_schema) != TILEDB_SM_OK)
     return TILEDB_SM_ERR;
 
   // Create metadata object
+  Config config;
+  array_config_get(metadata_dir, config);
   metadata = new Metadata();
-  int rc = metadata->init(array_schema, mode, attributes, attribute_num);
+  int rc = metadata->init(
+               array_schema, 
+               mode, 
+               attributes, 
+               attribute_num, 
+               &config);
 
   // Return
   if(rc != TILEDB_MT_OK) {
@@ -683,18 +947,20 @@ int StorageManager::metadata_iterator_init(
     void** buffers,
     size_t* buffer_sizes)  const {
   // Load metadata schema
-  ArraySchema* array_schema;
+  const ArraySchema* array_schema;
   if(metadata_load_schema(metadata_dir, array_schema) != TILEDB_SM_OK)
     return TILEDB_SM_ERR;
 
   // Create metadata object
+  Config config;
+  array_config_get(metadata_dir, config);
   Metadata* metadata = new Metadata();
   if(metadata->init(
          array_schema, 
          TILEDB_METADATA_READ, 
          attributes, 
-         attribute_num) !=
-     TILEDB_MT_OK) {
+         attribute_num,
+         &config) != TILEDB_MT_OK) {
     delete metadata;
     metadata_it = NULL;
     return TILEDB_SM_ERR;
@@ -904,6 +1170,8 @@ int StorageManager::array_clear(
     if(is_metadata(filename)) {         // Metadata
       metadata_delete(filename);
     } else if(is_fragment(filename)){   // Fragment
+      TileCache::instance()->invalidate(filename);
+      ArrayMetadataCache::instance()->invalidate(filename);
       if(delete_dir(filename) != TILEDB_UT_OK)
         return TILEDB_SM_ERR;
     } else {                            // Non TileDB related
@@ -924,6 +1192,22 @@ int StorageManager::array_clear(
   return TILEDB_SM_OK;
 }
 
+void StorageManager::array_config_get(
+    const char* array_dir,
+    Config& config) const {
+  // Start from the parameters of the context
+  config = config_;
+
+  // Apply the overrides of the array, if any
+  std::map<std::string, 
+           std::vector<std::pair<std::string, std::string> > >::const_iterator
+      it = array_config_params_.find(::real_dir(array_dir));
+  if(it == array_config_params_.end())
+    return;
+  for(int i=0; i<int(it->second.size()); ++i) 
+    config.set(it->second[i].first, it->second[i].second);
+}
+
 int StorageManager::array_delete(
     const std::string& array) const {
   // Clear the array
@@ -931,6 +1215,8 @@ int StorageManager::array_delete(
     return TILEDB_SM_ERR;
 
   // Delete array directory
+  TileCache::instance()->invalidate(::real_dir(array));
+  ArrayMetadataCache::instance()->invalidate(::real_dir(array));
   if(delete_dir(array) != TILEDB_UT_OK)
     return TILEDB_SM_ERR; 
 
@@ -974,17 +1260,76 @@ int StorageManager::array_move(
                 strerror(errno));
     return TILEDB_SM_ERR;
   }
+  TileCache::instance()->invalidate(old_array_real);
+  ArrayMetadataCache::instance()->invalidate(old_array_real);
 
   // Success
   return TILEDB_SM_OK;
 }
 
+bool StorageManager::config_has_parameter(const std::string& parameter) {
+  return Config::has_parameter(parameter) ||
+         parameter == TILEDB_SM_CONFIG_TILE_CACHE_SIZE ||
+         parameter == TILEDB_SM_CONFIG_ARRAY_METADATA_CACHE_SIZE ||
+         parameter == TILEDB_SM_CONFIG_AIO_THREAD_NUM ||
+         parameter == TILEDB_SM_CONFIG_CONSOLIDATION_BUFFER_SIZE ||
+         parameter == TILEDB_SM_CONFIG_CONSOLIDATION_MODE ||
+         parameter == TILEDB_SM_CONFIG_CONSOLIDATION_TIER_SIZE_RATIO ||
+         parameter == TILEDB_SM_CONFIG_CONSOLIDATION_TIER_MIN_FRAGMENT_NUM ||
+         parameter == TILEDB_SM_CONFIG_CONSOLIDATION_TIER_MAX_FRAGMENT_NUM;
+}
+
 int StorageManager::config_set(const char* config_filename) {
+  // Start from the default values
+  config_set_default();
+
+  // Open configuration file
+  std::ifstream config_file(config_filename);
+  if(!config_file.is_open()) {
+    PRINT_ERROR(std::string("Cannot set configuration parameters; "
+                "Cannot open file '") + config_filename + "'");
+    return TILEDB_SM_ERR;
+  }
+
+  // Parse the parameters, one per line
+  std::string line, parameter, value;
+  while(std::getline(config_file, line)) {
+    std::istringstream line_ss(line);
+    if(!(line_ss >> parameter) || parameter[0] == '#') // Empty line or comment
+      continue;
+    if(!(line_ss >> value)) {
+      PRINT_ERROR(std::string("Cannot set configuration parameters; "
+                  "Missing value for parameter '") + parameter + "'");
+      return TILEDB_SM_ERR;
+    }
+
+    if(!config_has_parameter(parameter)) {
+      PRINT_WARNING(std::string("Ignoring unknown configuration parameter '") +
+                    parameter + "'");
+      continue;
+    }
+    if(config_set_parameter(parameter, value) != TILEDB_SM_OK)
+      return TILEDB_SM_ERR;
+  }
+
   // Success
   return TILEDB_SM_OK;
 } 
 
 void StorageManager::config_set_default() {
+  // The process-wide caches keep their capacities, which start at their
+  // defaults and change only when set explicitly
+  aio_thread_num_ = TILEDB_AIO_THREAD_NUM;
+  consolidation_buffer_size_ = TILEDB_CONSOLIDATION_BUFFER_SIZE;
+  consolidation_policy_.mode_ = TILEDB_CONSOLIDATION_MODE;
+  consolidation_policy_.tier_size_ratio_ = 
+      TILEDB_CONSOLIDATION_TIER_SIZE_RATIO;
+  consolidation_policy_.tier_min_fragment_num_ = 
+      TILEDB_CONSOLIDATION_TIER_MIN_FRAGMENT_NUM;
+  consolidation_policy_.tier_max_fragment_num_ = 
+      TILEDB_CONSOLIDATION_TIER_MAX_FRAGMENT_NUM;
+  consolidation_policy_.subarray_ = NULL;
+  config_.set_default();
 }
 
 int StorageManager::create_group_file(const std::string& group) const {
@@ -1176,6 +1521,8 @@ int StorageManager::group_move(
                 strerror(errno));
     return TILEDB_SM_ERR;
   }
+  TileCache::instance()->invalidate(old_group_real);
+  ArrayMetadataCache::instance()->invalidate(old_group_real);
 
   // Success
   return TILEDB_SM_OK;
@@ -1193,7 +1540,7 @@ int StorageManager::master_catalog_consolidate() const {
     return TILEDB_SM_ERR;
   
   // Consolidate master catalog
-  if(metadata->consolidate() != TILEDB_MT_OK)
+  if(metadata_consolidate(metadata) != TILEDB_SM_OK)
     return TILEDB_SM_ERR;
 
   // Finalize master catalog
@@ -1259,6 +1606,8 @@ int StorageManager::metadata_clear(
       continue;
     filename = metadata_real + "/" + next_file->d_name;
     if(is_fragment(filename)) {  // Fragment
+      TileCache::instance()->invalidate(filename);
+      ArrayMetadataCache::instance()->invalidate(filename);
       if(delete_dir(filename))
         return TILEDB_SM_ERR;
     } else {                     // Non TileDB related
@@ -1289,6 +1638,8 @@ int StorageManager::metadata_delete(
     return TILEDB_SM_ERR;
 
   // Delete metadata directory
+  TileCache::instance()->invalidate(metadata_real);
+  ArrayMetadataCache::instance()->invalidate(metadata_real);
   if(delete_dir(metadata_real))
     return TILEDB_SM_ERR; 
 
@@ -1333,6 +1684,8 @@ int StorageManager::metadata_move(
                 strerror(errno));
     return TILEDB_SM_ERR;
   }
+  TileCache::instance()->invalidate(old_metadata_real);
+  ArrayMetadataCache::instance()->invalidate(old_metadata_real);
 
   // Success
   return TILEDB_SM_OK;
@@ -1483,6 +1836,8 @@ int StorageManager::workspace_move(
                 strerror(errno));
     return TILEDB_SM_ERR;
   }
+  TileCache::instance()->invalidate(old_workspace_real);
+  ArrayMetadataCache::instance()->invalidate(old_workspace_real);
 
   // Update master catalog by adding new workspace 
   if(create_master_catalog_entry(old_workspace_real, TILEDB_SM_MC_DEL) !=
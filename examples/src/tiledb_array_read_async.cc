@@ -0,0 +1,104 @@
+/**
+ * @file   tiledb_array_read_async.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ * 
+ * @copyright Copyright (c) 2016 MIT and Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * 
+ * @section DESCRIPTION
+ *
+ * It shows how to read asynchronously from a dense array, resubmitting the
+ * read request upon buffer overflow.
+ */
+
+#include "c_api.h"
+#include <cstdio>
+#include <unistd.h>
+
+// Invoked by TileDB upon the completion of a read request
+void print_upon_completion(void* data) {
+  printf("%s\n", (char*) data);
+}
+
+int main() {
+  // Initialize context with the default configuration parameters
+  TileDB_CTX* tiledb_ctx;
+  tiledb_ctx_init(&tiledb_ctx, NULL);
+
+  // Subarray and attributes
+  int64_t subarray[] = { 3, 4, 2, 4 }; 
+  const char* attributes[] = { "a1" };
+
+  // Initialize array 
+  TileDB_Array* tiledb_array;
+  tiledb_array_init(
+      tiledb_ctx,                                       // Context
+      &tiledb_array,                                    // Array object
+      "my_workspace/dense_arrays/my_array_A",           // Array name
+      TILEDB_ARRAY_READ,                                // Mode
+      NULL,                                             // Whole domain
+      attributes,                                       // Subset on attributes
+      1);                                               // Number of attributes
+
+  // Prepare cell buffers 
+  int buffer_a1[3];
+  void* buffers[] = { buffer_a1 };
+  size_t buffer_sizes[1];
+
+  // Prepare the read request
+  char completion_message[] = "Read completed";
+  TileDB_AIO_Request tiledb_aio_request = {};
+  tiledb_aio_request.buffers_ = buffers;
+  tiledb_aio_request.buffer_sizes_ = buffer_sizes;
+  tiledb_aio_request.completion_handle_ = print_upon_completion;
+  tiledb_aio_request.completion_data_ = completion_message;
+  tiledb_aio_request.subarray_ = subarray;
+
+  // Loop until no overflow
+  printf(" a1\n----\n");
+  do {
+    // Submit the read request
+    buffer_sizes[0] = sizeof(buffer_a1);
+    tiledb_array_read_async(tiledb_array, &tiledb_aio_request); 
+
+    // Do other work while waiting for the request to complete
+    while(tiledb_aio_request.status_ == TILEDB_AIO_INPROGRESS) 
+      usleep(1000);
+
+    // Any resubmission continues from where the previous read stopped 
+    tiledb_aio_request.subarray_ = NULL;
+
+    // Print cell values
+    int64_t result_num = buffer_sizes[0] / sizeof(int);
+    for(int i=0; i<result_num; ++i) 
+      printf("%3d\n", buffer_a1[i]);
+  } while(tiledb_aio_request.status_ == TILEDB_AIO_OVERFLOW);
+ 
+  // Finalize the array
+  tiledb_array_finalize(tiledb_array);
+
+  /* Finalize context. */
+  tiledb_ctx_finalize(tiledb_ctx);
+
+  return 0;
+}
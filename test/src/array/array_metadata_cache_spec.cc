@@ -0,0 +1,317 @@
+/**
+ * Copyright (c) 2016  Massachusetts Institute of Technology and Intel Corp.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Tests to check that reopened arrays reuse the cached schemas and
+ * book-keeping structures, and that consolidation drops the cached
+ * book-keeping of the fragments it deletes
+ */
+
+#include <gtest/gtest.h>
+#include "array_metadata_cache.h"
+#include "c_api.h"
+#include "utils.h"
+#include <cstdlib>
+#include <dirent.h>
+#include <map>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+class ArrayMetadataCacheTest: public testing::Test {
+  const std::string WORKSPACE = ".__workspace/";
+  const std::string ARRAYNAME = "sparse_test_100x100_10x10";
+
+public:
+  // TileDB context
+  TileDB_CTX* tiledb_ctx;
+  // Array name is initialized with the workspace folder
+  std::string array_name;
+
+  const ArraySchema* acquire_array_schema();
+  int consolidate();
+  int create_array();
+  std::vector<std::string> fragment_names();
+  std::map<int64_t, int> read_array();
+  int write_cells(int64_t first_row, int value);
+
+  virtual void SetUp() {
+    // Initialize context with the default configuration parameters
+    tiledb_ctx_init(&tiledb_ctx, NULL);
+    if (tiledb_workspace_create(
+        tiledb_ctx,
+        WORKSPACE.c_str()) != TILEDB_OK) {
+      exit(EXIT_FAILURE);
+    }
+
+    array_name.append(WORKSPACE);
+    array_name.append(ARRAYNAME);
+
+    // Start without the entries cached by other tests
+    ArrayMetadataCache::instance()->clear();
+  }
+
+  virtual void TearDown() {
+    // Finalize TileDB context
+    tiledb_ctx_finalize(tiledb_ctx);
+
+    // Remove the temporary workspace
+    std::string command = "rm -rf ";
+    command.append(WORKSPACE);
+    int ret = system(command.c_str());
+  }
+};
+
+/**
+ * Look up the cached schema of the array, without keeping a reference on it
+ */
+const ArraySchema* ArrayMetadataCacheTest::acquire_array_schema() {
+  std::string dir = real_dir(array_name);
+  struct stat st;
+  if (stat((dir + "/" + TILEDB_ARRAY_SCHEMA_FILENAME).c_str(), &st) != 0)
+    return NULL;
+  ArrayMetadataCache* cache = ArrayMetadataCache::instance();
+  const ArraySchema* array_schema = cache->acquire_array_schema(dir, st);
+  if (array_schema != NULL)
+    cache->release_array_schema(array_schema);
+  return array_schema;
+}
+
+/**
+ * Consolidate all the fragments of the array
+ */
+int ArrayMetadataCacheTest::consolidate() {
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_WRITE,
+          NULL,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  int rc = tiledb_array_consolidate(tiledb_array);
+  if (tiledb_array_finalize(tiledb_array) != TILEDB_OK)
+    return TILEDB_ERR;
+  return rc;
+}
+
+/**
+ * Create a sparse 100x100 array with 10x10 tiles and a single int attribute
+ */
+int ArrayMetadataCacheTest::create_array() {
+  const char* attributes[] = { "ATTR_INT32" };
+  const char* dimensions[] = { "X", "Y" };
+  int64_t domain[] = { 0, 99, 0, 99 };
+  int64_t tile_extents[] = { 10, 10 };
+  const int types[] = { TILEDB_INT32, TILEDB_INT64 };
+  const int compression[] = { TILEDB_GZIP, TILEDB_NO_COMPRESSION };
+
+  TileDB_ArraySchema schema;
+  tiledb_array_set_schema(
+      &schema,
+      array_name.c_str(),
+      attributes,
+      1,
+      50,
+      TILEDB_ROW_MAJOR,
+      NULL,
+      compression,
+      0,
+      dimensions,
+      2,
+      domain,
+      4*sizeof(int64_t),
+      tile_extents,
+      2*sizeof(int64_t),
+      0,
+      types);
+
+  int rc = tiledb_array_create(tiledb_ctx, &schema);
+  tiledb_array_free_schema(&schema);
+  return rc;
+}
+
+/**
+ * Return the real directories of the fragments of the array, which name
+ * their cached book-keeping structures
+ */
+std::vector<std::string> ArrayMetadataCacheTest::fragment_names() {
+  std::vector<std::string> names;
+  std::string dir_name = real_dir(array_name);
+  DIR* dir = opendir(dir_name.c_str());
+  if (dir == NULL)
+    return names;
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    std::string name = entry->d_name;
+    if (name.compare(0, 2, "__") == 0 && entry->d_type == DT_DIR)
+      names.push_back(dir_name + "/" + name);
+  }
+  closedir(dir);
+  return names;
+}
+
+/**
+ * Read the entire array and map every cell, keyed by row * 100 + column, to
+ * its value
+ */
+std::map<int64_t, int> ArrayMetadataCacheTest::read_array() {
+  std::map<int64_t, int> cells;
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_READ,
+          NULL,
+          NULL,
+          0) != TILEDB_OK)
+    return cells;
+
+  std::vector<int> buffer_a1(10000);
+  std::vector<int64_t> buffer_coords(20000);
+  void* buffers[] = { &buffer_a1[0], &buffer_coords[0] };
+  size_t buffer_sizes[] = {
+      buffer_a1.size() * sizeof(int),
+      buffer_coords.size() * sizeof(int64_t) };
+  if (tiledb_array_read(tiledb_array, buffers, buffer_sizes) == TILEDB_OK) {
+    int64_t cell_num = buffer_sizes[0] / sizeof(int);
+    for (int64_t i = 0; i < cell_num; ++i)
+      cells[buffer_coords[2*i] * 100 + buffer_coords[2*i+1]] = buffer_a1[i];
+  }
+
+  tiledb_array_finalize(tiledb_array);
+  return cells;
+}
+
+/**
+ * Write a sparse fragment with the cells of 20 rows starting from the input
+ * one, all holding the input value
+ */
+int ArrayMetadataCacheTest::write_cells(int64_t first_row, int value) {
+  // Keep the fragment timestamps distinct, so that the fragment order is
+  // fixed
+  usleep(2000);
+
+  std::vector<int> buffer_a1;
+  std::vector<int64_t> buffer_coords;
+  for (int64_t i = first_row; i < first_row + 20; ++i) {
+    for (int64_t j = 0; j < 100; ++j) {
+      buffer_a1.push_back(value);
+      buffer_coords.push_back(i);
+      buffer_coords.push_back(j);
+    }
+  }
+
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_WRITE_UNSORTED,
+          NULL,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+  const void* buffers[] = { &buffer_a1[0], &buffer_coords[0] };
+  size_t buffer_sizes[] = {
+      buffer_a1.size() * sizeof(int),
+      buffer_coords.size() * sizeof(int64_t) };
+  if (tiledb_array_write(tiledb_array, buffers, buffer_sizes) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  return tiledb_array_finalize(tiledb_array);
+}
+
+/***************************/
+/********** TESTS **********/
+/***************************/
+TEST_F(ArrayMetadataCacheTest, ReopenHitsCache) {
+  ArrayMetadataCache* cache = ArrayMetadataCache::instance();
+  ASSERT_EQ(TILEDB_OK, create_array());
+  ASSERT_EQ(TILEDB_OK, write_cells(0, 1));
+  std::vector<std::string> fragments = fragment_names();
+  ASSERT_EQ(size_t(1), fragments.size());
+
+  // Nothing is cached before the array is read
+  ASSERT_TRUE(cache->acquire_book_keeping(fragments[0]) == NULL);
+
+  // The first read caches the schema and the book-keeping
+  std::map<int64_t, int> cells = read_array();
+  ASSERT_EQ(size_t(2000), cells.size());
+  const ArraySchema* array_schema = acquire_array_schema();
+  ASSERT_TRUE(array_schema != NULL);
+  BookKeeping* book_keeping = cache->acquire_book_keeping(fragments[0]);
+  ASSERT_TRUE(book_keeping != NULL);
+  cache->release_book_keeping(book_keeping);
+
+  // The reopened array reuses them, instead of loading new ones
+  ASSERT_EQ(cells, read_array());
+  ASSERT_EQ(array_schema, acquire_array_schema());
+  BookKeeping* reused_book_keeping = cache->acquire_book_keeping(fragments[0]);
+  ASSERT_EQ(book_keeping, reused_book_keeping);
+  cache->release_book_keeping(reused_book_keeping);
+}
+
+TEST_F(ArrayMetadataCacheTest, ConsolidationInvalidatesBookKeeping) {
+  ArrayMetadataCache* cache = ArrayMetadataCache::instance();
+  ASSERT_EQ(TILEDB_OK, create_array());
+
+  // Two overlapping fragments, both cached by a read
+  ASSERT_EQ(TILEDB_OK, write_cells(0, 1));
+  ASSERT_EQ(TILEDB_OK, write_cells(10, 2));
+  std::vector<std::string> old_fragments = fragment_names();
+  ASSERT_EQ(size_t(2), old_fragments.size());
+  std::map<int64_t, int> cells = read_array();
+  ASSERT_EQ(size_t(3000), cells.size());
+  for (int i = 0; i < 2; ++i) {
+    BookKeeping* book_keeping = cache->acquire_book_keeping(old_fragments[i]);
+    ASSERT_TRUE(book_keeping != NULL);
+    cache->release_book_keeping(book_keeping);
+  }
+
+  // Consolidation drops the book-keeping of the deleted fragments
+  ASSERT_EQ(TILEDB_OK, consolidate());
+  std::vector<std::string> new_fragments = fragment_names();
+  ASSERT_EQ(size_t(1), new_fragments.size());
+  for (int i = 0; i < 2; ++i)
+    ASSERT_TRUE(cache->acquire_book_keeping(old_fragments[i]) == NULL);
+
+  // The next read loads and caches the consolidated fragment, and returns
+  // the same cells
+  ASSERT_EQ(cells, read_array());
+  BookKeeping* book_keeping = cache->acquire_book_keeping(new_fragments[0]);
+  ASSERT_TRUE(book_keeping != NULL);
+  cache->release_book_keeping(book_keeping);
+
+  // A new fragment, cached by the next read, shadows the consolidated one
+  ASSERT_EQ(TILEDB_OK, write_cells(20, 3));
+  for (int64_t i = 2000; i < 3000; ++i)
+    cells[i] = 3;
+  for (int64_t i = 3000; i < 4000; ++i)
+    cells[i] = 3;
+  ASSERT_EQ(cells, read_array());
+}
@@ -0,0 +1,361 @@
+/**
+ * Copyright (c) 2016  Massachusetts Institute of Technology and Intel Corp.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Tests to check that the asynchronous reads return the same cells as the
+ * synchronous ones, in submission order, and that finalization waits for the
+ * pending requests
+ */
+
+#include <gtest/gtest.h>
+#include "c_api.h"
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <unistd.h>
+#include <vector>
+
+class AsyncReadTest: public testing::Test {
+  const std::string WORKSPACE = ".__workspace/";
+  const std::string ARRAYNAME = "test_100x100_10x10";
+
+public:
+  // TileDB context
+  TileDB_CTX* tiledb_ctx;
+  // Array name is initialized with the workspace folder
+  std::string array_name;
+
+  int create_array();
+  int read_array(const int64_t* subarray, std::vector<int>& buffer_a1);
+  void wait(const TileDB_AIO_Request* request);
+  int write_array();
+
+  virtual void SetUp() {
+    // Initialize context with the default configuration parameters
+    tiledb_ctx_init(&tiledb_ctx, NULL);
+    if (tiledb_workspace_create(
+        tiledb_ctx,
+        WORKSPACE.c_str()) != TILEDB_OK) {
+      exit(EXIT_FAILURE);
+    }
+
+    array_name.append(WORKSPACE);
+    array_name.append(ARRAYNAME);
+  }
+
+  virtual void TearDown() {
+    // Finalize TileDB context
+    tiledb_ctx_finalize(tiledb_ctx);
+
+    // Remove the temporary workspace
+    std::string command = "rm -rf ";
+    command.append(WORKSPACE);
+    int ret = system(command.c_str());
+  }
+};
+
+/** Records the order in which the requests complete. */
+class CompletionLog {
+ public:
+  void append(int id) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    ids_.push_back(id);
+  }
+  std::vector<int> ids() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return ids_;
+  }
+ private:
+  std::vector<int> ids_;
+  std::mutex mtx_;
+};
+
+/** The argument of the completion handle of a request. */
+struct CompletionData {
+  CompletionLog* log_;
+  int id_;
+};
+
+/** Appends the id of the completed request to its log. */
+static void log_completion(void* data) {
+  CompletionData* completion_data = static_cast<CompletionData*>(data);
+  completion_data->log_->append(completion_data->id_);
+}
+
+/**
+ * Create a dense 100x100 array with 10x10 tiles and a single int attribute
+ */
+int AsyncReadTest::create_array() {
+  const char* attributes[] = { "ATTR_INT32" };
+  const char* dimensions[] = { "X", "Y" };
+  int64_t domain[] = { 0, 99, 0, 99 };
+  int64_t tile_extents[] = { 10, 10 };
+  const int types[] = { TILEDB_INT32, TILEDB_INT64 };
+  const int compression[] = { TILEDB_GZIP, TILEDB_NO_COMPRESSION };
+
+  TileDB_ArraySchema schema;
+  tiledb_array_set_schema(
+      &schema,
+      array_name.c_str(),
+      attributes,
+      1,
+      0,
+      TILEDB_ROW_MAJOR,
+      NULL,
+      compression,
+      1,
+      dimensions,
+      2,
+      domain,
+      4*sizeof(int64_t),
+      tile_extents,
+      2*sizeof(int64_t),
+      0,
+      types);
+
+  int rc = tiledb_array_create(tiledb_ctx, &schema);
+  tiledb_array_free_schema(&schema);
+  return rc;
+}
+
+/**
+ * Read the subarray synchronously in a single pass
+ */
+int AsyncReadTest::read_array(
+    const int64_t* subarray,
+    std::vector<int>& buffer_a1) {
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_READ,
+          subarray,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  buffer_a1.resize(10000);
+  void* buffers[] = { &buffer_a1[0] };
+  size_t buffer_sizes[] = { buffer_a1.size() * sizeof(int) };
+  int rc = tiledb_array_read(tiledb_array, buffers, buffer_sizes);
+  buffer_a1.resize(buffer_sizes[0] / sizeof(int));
+
+  if (tiledb_array_finalize(tiledb_array) != TILEDB_OK)
+    return TILEDB_ERR;
+  return rc;
+}
+
+/**
+ * Wait until the request is served
+ */
+void AsyncReadTest::wait(const TileDB_AIO_Request* request) {
+  while (request->status_ == TILEDB_AIO_INPROGRESS)
+    usleep(100);
+}
+
+/**
+ * Write the entire array, where the k-th cell in the global cell order has
+ * value k
+ */
+int AsyncReadTest::write_array() {
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_WRITE,
+          NULL,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  std::vector<int> buffer_a1(10000);
+  for (int k = 0; k < 10000; ++k)
+    buffer_a1[k] = k;
+  const void* buffers[] = { &buffer_a1[0] };
+  size_t buffer_sizes[] = { buffer_a1.size() * sizeof(int) };
+  if (tiledb_array_write(tiledb_array, buffers, buffer_sizes) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  return tiledb_array_finalize(tiledb_array);
+}
+
+/***************************/
+/********** TESTS **********/
+/***************************/
+TEST_F(AsyncReadTest, QueuedRequestsCompleteInOrder) {
+  ASSERT_EQ(TILEDB_OK, create_array());
+  ASSERT_EQ(TILEDB_OK, write_array());
+
+  TileDB_Array* tiledb_array;
+  ASSERT_EQ(
+      TILEDB_OK,
+      tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_READ,
+          NULL,
+          NULL,
+          0));
+
+  // Queue requests on different subarrays, which cut through tiles
+  const int request_num = 8;
+  int64_t subarrays[request_num][4];
+  std::vector<std::vector<int> > results(request_num);
+  std::vector<void*> buffers(request_num);
+  std::vector<size_t> buffer_sizes(request_num);
+  TileDB_AIO_Request requests[request_num];
+  CompletionLog log;
+  CompletionData completion_data[request_num];
+  for (int r = 0; r < request_num; ++r) {
+    int64_t subarray[] = { 5 * r, 5 * r + 33, 90 - 7 * r, 95 - 4 * r };
+    memcpy(subarrays[r], subarray, sizeof(subarray));
+    results[r].resize(10000);
+    buffers[r] = &results[r][0];
+    buffer_sizes[r] = results[r].size() * sizeof(int);
+    completion_data[r].log_ = &log;
+    completion_data[r].id_ = r;
+    requests[r].buffers_ = &buffers[r];
+    requests[r].buffer_sizes_ = &buffer_sizes[r];
+    requests[r].completion_handle_ = log_completion;
+    requests[r].completion_data_ = &completion_data[r];
+    requests[r].subarray_ = subarrays[r];
+    ASSERT_EQ(TILEDB_OK, tiledb_array_read_async(tiledb_array, &requests[r]));
+  }
+
+  // Each request gets the cells of a synchronous read of its subarray, and
+  // the requests complete in submission order
+  for (int r = 0; r < request_num; ++r) {
+    wait(&requests[r]);
+    ASSERT_EQ(TILEDB_AIO_COMPLETED, requests[r].status_);
+    std::vector<int> expected;
+    ASSERT_EQ(TILEDB_OK, read_array(subarrays[r], expected));
+    ASSERT_EQ(expected.size() * sizeof(int), buffer_sizes[r]);
+    results[r].resize(expected.size());
+    ASSERT_EQ(expected, results[r]);
+  }
+  ASSERT_EQ(TILEDB_OK, tiledb_array_finalize(tiledb_array));
+  std::vector<int> ids = log.ids();
+  ASSERT_EQ(size_t(request_num), ids.size());
+  for (int r = 0; r < request_num; ++r)
+    ASSERT_EQ(r, ids[r]);
+}
+
+TEST_F(AsyncReadTest, FinalizeWaitsForPendingRequests) {
+  ASSERT_EQ(TILEDB_OK, create_array());
+  ASSERT_EQ(TILEDB_OK, write_array());
+
+  TileDB_Array* tiledb_array;
+  ASSERT_EQ(
+      TILEDB_OK,
+      tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_READ,
+          NULL,
+          NULL,
+          0));
+
+  // Queue reads of the entire array without completion handles, and
+  // finalize the array right away
+  const int request_num = 16;
+  int64_t domain[] = { 0, 99, 0, 99 };
+  std::vector<std::vector<int> > results(request_num);
+  std::vector<void*> buffers(request_num);
+  std::vector<size_t> buffer_sizes(request_num);
+  TileDB_AIO_Request requests[request_num];
+  for (int r = 0; r < request_num; ++r) {
+    results[r].resize(10000);
+    buffers[r] = &results[r][0];
+    buffer_sizes[r] = results[r].size() * sizeof(int);
+    requests[r].buffers_ = &buffers[r];
+    requests[r].buffer_sizes_ = &buffer_sizes[r];
+    requests[r].completion_handle_ = NULL;
+    requests[r].completion_data_ = NULL;
+    requests[r].subarray_ = domain;
+    ASSERT_EQ(TILEDB_OK, tiledb_array_read_async(tiledb_array, &requests[r]));
+  }
+  ASSERT_EQ(TILEDB_OK, tiledb_array_finalize(tiledb_array));
+
+  // Every request was served before the finalization returned
+  std::vector<int> expected;
+  ASSERT_EQ(TILEDB_OK, read_array(domain, expected));
+  for (int r = 0; r < request_num; ++r) {
+    ASSERT_EQ(TILEDB_AIO_COMPLETED, requests[r].status_);
+    ASSERT_EQ(expected, results[r]);
+  }
+}
+
+TEST_F(AsyncReadTest, OverflowResubmission) {
+  ASSERT_EQ(TILEDB_OK, create_array());
+  ASSERT_EQ(TILEDB_OK, write_array());
+
+  TileDB_Array* tiledb_array;
+  ASSERT_EQ(
+      TILEDB_OK,
+      tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_READ,
+          NULL,
+          NULL,
+          0));
+
+  // A buffer of 300 cells overflows, and each resubmission continues the
+  // read from where the previous one stopped
+  int64_t subarray[] = { 3, 97, 11, 88 };
+  std::vector<int> buffer_a1(300);
+  void* buffers[] = { &buffer_a1[0] };
+  size_t buffer_sizes[1];
+  TileDB_AIO_Request request;
+  request.buffers_ = buffers;
+  request.buffer_sizes_ = buffer_sizes;
+  request.completion_handle_ = NULL;
+  request.completion_data_ = NULL;
+  request.subarray_ = subarray;
+  std::vector<int> result;
+  int overflow_num = 0;
+  do {
+    buffer_sizes[0] = buffer_a1.size() * sizeof(int);
+    ASSERT_EQ(TILEDB_OK, tiledb_array_read_async(tiledb_array, &request));
+    wait(&request);
+    ASSERT_NE(TILEDB_AIO_ERR, request.status_);
+    result.insert(
+        result.end(),
+        buffer_a1.begin(),
+        buffer_a1.begin() + buffer_sizes[0] / sizeof(int));
+    request.subarray_ = NULL;
+    if (request.status_ == TILEDB_AIO_OVERFLOW)
+      ++overflow_num;
+  } while (request.status_ == TILEDB_AIO_OVERFLOW);
+  ASSERT_EQ(TILEDB_AIO_COMPLETED, request.status_);
+  ASSERT_EQ(TILEDB_OK, tiledb_array_finalize(tiledb_array));
+
+  std::vector<int> expected;
+  ASSERT_EQ(TILEDB_OK, read_array(subarray, expected));
+  ASSERT_EQ(int64_t(expected.size() / 300), overflow_num);
+  ASSERT_EQ(expected, result);
+}
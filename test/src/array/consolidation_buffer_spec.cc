@@ -0,0 +1,272 @@
+/**
+ * Copyright (c) 2016  Massachusetts Institute of Technology and Intel Corp.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Tests to check that consolidation copies the cells of all the attributes
+ * through buffers of any total size, enlarging those that cannot hold a
+ * single cell
+ */
+
+#include <gtest/gtest.h>
+#include "c_api.h"
+#include <cstdlib>
+#include <dirent.h>
+#include <map>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+class ConsolidationBufferTest: public testing::Test {
+  const std::string WORKSPACE = ".__workspace/";
+  const std::string ARRAYNAME = "test_100x100_10x10";
+
+public:
+  // TileDB context
+  TileDB_CTX* tiledb_ctx;
+  // Array name is initialized with the workspace folder
+  std::string array_name;
+
+  int consolidate();
+  int create_array();
+  int fragment_num();
+  std::map<int64_t, std::pair<int64_t, std::string> > read_array();
+  int write_cells(const std::vector<int64_t>& coords, int64_t value);
+
+  virtual void SetUp() {
+    // Initialize context with the default configuration parameters
+    tiledb_ctx_init(&tiledb_ctx, NULL);
+    if (tiledb_workspace_create(
+        tiledb_ctx,
+        WORKSPACE.c_str()) != TILEDB_OK) {
+      exit(EXIT_FAILURE);
+    }
+
+    array_name.append(WORKSPACE);
+    array_name.append(ARRAYNAME);
+  }
+
+  virtual void TearDown() {
+    // Finalize TileDB context
+    tiledb_ctx_finalize(tiledb_ctx);
+
+    // Remove the temporary workspace
+    std::string command = "rm -rf ";
+    command.append(WORKSPACE);
+    int ret = system(command.c_str());
+  }
+};
+
+/**
+ * Consolidate all the fragments of the array
+ */
+int ConsolidationBufferTest::consolidate() {
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_WRITE,
+          NULL,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  int rc = tiledb_array_consolidate(tiledb_array);
+  if (tiledb_array_finalize(tiledb_array) != TILEDB_OK)
+    return TILEDB_ERR;
+  return rc;
+}
+
+/**
+ * Create a sparse 100x100 array with 10x10 tiles, an int64 attribute and a
+ * variable-sized char attribute
+ */
+int ConsolidationBufferTest::create_array() {
+  const char* attributes[] = { "ATTR_INT64", "ATTR_CHAR_VAR" };
+  const char* dimensions[] = { "X", "Y" };
+  int64_t domain[] = { 0, 99, 0, 99 };
+  int64_t tile_extents[] = { 10, 10 };
+  const int cell_val_num[] = { 1, TILEDB_VAR_NUM };
+  const int types[] = { TILEDB_INT64, TILEDB_CHAR, TILEDB_INT64 };
+  const int compression[] = {
+      TILEDB_GZIP, TILEDB_GZIP, TILEDB_NO_COMPRESSION };
+
+  TileDB_ArraySchema schema;
+  tiledb_array_set_schema(
+      &schema,
+      array_name.c_str(),
+      attributes,
+      2,
+      20,
+      TILEDB_ROW_MAJOR,
+      cell_val_num,
+      compression,
+      0,
+      dimensions,
+      2,
+      domain,
+      4*sizeof(int64_t),
+      tile_extents,
+      2*sizeof(int64_t),
+      0,
+      types);
+
+  int rc = tiledb_array_create(tiledb_ctx, &schema);
+  tiledb_array_free_schema(&schema);
+  return rc;
+}
+
+/**
+ * Count the fragment directories of the array
+ */
+int ConsolidationBufferTest::fragment_num() {
+  int num = 0;
+  DIR* dir = opendir(array_name.c_str());
+  if (dir == NULL)
+    return -1;
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    std::string name = entry->d_name;
+    if (name.compare(0, 2, "__") == 0 && entry->d_type == DT_DIR)
+      ++num;
+  }
+  closedir(dir);
+  return num;
+}
+
+/**
+ * Read the entire array and map every cell, keyed by row * 100 + column, to
+ * its values
+ */
+std::map<int64_t, std::pair<int64_t, std::string> >
+ConsolidationBufferTest::read_array() {
+  std::map<int64_t, std::pair<int64_t, std::string> > cells;
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_READ,
+          NULL,
+          NULL,
+          0) != TILEDB_OK)
+    return cells;
+
+  std::vector<int64_t> buffer_a1(1000);
+  std::vector<size_t> buffer_a2(1000);
+  std::vector<char> buffer_var_a2(100000);
+  std::vector<int64_t> buffer_coords(2000);
+  void* buffers[] = {
+      &buffer_a1[0], &buffer_a2[0], &buffer_var_a2[0], &buffer_coords[0] };
+  size_t buffer_sizes[] = {
+      buffer_a1.size() * sizeof(int64_t),
+      buffer_a2.size() * sizeof(size_t),
+      buffer_var_a2.size(),
+      buffer_coords.size() * sizeof(int64_t) };
+  if (tiledb_array_read(tiledb_array, buffers, buffer_sizes) == TILEDB_OK) {
+    int64_t cell_num = buffer_sizes[0] / sizeof(int64_t);
+    for (int64_t i = 0; i < cell_num; ++i) {
+      size_t end = (i == cell_num - 1) ? buffer_sizes[2] : buffer_a2[i+1];
+      cells[buffer_coords[2*i] * 100 + buffer_coords[2*i+1]] =
+          std::make_pair(
+              buffer_a1[i],
+              std::string(&buffer_var_a2[buffer_a2[i]], end - buffer_a2[i]));
+    }
+  }
+
+  tiledb_array_finalize(tiledb_array);
+  return cells;
+}
+
+/**
+ * Write a sparse fragment with the input cells, where each cell gets the
+ * input value plus its position in the input, and a string of 10 to 39
+ * characters
+ */
+int ConsolidationBufferTest::write_cells(
+    const std::vector<int64_t>& coords,
+    int64_t value) {
+  // Keep the fragment timestamps distinct, so that the fragment order is
+  // fixed
+  usleep(2000);
+
+  std::vector<int64_t> buffer_a1;
+  std::vector<size_t> buffer_a2;
+  std::string buffer_var_a2;
+  for (size_t i = 0; i < coords.size() / 2; ++i) {
+    buffer_a1.push_back(value + i);
+    buffer_a2.push_back(buffer_var_a2.size());
+    buffer_var_a2.append(10 + (value + i) % 30, 'a' + i % 26);
+  }
+
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_WRITE_UNSORTED,
+          NULL,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+  const void* buffers[] = {
+      &buffer_a1[0], &buffer_a2[0], buffer_var_a2.c_str(), &coords[0] };
+  size_t buffer_sizes[] = {
+      buffer_a1.size() * sizeof(int64_t),
+      buffer_a2.size() * sizeof(size_t),
+      buffer_var_a2.size(),
+      coords.size() * sizeof(int64_t) };
+  if (tiledb_array_write(tiledb_array, buffers, buffer_sizes) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  return tiledb_array_finalize(tiledb_array);
+}
+
+/***************************/
+/********** TESTS **********/
+/***************************/
+TEST_F(ConsolidationBufferTest, BudgetSmallerThanOneCell) {
+  ASSERT_EQ(TILEDB_OK, create_array());
+
+  // Three fragments in two columns, the last of which overwrites the first
+  for (int f = 0; f < 3; ++f) {
+    std::vector<int64_t> coords;
+    for (int64_t i = 0; i < 40; ++i) {
+      coords.push_back(i);
+      coords.push_back(f % 2);
+    }
+    ASSERT_EQ(TILEDB_OK, write_cells(coords, 1000 * f));
+  }
+  ASSERT_EQ(3, fragment_num());
+  std::map<int64_t, std::pair<int64_t, std::string> > before = read_array();
+  ASSERT_EQ(size_t(80), before.size());
+  ASSERT_EQ(2005, before[5 * 100].first);
+
+  // A single byte is split across the three buffers, which are enlarged
+  // until each holds a cell
+  ASSERT_EQ(
+      TILEDB_OK,
+      tiledb_ctx_set_config(tiledb_ctx, "consolidation_buffer_size", "1"));
+  ASSERT_EQ(TILEDB_OK, consolidate());
+  ASSERT_EQ(1, fragment_num());
+  ASSERT_EQ(before, read_array());
+}
@@ -0,0 +1,396 @@
+/**
+ * Copyright (c) 2016  Massachusetts Institute of Technology and Intel Corp.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Tests to check that the tiered and subarray consolidation policies merge
+ * the expected fragments of dense and sparse arrays, without changing the
+ * array contents
+ */
+
+#include <gtest/gtest.h>
+#include "c_api.h"
+#include <cstdlib>
+#include <dirent.h>
+#include <map>
+#include <unistd.h>
+#include <vector>
+
+class ConsolidationTest: public testing::Test {
+  const std::string WORKSPACE = ".__workspace/";
+  const std::string ARRAYNAME = "test_100x100_10x10";
+
+public:
+  // TileDB context
+  TileDB_CTX* tiledb_ctx;
+  // Array name is initialized with the workspace folder
+  std::string array_name;
+
+  int consolidate(const TileDB_ConsolidationPolicy* policy);
+  int create_array(int dense);
+  int fragment_num();
+  std::map<int64_t, int> read_array(int dense);
+  int write_dense_tiles(const int64_t* subarray, int value);
+  int write_sparse_cells(const std::vector<int64_t>& coords, int value);
+
+  virtual void SetUp() {
+    // Initialize context with the default configuration parameters
+    tiledb_ctx_init(&tiledb_ctx, NULL);
+    if (tiledb_workspace_create(
+        tiledb_ctx,
+        WORKSPACE.c_str()) != TILEDB_OK) {
+      exit(EXIT_FAILURE);
+    }
+
+    array_name.append(WORKSPACE);
+    array_name.append(ARRAYNAME);
+  }
+
+  virtual void TearDown() {
+    // Finalize TileDB context
+    tiledb_ctx_finalize(tiledb_ctx);
+
+    // Remove the temporary workspace
+    std::string command = "rm -rf ";
+    command.append(WORKSPACE);
+    int ret = system(command.c_str());
+  }
+};
+
+/**
+ * Consolidate the array with the input policy
+ */
+int ConsolidationTest::consolidate(const TileDB_ConsolidationPolicy* policy) {
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_WRITE,
+          NULL,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  int rc = tiledb_array_consolidate_with_policy(tiledb_array, policy);
+  if (tiledb_array_finalize(tiledb_array) != TILEDB_OK)
+    return TILEDB_ERR;
+  return rc;
+}
+
+/**
+ * Create a 100x100 array with 10x10 tiles and a single int attribute
+ */
+int ConsolidationTest::create_array(int dense) {
+  const char* attributes[] = { "ATTR_INT32" };
+  const char* dimensions[] = { "X", "Y" };
+  int64_t domain[] = { 0, 99, 0, 99 };
+  int64_t tile_extents[] = { 10, 10 };
+  const int types[] = { TILEDB_INT32, TILEDB_INT64 };
+  const int compression[] = { TILEDB_GZIP, TILEDB_NO_COMPRESSION };
+
+  TileDB_ArraySchema schema;
+  tiledb_array_set_schema(
+      &schema,
+      array_name.c_str(),
+      attributes,
+      1,
+      20,
+      TILEDB_ROW_MAJOR,
+      NULL,
+      compression,
+      dense,
+      dimensions,
+      2,
+      domain,
+      4*sizeof(int64_t),
+      tile_extents,
+      2*sizeof(int64_t),
+      0,
+      types);
+
+  int rc = tiledb_array_create(tiledb_ctx, &schema);
+  tiledb_array_free_schema(&schema);
+  return rc;
+}
+
+/**
+ * Count the fragment directories of the array
+ */
+int ConsolidationTest::fragment_num() {
+  int num = 0;
+  DIR* dir = opendir(array_name.c_str());
+  if (dir == NULL)
+    return -1;
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    std::string name = entry->d_name;
+    if (name.compare(0, 2, "__") == 0 && entry->d_type == DT_DIR)
+      ++num;
+  }
+  closedir(dir);
+  return num;
+}
+
+/**
+ * Read the entire array and map every cell to its value. The cells of sparse
+ * arrays are keyed by their coordinates, encoded as row * 100 + column,
+ * whereas those of dense arrays are keyed by their position in the result,
+ * since the dense reads return all the cells in the global cell order without
+ * coordinates. The empty cells of dense arrays are left out.
+ */
+std::map<int64_t, int> ConsolidationTest::read_array(int dense) {
+  std::map<int64_t, int> cells;
+  const char* attributes[] = { "ATTR_INT32", TILEDB_COORDS };
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_READ,
+          NULL,
+          attributes,
+          dense ? 1 : 2) != TILEDB_OK)
+    return cells;
+
+  std::vector<int> buffer_a1(10000);
+  std::vector<int64_t> buffer_coords(20000);
+  void* buffers[] = { &buffer_a1[0], &buffer_coords[0] };
+  int64_t pos = 0;
+  do {
+    size_t buffer_sizes[] = {
+        buffer_a1.size() * sizeof(int),
+        buffer_coords.size() * sizeof(int64_t) };
+    if (tiledb_array_read(tiledb_array, buffers, buffer_sizes) != TILEDB_OK)
+      break;
+    int64_t cell_num = buffer_sizes[0] / sizeof(int);
+    for (int64_t i = 0; i < cell_num; ++i, ++pos) {
+      if (dense) {
+        if (buffer_a1[i] != TILEDB_EMPTY_INT32)
+          cells[pos] = buffer_a1[i];
+      } else {
+        cells[buffer_coords[2*i] * 100 + buffer_coords[2*i+1]] = buffer_a1[i];
+      }
+    }
+  } while (tiledb_array_overflow(tiledb_array, 0));
+
+  tiledb_array_finalize(tiledb_array);
+  return cells;
+}
+
+/**
+ * Write a dense fragment over a tile-aligned subarray, tile by tile, where
+ * each cell gets the input value plus its position in the tile
+ */
+int ConsolidationTest::write_dense_tiles(const int64_t* subarray, int value) {
+  // Keep the fragment timestamps distinct, so that the fragment order is
+  // fixed
+  usleep(2000);
+
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_WRITE,
+          subarray,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  int buffer_a1[100];
+  for (int i = 0; i < 100; ++i)
+    buffer_a1[i] = value + i;
+  const void* buffers[] = { buffer_a1 };
+  size_t buffer_sizes[] = { sizeof(buffer_a1) };
+  for (int64_t i = subarray[0]; i < subarray[1]; i += 10)
+    for (int64_t j = subarray[2]; j < subarray[3]; j += 10)
+      if (tiledb_array_write(tiledb_array, buffers, buffer_sizes) != TILEDB_OK)
+        return TILEDB_ERR;
+
+  return tiledb_array_finalize(tiledb_array);
+}
+
+/**
+ * Write a sparse fragment with the input cells, where each cell gets the
+ * input value plus its position in the input
+ */
+int ConsolidationTest::write_sparse_cells(
+    const std::vector<int64_t>& coords,
+    int value) {
+  // Keep the fragment timestamps distinct, so that the fragment order is
+  // fixed
+  usleep(2000);
+
+  const char* attributes[] = { "ATTR_INT32", TILEDB_COORDS };
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_WRITE_UNSORTED,
+          NULL,
+          attributes,
+          2) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  std::vector<int> buffer_a1;
+  for (size_t i = 0; i < coords.size() / 2; ++i)
+    buffer_a1.push_back(value + i);
+  const void* buffers[] = { &buffer_a1[0], &coords[0] };
+  size_t buffer_sizes[] = {
+      buffer_a1.size() * sizeof(int),
+      coords.size() * sizeof(int64_t) };
+  if (tiledb_array_write(tiledb_array, buffers, buffer_sizes) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  return tiledb_array_finalize(tiledb_array);
+}
+
+/***************************/
+/********** TESTS **********/
+/***************************/
+TEST_F(ConsolidationTest, DenseTiered) {
+  ASSERT_EQ(TILEDB_OK, create_array(1));
+
+  // A large fragment followed by four small ones, which together cover
+  // the [0,19]x[0,19] subarray
+  int64_t domain[] = { 0, 99, 0, 99 };
+  ASSERT_EQ(TILEDB_OK, write_dense_tiles(domain, 0));
+  int64_t tiles[][4] = {
+      { 0, 9, 0, 9 }, { 0, 9, 10, 19 }, { 10, 19, 0, 9 }, { 10, 19, 10, 19 } };
+  for (int i = 0; i < 4; ++i)
+    ASSERT_EQ(TILEDB_OK, write_dense_tiles(tiles[i], 1000 * (i + 1)));
+  ASSERT_EQ(5, fragment_num());
+  std::map<int64_t, int> before = read_array(1);
+  ASSERT_EQ(size_t(10000), before.size());
+
+  // Only the run of small fragments is merged
+  TileDB_ConsolidationPolicy policy = {
+      TILEDB_CONSOLIDATION_TIERED, 2.0, 2, 10, NULL };
+  ASSERT_EQ(TILEDB_OK, consolidate(&policy));
+  ASSERT_EQ(2, fragment_num());
+  ASSERT_EQ(before, read_array(1));
+}
+
+TEST_F(ConsolidationTest, DenseSubarray) {
+  ASSERT_EQ(TILEDB_OK, create_array(1));
+
+  // Two overlapping dense fragments, a disjoint one between them, and a
+  // sparse update of the first tile
+  int64_t tile_a[] = { 0, 9, 0, 9 };
+  int64_t tile_b[] = { 50, 59, 50, 59 };
+  ASSERT_EQ(TILEDB_OK, write_dense_tiles(tile_a, 0));
+  ASSERT_EQ(TILEDB_OK, write_dense_tiles(tile_b, 1000));
+  ASSERT_EQ(TILEDB_OK, write_dense_tiles(tile_a, 2000));
+  std::vector<int64_t> coords = { 3, 4, 7, 1, 0, 9 };
+  ASSERT_EQ(TILEDB_OK, write_sparse_cells(coords, 3000));
+  ASSERT_EQ(4, fragment_num());
+  std::map<int64_t, int> before = read_array(1);
+  ASSERT_EQ(size_t(200), before.size());
+  ASSERT_EQ(3000, before[3 * 10 + 4]);
+  ASSERT_EQ(1000, before[55 * 100]);
+
+  // The fragments overlapping the first tile are merged, whereas the one
+  // between them is not
+  int64_t subarray[] = { 0, 9, 0, 9 };
+  TileDB_ConsolidationPolicy policy = {
+      TILEDB_CONSOLIDATION_SUBARRAY, 0.0, 0, 0, subarray };
+  ASSERT_EQ(TILEDB_OK, consolidate(&policy));
+  ASSERT_EQ(2, fragment_num());
+  ASSERT_EQ(before, read_array(1));
+}
+
+TEST_F(ConsolidationTest, SparseTiered) {
+  ASSERT_EQ(TILEDB_OK, create_array(0));
+
+  // A large fragment followed by three small ones that overwrite some of
+  // its cells
+  std::vector<int64_t> coords;
+  for (int64_t i = 0; i < 100; ++i) {
+    for (int64_t j = 0; j < 10; ++j) {
+      coords.push_back(i);
+      coords.push_back(j);
+    }
+  }
+  ASSERT_EQ(TILEDB_OK, write_sparse_cells(coords, 0));
+  for (int f = 1; f <= 3; ++f) {
+    coords.clear();
+    for (int64_t i = 0; i < 5; ++i) {
+      coords.push_back(10 * f + i);
+      coords.push_back(f + i);
+    }
+    ASSERT_EQ(TILEDB_OK, write_sparse_cells(coords, 1000 * f));
+  }
+  ASSERT_EQ(4, fragment_num());
+  std::map<int64_t, int> before = read_array(0);
+  ASSERT_EQ(size_t(1000), before.size());
+  ASSERT_EQ(1000, before[10 * 100 + 1]);
+
+  // Only the run of small fragments is merged
+  TileDB_ConsolidationPolicy policy = {
+      TILEDB_CONSOLIDATION_TIERED, 2.0, 2, 10, NULL };
+  ASSERT_EQ(TILEDB_OK, consolidate(&policy));
+  ASSERT_EQ(2, fragment_num());
+  ASSERT_EQ(before, read_array(0));
+}
+
+TEST_F(ConsolidationTest, SparseSubarray) {
+  ASSERT_EQ(TILEDB_OK, create_array(0));
+
+  // Fragments in the [0,9]x[0,9] and [50,59]x[50,59] regions, the last of
+  // which spans both regions
+  std::vector<int64_t> coords_a = { 1, 1, 2, 2, 3, 3 };
+  std::vector<int64_t> coords_b = { 50, 50, 55, 55, 59, 59 };
+  std::vector<int64_t> coords_c = { 2, 2, 4, 4 };
+  std::vector<int64_t> coords_d = { 5, 5, 55, 55 };
+  ASSERT_EQ(TILEDB_OK, write_sparse_cells(coords_a, 0));
+  ASSERT_EQ(TILEDB_OK, write_sparse_cells(coords_b, 1000));
+  ASSERT_EQ(TILEDB_OK, write_sparse_cells(coords_c, 2000));
+  ASSERT_EQ(TILEDB_OK, write_sparse_cells(coords_d, 3000));
+  ASSERT_EQ(4, fragment_num());
+  std::map<int64_t, int> before = read_array(0);
+  ASSERT_EQ(2000, before[2 * 100 + 2]);
+  ASSERT_EQ(3001, before[55 * 100 + 55]);
+
+  // The fragments overlapping the subarray are merged. The second fragment
+  // overlaps none of the older merged ones, hence it is kept.
+  int64_t subarray[] = { 0, 9, 0, 9 };
+  TileDB_ConsolidationPolicy policy = {
+      TILEDB_CONSOLIDATION_SUBARRAY, 0.0, 0, 0, subarray };
+  ASSERT_EQ(TILEDB_OK, consolidate(&policy));
+  ASSERT_EQ(2, fragment_num());
+  ASSERT_EQ(before, read_array(0));
+
+  // Only the second and the last fragment overlap the new subarray, but the
+  // fragments between them overlap the second one, so all are merged
+  std::vector<int64_t> coords_e = { 1, 1, 56, 56 };
+  ASSERT_EQ(TILEDB_OK, write_sparse_cells(coords_e, 4000));
+  std::vector<int64_t> coords_f = { 57, 57 };
+  ASSERT_EQ(TILEDB_OK, write_sparse_cells(coords_f, 5000));
+  ASSERT_EQ(4, fragment_num());
+  before = read_array(0);
+  int64_t subarray_f[] = { 57, 57, 57, 57 };
+  policy.subarray_ = subarray_f;
+  ASSERT_EQ(TILEDB_OK, consolidate(&policy));
+  ASSERT_EQ(1, fragment_num());
+  ASSERT_EQ(before, read_array(0));
+}
@@ -0,0 +1,328 @@
+/**
+ * Copyright (c) 2016  Massachusetts Institute of Technology and Intel Corp.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Tests to check that the reads of dense arrays with several fragments and
+ * empty regions return the most recent cells, and the empty values of the
+ * attribute types elsewhere, for subarrays that cut through tiles
+ */
+
+#include <gtest/gtest.h>
+#include "c_api.h"
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+class DenseReadTest: public testing::Test {
+  const std::string WORKSPACE = ".__workspace/";
+  const std::string ARRAYNAME = "dense_test_40x40_10x10";
+
+public:
+  /** The cells of an array or of a read, one vector per attribute. */
+  struct Cells {
+    std::vector<int> a1;
+    std::vector<float> a2;
+    std::string a3;
+    std::vector<std::string> a4;
+
+    bool operator==(const Cells& cells) const {
+      return a1 == cells.a1 && a2 == cells.a2 &&
+             a3 == cells.a3 && a4 == cells.a4;
+    }
+  };
+
+  // TileDB context
+  TileDB_CTX* tiledb_ctx;
+  // Array name is initialized with the workspace folder
+  std::string array_name;
+  // The current cells of the array, keyed by row * 40 + column
+  Cells cells;
+
+  int create_array();
+  Cells expected_cells(const int64_t* subarray);
+  int read_array(
+      const int64_t* subarray,
+      int64_t buffer_cell_num,
+      Cells& result);
+  int write_subarray(const int64_t* subarray, int value);
+
+  virtual void SetUp() {
+    // Initialize context with the default configuration parameters
+    tiledb_ctx_init(&tiledb_ctx, NULL);
+    if (tiledb_workspace_create(
+        tiledb_ctx,
+        WORKSPACE.c_str()) != TILEDB_OK) {
+      exit(EXIT_FAILURE);
+    }
+
+    array_name.append(WORKSPACE);
+    array_name.append(ARRAYNAME);
+
+    // All the cells are empty at first
+    cells.a1.assign(1600, TILEDB_EMPTY_INT32);
+    cells.a2.assign(1600, TILEDB_EMPTY_FLOAT32);
+    cells.a3.assign(3 * 1600, TILEDB_EMPTY_CHAR);
+    cells.a4.assign(1600, std::string(1, TILEDB_EMPTY_CHAR));
+  }
+
+  virtual void TearDown() {
+    // Finalize TileDB context
+    tiledb_ctx_finalize(tiledb_ctx);
+
+    // Remove the temporary workspace
+    std::string command = "rm -rf ";
+    command.append(WORKSPACE);
+    int ret = system(command.c_str());
+  }
+};
+
+/**
+ * Create a dense 40x40 array with 10x10 tiles, an int, a float, a char
+ * attribute of three values per cell and a variable-sized char attribute
+ */
+int DenseReadTest::create_array() {
+  const char* attributes[] = {
+      "ATTR_INT32", "ATTR_FLOAT32", "ATTR_CHAR", "ATTR_CHAR_VAR" };
+  const char* dimensions[] = { "X", "Y" };
+  int64_t domain[] = { 0, 39, 0, 39 };
+  int64_t tile_extents[] = { 10, 10 };
+  const int cell_val_num[] = { 1, 1, 3, TILEDB_VAR_NUM };
+  const int types[] = {
+      TILEDB_INT32, TILEDB_FLOAT32, TILEDB_CHAR, TILEDB_CHAR, TILEDB_INT64 };
+  const int compression[] = {
+      TILEDB_GZIP, TILEDB_NO_COMPRESSION, TILEDB_GZIP, TILEDB_NO_COMPRESSION,
+      TILEDB_NO_COMPRESSION };
+
+  TileDB_ArraySchema schema;
+  tiledb_array_set_schema(
+      &schema,
+      array_name.c_str(),
+      attributes,
+      4,
+      0,
+      TILEDB_ROW_MAJOR,
+      cell_val_num,
+      compression,
+      1,
+      dimensions,
+      2,
+      domain,
+      4*sizeof(int64_t),
+      tile_extents,
+      2*sizeof(int64_t),
+      TILEDB_ROW_MAJOR,
+      types);
+
+  int rc = tiledb_array_create(tiledb_ctx, &schema);
+  tiledb_array_free_schema(&schema);
+  return rc;
+}
+
+/**
+ * Return the current cells of the array that fall in the subarray, in the
+ * global cell order, i.e., tile by tile
+ */
+DenseReadTest::Cells DenseReadTest::expected_cells(const int64_t* subarray) {
+  Cells expected;
+  for (int64_t ti = subarray[0] / 10; ti <= subarray[1] / 10; ++ti) {
+    for (int64_t tj = subarray[2] / 10; tj <= subarray[3] / 10; ++tj) {
+      for (int64_t i = ti * 10; i < ti * 10 + 10; ++i) {
+        for (int64_t j = tj * 10; j < tj * 10 + 10; ++j) {
+          if (i < subarray[0] || i > subarray[1] ||
+              j < subarray[2] || j > subarray[3])
+            continue;
+          int64_t pos = i * 40 + j;
+          expected.a1.push_back(cells.a1[pos]);
+          expected.a2.push_back(cells.a2[pos]);
+          expected.a3.append(cells.a3, 3 * pos, 3);
+          expected.a4.push_back(cells.a4[pos]);
+        }
+      }
+    }
+  }
+  return expected;
+}
+
+/**
+ * Read the subarray with buffers of the input number of cells, and append
+ * the cells to the result in the order they are read
+ */
+int DenseReadTest::read_array(
+    const int64_t* subarray,
+    int64_t buffer_cell_num,
+    Cells& result) {
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_READ,
+          subarray,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  // The variable-sized buffer holds as many cells as the others
+  std::vector<int> buffer_a1(buffer_cell_num);
+  std::vector<float> buffer_a2(buffer_cell_num);
+  std::vector<char> buffer_a3(3 * buffer_cell_num);
+  std::vector<size_t> buffer_a4(buffer_cell_num);
+  std::vector<char> buffer_var_a4(4 * buffer_cell_num);
+  void* buffers[] = {
+      &buffer_a1[0], &buffer_a2[0], &buffer_a3[0], &buffer_a4[0],
+      &buffer_var_a4[0] };
+  int rc;
+  bool overflow;
+  do {
+    size_t buffer_sizes[] = {
+        buffer_a1.size() * sizeof(int),
+        buffer_a2.size() * sizeof(float),
+        buffer_a3.size(),
+        buffer_a4.size() * sizeof(size_t),
+        buffer_var_a4.size() };
+    rc = tiledb_array_read(tiledb_array, buffers, buffer_sizes);
+    if (rc != TILEDB_OK)
+      break;
+
+    result.a1.insert(
+        result.a1.end(),
+        buffer_a1.begin(),
+        buffer_a1.begin() + buffer_sizes[0] / sizeof(int));
+    result.a2.insert(
+        result.a2.end(),
+        buffer_a2.begin(),
+        buffer_a2.begin() + buffer_sizes[1] / sizeof(float));
+    result.a3.append(&buffer_a3[0], buffer_sizes[2]);
+    int64_t cell_num = buffer_sizes[3] / sizeof(size_t);
+    for (int64_t i = 0; i < cell_num; ++i) {
+      size_t end = (i == cell_num - 1) ? buffer_sizes[4] : buffer_a4[i+1];
+      result.a4.push_back(
+          std::string(&buffer_var_a4[buffer_a4[i]], end - buffer_a4[i]));
+    }
+
+    overflow = false;
+    for (int i = 0; i < 4; ++i)
+      overflow = overflow || tiledb_array_overflow(tiledb_array, i);
+  } while (overflow);
+
+  if (tiledb_array_finalize(tiledb_array) != TILEDB_OK)
+    return TILEDB_ERR;
+  return rc;
+}
+
+/**
+ * Write a fragment over the input subarray, where the cells get the input
+ * value plus their position in the fragment, and record the ones inside the
+ * subarray
+ */
+int DenseReadTest::write_subarray(const int64_t* subarray, int value) {
+  // Keep the fragment timestamps distinct, so that the fragment order is
+  // fixed
+  usleep(2000);
+
+  // Cells in the global order, i.e., tile by tile, over the tiles that the
+  // subarray overlaps. The cells outside the subarray only pad the tiles.
+  std::vector<int> buffer_a1;
+  std::vector<float> buffer_a2;
+  std::string buffer_a3;
+  std::vector<size_t> buffer_a4;
+  std::string buffer_var_a4;
+  for (int64_t ti = subarray[0] / 10; ti <= subarray[1] / 10; ++ti) {
+    for (int64_t tj = subarray[2] / 10; tj <= subarray[3] / 10; ++tj) {
+      for (int64_t i = ti * 10; i < ti * 10 + 10; ++i) {
+        for (int64_t j = tj * 10; j < tj * 10 + 10; ++j) {
+          int a1 = value + buffer_a1.size();
+          buffer_a1.push_back(a1);
+          buffer_a2.push_back(a1 * 0.5f);
+          buffer_a3.append(3, 'a' + a1 % 26);
+          buffer_a4.push_back(buffer_var_a4.size());
+          buffer_var_a4.append(1 + a1 % 4, 'A' + a1 % 26);
+
+          if (i < subarray[0] || i > subarray[1] ||
+              j < subarray[2] || j > subarray[3])
+            continue;
+          int64_t pos = i * 40 + j;
+          cells.a1[pos] = a1;
+          cells.a2[pos] = a1 * 0.5f;
+          cells.a3.replace(3 * pos, 3, 3, 'a' + a1 % 26);
+          cells.a4[pos] = std::string(1 + a1 % 4, 'A' + a1 % 26);
+        }
+      }
+    }
+  }
+
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_WRITE,
+          subarray,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+  const void* buffers[] = {
+      &buffer_a1[0], &buffer_a2[0], buffer_a3.c_str(), &buffer_a4[0],
+      buffer_var_a4.c_str() };
+  size_t buffer_sizes[] = {
+      buffer_a1.size() * sizeof(int),
+      buffer_a2.size() * sizeof(float),
+      buffer_a3.size(),
+      buffer_a4.size() * sizeof(size_t),
+      buffer_var_a4.size() };
+  if (tiledb_array_write(tiledb_array, buffers, buffer_sizes) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  return tiledb_array_finalize(tiledb_array);
+}
+
+/***************************/
+/********** TESTS **********/
+/***************************/
+TEST_F(DenseReadTest, SubarraysAcrossFragmentsAndEmptyRegions) {
+  ASSERT_EQ(TILEDB_OK, create_array());
+
+  // Three overlapping fragments, which leave parts of their tiles empty, as
+  // well as the tiles of rows 20-29 and columns 0-9, and of rows 30-39 and
+  // columns 10-39
+  int64_t fragments[][4] = {
+      { 0, 14, 0, 24 }, { 8, 27, 12, 39 }, { 33, 39, 0, 6 } };
+  for (int f = 0; f < 3; ++f)
+    ASSERT_EQ(TILEDB_OK, write_subarray(fragments[f], 10000 * f));
+
+  // The entire domain, subarrays cutting through the tiles of several
+  // fragments and empty regions, a single row and a single empty cell
+  int64_t subarrays[][4] = {
+      { 0, 39, 0, 39 }, { 5, 34, 3, 27 }, { 12, 37, 15, 36 },
+      { 17, 17, 0, 39 }, { 25, 25, 5, 5 } };
+  for (int s = 0; s < 5; ++s) {
+    // Buffers for all the cells, and buffers that take many rounds and
+    // split the runs of empty cells
+    Cells expected = expected_cells(subarrays[s]);
+    Cells whole, split;
+    ASSERT_EQ(TILEDB_OK, read_array(subarrays[s], 1600, whole));
+    ASSERT_EQ(TILEDB_OK, read_array(subarrays[s], 7, split));
+    ASSERT_TRUE(expected == whole);
+    ASSERT_TRUE(expected == split);
+  }
+}
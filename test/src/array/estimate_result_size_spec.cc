@@ -0,0 +1,301 @@
+/**
+ * Copyright (c) 2016  Massachusetts Institute of Technology and Intel Corp.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Tests to check that the estimated result sizes are upper bounds, i.e., that
+ * buffers of the estimated sizes hold the entire result of a read
+ */
+
+#include <gtest/gtest.h>
+#include "c_api.h"
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+class EstimateResultSizeTest: public testing::Test {
+  const std::string WORKSPACE = ".__workspace/";
+  const std::string ARRAYNAME = "test_100x100_10x10";
+
+public:
+  // TileDB context
+  TileDB_CTX* tiledb_ctx;
+  // Array name is initialized with the workspace folder
+  std::string array_name;
+  // The estimated sizes and the sizes of the results of the last read
+  size_t estimated_sizes[4];
+  size_t result_sizes[4];
+
+  int create_array(bool dense);
+  int read_estimated(const int64_t* subarray, bool dense);
+  int write_dense_subarray(const int64_t* subarray);
+  int write_sparse_cells(int64_t cell_num);
+
+  virtual void SetUp() {
+    // Initialize context with the default configuration parameters
+    tiledb_ctx_init(&tiledb_ctx, NULL);
+    if (tiledb_workspace_create(
+        tiledb_ctx,
+        WORKSPACE.c_str()) != TILEDB_OK) {
+      exit(EXIT_FAILURE);
+    }
+
+    array_name.append(WORKSPACE);
+    array_name.append(ARRAYNAME);
+  }
+
+  virtual void TearDown() {
+    // Finalize TileDB context
+    tiledb_ctx_finalize(tiledb_ctx);
+
+    // Remove the temporary workspace
+    std::string command = "rm -rf ";
+    command.append(WORKSPACE);
+    int ret = system(command.c_str());
+  }
+};
+
+/**
+ * Create a 100x100 array with 10x10 tiles, a fixed-sized and a variable-sized
+ * attribute
+ */
+int EstimateResultSizeTest::create_array(bool dense) {
+  const char* attributes[] = { "ATTR_INT32", "ATTR_CHAR_VAR" };
+  const char* dimensions[] = { "X", "Y" };
+  int64_t domain[] = { 0, 99, 0, 99 };
+  int64_t tile_extents[] = { 10, 10 };
+  const int cell_val_num[] = { 1, TILEDB_VAR_NUM };
+  const int types[] = { TILEDB_INT32, TILEDB_CHAR, TILEDB_INT64 };
+  const int compression[] = { TILEDB_GZIP, TILEDB_GZIP, TILEDB_GZIP };
+
+  TileDB_ArraySchema schema;
+  tiledb_array_set_schema(
+      &schema,
+      array_name.c_str(),
+      attributes,
+      2,
+      50,
+      TILEDB_ROW_MAJOR,
+      cell_val_num,
+      compression,
+      dense,
+      dimensions,
+      2,
+      domain,
+      4*sizeof(int64_t),
+      tile_extents,
+      2*sizeof(int64_t),
+      0,
+      types);
+
+  int rc = tiledb_array_create(tiledb_ctx, &schema);
+  tiledb_array_free_schema(&schema);
+  return rc;
+}
+
+/**
+ * Estimate the result size of the input subarray, and then read it in a
+ * single pass into buffers of the estimated sizes. It fails if the buffers
+ * overflow.
+ */
+int EstimateResultSizeTest::read_estimated(
+    const int64_t* subarray,
+    bool dense) {
+  TileDB_Array* tiledb_array;
+  const char* attributes[] = {
+      "ATTR_INT32", "ATTR_CHAR_VAR", TILEDB_COORDS };
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_READ,
+          subarray,
+          attributes,
+          dense ? 2 : 3) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  int buffer_num = dense ? 3 : 4;
+  size_t buffer_sizes[4];
+  if (tiledb_array_estimate_result_size(tiledb_array, buffer_sizes) !=
+      TILEDB_OK)
+    return TILEDB_ERR;
+
+  std::vector<std::vector<char> > buffers(buffer_num);
+  void* buffer_ptrs[4];
+  for (int i = 0; i < buffer_num; ++i) {
+    estimated_sizes[i] = buffer_sizes[i];
+    buffers[i].resize(buffer_sizes[i] + 1);
+    buffer_ptrs[i] = &buffers[i][0];
+  }
+  if (tiledb_array_read(tiledb_array, buffer_ptrs, buffer_sizes) !=
+      TILEDB_OK)
+    return TILEDB_ERR;
+  for (int i = 0; i < buffer_num; ++i)
+    result_sizes[i] = buffer_sizes[i];
+
+  int rc = TILEDB_OK;
+  for (int i = 0; i < (dense ? 2 : 3); ++i)
+    if (tiledb_array_overflow(tiledb_array, i))
+      rc = TILEDB_ERR;
+
+  if (tiledb_array_finalize(tiledb_array) != TILEDB_OK)
+    return TILEDB_ERR;
+  return rc;
+}
+
+/**
+ * Write a dense fragment over the input subarray, whose cells hold values of
+ * up to five characters
+ */
+int EstimateResultSizeTest::write_dense_subarray(const int64_t* subarray) {
+  int64_t cell_num =
+      (subarray[1] - subarray[0] + 1) * (subarray[3] - subarray[2] + 1);
+  std::vector<int> buffer_a1;
+  std::vector<size_t> buffer_a2_offsets;
+  std::string buffer_a2;
+  for (int64_t k = 0; k < cell_num; ++k) {
+    buffer_a1.push_back(k);
+    buffer_a2_offsets.push_back(buffer_a2.size());
+    buffer_a2.append(k % 5 + 1, 'a' + k % 26);
+  }
+
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_WRITE,
+          subarray,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  const void* buffers[] = {
+      &buffer_a1[0], &buffer_a2_offsets[0], buffer_a2.c_str() };
+  size_t buffer_sizes[] = {
+      buffer_a1.size() * sizeof(int),
+      buffer_a2_offsets.size() * sizeof(size_t),
+      buffer_a2.size() };
+  if (tiledb_array_write(tiledb_array, buffers, buffer_sizes) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  // Fragments created in the same millisecond would get the same name
+  usleep(2000);
+  return tiledb_array_finalize(tiledb_array);
+}
+
+/**
+ * Write the first cell_num cells of the first ten columns in random order
+ */
+int EstimateResultSizeTest::write_sparse_cells(int64_t cell_num) {
+  std::vector<int> buffer_a1;
+  std::vector<size_t> buffer_a2_offsets;
+  std::string buffer_a2;
+  std::vector<int64_t> buffer_coords;
+  srand(7);
+  for (int64_t k = 0; k < cell_num; ++k) {
+    int64_t r = rand() % cell_num;
+    buffer_a1.push_back(r);
+    buffer_a2_offsets.push_back(buffer_a2.size());
+    buffer_a2.append(r % 5 + 1, 'a' + r % 26);
+    buffer_coords.push_back(k / 10);
+    buffer_coords.push_back(k % 10);
+  }
+
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_WRITE_UNSORTED,
+          NULL,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  const void* buffers[] = {
+      &buffer_a1[0], &buffer_a2_offsets[0], buffer_a2.c_str(),
+      &buffer_coords[0] };
+  size_t buffer_sizes[] = {
+      buffer_a1.size() * sizeof(int),
+      buffer_a2_offsets.size() * sizeof(size_t),
+      buffer_a2.size(),
+      buffer_coords.size() * sizeof(int64_t) };
+  if (tiledb_array_write(tiledb_array, buffers, buffer_sizes) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  usleep(2000);
+  return tiledb_array_finalize(tiledb_array);
+}
+
+/***************************/
+/********** TESTS **********/
+/***************************/
+TEST_F(EstimateResultSizeTest, DensePartialFragment) {
+  // A fragment over part of the domain
+  ASSERT_EQ(TILEDB_OK, create_array(true));
+  int64_t fragment_subarray[] = { 10, 29, 10, 39 };
+  ASSERT_EQ(TILEDB_OK, write_dense_subarray(fragment_subarray));
+
+  // The whole domain, and subarrays within, across and outside the fragment
+  int64_t subarrays[][4] = {
+      { 0, 99, 0, 99 }, { 16, 18, 16, 18 }, { 0, 19, 5, 44 },
+      { 50, 59, 0, 9 } };
+  for (int s = 0; s < 4; ++s)
+    ASSERT_EQ(TILEDB_OK, read_estimated(subarrays[s], true));
+
+  // The estimates of the whole domain account for its empty cells
+  ASSERT_EQ(TILEDB_OK, read_estimated(subarrays[0], true));
+  ASSERT_EQ(10000 * sizeof(int), estimated_sizes[0]);
+  ASSERT_EQ(10000 * sizeof(size_t), estimated_sizes[1]);
+  ASSERT_LE(result_sizes[2], estimated_sizes[2]);
+  // Every cell holds at least one character, empty or not
+  ASSERT_LE(10000 * sizeof(char), estimated_sizes[2]);
+}
+
+TEST_F(EstimateResultSizeTest, DenseOverlappingFragments) {
+  ASSERT_EQ(TILEDB_OK, create_array(true));
+  int64_t fragment_subarrays[][4] = {
+      { 10, 19, 10, 19 }, { 0, 29, 0, 9 }, { 10, 39, 0, 49 } };
+  for (int f = 0; f < 3; ++f)
+    ASSERT_EQ(TILEDB_OK, write_dense_subarray(fragment_subarrays[f]));
+
+  int64_t subarrays[][4] = {
+      { 0, 99, 0, 99 }, { 3, 17, 2, 25 }, { 30, 49, 40, 59 } };
+  for (int s = 0; s < 3; ++s)
+    ASSERT_EQ(TILEDB_OK, read_estimated(subarrays[s], true));
+}
+
+TEST_F(EstimateResultSizeTest, Sparse) {
+  ASSERT_EQ(TILEDB_OK, create_array(false));
+  ASSERT_EQ(TILEDB_OK, write_sparse_cells(995));
+  ASSERT_EQ(TILEDB_OK, write_sparse_cells(333));
+
+  int64_t subarrays[][4] = {
+      { 0, 99, 0, 99 }, { 3, 17, 2, 25 }, { 30, 49, 40, 59 } };
+  for (int s = 0; s < 3; ++s)
+    ASSERT_EQ(TILEDB_OK, read_estimated(subarrays[s], false));
+
+  // The whole array holds the 995 cells of the first write
+  ASSERT_EQ(TILEDB_OK, read_estimated(subarrays[0], false));
+  ASSERT_EQ(995 * sizeof(int), result_sizes[0]);
+}
@@ -0,0 +1,339 @@
+/**
+ * Copyright (c) 2016  Massachusetts Institute of Technology and Intel Corp.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Tests to check that the zero-copy views of an array return the same results
+ * as the regular reads, and that the views are leased properly
+ */
+
+#include <gtest/gtest.h>
+#include "c_api.h"
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+class ReadViewsTest: public testing::Test {
+  const std::string WORKSPACE = ".__workspace/";
+  const std::string ARRAYNAME = "test_100x100_10x10";
+
+public:
+  // TileDB context
+  TileDB_CTX* tiledb_ctx;
+  // Array name is initialized with the workspace folder
+  std::string array_name;
+  // The results of the last read, for the attribute and the coordinates
+  std::vector<int> a1;
+  std::vector<int64_t> coords;
+
+  int create_array(bool dense);
+  int read_array(const int64_t* subarray, bool dense);
+  int read_array_views(const int64_t* subarray, bool dense);
+  int write_array(bool dense);
+
+  virtual void SetUp() {
+    // Initialize context with the default configuration parameters
+    tiledb_ctx_init(&tiledb_ctx, NULL);
+    if (tiledb_workspace_create(
+        tiledb_ctx,
+        WORKSPACE.c_str()) != TILEDB_OK) {
+      exit(EXIT_FAILURE);
+    }
+
+    array_name.append(WORKSPACE);
+    array_name.append(ARRAYNAME);
+  }
+
+  virtual void TearDown() {
+    // Finalize TileDB context
+    tiledb_ctx_finalize(tiledb_ctx);
+
+    // Remove the temporary workspace
+    std::string command = "rm -rf ";
+    command.append(WORKSPACE);
+    int ret = system(command.c_str());
+  }
+};
+
+/**
+ * Create a 100x100 array with 10x10 tiles, a compressed int attribute and,
+ * for the sparse case, a capacity of 50 cells
+ */
+int ReadViewsTest::create_array(bool dense) {
+  const char* attributes[] = { "ATTR_INT32" };
+  const char* dimensions[] = { "X", "Y" };
+  int64_t domain[] = { 0, 99, 0, 99 };
+  int64_t tile_extents[] = { 10, 10 };
+  const int types[] = { TILEDB_INT32, TILEDB_INT64 };
+  const int compression[] = { TILEDB_GZIP, TILEDB_GZIP };
+
+  TileDB_ArraySchema schema;
+  tiledb_array_set_schema(
+      &schema,
+      array_name.c_str(),
+      attributes,
+      1,
+      50,
+      TILEDB_ROW_MAJOR,
+      NULL,
+      compression,
+      dense,
+      dimensions,
+      2,
+      domain,
+      4*sizeof(int64_t),
+      tile_extents,
+      2*sizeof(int64_t),
+      0,
+      types);
+
+  int rc = tiledb_array_create(tiledb_ctx, &schema);
+  tiledb_array_free_schema(&schema);
+  return rc;
+}
+
+/**
+ * Read the input subarray with tiledb_array_read(), in small batches so that
+ * the reads overflow
+ */
+int ReadViewsTest::read_array(const int64_t* subarray, bool dense) {
+  a1.clear();
+  coords.clear();
+
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_READ,
+          subarray,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  std::vector<int> buffer_a1(77);
+  std::vector<int64_t> buffer_coords(2 * 77);
+  void* buffers[] = { &buffer_a1[0], &buffer_coords[0] };
+  for (;;) {
+    size_t buffer_sizes[] = {
+        buffer_a1.size() * sizeof(int),
+        buffer_coords.size() * sizeof(int64_t) };
+    if (tiledb_array_read(tiledb_array, buffers, buffer_sizes) != TILEDB_OK)
+      return TILEDB_ERR;
+    if (buffer_sizes[0] == 0)
+      break;
+    a1.insert(
+        a1.end(),
+        buffer_a1.begin(),
+        buffer_a1.begin() + buffer_sizes[0] / sizeof(int));
+    if (!dense)
+      coords.insert(
+          coords.end(),
+          buffer_coords.begin(),
+          buffer_coords.begin() + buffer_sizes[1] / sizeof(int64_t));
+  }
+
+  return tiledb_array_finalize(tiledb_array);
+}
+
+/**
+ * Read the input subarray with tiledb_array_read_views(), releasing the views
+ * after copying them
+ */
+int ReadViewsTest::read_array_views(const int64_t* subarray, bool dense) {
+  a1.clear();
+  coords.clear();
+
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_READ,
+          subarray,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  const void* views[2];
+  size_t view_sizes[2];
+  for (;;) {
+    if (tiledb_array_read_views(tiledb_array, views, view_sizes) != TILEDB_OK)
+      return TILEDB_ERR;
+    if (view_sizes[0] == 0 && (dense || view_sizes[1] == 0))
+      break;
+    const int* view_a1 = static_cast<const int*>(views[0]);
+    a1.insert(a1.end(), view_a1, view_a1 + view_sizes[0] / sizeof(int));
+    if (!dense) {
+      const int64_t* view_coords = static_cast<const int64_t*>(views[1]);
+      coords.insert(
+          coords.end(),
+          view_coords,
+          view_coords + view_sizes[1] / sizeof(int64_t));
+    }
+    if (tiledb_array_release_views(tiledb_array) != TILEDB_OK)
+      return TILEDB_ERR;
+  }
+
+  return tiledb_array_finalize(tiledb_array);
+}
+
+/**
+ * Write the entire array for the dense case, and the cells of every third
+ * column in random order for the sparse case, where cell (i,j) has value
+ * i * 100 + j
+ */
+int ReadViewsTest::write_array(bool dense) {
+  std::vector<int> buffer_a1;
+  std::vector<int64_t> buffer_coords;
+  if (dense) {
+    // Cells in the global order, i.e., tile by tile
+    for (int64_t t = 0; t < 100; ++t)
+      for (int64_t c = 0; c < 100; ++c)
+        buffer_a1.push_back(
+            ((t / 10) * 10 + c / 10) * 100 + (t % 10) * 10 + c % 10);
+  } else {
+    for (int64_t i = 0; i < 100; ++i) {
+      for (int64_t j = 0; j < 100; j += 3) {
+        buffer_a1.push_back(i * 100 + j);
+        buffer_coords.push_back(i);
+        buffer_coords.push_back(j);
+      }
+    }
+    srand(7);
+    for (int64_t k = buffer_a1.size() - 1; k > 0; --k) {
+      int64_t r = rand() % (k + 1);
+      std::swap(buffer_a1[k], buffer_a1[r]);
+      std::swap(buffer_coords[2*k], buffer_coords[2*r]);
+      std::swap(buffer_coords[2*k+1], buffer_coords[2*r+1]);
+    }
+  }
+
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          dense ? TILEDB_ARRAY_WRITE : TILEDB_ARRAY_WRITE_UNSORTED,
+          NULL,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  const void* buffers[] = { &buffer_a1[0], &buffer_coords[0] };
+  size_t buffer_sizes[] = {
+      buffer_a1.size() * sizeof(int),
+      buffer_coords.size() * sizeof(int64_t) };
+  if (tiledb_array_write(tiledb_array, buffers, buffer_sizes) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  return tiledb_array_finalize(tiledb_array);
+}
+
+/***************************/
+/********** TESTS **********/
+/***************************/
+TEST_F(ReadViewsTest, DenseViewsMatchRead) {
+  ASSERT_EQ(TILEDB_OK, create_array(true));
+  ASSERT_EQ(TILEDB_OK, write_array(true));
+
+  // The entire domain, and a subarray cutting through tiles
+  int64_t subarrays[][4] = { { 0, 99, 0, 99 }, { 5, 54, 13, 77 } };
+  for (int s = 0; s < 2; ++s) {
+    ASSERT_EQ(TILEDB_OK, read_array(subarrays[s], true));
+    std::vector<int> expected_a1 = a1;
+    ASSERT_EQ(TILEDB_OK, read_array_views(subarrays[s], true));
+    ASSERT_EQ(expected_a1, a1);
+  }
+  ASSERT_EQ(size_t(50 * 65), a1.size());
+}
+
+TEST_F(ReadViewsTest, SparseViewsMatchRead) {
+  ASSERT_EQ(TILEDB_OK, create_array(false));
+  ASSERT_EQ(TILEDB_OK, write_array(false));
+
+  int64_t subarrays[][4] = { { 0, 99, 0, 99 }, { 5, 54, 13, 77 } };
+  for (int s = 0; s < 2; ++s) {
+    ASSERT_EQ(TILEDB_OK, read_array(subarrays[s], false));
+    std::vector<int> expected_a1 = a1;
+    std::vector<int64_t> expected_coords = coords;
+    ASSERT_EQ(TILEDB_OK, read_array_views(subarrays[s], false));
+    ASSERT_EQ(expected_a1, a1);
+    ASSERT_EQ(expected_coords, coords);
+  }
+  for (size_t k = 0; k < a1.size(); ++k)
+    ASSERT_EQ(coords[2*k] * 100 + coords[2*k+1], a1[k]);
+}
+
+TEST_F(ReadViewsTest, LeaseErrors) {
+  ASSERT_EQ(TILEDB_OK, create_array(false));
+  ASSERT_EQ(TILEDB_OK, write_array(false));
+
+  TileDB_Array* tiledb_array;
+  ASSERT_EQ(TILEDB_OK, tiledb_array_init(
+      tiledb_ctx,
+      &tiledb_array,
+      array_name.c_str(),
+      TILEDB_ARRAY_READ,
+      NULL,
+      NULL,
+      0));
+  const void* views[2];
+  size_t view_sizes[2];
+  std::vector<int> buffer_a1(100);
+  std::vector<int64_t> buffer_coords(200);
+  void* buffers[] = { &buffer_a1[0], &buffer_coords[0] };
+  size_t buffer_sizes[] = {
+      buffer_a1.size() * sizeof(int),
+      buffer_coords.size() * sizeof(int64_t) };
+
+  // The views must be released before the next views are read
+  ASSERT_EQ(
+      TILEDB_OK,
+      tiledb_array_read_views(tiledb_array, views, view_sizes));
+  ASSERT_EQ(
+      TILEDB_ERR,
+      tiledb_array_read_views(tiledb_array, views, view_sizes));
+  ASSERT_EQ(TILEDB_OK, tiledb_array_release_views(tiledb_array));
+  ASSERT_EQ(
+      TILEDB_OK,
+      tiledb_array_read_views(tiledb_array, views, view_sizes));
+
+  // Reads fail once the views have been used, even after their release
+  ASSERT_EQ(
+      TILEDB_ERR,
+      tiledb_array_read(tiledb_array, buffers, buffer_sizes));
+  ASSERT_EQ(TILEDB_OK, tiledb_array_release_views(tiledb_array));
+  ASSERT_EQ(
+      TILEDB_ERR,
+      tiledb_array_read(tiledb_array, buffers, buffer_sizes));
+
+  // Resetting the subarray starts over, and then views fail after a read
+  ASSERT_EQ(TILEDB_OK, tiledb_array_reset_subarray(tiledb_array, NULL));
+  ASSERT_EQ(
+      TILEDB_OK,
+      tiledb_array_read(tiledb_array, buffers, buffer_sizes));
+  ASSERT_EQ(
+      TILEDB_ERR,
+      tiledb_array_read_views(tiledb_array, views, view_sizes));
+
+  ASSERT_EQ(TILEDB_OK, tiledb_array_finalize(tiledb_array));
+}
@@ -0,0 +1,284 @@
+/**
+ * Copyright (c) 2016  Massachusetts Institute of Technology and Intel Corp.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Tests to check that the reads of sparse arrays with several overlapping
+ * fragments return the most recent cells in the global cell order
+ */
+
+#include <gtest/gtest.h>
+#include "c_api.h"
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <unistd.h>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+class SparseReadTest: public testing::Test {
+  const std::string WORKSPACE = ".__workspace/";
+  const std::string ARRAYNAME = "test_100x100_10x10";
+
+public:
+  // TileDB context
+  TileDB_CTX* tiledb_ctx;
+  // Array name is initialized with the workspace folder
+  std::string array_name;
+
+  int create_array();
+  std::vector<std::pair<int64_t, int> > expected_cells(
+      const std::map<int64_t, int>& cells,
+      const int64_t* subarray);
+  int read_array(
+      const int64_t* subarray,
+      int64_t buffer_cell_num,
+      std::vector<std::pair<int64_t, int> >& cells);
+  int write_fragments(std::map<int64_t, int>& cells);
+
+  virtual void SetUp() {
+    // Initialize context with the default configuration parameters
+    tiledb_ctx_init(&tiledb_ctx, NULL);
+    if (tiledb_workspace_create(
+        tiledb_ctx,
+        WORKSPACE.c_str()) != TILEDB_OK) {
+      exit(EXIT_FAILURE);
+    }
+
+    array_name.append(WORKSPACE);
+    array_name.append(ARRAYNAME);
+  }
+
+  virtual void TearDown() {
+    // Finalize TileDB context
+    tiledb_ctx_finalize(tiledb_ctx);
+
+    // Remove the temporary workspace
+    std::string command = "rm -rf ";
+    command.append(WORKSPACE);
+    int ret = system(command.c_str());
+  }
+};
+
+/**
+ * Create a sparse 100x100 array with 10x10 tiles, a small capacity and a
+ * single int attribute
+ */
+int SparseReadTest::create_array() {
+  const char* attributes[] = { "ATTR_INT32" };
+  const char* dimensions[] = { "X", "Y" };
+  int64_t domain[] = { 0, 99, 0, 99 };
+  int64_t tile_extents[] = { 10, 10 };
+  const int types[] = { TILEDB_INT32, TILEDB_INT64 };
+  const int compression[] = { TILEDB_GZIP, TILEDB_NO_COMPRESSION };
+
+  TileDB_ArraySchema schema;
+  tiledb_array_set_schema(
+      &schema,
+      array_name.c_str(),
+      attributes,
+      1,
+      10,
+      TILEDB_ROW_MAJOR,
+      NULL,
+      compression,
+      0,
+      dimensions,
+      2,
+      domain,
+      4*sizeof(int64_t),
+      tile_extents,
+      2*sizeof(int64_t),
+      0,
+      types);
+
+  int rc = tiledb_array_create(tiledb_ctx, &schema);
+  tiledb_array_free_schema(&schema);
+  return rc;
+}
+
+/**
+ * Return the input cells, keyed by row * 100 + column, that fall in the
+ * subarray, in the global cell order
+ */
+std::vector<std::pair<int64_t, int> > SparseReadTest::expected_cells(
+    const std::map<int64_t, int>& cells,
+    const int64_t* subarray) {
+  // Order the cells by their tile id first, and then by their coordinates
+  std::map<int64_t, std::pair<int64_t, int> > ordered;
+  std::map<int64_t, int>::const_iterator it = cells.begin();
+  for (; it != cells.end(); ++it) {
+    int64_t x = it->first / 100, y = it->first % 100;
+    if (x >= subarray[0] && x <= subarray[1] &&
+        y >= subarray[2] && y <= subarray[3])
+      ordered[(x / 10 * 10 + y / 10) * 10000 + it->first] = *it;
+  }
+
+  std::vector<std::pair<int64_t, int> > expected;
+  std::map<int64_t, std::pair<int64_t, int> >::const_iterator jt;
+  for (jt = ordered.begin(); jt != ordered.end(); ++jt)
+    expected.push_back(jt->second);
+  return expected;
+}
+
+/**
+ * Read the subarray with buffers of the input number of cells, and return
+ * the cells keyed by row * 100 + column in the order they are read
+ */
+int SparseReadTest::read_array(
+    const int64_t* subarray,
+    int64_t buffer_cell_num,
+    std::vector<std::pair<int64_t, int> >& cells) {
+  const char* attributes[] = { "ATTR_INT32", TILEDB_COORDS };
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_READ,
+          subarray,
+          attributes,
+          2) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  std::vector<int> buffer_a1(buffer_cell_num);
+  std::vector<int64_t> buffer_coords(2 * buffer_cell_num);
+  void* buffers[] = { &buffer_a1[0], &buffer_coords[0] };
+  int rc;
+  do {
+    size_t buffer_sizes[] = {
+        buffer_a1.size() * sizeof(int),
+        buffer_coords.size() * sizeof(int64_t) };
+    rc = tiledb_array_read(tiledb_array, buffers, buffer_sizes);
+    if (rc != TILEDB_OK)
+      break;
+    int64_t cell_num = buffer_sizes[0] / sizeof(int);
+    for (int64_t i = 0; i < cell_num; ++i)
+      cells.push_back(
+          std::pair<int64_t, int>(
+              buffer_coords[2*i] * 100 + buffer_coords[2*i+1],
+              buffer_a1[i]));
+  } while (tiledb_array_overflow(tiledb_array, 0));
+
+  if (tiledb_array_finalize(tiledb_array) != TILEDB_OK)
+    return TILEDB_ERR;
+  return rc;
+}
+
+/**
+ * Write four overlapping sparse fragments of random cells, and map every
+ * cell to the value of its most recent write
+ */
+int SparseReadTest::write_fragments(std::map<int64_t, int>& cells) {
+  const char* attributes[] = { "ATTR_INT32", TILEDB_COORDS };
+  srand(7);
+  for (int f = 0; f < 4; ++f) {
+    // Keep the fragment timestamps distinct, so that the fragment order is
+    // fixed
+    usleep(2000);
+
+    // Distinct random cells, packed in the upper left half of the domain
+    // by the last fragments, so that the fragments overlap more and more
+    std::vector<int64_t> positions(10000);
+    for (int64_t i = 0; i < 10000; ++i)
+      positions[i] = (f < 2) ? i : i / 2;
+    std::random_shuffle(positions.begin(), positions.end());
+    std::sort(positions.begin(), positions.begin() + 1500);
+    int64_t cell_num = std::unique(positions.begin(), positions.begin() + 1500)
+                       - positions.begin();
+    std::random_shuffle(positions.begin(), positions.begin() + cell_num);
+
+    std::vector<int> buffer_a1;
+    std::vector<int64_t> buffer_coords;
+    for (int64_t i = 0; i < cell_num; ++i) {
+      buffer_a1.push_back(f * 10000 + i);
+      buffer_coords.push_back(positions[i] / 100);
+      buffer_coords.push_back(positions[i] % 100);
+      cells[positions[i]] = f * 10000 + i;
+    }
+
+    TileDB_Array* tiledb_array;
+    if (tiledb_array_init(
+            tiledb_ctx,
+            &tiledb_array,
+            array_name.c_str(),
+            TILEDB_ARRAY_WRITE_UNSORTED,
+            NULL,
+            attributes,
+            2) != TILEDB_OK)
+      return TILEDB_ERR;
+    const void* buffers[] = { &buffer_a1[0], &buffer_coords[0] };
+    size_t buffer_sizes[] = {
+        buffer_a1.size() * sizeof(int),
+        buffer_coords.size() * sizeof(int64_t) };
+    if (tiledb_array_write(tiledb_array, buffers, buffer_sizes) != TILEDB_OK ||
+        tiledb_array_finalize(tiledb_array) != TILEDB_OK)
+      return TILEDB_ERR;
+  }
+
+  return TILEDB_OK;
+}
+
+/***************************/
+/********** TESTS **********/
+/***************************/
+TEST_F(SparseReadTest, OverlappingFragmentsWithTileGrid) {
+  ASSERT_EQ(TILEDB_OK, create_array());
+  std::map<int64_t, int> cells;
+  ASSERT_EQ(TILEDB_OK, write_fragments(cells));
+
+  // The entire domain, and a subarray that cuts through tiles
+  int64_t subarrays[][4] = { { 0, 99, 0, 99 }, { 15, 64, 23, 77 } };
+  for (int s = 0; s < 2; ++s) {
+    std::vector<std::pair<int64_t, int> > result;
+    ASSERT_EQ(TILEDB_OK, read_array(subarrays[s], 10000, result));
+    ASSERT_EQ(expected_cells(cells, subarrays[s]), result);
+  }
+}
+
+TEST_F(SparseReadTest, ParallelMergeMatchesSerial) {
+  ASSERT_EQ(TILEDB_OK, create_array());
+  std::map<int64_t, int> cells;
+  ASSERT_EQ(TILEDB_OK, write_fragments(cells));
+
+  // Small buffers, so that the reads take many rounds, which are merged by
+  // a single thread and then by several threads
+  int64_t subarray[] = { 0, 99, 0, 99 };
+  std::vector<std::pair<int64_t, int> > serial, parallel;
+#ifdef _OPENMP
+  int thread_num = omp_get_max_threads();
+  omp_set_num_threads(1);
+#endif
+  ASSERT_EQ(TILEDB_OK, read_array(subarray, 37, serial));
+#ifdef _OPENMP
+  omp_set_num_threads(4);
+#endif
+  ASSERT_EQ(TILEDB_OK, read_array(subarray, 37, parallel));
+#ifdef _OPENMP
+  omp_set_num_threads(thread_num);
+#endif
+
+  ASSERT_EQ(expected_cells(cells, subarray), serial);
+  ASSERT_EQ(serial, parallel);
+}
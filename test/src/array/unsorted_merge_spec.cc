@@ -0,0 +1,361 @@
+/**
+ * Copyright (c) 2016  Massachusetts Institute of Technology and Intel Corp.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Tests to check that the unsorted writes to a sparse array are spilled as
+ * sorted runs and merged into a single fragment upon finalization, when the
+ * unsorted_merge_buffer_size parameter is set
+ */
+
+#include <gtest/gtest.h>
+#include "c_api.h"
+#include <algorithm>
+#include <cstdlib>
+#include <dirent.h>
+#include <string>
+#include <vector>
+
+class UnsortedMergeTest: public testing::Test {
+  const std::string WORKSPACE = ".__workspace/";
+  const std::string ARRAYNAME = "test_100x100_10x10";
+
+public:
+  // TileDB context
+  TileDB_CTX* tiledb_ctx;
+  // Array name is initialized with the workspace folder
+  std::string array_name;
+
+  int create_array();
+  std::vector<std::string> list_dirs(const std::string& dirname);
+  int read_array(
+      std::vector<int64_t>& coords,
+      std::vector<int>& values,
+      std::vector<std::string>& strings);
+  int write_cells(
+      TileDB_Array* tiledb_array,
+      const std::vector<int64_t>& coords,
+      int value);
+
+  virtual void SetUp() {
+    // Initialize context with the default configuration parameters, and
+    // merge the unsorted writes through small buffers, so that the merge
+    // takes several passes
+    tiledb_ctx_init(&tiledb_ctx, NULL);
+    if (tiledb_ctx_set_config(
+            tiledb_ctx,
+            "unsorted_merge_buffer_size",
+            "4096") != TILEDB_OK ||
+        tiledb_workspace_create(
+            tiledb_ctx,
+            WORKSPACE.c_str()) != TILEDB_OK) {
+      exit(EXIT_FAILURE);
+    }
+
+    array_name.append(WORKSPACE);
+    array_name.append(ARRAYNAME);
+  }
+
+  virtual void TearDown() {
+    // Finalize TileDB context
+    tiledb_ctx_finalize(tiledb_ctx);
+
+    // Remove the temporary workspace
+    std::string command = "rm -rf ";
+    command.append(WORKSPACE);
+    int ret = system(command.c_str());
+  }
+};
+
+/**
+ * Create a sparse 100x100 array with 10x10 tiles, an int attribute and a
+ * variable-sized char attribute
+ */
+int UnsortedMergeTest::create_array() {
+  const char* attributes[] = { "ATTR_INT32", "ATTR_CHAR_VAR" };
+  const char* dimensions[] = { "X", "Y" };
+  int64_t domain[] = { 0, 99, 0, 99 };
+  int64_t tile_extents[] = { 10, 10 };
+  const int cell_val_num[] = { 1, TILEDB_VAR_NUM };
+  const int types[] = { TILEDB_INT32, TILEDB_CHAR, TILEDB_INT64 };
+  const int compression[] = {
+      TILEDB_GZIP, TILEDB_GZIP, TILEDB_NO_COMPRESSION };
+
+  TileDB_ArraySchema schema;
+  tiledb_array_set_schema(
+      &schema,
+      array_name.c_str(),
+      attributes,
+      2,
+      20,
+      TILEDB_ROW_MAJOR,
+      cell_val_num,
+      compression,
+      0,
+      dimensions,
+      2,
+      domain,
+      4*sizeof(int64_t),
+      tile_extents,
+      2*sizeof(int64_t),
+      0,
+      types);
+
+  int rc = tiledb_array_create(tiledb_ctx, &schema);
+  tiledb_array_free_schema(&schema);
+  return rc;
+}
+
+/**
+ * Return the names of the subdirectories of the input directory, including
+ * the hidden ones
+ */
+std::vector<std::string> UnsortedMergeTest::list_dirs(
+    const std::string& dirname) {
+  std::vector<std::string> dirs;
+  DIR* dir = opendir(dirname.c_str());
+  if (dir == NULL)
+    return dirs;
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    std::string name = entry->d_name;
+    if (entry->d_type == DT_DIR && name != "." && name != "..")
+      dirs.push_back(name);
+  }
+  closedir(dir);
+  return dirs;
+}
+
+/**
+ * Read the entire array in the global cell order
+ */
+int UnsortedMergeTest::read_array(
+    std::vector<int64_t>& coords,
+    std::vector<int>& values,
+    std::vector<std::string>& strings) {
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_READ,
+          NULL,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  std::vector<int> buffer_a1(10000);
+  std::vector<size_t> buffer_a2(10000);
+  std::vector<char> buffer_var_a2(400000);
+  std::vector<int64_t> buffer_coords(20000);
+  void* buffers[] = {
+      &buffer_a1[0], &buffer_a2[0], &buffer_var_a2[0], &buffer_coords[0] };
+  size_t buffer_sizes[] = {
+      buffer_a1.size() * sizeof(int),
+      buffer_a2.size() * sizeof(size_t),
+      buffer_var_a2.size(),
+      buffer_coords.size() * sizeof(int64_t) };
+  int rc = tiledb_array_read(tiledb_array, buffers, buffer_sizes);
+  for (int i = 0; i < 3; ++i)
+    if (rc == TILEDB_OK && tiledb_array_overflow(tiledb_array, i))
+      rc = TILEDB_ERR;
+
+  int64_t cell_num = buffer_sizes[0] / sizeof(int);
+  for (int64_t i = 0; rc == TILEDB_OK && i < cell_num; ++i) {
+    size_t end = (i == cell_num - 1) ? buffer_sizes[2] : buffer_a2[i+1];
+    values.push_back(buffer_a1[i]);
+    strings.push_back(
+        std::string(&buffer_var_a2[buffer_a2[i]], end - buffer_a2[i]));
+    coords.push_back(buffer_coords[2*i]);
+    coords.push_back(buffer_coords[2*i+1]);
+  }
+
+  if (tiledb_array_finalize(tiledb_array) != TILEDB_OK)
+    return TILEDB_ERR;
+  return rc;
+}
+
+/**
+ * Write the input cells in a single unsorted write, where each cell gets the
+ * input value plus its position in the input, and a string of as many 'a'
+ * characters as its row coordinate plus one
+ */
+int UnsortedMergeTest::write_cells(
+    TileDB_Array* tiledb_array,
+    const std::vector<int64_t>& coords,
+    int value) {
+  std::vector<int> buffer_a1;
+  std::vector<size_t> buffer_a2;
+  std::string buffer_var_a2;
+  for (size_t i = 0; i < coords.size() / 2; ++i) {
+    buffer_a1.push_back(value + i);
+    buffer_a2.push_back(buffer_var_a2.size());
+    buffer_var_a2.append(coords[2*i] + 1, 'a');
+  }
+  const void* buffers[] = {
+      &buffer_a1[0], &buffer_a2[0], buffer_var_a2.c_str(), &coords[0] };
+  size_t buffer_sizes[] = {
+      buffer_a1.size() * sizeof(int),
+      buffer_a2.size() * sizeof(size_t),
+      buffer_var_a2.size(),
+      coords.size() * sizeof(int64_t) };
+  return tiledb_array_write(tiledb_array, buffers, buffer_sizes);
+}
+
+/***************************/
+/********** TESTS **********/
+/***************************/
+TEST_F(UnsortedMergeTest, SeveralWritesMakeOneFragment) {
+  ASSERT_EQ(TILEDB_OK, create_array());
+
+  // Three writes of 1000 distinct cells each
+  std::vector<int64_t> cells(10000);
+  for (int64_t i = 0; i < 10000; ++i)
+    cells[i] = i;
+  srand(7);
+  std::random_shuffle(cells.begin(), cells.end());
+  TileDB_Array* tiledb_array;
+  ASSERT_EQ(
+      TILEDB_OK,
+      tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_WRITE_UNSORTED,
+          NULL,
+          NULL,
+          0));
+  for (int w = 0; w < 3; ++w) {
+    std::vector<int64_t> coords;
+    for (int64_t k = 0; k < 1000; ++k) {
+      coords.push_back(cells[w * 1000 + k] / 100);
+      coords.push_back(cells[w * 1000 + k] % 100);
+    }
+    ASSERT_EQ(TILEDB_OK, write_cells(tiledb_array, coords, 100000 * w));
+  }
+  ASSERT_EQ(TILEDB_OK, tiledb_array_finalize(tiledb_array));
+
+  // A single fragment holds the cells, and the runs are deleted
+  std::vector<std::string> dirs = list_dirs(array_name);
+  ASSERT_EQ(size_t(1), dirs.size());
+  ASSERT_EQ(0, dirs[0].compare(0, 2, "__"));
+  ASSERT_EQ(size_t(0), list_dirs(array_name + "/" + dirs[0]).size());
+
+  // The cells are read in the global cell order, with the values of their
+  // write
+  std::vector<int64_t> coords;
+  std::vector<int> values;
+  std::vector<std::string> strings;
+  ASSERT_EQ(TILEDB_OK, read_array(coords, values, strings));
+  std::vector<int64_t> expected(cells.begin(), cells.begin() + 3000);
+  for (int64_t k = 0; k < 3000; ++k) {
+    int64_t x = expected[k] / 100, y = expected[k] % 100;
+    expected[k] = ((x / 10 * 10 + y / 10) * 10000) + x * 100 + y;
+  }
+  std::sort(expected.begin(), expected.end());
+  ASSERT_EQ(size_t(3000), values.size());
+  for (int64_t i = 0; i < 3000; ++i) {
+    int64_t cell = expected[i] % 10000;
+    int64_t k = std::find(cells.begin(), cells.end(), cell) - cells.begin();
+    ASSERT_EQ(cell / 100, coords[2*i]);
+    ASSERT_EQ(cell % 100, coords[2*i+1]);
+    ASSERT_EQ(k / 1000 * 100000 + k % 1000, values[i]);
+    ASSERT_EQ(std::string(cell / 100 + 1, 'a'), strings[i]);
+  }
+}
+
+TEST_F(UnsortedMergeTest, DuplicatesAcrossRuns) {
+  ASSERT_EQ(TILEDB_OK, create_array());
+
+  // The second write overwrites the odd rows of the first one
+  TileDB_Array* tiledb_array;
+  ASSERT_EQ(
+      TILEDB_OK,
+      tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_WRITE_UNSORTED,
+          NULL,
+          NULL,
+          0));
+  std::vector<int64_t> first, second;
+  for (int64_t i = 19; i >= 0; --i) {
+    for (int64_t j = 0; j < 20; ++j) {
+      first.push_back(i);
+      first.push_back(j);
+      if (i % 2 == 1) {
+        second.push_back(i);
+        second.push_back(j);
+      }
+    }
+  }
+  ASSERT_EQ(TILEDB_OK, write_cells(tiledb_array, first, 0));
+  ASSERT_EQ(TILEDB_OK, write_cells(tiledb_array, second, 1000));
+  ASSERT_EQ(TILEDB_OK, tiledb_array_finalize(tiledb_array));
+  ASSERT_EQ(size_t(1), list_dirs(array_name).size());
+
+  // Every cell is read once, with the value of the last write
+  std::vector<int64_t> coords;
+  std::vector<int> values;
+  std::vector<std::string> strings;
+  ASSERT_EQ(TILEDB_OK, read_array(coords, values, strings));
+  ASSERT_EQ(size_t(400), values.size());
+  for (size_t k = 0; k < values.size(); ++k) {
+    int64_t i = coords[2*k], j = coords[2*k+1];
+    if (i % 2 == 1)
+      ASSERT_EQ(1000 + (19 - i) / 2 * 20 + j, values[k]);
+    else
+      ASSERT_EQ((19 - i) * 20 + j, values[k]);
+  }
+}
+
+TEST_F(UnsortedMergeTest, FailedMergeDeletesRuns) {
+  ASSERT_EQ(TILEDB_OK, create_array());
+
+  TileDB_Array* tiledb_array;
+  ASSERT_EQ(
+      TILEDB_OK,
+      tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_WRITE_UNSORTED,
+          NULL,
+          NULL,
+          0));
+  std::vector<int64_t> coords = { 5, 5, 1, 2, 70, 30 };
+  ASSERT_EQ(TILEDB_OK, write_cells(tiledb_array, coords, 0));
+  ASSERT_EQ(TILEDB_OK, write_cells(tiledb_array, coords, 1000));
+
+  // Delete the book-keeping of the first run, so that it cannot be merged
+  std::vector<std::string> dirs = list_dirs(array_name);
+  ASSERT_EQ(size_t(1), dirs.size());
+  std::string run_name =
+      array_name + "/" + dirs[0] + "/" + TILEDB_RUNS_DIRNAME + "/__run_0";
+  std::string command =
+      "rm " + run_name + "/" + TILEDB_BOOK_KEEPING_FILENAME + "*";
+  ASSERT_EQ(0, system(command.c_str()));
+
+  // The merge fails, and neither the runs nor the new fragment are left
+  ASSERT_EQ(TILEDB_ERR, tiledb_array_finalize(tiledb_array));
+  ASSERT_EQ(size_t(0), list_dirs(array_name).size());
+}
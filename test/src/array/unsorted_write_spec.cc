@@ -0,0 +1,411 @@
+/**
+ * Copyright (c) 2016  Massachusetts Institute of Technology and Intel Corp.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Tests to check that unsorted writes to sparse arrays store the cells in
+ * the global cell order, for every cell order and coordinates type
+ */
+
+#include <gtest/gtest.h>
+#include "array_metadata_cache.h"
+#include "c_api.h"
+#include "storage_manager.h"
+#include <algorithm>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+class UnsortedWriteTest: public testing::Test {
+  const std::string WORKSPACE = ".__workspace/";
+  const std::string ARRAYNAME = "test_100x100_10x10";
+
+public:
+  // TileDB context
+  TileDB_CTX* tiledb_ctx;
+  // Array name is initialized with the workspace folder
+  std::string array_name;
+
+  int create_array(int cell_order, int coords_type);
+  int create_fixed_char_array();
+  template<class T>
+  void check_unsorted_write(int cell_order, int coords_type);
+  template<class T>
+  int global_order(
+      const std::vector<T>& coords,
+      std::vector<int64_t>& cell_pos);
+  std::vector<char> read_fragment_file(const std::string& attribute);
+
+  virtual void SetUp() {
+    // Initialize context with the default configuration parameters
+    tiledb_ctx_init(&tiledb_ctx, NULL);
+    if (tiledb_workspace_create(
+        tiledb_ctx,
+        WORKSPACE.c_str()) != TILEDB_OK) {
+      exit(EXIT_FAILURE);
+    }
+
+    array_name.append(WORKSPACE);
+    array_name.append(ARRAYNAME);
+    srand(7);
+  }
+
+  virtual void TearDown() {
+    // Finalize TileDB context
+    tiledb_ctx_finalize(tiledb_ctx);
+
+    // Remove the temporary workspace
+    std::string command = "rm -rf ";
+    command.append(WORKSPACE);
+    int ret = system(command.c_str());
+  }
+};
+
+/** Orders cells by their coordinates in the global order of an array. */
+template<class T>
+class GlobalOrderLess {
+ public:
+  GlobalOrderLess(const ArraySchema* array_schema, const std::vector<T>& coords)
+      : array_schema_(array_schema), coords_(coords) { }
+  bool operator()(int64_t a, int64_t b) const {
+    return array_schema_->tile_cell_order_cmp<T>(
+               &coords_[2*a],
+               &coords_[2*b]) < 0;
+  }
+ private:
+  const ArraySchema* array_schema_;
+  const std::vector<T>& coords_;
+};
+
+/**
+ * Create a sparse 100x100 array with 10x10 tiles (unless the cell order is
+ * Hilbert), a capacity of 50, an int attribute and a variable-sized char
+ * attribute, all uncompressed so that the cells can be checked directly in
+ * the fragment files
+ */
+int UnsortedWriteTest::create_array(int cell_order, int coords_type) {
+  const char* attributes[] = { "ATTR_INT32", "ATTR_CHAR_VAR" };
+  const char* dimensions[] = { "X", "Y" };
+  int64_t domain_int64[] = { 0, 99, 0, 99 };
+  int64_t tile_extents_int64[] = { 10, 10 };
+  float domain_float[] = { 0, 99, 0, 99 };
+  float tile_extents_float[] = { 10, 10 };
+  bool float_coords = (coords_type == TILEDB_FLOAT32);
+  // The Hilbert order applies to arrays without a tile grid
+  const void* tile_extents = NULL;
+  size_t tile_extents_size = 0;
+  if (cell_order != TILEDB_HILBERT) {
+    tile_extents = float_coords ? (void*) tile_extents_float
+                                : (void*) tile_extents_int64;
+    tile_extents_size = float_coords ? 2*sizeof(float) : 2*sizeof(int64_t);
+  }
+  const int cell_val_num[] = { 1, TILEDB_VAR_NUM };
+  const int types[] = { TILEDB_INT32, TILEDB_CHAR, coords_type };
+  const int compression[] = {
+      TILEDB_NO_COMPRESSION, TILEDB_NO_COMPRESSION, TILEDB_NO_COMPRESSION };
+
+  TileDB_ArraySchema schema;
+  tiledb_array_set_schema(
+      &schema,
+      array_name.c_str(),
+      attributes,
+      2,
+      50,
+      cell_order,
+      cell_val_num,
+      compression,
+      0,
+      dimensions,
+      2,
+      float_coords ? (void*) domain_float : (void*) domain_int64,
+      float_coords ? 4*sizeof(float) : 4*sizeof(int64_t),
+      tile_extents,
+      tile_extents_size,
+      0,
+      types);
+
+  int rc = tiledb_array_create(tiledb_ctx, &schema);
+  tiledb_array_free_schema(&schema);
+  return rc;
+}
+
+/**
+ * Create a sparse 100x100 array with 10x10 tiles and uncompressed char
+ * attributes of 4, 8, 16 and 5 characters per cell
+ */
+int UnsortedWriteTest::create_fixed_char_array() {
+  const char* attributes[] = { "ATTR_4", "ATTR_8", "ATTR_16", "ATTR_5" };
+  const char* dimensions[] = { "X", "Y" };
+  int64_t domain[] = { 0, 99, 0, 99 };
+  int64_t tile_extents[] = { 10, 10 };
+  const int cell_val_num[] = { 4, 8, 16, 5 };
+  const int types[] = {
+      TILEDB_CHAR, TILEDB_CHAR, TILEDB_CHAR, TILEDB_CHAR, TILEDB_INT64 };
+  const int compression[] = {
+      TILEDB_NO_COMPRESSION, TILEDB_NO_COMPRESSION, TILEDB_NO_COMPRESSION,
+      TILEDB_NO_COMPRESSION, TILEDB_NO_COMPRESSION };
+
+  TileDB_ArraySchema schema;
+  tiledb_array_set_schema(
+      &schema,
+      array_name.c_str(),
+      attributes,
+      4,
+      50,
+      TILEDB_ROW_MAJOR,
+      cell_val_num,
+      compression,
+      0,
+      dimensions,
+      2,
+      domain,
+      4*sizeof(int64_t),
+      tile_extents,
+      2*sizeof(int64_t),
+      0,
+      types);
+
+  int rc = tiledb_array_create(tiledb_ctx, &schema);
+  tiledb_array_free_schema(&schema);
+  return rc;
+}
+
+/**
+ * Write distinct random cells in a single unsorted write, where the k-th
+ * cell has value k and a string of k % 5 + 1 characters, then compare the
+ * cells stored in the fragment with their expected global order
+ */
+template<class T>
+void UnsortedWriteTest::check_unsorted_write(int cell_order, int coords_type) {
+  ASSERT_EQ(TILEDB_OK, create_array(cell_order, coords_type));
+
+  // Distinct coordinates, with fractional parts if they are real
+  int64_t cell_num = 3000;
+  std::vector<int64_t> cells(9900);
+  for (int64_t i = 0; i < 9900; ++i)
+    cells[i] = i;
+  std::random_shuffle(cells.begin(), cells.end());
+  std::vector<int> buffer_a1;
+  std::vector<size_t> buffer_a2_offsets;
+  std::string buffer_a2;
+  std::vector<T> buffer_coords;
+  for (int64_t k = 0; k < cell_num; ++k) {
+    buffer_a1.push_back(k);
+    buffer_a2_offsets.push_back(buffer_a2.size());
+    buffer_a2.append(k % 5 + 1, 'a' + k % 26);
+    buffer_coords.push_back(cells[k] / 100 + T(cells[k] % 4) / 5);
+    buffer_coords.push_back(cells[k] % 100);
+  }
+
+  TileDB_Array* tiledb_array;
+  ASSERT_EQ(
+      TILEDB_OK,
+      tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_WRITE_UNSORTED,
+          NULL,
+          NULL,
+          0));
+  const void* buffers[] = {
+      &buffer_a1[0], &buffer_a2_offsets[0], buffer_a2.c_str(),
+      &buffer_coords[0] };
+  size_t buffer_sizes[] = {
+      buffer_a1.size() * sizeof(int),
+      buffer_a2_offsets.size() * sizeof(size_t),
+      buffer_a2.size(),
+      buffer_coords.size() * sizeof(T) };
+  ASSERT_EQ(TILEDB_OK, tiledb_array_write(tiledb_array, buffers, buffer_sizes));
+  ASSERT_EQ(TILEDB_OK, tiledb_array_finalize(tiledb_array));
+
+  // Sort the written cells with the cell comparator of the array schema
+  std::vector<int64_t> expected;
+  ASSERT_EQ(TILEDB_OK, global_order(buffer_coords, expected));
+
+  // The fragment files hold the cells in the global order
+  std::vector<char> file_a1 = read_fragment_file("ATTR_INT32");
+  std::vector<char> file_a2 = read_fragment_file("ATTR_CHAR_VAR_var");
+  std::vector<char> file_coords = read_fragment_file(TILEDB_COORDS);
+  ASSERT_EQ(cell_num * sizeof(int), file_a1.size());
+  ASSERT_EQ(buffer_a2.size(), file_a2.size());
+  ASSERT_EQ(buffer_coords.size() * sizeof(T), file_coords.size());
+  const int* stored_a1 = reinterpret_cast<const int*>(&file_a1[0]);
+  const T* stored_coords = reinterpret_cast<const T*>(&file_coords[0]);
+  std::string expected_a2;
+  for (int64_t i = 0; i < cell_num; ++i) {
+    int64_t k = expected[i];
+    ASSERT_EQ(k, stored_a1[i]);
+    ASSERT_EQ(buffer_coords[2*k], stored_coords[2*i]);
+    ASSERT_EQ(buffer_coords[2*k+1], stored_coords[2*i+1]);
+    expected_a2.append(k % 5 + 1, 'a' + k % 26);
+  }
+  ASSERT_EQ(expected_a2, std::string(file_a2.begin(), file_a2.end()));
+}
+
+/**
+ * Compute the positions of the input cells in the global cell order, with
+ * the cell comparator of the array schema
+ */
+template<class T>
+int UnsortedWriteTest::global_order(
+    const std::vector<T>& coords,
+    std::vector<int64_t>& cell_pos) {
+  ArrayMetadataCache::instance()->clear();
+  StorageManager storage_manager;
+  if (storage_manager.init(NULL) != TILEDB_SM_OK)
+    return TILEDB_ERR;
+  Array* array;
+  if (storage_manager.array_init(
+          array,
+          array_name.c_str(),
+          TILEDB_ARRAY_READ,
+          NULL,
+          NULL,
+          0) != TILEDB_SM_OK)
+    return TILEDB_ERR;
+
+  int64_t cell_num = coords.size() / 2;
+  cell_pos.resize(cell_num);
+  for (int64_t k = 0; k < cell_num; ++k)
+    cell_pos[k] = k;
+  std::sort(
+      cell_pos.begin(),
+      cell_pos.end(),
+      GlobalOrderLess<T>(array->array_schema(), coords));
+
+  if (storage_manager.array_finalize(array) != TILEDB_SM_OK)
+    return TILEDB_ERR;
+  return TILEDB_OK;
+}
+
+/**
+ * Return the contents of an attribute file of the single fragment of the
+ * array
+ */
+std::vector<char> UnsortedWriteTest::read_fragment_file(
+    const std::string& attribute) {
+  std::vector<char> contents;
+  DIR* dir = opendir(array_name.c_str());
+  if (dir == NULL)
+    return contents;
+  std::string filename;
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    std::string name = entry->d_name;
+    if (name.compare(0, 2, "__") == 0 && entry->d_type == DT_DIR)
+      filename = array_name + "/" + name + "/" + attribute +
+                 TILEDB_FILE_SUFFIX;
+  }
+  closedir(dir);
+
+  std::ifstream file(filename.c_str(), std::ios::binary);
+  contents.assign(
+      std::istreambuf_iterator<char>(file),
+      std::istreambuf_iterator<char>());
+  return contents;
+}
+
+/***************************/
+/********** TESTS **********/
+/***************************/
+TEST_F(UnsortedWriteTest, RowMajor) {
+  check_unsorted_write<int64_t>(TILEDB_ROW_MAJOR, TILEDB_INT64);
+}
+
+TEST_F(UnsortedWriteTest, ColMajor) {
+  check_unsorted_write<int64_t>(TILEDB_COL_MAJOR, TILEDB_INT64);
+}
+
+TEST_F(UnsortedWriteTest, Hilbert) {
+  check_unsorted_write<int64_t>(TILEDB_HILBERT, TILEDB_INT64);
+}
+
+TEST_F(UnsortedWriteTest, FloatCoordinates) {
+  check_unsorted_write<float>(TILEDB_ROW_MAJOR, TILEDB_FLOAT32);
+  ASSERT_EQ(TILEDB_OK, tiledb_delete(tiledb_ctx, array_name.c_str()));
+  check_unsorted_write<float>(TILEDB_COL_MAJOR, TILEDB_FLOAT32);
+  ASSERT_EQ(TILEDB_OK, tiledb_delete(tiledb_ctx, array_name.c_str()));
+  check_unsorted_write<float>(TILEDB_HILBERT, TILEDB_FLOAT32);
+}
+
+TEST_F(UnsortedWriteTest, UnalignedFixedSizedCells) {
+  ASSERT_EQ(TILEDB_OK, create_fixed_char_array());
+
+  // The cell values start at odd addresses, and the k-th cell of each
+  // attribute holds characters derived from k
+  int64_t cell_num = 3000;
+  int cell_sizes[] = { 4, 8, 16, 5 };
+  std::vector<std::vector<char> > values(4);
+  for (int a = 0; a < 4; ++a) {
+    values[a].push_back(0);
+    for (int64_t k = 0; k < cell_num; ++k)
+      for (int c = 0; c < cell_sizes[a]; ++c)
+        values[a].push_back('!' + (k * 7 + c + a) % 90);
+  }
+  std::vector<int64_t> cells(10000);
+  for (int64_t i = 0; i < 10000; ++i)
+    cells[i] = i;
+  std::random_shuffle(cells.begin(), cells.end());
+  std::vector<int64_t> buffer_coords;
+  for (int64_t k = 0; k < cell_num; ++k) {
+    buffer_coords.push_back(cells[k] / 100);
+    buffer_coords.push_back(cells[k] % 100);
+  }
+
+  TileDB_Array* tiledb_array;
+  ASSERT_EQ(
+      TILEDB_OK,
+      tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_WRITE_UNSORTED,
+          NULL,
+          NULL,
+          0));
+  const void* buffers[] = {
+      &values[0][1], &values[1][1], &values[2][1], &values[3][1],
+      &buffer_coords[0] };
+  size_t buffer_sizes[] = {
+      values[0].size() - 1, values[1].size() - 1, values[2].size() - 1,
+      values[3].size() - 1, buffer_coords.size() * sizeof(int64_t) };
+  ASSERT_EQ(TILEDB_OK, tiledb_array_write(tiledb_array, buffers, buffer_sizes));
+  ASSERT_EQ(TILEDB_OK, tiledb_array_finalize(tiledb_array));
+
+  // Every attribute file holds the cells in the global order
+  std::vector<int64_t> expected;
+  ASSERT_EQ(TILEDB_OK, global_order(buffer_coords, expected));
+  const char* attributes[] = { "ATTR_4", "ATTR_8", "ATTR_16", "ATTR_5" };
+  for (int a = 0; a < 4; ++a) {
+    std::vector<char> stored = read_fragment_file(attributes[a]);
+    ASSERT_EQ(values[a].size() - 1, stored.size());
+    for (int64_t i = 0; i < cell_num; ++i) {
+      int64_t k = expected[i];
+      ASSERT_EQ(
+          std::string(&values[a][1 + k * cell_sizes[a]], cell_sizes[a]),
+          std::string(&stored[i * cell_sizes[a]], cell_sizes[a]));
+    }
+  }
+}
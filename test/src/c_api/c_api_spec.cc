@@ -27,6 +27,7 @@
 
 #include <gtest/gtest.h>
 #include "c_api.h"
+#include "tile_cache.h"
 #include <iostream>
 #include <time.h>
 #include <sys/time.h>
@@ -453,3 +454,26 @@ TEST_F(TileDBAPITest, DenseArrayRandomUpdates) {
 
   ASSERT_EQ(fail, false);
 }
+
+TEST_F(TileDBAPITest, CacheSizesAreProcessWide) {
+  // The cache sizes set in a context apply to the entire process, and the
+  // initialization of another context does not reset them
+  ASSERT_EQ(
+      TILEDB_OK,
+      tiledb_ctx_set_config(tiledb_ctx, "tile_cache_size", "12345"));
+  TileDB_CTX* other_ctx;
+  ASSERT_EQ(TILEDB_OK, tiledb_ctx_init(&other_ctx, NULL));
+  ASSERT_EQ(size_t(12345), TileCache::instance()->capacity());
+  ASSERT_EQ(TILEDB_OK, tiledb_ctx_finalize(other_ctx));
+
+  // Restore the default for the other tests
+  std::ostringstream tile_cache_size;
+  tile_cache_size << TILEDB_TILE_CACHE_SIZE;
+  ASSERT_EQ(
+      TILEDB_OK,
+      tiledb_ctx_set_config(
+          tiledb_ctx,
+          "tile_cache_size",
+          tile_cache_size.str().c_str()));
+  ASSERT_EQ(size_t(TILEDB_TILE_CACHE_SIZE), TileCache::instance()->capacity());
+}
@@ -0,0 +1,421 @@
+/**
+ * Copyright (c) 2016  Massachusetts Institute of Technology and Intel Corp.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Tests to check that the memory-mapped book-keeping file of a fragment is
+ * written and loaded correctly, that damaged files are rejected, and that
+ * the GZIP-compressed book-keeping of older fragments is still loaded
+ */
+
+#include <gtest/gtest.h>
+#include "array_metadata_cache.h"
+#include "book_keeping.h"
+#include "c_api.h"
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <zlib.h>
+
+class BookKeepingTest: public testing::Test {
+  const std::string WORKSPACE = ".__workspace/";
+  const std::string ARRAYNAME = "sparse_test_100x100_10x10";
+
+public:
+  const int CELL_NUM = 1000;
+
+  // TileDB context
+  TileDB_CTX* tiledb_ctx;
+  // Array name is initialized with the workspace folder
+  std::string array_name;
+  // The cells read from the array
+  std::vector<int> a1;
+  std::vector<size_t> a2_offsets;
+  std::vector<char> a2;
+  std::vector<int64_t> coords;
+
+  std::string book_keeping_filename();
+  int create_sparse_array();
+  std::vector<char> read_file(const std::string& filename);
+  int read_sparse_array();
+  int write_file(const std::string& filename, const std::vector<char>& data);
+  int write_legacy_book_keeping();
+  int write_sparse_array();
+
+  virtual void SetUp() {
+    // Initialize context with the default configuration parameters
+    tiledb_ctx_init(&tiledb_ctx, NULL);
+    if (tiledb_workspace_create(
+        tiledb_ctx,
+        WORKSPACE.c_str()) != TILEDB_OK) {
+      exit(EXIT_FAILURE);
+    }
+
+    array_name.append(WORKSPACE);
+    array_name.append(ARRAYNAME);
+  }
+
+  virtual void TearDown() {
+    // Finalize TileDB context
+    tiledb_ctx_finalize(tiledb_ctx);
+
+    // Remove the temporary workspace
+    std::string command = "rm -rf ";
+    command.append(WORKSPACE);
+    int ret = system(command.c_str());
+  }
+};
+
+/**
+ * Return the book-keeping file of the single fragment of the array
+ */
+std::string BookKeepingTest::book_keeping_filename() {
+  std::string filename;
+  DIR* dir = opendir(array_name.c_str());
+  if (dir == NULL)
+    return filename;
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    std::string name = entry->d_name;
+    if (name.compare(0, 2, "__") == 0 && entry->d_type == DT_DIR)
+      filename = array_name + "/" + name + "/" +
+                 TILEDB_BOOK_KEEPING_FILENAME + TILEDB_FILE_SUFFIX;
+  }
+  closedir(dir);
+  return filename;
+}
+
+/**
+ * Create a sparse 100x100 array with 10x10 tiles, a fixed-sized and a
+ * variable-sized attribute
+ */
+int BookKeepingTest::create_sparse_array() {
+  const char* attributes[] = { "ATTR_INT32", "ATTR_CHAR_VAR" };
+  const char* dimensions[] = { "X", "Y" };
+  int64_t domain[] = { 0, 99, 0, 99 };
+  int64_t tile_extents[] = { 10, 10 };
+  const int cell_val_num[] = { 1, TILEDB_VAR_NUM };
+  const int types[] = { TILEDB_INT32, TILEDB_CHAR, TILEDB_INT64 };
+  const int compression[] =
+      { TILEDB_GZIP, TILEDB_GZIP, TILEDB_NO_COMPRESSION };
+
+  TileDB_ArraySchema schema;
+  tiledb_array_set_schema(
+      &schema,
+      array_name.c_str(),
+      attributes,
+      2,
+      50,
+      TILEDB_ROW_MAJOR,
+      cell_val_num,
+      compression,
+      0,
+      dimensions,
+      2,
+      domain,
+      4*sizeof(int64_t),
+      tile_extents,
+      2*sizeof(int64_t),
+      0,
+      types);
+
+  int rc = tiledb_array_create(tiledb_ctx, &schema);
+  tiledb_array_free_schema(&schema);
+  return rc;
+}
+
+/**
+ * Read the entire array into the member buffers. The book-keeping cache is
+ * cleared first, so that the book-keeping is loaded from the disk.
+ */
+int BookKeepingTest::read_sparse_array() {
+  ArrayMetadataCache::instance()->clear();
+
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_READ,
+          NULL,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  a1.assign(2 * CELL_NUM, 0);
+  a2_offsets.assign(2 * CELL_NUM, 0);
+  a2.assign(20 * CELL_NUM, 0);
+  coords.assign(4 * CELL_NUM, 0);
+  void* buffers[] = { &a1[0], &a2_offsets[0], &a2[0], &coords[0] };
+  size_t buffer_sizes[] = {
+      a1.size() * sizeof(int),
+      a2_offsets.size() * sizeof(size_t),
+      a2.size(),
+      coords.size() * sizeof(int64_t) };
+  if (tiledb_array_read(tiledb_array, buffers, buffer_sizes) != TILEDB_OK ||
+      tiledb_array_overflow(tiledb_array, 0)) {
+    tiledb_array_finalize(tiledb_array);
+    return TILEDB_ERR;
+  }
+  a1.resize(buffer_sizes[0] / sizeof(int));
+  a2_offsets.resize(buffer_sizes[1] / sizeof(size_t));
+  a2.resize(buffer_sizes[2]);
+  coords.resize(buffer_sizes[3] / sizeof(int64_t));
+
+  return tiledb_array_finalize(tiledb_array);
+}
+
+std::vector<char> BookKeepingTest::read_file(const std::string& filename) {
+  std::vector<char> data;
+  struct stat st;
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd == -1 || fstat(fd, &st))
+    return data;
+  data.resize(st.st_size);
+  if (pread(fd, &data[0], st.st_size, 0) != st.st_size)
+    data.clear();
+  close(fd);
+  return data;
+}
+
+int BookKeepingTest::write_file(
+    const std::string& filename,
+    const std::vector<char>& data) {
+  int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRWXU);
+  if (fd == -1)
+    return TILEDB_ERR;
+  ssize_t written = write(fd, data.empty() ? NULL : &data[0], data.size());
+  close(fd);
+  return (written == ssize_t(data.size())) ? TILEDB_OK : TILEDB_ERR;
+}
+
+/**
+ * Replace the book-keeping file of the fragment with a GZIP-compressed file
+ * of the format written before the book-keeping was memory-mapped, i.e.,
+ * with the sections of the current file each preceded by its number of
+ * entries, and without the tile statistics and the R-tree
+ */
+int BookKeepingTest::write_legacy_book_keeping() {
+  const int attribute_num = 2;
+  const size_t coords_size = 2 * sizeof(int64_t);
+  std::string filename = book_keeping_filename();
+  std::vector<char> data = read_file(filename);
+  if (data.empty())
+    return TILEDB_ERR;
+
+  // Parse the header of the current format
+  const char* p = &data[0];
+  int version;
+  memcpy(&version, p, sizeof(int));
+  if (version != TILEDB_BK_VERSION)
+    return TILEDB_ERR;
+  size_t domain_size;
+  memcpy(&domain_size, p + 2*sizeof(int), sizeof(size_t));
+  const int64_t* nums =
+      reinterpret_cast<const int64_t*>(p + 2*sizeof(int) + sizeof(size_t));
+  int64_t last_tile_cell_num = nums[0];
+  const int64_t* section_nums = &nums[1];
+  const char* section = reinterpret_cast<const char*>(&nums[4*attribute_num+4]);
+
+  // Each section with the size of its entries, in file order
+  std::vector<std::pair<int64_t, size_t> > sections;
+  sections.push_back(std::make_pair(section_nums[0], coords_size * 2));
+  sections.push_back(std::make_pair(section_nums[1], coords_size * 2));
+  for (int i = 0; i < attribute_num + 1; ++i)
+    sections.push_back(std::make_pair(section_nums[2+i], sizeof(off_t)));
+  for (int i = 0; i < attribute_num; ++i)
+    sections.push_back(
+        std::make_pair(section_nums[3+attribute_num+i], sizeof(off_t)));
+  for (int i = 0; i < attribute_num; ++i)
+    sections.push_back(
+        std::make_pair(section_nums[3+2*attribute_num+i], sizeof(size_t)));
+
+  // Write the legacy file
+  gzFile fd = gzopen((filename + TILEDB_GZIP_SUFFIX).c_str(), "wb");
+  if (fd == NULL)
+    return TILEDB_ERR;
+  gzwrite(fd, &domain_size, sizeof(size_t));
+  gzwrite(fd, section, domain_size);
+  section += domain_size;
+  for (size_t i = 0; i < sections.size(); ++i) {
+    size_t section_size = sections[i].first * sections[i].second;
+    gzwrite(fd, &sections[i].first, sizeof(int64_t));
+    if (section_size != 0)
+      gzwrite(fd, section, section_size);
+    section += section_size;
+  }
+  gzwrite(fd, &last_tile_cell_num, sizeof(int64_t));
+  if (gzclose(fd) != Z_OK)
+    return TILEDB_ERR;
+
+  return (unlink(filename.c_str()) == 0) ? TILEDB_OK : TILEDB_ERR;
+}
+
+/**
+ * Write CELL_NUM cells in ten columns, where the fixed-sized value of cell
+ * (i,j) is i * 100 + j and the variable-sized value holds (j % 5) + 1
+ * characters
+ */
+int BookKeepingTest::write_sparse_array() {
+  std::vector<int> buffer_a1;
+  std::vector<size_t> buffer_a2_offsets;
+  std::string buffer_a2;
+  std::vector<int64_t> buffer_coords;
+  for (int64_t i = 0; i < CELL_NUM / 10; ++i) {
+    for (int64_t j = 0; j < 10; ++j) {
+      buffer_a1.push_back(i * 100 + j);
+      buffer_a2_offsets.push_back(buffer_a2.size());
+      buffer_a2.append(j % 5 + 1, 'a' + j);
+      buffer_coords.push_back(i);
+      buffer_coords.push_back(j);
+    }
+  }
+
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_WRITE,
+          NULL,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  const void* buffers[] = {
+      &buffer_a1[0], &buffer_a2_offsets[0], buffer_a2.c_str(),
+      &buffer_coords[0] };
+  size_t buffer_sizes[] = {
+      buffer_a1.size() * sizeof(int),
+      buffer_a2_offsets.size() * sizeof(size_t),
+      buffer_a2.size(),
+      buffer_coords.size() * sizeof(int64_t) };
+  if (tiledb_array_write(tiledb_array, buffers, buffer_sizes) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  return tiledb_array_finalize(tiledb_array);
+}
+
+/***************************/
+/********** TESTS **********/
+/***************************/
+TEST_F(BookKeepingTest, MappedRoundTrip) {
+  ASSERT_EQ(TILEDB_OK, create_sparse_array());
+  ASSERT_EQ(TILEDB_OK, write_sparse_array());
+
+  // The fragment has an uncompressed book-keeping file of the current version
+  std::vector<char> data = read_file(book_keeping_filename());
+  ASSERT_GE(data.size(), 2*sizeof(int));
+  int header[2];
+  memcpy(header, &data[0], sizeof(header));
+  ASSERT_EQ(TILEDB_BK_VERSION, header[0]);
+  ASSERT_EQ(2, header[1]);
+
+  // All the cells are read back through the mapped book-keeping
+  ASSERT_EQ(TILEDB_OK, read_sparse_array());
+  ASSERT_EQ(size_t(CELL_NUM), a1.size());
+  std::string a2_expected;
+  for (int i = 0; i < CELL_NUM; ++i) {
+    int64_t row = coords[2*i], col = coords[2*i+1];
+    ASSERT_EQ(row * 100 + col, a1[i]);
+    ASSERT_EQ(a2_expected.size(), a2_offsets[i]);
+    a2_expected.append(col % 5 + 1, 'a' + col);
+  }
+  ASSERT_EQ(a2_expected, std::string(a2.begin(), a2.end()));
+}
+
+TEST_F(BookKeepingTest, RejectsDamagedFile) {
+  ASSERT_EQ(TILEDB_OK, create_sparse_array());
+  ASSERT_EQ(TILEDB_OK, write_sparse_array());
+  std::string filename = book_keeping_filename();
+  std::vector<char> data = read_file(filename);
+  ASSERT_FALSE(data.empty());
+
+  // A file truncated in its sections
+  std::vector<char> truncated(data.begin(), data.begin() + data.size() / 2);
+  ASSERT_EQ(TILEDB_OK, write_file(filename, truncated));
+  ASSERT_EQ(TILEDB_ERR, read_sparse_array());
+
+  // A file truncated in its header
+  truncated.resize(sizeof(int) + 1);
+  ASSERT_EQ(TILEDB_OK, write_file(filename, truncated));
+  ASSERT_EQ(TILEDB_ERR, read_sparse_array());
+
+  // A file of an unknown version, or of the previous version, which lacks
+  // the tile statistics
+  std::vector<char> wrong_version = data;
+  int versions[] = { TILEDB_BK_VERSION + 1, TILEDB_BK_VERSION - 1 };
+  for (int i = 0; i < 2; ++i) {
+    memcpy(&wrong_version[0], &versions[i], sizeof(int));
+    ASSERT_EQ(TILEDB_OK, write_file(filename, wrong_version));
+    ASSERT_EQ(TILEDB_ERR, read_sparse_array());
+  }
+
+  // The original file is still loaded
+  ASSERT_EQ(TILEDB_OK, write_file(filename, data));
+  ASSERT_EQ(TILEDB_OK, read_sparse_array());
+  ASSERT_EQ(size_t(CELL_NUM), a1.size());
+}
+
+TEST_F(BookKeepingTest, LoadsLegacyFile) {
+  ASSERT_EQ(TILEDB_OK, create_sparse_array());
+  ASSERT_EQ(TILEDB_OK, write_sparse_array());
+  ASSERT_EQ(TILEDB_OK, read_sparse_array());
+  std::vector<int> a1_expected = a1;
+  std::vector<size_t> a2_offsets_expected = a2_offsets;
+  std::vector<char> a2_expected = a2;
+  std::vector<int64_t> coords_expected = coords;
+
+  // The fragment reads the same through the legacy book-keeping file, whose
+  // R-tree is built on load
+  ASSERT_EQ(TILEDB_OK, write_legacy_book_keeping());
+  ASSERT_EQ(TILEDB_OK, read_sparse_array());
+  ASSERT_EQ(a1_expected, a1);
+  ASSERT_EQ(a2_offsets_expected, a2_offsets);
+  ASSERT_EQ(a2_expected, a2);
+  ASSERT_EQ(coords_expected, coords);
+
+  // A subarray read prunes the tiles through the rebuilt R-tree
+  ArrayMetadataCache::instance()->clear();
+  int64_t subarray[] = { 40, 49, 3, 4 };
+  const char* attributes[] = { "ATTR_INT32" };
+  TileDB_Array* tiledb_array;
+  ASSERT_EQ(TILEDB_OK, tiledb_array_init(
+      tiledb_ctx,
+      &tiledb_array,
+      array_name.c_str(),
+      TILEDB_ARRAY_READ,
+      subarray,
+      attributes,
+      1));
+  int buffer_a1[100];
+  void* buffers[] = { buffer_a1 };
+  size_t buffer_sizes[] = { sizeof(buffer_a1) };
+  ASSERT_EQ(TILEDB_OK, tiledb_array_read(tiledb_array, buffers, buffer_sizes));
+  ASSERT_EQ(TILEDB_OK, tiledb_array_finalize(tiledb_array));
+  ASSERT_EQ(20 * sizeof(int), buffer_sizes[0]);
+  for (int i = 0; i < 20; ++i)
+    ASSERT_EQ((40 + i / 2) * 100 + 3 + i % 2, buffer_a1[i]);
+}
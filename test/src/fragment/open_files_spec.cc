@@ -0,0 +1,203 @@
+/**
+ * Copyright (c) 2016  Massachusetts Institute of Technology and Intel Corp.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Tests to check that reads of arrays with more fragment files than the
+ * process may keep open do not run out of file descriptors
+ */
+
+#include <gtest/gtest.h>
+#include "c_api.h"
+#include <cstdlib>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
+
+class OpenFilesTest: public testing::Test {
+  const std::string WORKSPACE = ".__workspace/";
+  const std::string ARRAYNAME = "test_100x100_10x10";
+
+public:
+  // TileDB context
+  TileDB_CTX* tiledb_ctx;
+  // Array name is initialized with the workspace folder
+  std::string array_name;
+  // The limit on the open files of the process before the test
+  struct rlimit original_limit;
+
+  int create_array();
+  int read_array(std::vector<int>& buffer_a1);
+  int write_tile(int64_t fragment_id);
+
+  virtual void SetUp() {
+    // Initialize context with the default configuration parameters
+    tiledb_ctx_init(&tiledb_ctx, NULL);
+    if (tiledb_workspace_create(
+        tiledb_ctx,
+        WORKSPACE.c_str()) != TILEDB_OK) {
+      exit(EXIT_FAILURE);
+    }
+
+    array_name.append(WORKSPACE);
+    array_name.append(ARRAYNAME);
+    getrlimit(RLIMIT_NOFILE, &original_limit);
+  }
+
+  virtual void TearDown() {
+    // Restore the limit on the open files
+    setrlimit(RLIMIT_NOFILE, &original_limit);
+
+    // Finalize TileDB context
+    tiledb_ctx_finalize(tiledb_ctx);
+
+    // Remove the temporary workspace
+    std::string command = "rm -rf ";
+    command.append(WORKSPACE);
+    int ret = system(command.c_str());
+  }
+};
+
+/**
+ * Create a dense 100x100 array with 10x10 tiles and a single int attribute
+ */
+int OpenFilesTest::create_array() {
+  const char* attributes[] = { "ATTR_INT32" };
+  const char* dimensions[] = { "X", "Y" };
+  int64_t domain[] = { 0, 99, 0, 99 };
+  int64_t tile_extents[] = { 10, 10 };
+  const int types[] = { TILEDB_INT32, TILEDB_INT64 };
+  const int compression[] = { TILEDB_GZIP, TILEDB_NO_COMPRESSION };
+
+  TileDB_ArraySchema schema;
+  tiledb_array_set_schema(
+      &schema,
+      array_name.c_str(),
+      attributes,
+      1,
+      0,
+      TILEDB_ROW_MAJOR,
+      NULL,
+      compression,
+      1,
+      dimensions,
+      2,
+      domain,
+      4*sizeof(int64_t),
+      tile_extents,
+      2*sizeof(int64_t),
+      0,
+      types);
+
+  int rc = tiledb_array_create(tiledb_ctx, &schema);
+  tiledb_array_free_schema(&schema);
+  return rc;
+}
+
+/**
+ * Read the entire array in a single pass
+ */
+int OpenFilesTest::read_array(std::vector<int>& buffer_a1) {
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_READ,
+          NULL,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  buffer_a1.resize(10000);
+  void* buffers[] = { &buffer_a1[0] };
+  size_t buffer_sizes[] = { buffer_a1.size() * sizeof(int) };
+  int rc = tiledb_array_read(tiledb_array, buffers, buffer_sizes);
+  if (rc == TILEDB_OK &&
+      (tiledb_array_overflow(tiledb_array, 0) ||
+       buffer_sizes[0] != buffer_a1.size() * sizeof(int)))
+    rc = TILEDB_ERR;
+
+  if (tiledb_array_finalize(tiledb_array) != TILEDB_OK)
+    return TILEDB_ERR;
+  return rc;
+}
+
+/**
+ * Write a fragment over the tile fragment_id % 100 of the array, whose k-th
+ * cell has value fragment_id * 1000 + k
+ */
+int OpenFilesTest::write_tile(int64_t fragment_id) {
+  int64_t tile_id = fragment_id % 100;
+  int64_t subarray[] = {
+      tile_id / 10 * 10, tile_id / 10 * 10 + 9,
+      tile_id % 10 * 10, tile_id % 10 * 10 + 9 };
+  std::vector<int> buffer_a1;
+  for (int k = 0; k < 100; ++k)
+    buffer_a1.push_back(fragment_id * 1000 + k);
+
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_WRITE,
+          subarray,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  const void* buffers[] = { &buffer_a1[0] };
+  size_t buffer_sizes[] = { buffer_a1.size() * sizeof(int) };
+  if (tiledb_array_write(tiledb_array, buffers, buffer_sizes) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  // Fragments created in the same millisecond would get the same name
+  usleep(2000);
+  return tiledb_array_finalize(tiledb_array);
+}
+
+/***************************/
+/********** TESTS **********/
+/***************************/
+TEST_F(OpenFilesTest, MoreFragmentsThanOpenFiles) {
+  ASSERT_EQ(TILEDB_OK, create_array());
+  for (int64_t f = 0; f < 150; ++f)
+    ASSERT_EQ(TILEDB_OK, write_tile(f));
+
+  // The process may not keep open a file of each of the 150 fragments
+  struct rlimit limit = original_limit;
+  limit.rlim_cur = 64;
+  ASSERT_EQ(0, setrlimit(RLIMIT_NOFILE, &limit));
+
+  // Read twice, so that the files are reopened by the second read
+  for (int r = 0; r < 2; ++r) {
+    std::vector<int> buffer_a1;
+    ASSERT_EQ(TILEDB_OK, read_array(buffer_a1));
+
+    // The first 50 tiles were overwritten by the last 50 fragments
+    for (int64_t t = 0; t < 100; ++t) {
+      int64_t fragment_id = (t < 50) ? t + 100 : t;
+      for (int k = 0; k < 100; ++k)
+        ASSERT_EQ(fragment_id * 1000 + k, buffer_a1[100 * t + k]);
+    }
+  }
+}
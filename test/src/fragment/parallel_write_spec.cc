@@ -0,0 +1,273 @@
+/**
+ * Copyright (c) 2016  Massachusetts Institute of Technology and Intel Corp.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Tests to check that the tiles compressed in parallel batches during writes
+ * are laid out in the fragment files exactly as when they are compressed one
+ * by one
+ */
+
+#include <gtest/gtest.h>
+#include "c_api.h"
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+class ParallelWriteTest: public testing::Test {
+  const std::string WORKSPACE = ".__workspace/";
+
+public:
+  // TileDB context
+  TileDB_CTX* tiledb_ctx;
+  // The cells written to the arrays
+  std::vector<int> buffer_a1;
+  std::vector<int64_t> buffer_a2;
+  std::vector<size_t> buffer_a3;
+  std::string buffer_var_a3;
+
+  int create_array(const std::string& array_name);
+  std::map<std::string, std::vector<char> > read_fragment_files(
+      const std::string& array_name);
+  int read_array(const std::string& array_name);
+  int write_array(const std::string& array_name, int thread_num);
+
+  virtual void SetUp() {
+    // Initialize context with the default configuration parameters
+    tiledb_ctx_init(&tiledb_ctx, NULL);
+    if (tiledb_workspace_create(
+        tiledb_ctx,
+        WORKSPACE.c_str()) != TILEDB_OK) {
+      exit(EXIT_FAILURE);
+    }
+
+    // Over 20 MB of cells, which are compressed in several batches
+    for (int64_t i = 0; i < 1000000; ++i) {
+      buffer_a1.push_back((i * 7919) % 100003);
+      buffer_a2.push_back(i * i);
+      buffer_a3.push_back(buffer_var_a3.size());
+      buffer_var_a3.append(1 + i % 5, 'a' + i % 26);
+    }
+  }
+
+  virtual void TearDown() {
+    // Finalize TileDB context
+    tiledb_ctx_finalize(tiledb_ctx);
+
+    // Remove the temporary workspace
+    std::string command = "rm -rf ";
+    command.append(WORKSPACE);
+    int ret = system(command.c_str());
+  }
+
+  std::string array_name(const std::string& name) const {
+    return WORKSPACE + name;
+  }
+};
+
+/**
+ * Create a dense 1000x1000 array with 100x100 tiles and GZIP-compressed int,
+ * int64 and variable-sized char attributes
+ */
+int ParallelWriteTest::create_array(const std::string& array_name) {
+  const char* attributes[] = { "ATTR_INT32", "ATTR_INT64", "ATTR_CHAR_VAR" };
+  const char* dimensions[] = { "X", "Y" };
+  int64_t domain[] = { 0, 999, 0, 999 };
+  int64_t tile_extents[] = { 100, 100 };
+  const int cell_val_num[] = { 1, 1, TILEDB_VAR_NUM };
+  const int types[] = { TILEDB_INT32, TILEDB_INT64, TILEDB_CHAR, TILEDB_INT64 };
+  const int compression[] = {
+      TILEDB_GZIP, TILEDB_GZIP, TILEDB_GZIP, TILEDB_NO_COMPRESSION };
+
+  TileDB_ArraySchema schema;
+  tiledb_array_set_schema(
+      &schema,
+      array_name.c_str(),
+      attributes,
+      3,
+      0,
+      TILEDB_ROW_MAJOR,
+      cell_val_num,
+      compression,
+      1,
+      dimensions,
+      2,
+      domain,
+      4*sizeof(int64_t),
+      tile_extents,
+      2*sizeof(int64_t),
+      0,
+      types);
+
+  int rc = tiledb_array_create(tiledb_ctx, &schema);
+  tiledb_array_free_schema(&schema);
+  return rc;
+}
+
+/**
+ * Return the contents of the files of the single fragment of the array,
+ * keyed by file name
+ */
+std::map<std::string, std::vector<char> >
+ParallelWriteTest::read_fragment_files(const std::string& array_name) {
+  std::map<std::string, std::vector<char> > files;
+
+  // Find the fragment directory
+  std::string fragment_name;
+  DIR* dir = opendir(array_name.c_str());
+  if (dir == NULL)
+    return files;
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    std::string name = entry->d_name;
+    if (name.compare(0, 2, "__") == 0 && entry->d_type == DT_DIR)
+      fragment_name = array_name + "/" + name;
+  }
+  closedir(dir);
+
+  // Read its files
+  dir = opendir(fragment_name.c_str());
+  if (dir == NULL)
+    return files;
+  while ((entry = readdir(dir)) != NULL) {
+    std::string name = entry->d_name;
+    if (entry->d_type != DT_REG)
+      continue;
+    std::ifstream file((fragment_name + "/" + name).c_str(), std::ios::binary);
+    files[name].assign(
+        std::istreambuf_iterator<char>(file),
+        std::istreambuf_iterator<char>());
+  }
+  closedir(dir);
+  return files;
+}
+
+/**
+ * Read the entire array and compare it with the written cells
+ */
+int ParallelWriteTest::read_array(const std::string& array_name) {
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_READ,
+          NULL,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  std::vector<int> a1(buffer_a1.size());
+  std::vector<int64_t> a2(buffer_a2.size());
+  std::vector<size_t> a3(buffer_a3.size());
+  std::string var_a3(buffer_var_a3.size(), ' ');
+  void* buffers[] = { &a1[0], &a2[0], &a3[0], &var_a3[0] };
+  size_t buffer_sizes[] = {
+      a1.size() * sizeof(int),
+      a2.size() * sizeof(int64_t),
+      a3.size() * sizeof(size_t),
+      var_a3.size() };
+  int rc = tiledb_array_read(tiledb_array, buffers, buffer_sizes);
+  if (rc == TILEDB_OK &&
+      (buffer_sizes[0] != a1.size() * sizeof(int) ||
+       a1 != buffer_a1 ||
+       a2 != buffer_a2 ||
+       a3 != buffer_a3 ||
+       var_a3 != buffer_var_a3))
+    rc = TILEDB_ERR;
+
+  if (tiledb_array_finalize(tiledb_array) != TILEDB_OK)
+    return TILEDB_ERR;
+  return rc;
+}
+
+/**
+ * Write the cells to the entire array in a single write, compressing the
+ * tiles with the input number of threads
+ */
+int ParallelWriteTest::write_array(
+    const std::string& array_name,
+    int thread_num) {
+#ifdef _OPENMP
+  int max_thread_num = omp_get_max_threads();
+  omp_set_num_threads(thread_num);
+#endif
+
+  TileDB_Array* tiledb_array;
+  int rc = tiledb_array_init(
+               tiledb_ctx,
+               &tiledb_array,
+               array_name.c_str(),
+               TILEDB_ARRAY_WRITE,
+               NULL,
+               NULL,
+               0);
+  if (rc == TILEDB_OK) {
+    const void* buffers[] = {
+        &buffer_a1[0], &buffer_a2[0], &buffer_a3[0], buffer_var_a3.c_str() };
+    size_t buffer_sizes[] = {
+        buffer_a1.size() * sizeof(int),
+        buffer_a2.size() * sizeof(int64_t),
+        buffer_a3.size() * sizeof(size_t),
+        buffer_var_a3.size() };
+    rc = tiledb_array_write(tiledb_array, buffers, buffer_sizes);
+    if (tiledb_array_finalize(tiledb_array) != TILEDB_OK)
+      rc = TILEDB_ERR;
+  }
+
+#ifdef _OPENMP
+  omp_set_num_threads(max_thread_num);
+#endif
+  return rc;
+}
+
+/***************************/
+/********** TESTS **********/
+/***************************/
+TEST_F(ParallelWriteTest, ParallelBatchesMatchSerialWrite) {
+  std::string serial = array_name("serial");
+  std::string parallel = array_name("parallel");
+  ASSERT_EQ(TILEDB_OK, create_array(serial));
+  ASSERT_EQ(TILEDB_OK, create_array(parallel));
+  ASSERT_EQ(TILEDB_OK, write_array(serial, 1));
+  ASSERT_EQ(TILEDB_OK, write_array(parallel, 4));
+
+  // The attribute files hold the same compressed tiles in the same order,
+  // and the book-keeping the same tile offsets
+  std::map<std::string, std::vector<char> > serial_files =
+      read_fragment_files(serial);
+  std::map<std::string, std::vector<char> > parallel_files =
+      read_fragment_files(parallel);
+  ASSERT_LT(size_t(3), serial_files.size());
+  ASSERT_TRUE(serial_files == parallel_files);
+
+  // Both arrays hold the written cells
+  ASSERT_EQ(TILEDB_OK, read_array(serial));
+  ASSERT_EQ(TILEDB_OK, read_array(parallel));
+}
@@ -0,0 +1,223 @@
+/**
+ * Copyright (c) 2016  Massachusetts Institute of Technology and Intel Corp.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Tests to check that the packed R-tree finds the same overlapping tile MBRs
+ * as a linear scan
+ */
+
+#include <gtest/gtest.h>
+#include "rtree.h"
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <vector>
+
+class RTreeTest: public testing::Test {
+
+public:
+  // Leaf MBRs of a 2-dimensional fragment, stored contiguously
+  std::vector<int64_t> mbrs;
+
+  void generate_mbrs(int64_t mbr_num);
+  int64_t linear_scan(
+      const int64_t* subarray,
+      int64_t pos,
+      int64_t end) const;
+  void check_tree(int fanout);
+
+  virtual void SetUp() {
+    srand(7);
+  }
+};
+
+/**
+ * Generate MBRs that follow a row-major tile order with some jitter, so that
+ * consecutive MBRs are close but may overlap each other
+ */
+void RTreeTest::generate_mbrs(int64_t mbr_num) {
+  mbrs.clear();
+  for (int64_t i = 0; i < mbr_num; ++i) {
+    int64_t row = (i / 20) * 10 + rand() % 5;
+    int64_t col = (i % 20) * 10 + rand() % 5;
+    mbrs.push_back(row);
+    mbrs.push_back(row + rand() % 15);
+    mbrs.push_back(col);
+    mbrs.push_back(col + rand() % 15);
+  }
+}
+
+/**
+ * Return the first MBR in [pos, end] that overlaps the subarray, or -1
+ */
+int64_t RTreeTest::linear_scan(
+    const int64_t* subarray,
+    int64_t pos,
+    int64_t end) const {
+  int64_t mbr_num = mbrs.size() / 4;
+  for (int64_t i = pos; i <= end && i < mbr_num; ++i) {
+    const int64_t* mbr = &mbrs[4*i];
+    if (mbr[0] <= subarray[1] && mbr[1] >= subarray[0] &&
+        mbr[2] <= subarray[3] && mbr[3] >= subarray[2])
+      return i;
+  }
+  return -1;
+}
+
+/**
+ * Build a tree with the input fanout over the current MBRs, and compare its
+ * results with the linear scan for random subarrays and leaf ranges
+ */
+void RTreeTest::check_tree(int fanout) {
+  int64_t mbr_num = mbrs.size() / 4;
+  RTree rtree;
+  rtree.build<int64_t>(
+      mbrs.empty() ? NULL : &mbrs[0],
+      mbr_num,
+      2,
+      fanout);
+  const void* leaves = mbrs.empty() ? NULL : &mbrs[0];
+
+  for (int q = 0; q < 50; ++q) {
+    int64_t row = rand() % 120, col = rand() % 220;
+    int64_t subarray[] = {
+        row, row + rand() % 30, col, col + rand() % 30 };
+
+    // All the overlapping MBRs of the fragment, in order
+    int64_t pos = 0;
+    for (;;) {
+      int64_t expected = linear_scan(subarray, pos, mbr_num - 1);
+      int64_t found = rtree.next_overlapping_leaf<int64_t>(
+          leaves, mbr_num, subarray, pos, mbr_num - 1);
+      ASSERT_EQ(expected, found);
+      if (found == -1)
+        break;
+      pos = found + 1;
+    }
+
+    // Ranges that start and end at arbitrary leaves
+    for (int r = 0; r < 10 && mbr_num > 0; ++r) {
+      int64_t start = rand() % mbr_num;
+      int64_t end = start + rand() % (mbr_num - start);
+      ASSERT_EQ(
+          linear_scan(subarray, start, end),
+          rtree.next_overlapping_leaf<int64_t>(
+              leaves, mbr_num, subarray, start, end));
+    }
+  }
+
+  // A subarray overlapping every MBR returns each leaf of a range
+  int64_t domain[] = { 0, 1000, 0, 1000 };
+  for (int64_t i = 0; i < mbr_num; ++i)
+    ASSERT_EQ(i, rtree.next_overlapping_leaf<int64_t>(
+        leaves, mbr_num, domain, i, mbr_num - 1));
+
+  // A subarray overlapping no MBR returns nothing
+  int64_t outside[] = { 5000, 6000, 5000, 6000 };
+  ASSERT_EQ(-1, rtree.next_overlapping_leaf<int64_t>(
+      leaves, mbr_num, outside, 0, mbr_num - 1));
+}
+
+/***************************/
+/********** TESTS **********/
+/***************************/
+TEST_F(RTreeTest, MatchesLinearScan) {
+  // MBR numbers that are not multiples of the fanouts
+  int64_t mbr_nums[] = { 2, 5, 17, 63, 101, 1000 };
+  int fanouts[] = { 2, 3, 4, 7, 16 };
+  for (int i = 0; i < 6; ++i) {
+    generate_mbrs(mbr_nums[i]);
+    for (int j = 0; j < 5; ++j)
+      check_tree(fanouts[j]);
+  }
+}
+
+TEST_F(RTreeTest, SingleMBR) {
+  generate_mbrs(1);
+  RTree rtree;
+  rtree.build<int64_t>(&mbrs[0], 1, 2, 4);
+  ASSERT_EQ(0, rtree.level_num());
+  check_tree(4);
+}
+
+TEST_F(RTreeTest, ZeroLevels) {
+  // A tree loaded without levels above the leaves (as in fragments whose
+  // book-keeping has no tree) scans the leaves directly
+  generate_mbrs(9);
+  int header[] = { 4, 0 };
+  RTree rtree;
+  ASSERT_EQ(
+      TILEDB_RT_OK,
+      rtree.load(header, sizeof(header), 2, 2*sizeof(int64_t)));
+  ASSERT_EQ(0, rtree.level_num());
+  for (int q = 0; q < 20; ++q) {
+    int64_t row = rand() % 30, col = rand() % 100;
+    int64_t subarray[] = { row, row + 5, col, col + 5 };
+    for (int64_t pos = 0; pos < 9; ++pos)
+      ASSERT_EQ(
+          linear_scan(subarray, pos, 8),
+          rtree.next_overlapping_leaf<int64_t>(
+              &mbrs[0], 9, subarray, pos, 8));
+  }
+
+  // An empty fragment has no overlapping leaves
+  generate_mbrs(0);
+  check_tree(4);
+}
+
+TEST_F(RTreeTest, FlushLoadRoundTrip) {
+  generate_mbrs(101);
+  RTree rtree;
+  rtree.build<int64_t>(&mbrs[0], 101, 2, 3);
+  ASSERT_EQ(5, rtree.level_num());
+
+  // Write the tree to a file and load it back
+  FILE* file = tmpfile();
+  ASSERT_TRUE(file != NULL);
+  int fd = fileno(file);
+  ASSERT_EQ(TILEDB_RT_OK, rtree.flush(fd));
+  off_t file_size = lseek(fd, 0, SEEK_END);
+  std::vector<char> buffer(file_size);
+  ASSERT_EQ(file_size, pread(fd, &buffer[0], file_size, 0));
+  fclose(file);
+
+  RTree loaded;
+  ASSERT_EQ(
+      TILEDB_RT_OK,
+      loaded.load(&buffer[0], buffer.size(), 2, 2*sizeof(int64_t)));
+  ASSERT_EQ(rtree.level_num(), loaded.level_num());
+  for (int q = 0; q < 50; ++q) {
+    int64_t row = rand() % 60, col = rand() % 220;
+    int64_t subarray[] = { row, row + 10, col, col + 10 };
+    for (int64_t pos = 0; pos < 101; pos += 7)
+      ASSERT_EQ(
+          linear_scan(subarray, pos, 100),
+          loaded.next_overlapping_leaf<int64_t>(
+              &mbrs[0], 101, subarray, pos, 100));
+  }
+
+  // A truncated tree is rejected
+  RTree truncated;
+  ASSERT_EQ(
+      TILEDB_RT_ERR,
+      truncated.load(&buffer[0], buffer.size() - 1, 2, 2*sizeof(int64_t)));
+}
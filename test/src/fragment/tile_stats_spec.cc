@@ -0,0 +1,283 @@
+/**
+ * Copyright (c) 2016  Massachusetts Institute of Technology and Intel Corp.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Tests to check that the tile statistics kept in the book-keeping match the
+ * written values, for both compressed and uncompressed attributes
+ */
+
+#include <gtest/gtest.h>
+#include "array_metadata_cache.h"
+#include "book_keeping.h"
+#include "c_api.h"
+#include "storage_manager.h"
+#include <cstdlib>
+#include <vector>
+
+class TileStatsTest: public testing::Test {
+  const std::string WORKSPACE = ".__workspace/";
+  const std::string ARRAYNAME = "test_100x100_10x10";
+
+public:
+  // TileDB context
+  TileDB_CTX* tiledb_ctx;
+  // Array name is initialized with the workspace folder
+  std::string array_name;
+  // The tile statistics of the first attribute, loaded from the disk
+  std::vector<TileStats> tile_stats;
+
+  int create_array(bool dense, int compression);
+  int load_tile_stats();
+  int write_dense_array();
+  int write_sparse_array(int64_t cell_num);
+
+  virtual void SetUp() {
+    // Initialize context with the default configuration parameters
+    tiledb_ctx_init(&tiledb_ctx, NULL);
+    if (tiledb_workspace_create(
+        tiledb_ctx,
+        WORKSPACE.c_str()) != TILEDB_OK) {
+      exit(EXIT_FAILURE);
+    }
+
+    array_name.append(WORKSPACE);
+    array_name.append(ARRAYNAME);
+  }
+
+  virtual void TearDown() {
+    // Finalize TileDB context
+    tiledb_ctx_finalize(tiledb_ctx);
+
+    // Remove the temporary workspace
+    std::string command = "rm -rf ";
+    command.append(WORKSPACE);
+    int ret = system(command.c_str());
+  }
+};
+
+/**
+ * Create a 100x100 array with 10x10 tiles and a sparse capacity of 50, with
+ * an int attribute for dense arrays and a float attribute for sparse ones
+ */
+int TileStatsTest::create_array(bool dense, int compression) {
+  const char* attributes[] = { "ATTR" };
+  const char* dimensions[] = { "X", "Y" };
+  int64_t domain[] = { 0, 99, 0, 99 };
+  int64_t tile_extents[] = { 10, 10 };
+  const int types[] = {
+      dense ? TILEDB_INT32 : TILEDB_FLOAT32, TILEDB_INT64 };
+  const int compressions[] = { compression, TILEDB_NO_COMPRESSION };
+
+  TileDB_ArraySchema schema;
+  tiledb_array_set_schema(
+      &schema,
+      array_name.c_str(),
+      attributes,
+      1,
+      50,
+      TILEDB_ROW_MAJOR,
+      NULL,
+      compressions,
+      dense,
+      dimensions,
+      2,
+      domain,
+      4*sizeof(int64_t),
+      tile_extents,
+      2*sizeof(int64_t),
+      0,
+      types);
+
+  int rc = tiledb_array_create(tiledb_ctx, &schema);
+  tiledb_array_free_schema(&schema);
+  return rc;
+}
+
+/**
+ * Load the book-keeping of the single fragment of the array from the disk and
+ * copy the tile statistics of its attribute
+ */
+int TileStatsTest::load_tile_stats() {
+  tile_stats.clear();
+  ArrayMetadataCache::instance()->clear();
+
+  StorageManager storage_manager;
+  if (storage_manager.init(NULL) != TILEDB_SM_OK)
+    return TILEDB_ERR;
+  Array* array;
+  if (storage_manager.array_init(
+          array,
+          array_name.c_str(),
+          TILEDB_ARRAY_READ,
+          NULL,
+          NULL,
+          0) != TILEDB_SM_OK)
+    return TILEDB_ERR;
+
+  int rc = TILEDB_ERR;
+  std::vector<Fragment*> fragments = array->fragments();
+  if (fragments.size() == 1) {
+    const BookKeeping* book_keeping = fragments[0]->book_keeping();
+    const TileStats* stats = book_keeping->tile_stats(0);
+    if (stats != NULL) {
+      tile_stats.assign(stats, stats + book_keeping->tile_num());
+      rc = TILEDB_OK;
+    }
+  }
+
+  if (storage_manager.array_finalize(array) != TILEDB_SM_OK)
+    return TILEDB_ERR;
+  return rc;
+}
+
+/**
+ * Write the entire dense array in two parts that split a tile, where the
+ * k-th cell in the global order has value k, except for the empty first cell
+ */
+int TileStatsTest::write_dense_array() {
+  std::vector<int> buffer_a1;
+  for (int k = 0; k < 10000; ++k)
+    buffer_a1.push_back(k);
+  buffer_a1[0] = TILEDB_EMPTY_INT32;
+
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_WRITE,
+          NULL,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  const void* first_buffers[] = { &buffer_a1[0] };
+  size_t first_buffer_sizes[] = { 150 * sizeof(int) };
+  const void* rest_buffers[] = { &buffer_a1[150] };
+  size_t rest_buffer_sizes[] = { (10000 - 150) * sizeof(int) };
+  if (tiledb_array_write(
+          tiledb_array,
+          first_buffers,
+          first_buffer_sizes) != TILEDB_OK ||
+      tiledb_array_write(
+          tiledb_array,
+          rest_buffers,
+          rest_buffer_sizes) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  return tiledb_array_finalize(tiledb_array);
+}
+
+/**
+ * Write the first cell_num cells of the first ten columns in reverse order,
+ * where cell (i,j) has value i * 10 + j + 0.5. The cells of the first ten
+ * columns are in row-major order in the global order as well, so the k-th
+ * cell in the global order has value k + 0.5.
+ */
+int TileStatsTest::write_sparse_array(int64_t cell_num) {
+  std::vector<float> buffer_a1;
+  std::vector<int64_t> buffer_coords;
+  for (int64_t k = cell_num - 1; k >= 0; --k) {
+    buffer_a1.push_back(k + 0.5);
+    buffer_coords.push_back(k / 10);
+    buffer_coords.push_back(k % 10);
+  }
+
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_WRITE_UNSORTED,
+          NULL,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  const void* buffers[] = { &buffer_a1[0], &buffer_coords[0] };
+  size_t buffer_sizes[] = {
+      buffer_a1.size() * sizeof(float),
+      buffer_coords.size() * sizeof(int64_t) };
+  if (tiledb_array_write(tiledb_array, buffers, buffer_sizes) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  return tiledb_array_finalize(tiledb_array);
+}
+
+/***************************/
+/********** TESTS **********/
+/***************************/
+TEST_F(TileStatsTest, DenseUncompressed) {
+  ASSERT_EQ(TILEDB_OK, create_array(true, TILEDB_NO_COMPRESSION));
+  ASSERT_EQ(TILEDB_OK, write_dense_array());
+  ASSERT_EQ(TILEDB_OK, load_tile_stats());
+
+  // The empty cell is not taken into account
+  ASSERT_EQ(size_t(100), tile_stats.size());
+  ASSERT_EQ(99, tile_stats[0].count_);
+  ASSERT_EQ(1, tile_stats[0].min_.int_);
+  ASSERT_EQ(99, tile_stats[0].max_.int_);
+  ASSERT_EQ(4950, tile_stats[0].sum_.int_);
+  for (int64_t t = 1; t < 100; ++t) {
+    ASSERT_EQ(100, tile_stats[t].count_);
+    ASSERT_EQ(100 * t, tile_stats[t].min_.int_);
+    ASSERT_EQ(100 * t + 99, tile_stats[t].max_.int_);
+    ASSERT_EQ(10000 * t + 4950, tile_stats[t].sum_.int_);
+  }
+}
+
+TEST_F(TileStatsTest, DenseCompressedMatchesUncompressed) {
+  ASSERT_EQ(TILEDB_OK, create_array(true, TILEDB_NO_COMPRESSION));
+  ASSERT_EQ(TILEDB_OK, write_dense_array());
+  ASSERT_EQ(TILEDB_OK, load_tile_stats());
+  std::vector<TileStats> uncompressed_stats = tile_stats;
+  ASSERT_EQ(TILEDB_OK, tiledb_delete(tiledb_ctx, array_name.c_str()));
+
+  ASSERT_EQ(TILEDB_OK, create_array(true, TILEDB_GZIP));
+  ASSERT_EQ(TILEDB_OK, write_dense_array());
+  ASSERT_EQ(TILEDB_OK, load_tile_stats());
+  ASSERT_EQ(uncompressed_stats.size(), tile_stats.size());
+  for (size_t t = 0; t < tile_stats.size(); ++t) {
+    ASSERT_EQ(uncompressed_stats[t].count_, tile_stats[t].count_);
+    ASSERT_EQ(uncompressed_stats[t].min_.int_, tile_stats[t].min_.int_);
+    ASSERT_EQ(uncompressed_stats[t].max_.int_, tile_stats[t].max_.int_);
+    ASSERT_EQ(uncompressed_stats[t].sum_.int_, tile_stats[t].sum_.int_);
+  }
+}
+
+TEST_F(TileStatsTest, SparseUncompressed) {
+  // The last tile holds only 45 of the 50 cells of the capacity
+  ASSERT_EQ(TILEDB_OK, create_array(false, TILEDB_NO_COMPRESSION));
+  ASSERT_EQ(TILEDB_OK, write_sparse_array(995));
+  ASSERT_EQ(TILEDB_OK, load_tile_stats());
+
+  ASSERT_EQ(size_t(20), tile_stats.size());
+  for (int64_t t = 0; t < 20; ++t) {
+    int64_t count = (t < 19) ? 50 : 45;
+    ASSERT_EQ(count, tile_stats[t].count_);
+    ASSERT_DOUBLE_EQ(50 * t + 0.5, tile_stats[t].min_.real_);
+    ASSERT_DOUBLE_EQ(50 * t + count - 0.5, tile_stats[t].max_.real_);
+    ASSERT_DOUBLE_EQ(
+        count * (50 * t + 0.5) + count * (count - 1) / 2,
+        tile_stats[t].sum_.real_);
+  }
+}
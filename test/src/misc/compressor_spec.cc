@@ -0,0 +1,282 @@
+/**
+ * Copyright (c) 2016  Massachusetts Institute of Technology and Intel Corp.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Tests to check that the tile codecs and the byte shuffle round-trip their
+ * input, and that the array schema validates compression levels per codec
+ */
+
+#include <gtest/gtest.h>
+#include "c_api.h"
+#include "compressor.h"
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+class CompressorTest: public testing::Test {
+
+public:
+  const std::string WORKSPACE = ".__workspace/";
+  const std::string ARRAYNAME = "dense_test_100x100_10x10";
+
+  // TileDB context
+  TileDB_CTX* tiledb_ctx;
+  // Array name is initialized with the workspace folder
+  std::string array_name;
+  // Slowly changing values, as in coordinate tiles
+  std::vector<int64_t> values;
+
+  int create_dense_array(int compression);
+  void round_trip(int compression, int level);
+  int write_dense_array();
+
+  virtual void SetUp() {
+    // Initialize context with the default configuration parameters
+    tiledb_ctx_init(&tiledb_ctx, NULL);
+
+    if (tiledb_workspace_create(
+          tiledb_ctx,
+          WORKSPACE.c_str()) != TILEDB_OK) {
+      exit(EXIT_FAILURE);
+    }
+
+    array_name.append(WORKSPACE);
+    array_name.append(ARRAYNAME);
+
+    for (int64_t i = 0; i < 10000; ++i)
+      values.push_back(1000000 + i / 3);
+  }
+
+  virtual void TearDown() {
+    // Finalize TileDB context
+    tiledb_ctx_finalize(tiledb_ctx);
+
+    // Remove the temporary workspace
+    std::string command = "rm -rf ";
+    command.append(WORKSPACE);
+    int ret = system(command.c_str());
+  }
+};
+
+int CompressorTest::create_dense_array(int compression) {
+  const char* attributes[] = { "ATTR_INT32" };
+  const char* dimensions[] = { "X", "Y" };
+  int64_t domain[] = { 0, 99, 0, 99 };
+  int64_t tile_extents[] = { 10, 10 };
+  const int types[] = { TILEDB_INT32, TILEDB_INT64 };
+  const int compressions[] = { compression, TILEDB_NO_COMPRESSION };
+
+  TileDB_ArraySchema schema;
+  tiledb_array_set_schema(
+      &schema,
+      array_name.c_str(),
+      attributes,
+      1,
+      0,
+      TILEDB_ROW_MAJOR,
+      NULL,
+      compressions,
+      1,
+      dimensions,
+      2,
+      domain,
+      4*sizeof(int64_t),
+      tile_extents,
+      2*sizeof(int64_t),
+      0,
+      types);
+
+  int rc = tiledb_array_create(tiledb_ctx, &schema);
+  tiledb_array_free_schema(&schema);
+  return rc;
+}
+
+/**
+ * Compresses the test values with the input codec and level, and checks that
+ * decompression restores them
+ */
+void CompressorTest::round_trip(int compression, int level) {
+  const Compressor* compressor = Compressor::get(compression);
+  ASSERT_TRUE(compressor != NULL);
+
+  size_t in_size = values.size() * sizeof(int64_t);
+  std::vector<char> compressed(compressor->compress_bound(in_size));
+  ssize_t compressed_size = compressor->compress(
+      level,
+      sizeof(int64_t),
+      &values[0],
+      in_size,
+      &compressed[0],
+      compressed.size());
+  ASSERT_GT(compressed_size, 0);
+  ASSERT_LT(size_t(compressed_size), in_size);
+
+  std::vector<int64_t> decompressed(values.size());
+  size_t decompressed_size;
+  ASSERT_EQ(TILEDB_CP_OK, compressor->decompress(
+      sizeof(int64_t),
+      &compressed[0],
+      compressed_size,
+      &decompressed[0],
+      in_size,
+      decompressed_size));
+  ASSERT_EQ(in_size, decompressed_size);
+  ASSERT_EQ(values, decompressed);
+}
+
+/**
+ * Writes the entire dense array, where cell (i,j) has value i * 100 + j
+ */
+int CompressorTest::write_dense_array() {
+  std::vector<int> buffer_a1(10000);
+  for (int i = 0; i < 10000; ++i)
+    buffer_a1[i] = i;
+
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_WRITE,
+          NULL,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  const void* buffers[] = { &buffer_a1[0] };
+  size_t buffer_sizes[] = { buffer_a1.size() * sizeof(int) };
+  if (tiledb_array_write(tiledb_array, buffers, buffer_sizes) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  return tiledb_array_finalize(tiledb_array);
+}
+
+/***************************/
+/********** TESTS **********/
+/***************************/
+TEST_F(CompressorTest, GzipRoundTrip) {
+  const Compressor* compressor = Compressor::get(TILEDB_GZIP);
+  ASSERT_TRUE(compressor != NULL);
+  ASSERT_EQ(9, compressor->max_level());
+
+  for (int level = 0; level <= compressor->max_level(); ++level)
+    round_trip(TILEDB_GZIP, level);
+}
+
+#ifdef HAVE_LZ4
+TEST_F(CompressorTest, LZ4RoundTrip) {
+  round_trip(TILEDB_LZ4, 0);
+  round_trip(TILEDB_LZ4, TILEDB_COMPRESSION_LEVEL_MAX);
+  round_trip(TILEDB_SHUFFLE_LZ4, 0);
+  round_trip(TILEDB_SHUFFLE_LZ4, TILEDB_COMPRESSION_LEVEL_MAX);
+}
+#endif
+
+#ifdef HAVE_ZSTD
+TEST_F(CompressorTest, ZstdRoundTrip) {
+  const Compressor* compressor = Compressor::get(TILEDB_ZSTD);
+  ASSERT_TRUE(compressor != NULL);
+
+  round_trip(TILEDB_ZSTD, 0);
+  round_trip(TILEDB_ZSTD, 1);
+  round_trip(TILEDB_ZSTD, compressor->max_level());
+}
+#endif
+
+TEST_F(CompressorTest, ByteShuffleRoundTrip) {
+  // Use a size that leaves trailing bytes outside the full values
+  size_t size = values.size() * sizeof(int64_t) - 5;
+  const char* in = reinterpret_cast<const char*>(&values[0]);
+  std::vector<char> shuffled(size);
+  std::vector<char> unshuffled(size);
+
+  byte_shuffle(sizeof(int64_t), in, size, &shuffled[0]);
+
+  // The lowest byte of the first value is followed by that of the second
+  ASSERT_EQ(in[0], shuffled[0]);
+  ASSERT_EQ(in[sizeof(int64_t)], shuffled[1]);
+
+  byte_unshuffle(sizeof(int64_t), &shuffled[0], size, &unshuffled[0]);
+  ASSERT_EQ(0, memcmp(in, &unshuffled[0], size));
+}
+
+TEST_F(CompressorTest, SchemaCompressionLevels) {
+  // Levels up to the codec maximum are accepted
+  ASSERT_EQ(
+      TILEDB_OK,
+      create_dense_array(TILEDB_GZIP | TILEDB_COMPRESSION_LEVEL(9)));
+  ASSERT_EQ(TILEDB_OK, tiledb_delete(tiledb_ctx, array_name.c_str()));
+
+  // Levels beyond the codec maximum are rejected
+  ASSERT_EQ(
+      TILEDB_ERR,
+      create_dense_array(TILEDB_GZIP | TILEDB_COMPRESSION_LEVEL(15)));
+  ASSERT_EQ(
+      TILEDB_ERR,
+      create_dense_array(
+          TILEDB_NO_COMPRESSION | TILEDB_COMPRESSION_LEVEL(1)));
+#ifdef HAVE_ZSTD
+  ASSERT_EQ(
+      TILEDB_ERR,
+      create_dense_array(TILEDB_ZSTD | TILEDB_COMPRESSION_LEVEL(23)));
+#endif
+}
+
+TEST_F(CompressorTest, ConfigCompressionLevels) {
+  ASSERT_EQ(TILEDB_OK, create_dense_array(TILEDB_GZIP));
+
+  // Levels beyond every codec are rejected upfront
+  ASSERT_EQ(
+      TILEDB_ERR,
+      tiledb_ctx_set_config(tiledb_ctx, "compression_level", "32"));
+
+  // Levels beyond the codec of the attribute fail the writes, whether they
+  // are rejected upfront (if no codec of the build accepts them) or not
+  if (Compressor::max_supported_level() >= 15) {
+    ASSERT_EQ(
+        TILEDB_OK,
+        tiledb_ctx_set_config(tiledb_ctx, "compression_level", "15"));
+    ASSERT_EQ(TILEDB_ERR, write_dense_array());
+  } else {
+    ASSERT_EQ(
+        TILEDB_ERR,
+        tiledb_ctx_set_config(tiledb_ctx, "compression_level", "15"));
+  }
+
+  // Levels within the codec range are applied
+  ASSERT_EQ(
+      TILEDB_OK,
+      tiledb_ctx_set_config(tiledb_ctx, "compression_level", "9"));
+  ASSERT_EQ(TILEDB_OK, write_dense_array());
+
+  // A level set in the schema takes precedence over the configuration
+  ASSERT_EQ(TILEDB_OK, tiledb_delete(tiledb_ctx, array_name.c_str()));
+  ASSERT_EQ(
+      TILEDB_OK,
+      create_dense_array(TILEDB_GZIP | TILEDB_COMPRESSION_LEVEL(1)));
+  if (Compressor::max_supported_level() >= 15) {
+    ASSERT_EQ(
+        TILEDB_OK,
+        tiledb_ctx_set_config(tiledb_ctx, "compression_level", "15"));
+  }
+  ASSERT_EQ(TILEDB_OK, write_dense_array());
+}
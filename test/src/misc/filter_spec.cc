@@ -0,0 +1,279 @@
+/**
+ * Copyright (c) 2016  Massachusetts Institute of Technology and Intel Corp.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Tests to check that the tile filter pipeline is reversible, that filter
+ * chains are serialized/deserialized with the array schema, and that
+ * filtered arrays are read back correctly
+ */
+
+#include <gtest/gtest.h>
+#include "c_api.h"
+#include "filter.h"
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <vector>
+
+class FilterTest: public testing::Test {
+
+public:
+  const std::string WORKSPACE = ".__workspace/";
+  const std::string ARRAYNAME = "sparse_test_100x100_10x10";
+  const int CELL_NUM = 1000;
+
+  // TileDB context
+  TileDB_CTX* tiledb_ctx;
+  // Array name is initialized with the workspace folder
+  std::string array_name;
+
+  int create_sparse_array(const int* compression);
+  int write_sparse_array();
+  void check_pipeline(int filters);
+
+  virtual void SetUp() {
+    // Initialize context with the default configuration parameters
+    tiledb_ctx_init(&tiledb_ctx, NULL);
+
+    if (tiledb_workspace_create(
+          tiledb_ctx,
+          WORKSPACE.c_str()) != TILEDB_OK) {
+      exit(EXIT_FAILURE);
+    }
+
+    array_name.append(WORKSPACE);
+    array_name.append(ARRAYNAME);
+  }
+
+  virtual void TearDown() {
+    // Finalize TileDB context
+    tiledb_ctx_finalize(tiledb_ctx);
+
+    // Remove the temporary workspace
+    std::string command = "rm -rf ";
+    command.append(WORKSPACE);
+    int ret = system(command.c_str());
+  }
+};
+
+/**
+ * Create a sparse 100x100 array with 10x10 tiles, an int attribute and the
+ * input compression for the attribute and the coordinates
+ */
+int FilterTest::create_sparse_array(const int* compression) {
+  const char* attributes[] = { "ATTR_INT32" };
+  const char* dimensions[] = { "X", "Y" };
+  int64_t domain[] = { 0, 99, 0, 99 };
+  int64_t tile_extents[] = { 10, 10 };
+  const int types[] = { TILEDB_INT32, TILEDB_INT64 };
+
+  TileDB_ArraySchema schema;
+  tiledb_array_set_schema(
+      &schema,
+      array_name.c_str(),
+      attributes,
+      1,
+      50,
+      TILEDB_ROW_MAJOR,
+      NULL,
+      compression,
+      0,
+      dimensions,
+      2,
+      domain,
+      4*sizeof(int64_t),
+      tile_extents,
+      2*sizeof(int64_t),
+      0,
+      types);
+
+  int rc = tiledb_array_create(tiledb_ctx, &schema);
+  tiledb_array_free_schema(&schema);
+  return rc;
+}
+
+/**
+ * Write CELL_NUM cells in ten columns, where the value of cell (i,j) is
+ * i * 100 + j
+ */
+int FilterTest::write_sparse_array() {
+  std::vector<int> buffer_a1;
+  std::vector<int64_t> buffer_coords;
+  for (int64_t i = 0; i < CELL_NUM / 10; ++i) {
+    for (int64_t j = 0; j < 10; ++j) {
+      buffer_a1.push_back(i * 100 + j);
+      buffer_coords.push_back(i);
+      buffer_coords.push_back(j);
+    }
+  }
+
+  TileDB_Array* tiledb_array;
+  if (tiledb_array_init(
+          tiledb_ctx,
+          &tiledb_array,
+          array_name.c_str(),
+          TILEDB_ARRAY_WRITE_UNSORTED,
+          NULL,
+          NULL,
+          0) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  const void* buffers[] = { &buffer_a1[0], &buffer_coords[0] };
+  size_t buffer_sizes[] = {
+      buffer_a1.size() * sizeof(int),
+      buffer_coords.size() * sizeof(int64_t) };
+  if (tiledb_array_write(tiledb_array, buffers, buffer_sizes) != TILEDB_OK)
+    return TILEDB_ERR;
+
+  return tiledb_array_finalize(tiledb_array);
+}
+
+/**
+ * Filter a tile of slowly changing coordinates with the input chain and check
+ * that it is restored exactly
+ */
+void FilterTest::check_pipeline(int filters) {
+  // Two values per cell, with some trailing values outside a full cell
+  std::vector<int64_t> tile;
+  for (int64_t i = 0; i < 1001; ++i) {
+    tile.push_back(5000 + i / 7);
+    tile.push_back(-3 * i);
+  }
+  tile.push_back(42);
+  size_t tile_size = tile.size() * sizeof(int64_t);
+
+  FilterPipeline pipeline(filters, sizeof(int64_t), 2);
+  std::vector<char> filtered(pipeline.filter_bound(tile_size));
+  ssize_t filtered_size = pipeline.filter(
+      &tile[0],
+      tile_size,
+      &filtered[0],
+      filtered.size());
+  ASSERT_GT(filtered_size, 0);
+
+  std::vector<int64_t> unfiltered(tile.size());
+  ASSERT_EQ(TILEDB_FL_OK, pipeline.unfilter(
+      &filtered[0],
+      filtered_size,
+      &unfiltered[0],
+      tile_size));
+  ASSERT_EQ(tile, unfiltered);
+}
+
+/***************************/
+/********** TESTS **********/
+/***************************/
+TEST_F(FilterTest, PipelineRoundTrip) {
+  check_pipeline(TILEDB_FILTER_DELTA);
+  check_pipeline(TILEDB_FILTER_DOUBLE_DELTA);
+  check_pipeline(TILEDB_FILTER_BYTE_SHUFFLE);
+  check_pipeline(TILEDB_FILTER_BIT_SHUFFLE);
+  check_pipeline(TILEDB_FILTER_BIT_PACKING);
+  check_pipeline(
+      TILEDB_FILTER_DOUBLE_DELTA |
+      (TILEDB_FILTER_BIT_PACKING << TILEDB_FILTER_BITS));
+  check_pipeline(
+      TILEDB_FILTER_DELTA |
+      (TILEDB_FILTER_BIT_SHUFFLE << TILEDB_FILTER_BITS) |
+      (TILEDB_FILTER_BYTE_SHUFFLE << 2*TILEDB_FILTER_BITS));
+
+  // At most one bit-packing filter is allowed in a chain
+  ASSERT_TRUE(FilterPipeline::valid(TILEDB_FILTER_BIT_PACKING));
+  ASSERT_FALSE(FilterPipeline::valid(
+      TILEDB_FILTER_BIT_PACKING |
+      (TILEDB_FILTER_BIT_PACKING << TILEDB_FILTER_BITS)));
+}
+
+TEST_F(FilterTest, SchemaWithFiltersRoundTrip) {
+  const int compression[] = {
+      TILEDB_GZIP |
+          TILEDB_FILTER(0, TILEDB_FILTER_DELTA) |
+          TILEDB_FILTER(1, TILEDB_FILTER_BYTE_SHUFFLE),
+      TILEDB_GZIP | TILEDB_COMPRESSION_LEVEL(9) |
+          TILEDB_FILTER(0, TILEDB_FILTER_DOUBLE_DELTA) |
+          TILEDB_FILTER(1, TILEDB_FILTER_BIT_PACKING) };
+  ASSERT_EQ(TILEDB_OK, create_sparse_array(compression));
+
+  TileDB_ArraySchema schema_from_disk;
+  ASSERT_EQ(TILEDB_OK, tiledb_array_load_schema(
+      tiledb_ctx,
+      array_name.c_str(),
+      &schema_from_disk));
+  ASSERT_EQ(compression[0], schema_from_disk.compression_[0]);
+  ASSERT_EQ(compression[1], schema_from_disk.compression_[1]);
+  tiledb_array_free_schema(&schema_from_disk);
+}
+
+TEST_F(FilterTest, FilteredWriteRead) {
+  const int compression[] = {
+      TILEDB_GZIP |
+          TILEDB_FILTER(0, TILEDB_FILTER_DELTA) |
+          TILEDB_FILTER(1, TILEDB_FILTER_BIT_SHUFFLE),
+      TILEDB_GZIP |
+          TILEDB_FILTER(0, TILEDB_FILTER_DOUBLE_DELTA) |
+          TILEDB_FILTER(1, TILEDB_FILTER_BIT_PACKING) };
+  ASSERT_EQ(TILEDB_OK, create_sparse_array(compression));
+  ASSERT_EQ(TILEDB_OK, write_sparse_array());
+
+  // Read the entire array
+  TileDB_Array* tiledb_array;
+  ASSERT_EQ(TILEDB_OK, tiledb_array_init(
+      tiledb_ctx,
+      &tiledb_array,
+      array_name.c_str(),
+      TILEDB_ARRAY_READ,
+      NULL,
+      NULL,
+      0));
+  std::vector<int> buffer_a1(2 * CELL_NUM);
+  std::vector<int64_t> buffer_coords(4 * CELL_NUM);
+  void* buffers[] = { &buffer_a1[0], &buffer_coords[0] };
+  size_t buffer_sizes[] = {
+      buffer_a1.size() * sizeof(int),
+      buffer_coords.size() * sizeof(int64_t) };
+  ASSERT_EQ(TILEDB_OK, tiledb_array_read(tiledb_array, buffers, buffer_sizes));
+  ASSERT_EQ(TILEDB_OK, tiledb_array_finalize(tiledb_array));
+
+  // Every cell is read back once with its value
+  ASSERT_EQ(CELL_NUM * sizeof(int), buffer_sizes[0]);
+  ASSERT_EQ(2 * CELL_NUM * sizeof(int64_t), buffer_sizes[1]);
+  std::map<int64_t, int> cells;
+  for (int i = 0; i < CELL_NUM; ++i)
+    cells[buffer_coords[2*i] * 100 + buffer_coords[2*i+1]] = buffer_a1[i];
+  ASSERT_EQ(size_t(CELL_NUM), cells.size());
+  std::map<int64_t, int>::const_iterator it = cells.begin();
+  for (; it != cells.end(); ++it)
+    ASSERT_EQ(it->first, it->second);
+}
+
+TEST_F(FilterTest, FiltersRequireCompression) {
+  const int compression[] = {
+      TILEDB_NO_COMPRESSION | TILEDB_FILTER(0, TILEDB_FILTER_DELTA),
+      TILEDB_NO_COMPRESSION };
+  ASSERT_EQ(TILEDB_ERR, create_sparse_array(compression));
+
+  // Unknown filters are rejected as well
+  const int unknown_filter[] = {
+      TILEDB_GZIP | TILEDB_FILTER(0, TILEDB_FILTER_MASK),
+      TILEDB_NO_COMPRESSION };
+  ASSERT_EQ(TILEDB_ERR, create_sparse_array(unknown_filter));
+}
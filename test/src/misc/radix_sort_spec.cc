@@ -0,0 +1,179 @@
+/**
+ * Copyright (c) 2016  Massachusetts Institute of Technology and Intel Corp.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Tests to check that the radix keys preserve the order of the values, and
+ * that radix sort produces the same permutation as a stable comparison sort
+ */
+
+#include <gtest/gtest.h>
+#include "constants.h"
+#include "utils.h"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+class RadixSortTest: public testing::Test {
+
+public:
+  template<class T>
+  void check_sort(const std::vector<T>& values, int thread_num);
+
+  virtual void SetUp() {
+    srand(7);
+  }
+};
+
+/** Orders the positions of a vector by the values at these positions. */
+template<class T>
+class ValueLess {
+ public:
+  ValueLess(const std::vector<T>& values) : values_(values) { }
+  bool operator()(int64_t a, int64_t b) const {
+    return values_[a] < values_[b];
+  }
+ private:
+  const std::vector<T>& values_;
+};
+
+/**
+ * Sort the positions of the input values with radix sort on their keys, and
+ * compare the result with a stable comparison sort on the values
+ */
+template<class T>
+void RadixSortTest::check_sort(const std::vector<T>& values, int thread_num) {
+  int64_t value_num = values.size();
+  std::vector<uint64_t> keys(value_num);
+  std::vector<int64_t> positions(value_num);
+  for (int64_t i = 0; i < value_num; ++i) {
+    keys[i] = radix_key<T>(values[i]);
+    positions[i] = i;
+  }
+  std::vector<int64_t> expected = positions;
+  std::stable_sort(expected.begin(), expected.end(), ValueLess<T>(values));
+
+  radix_sort(keys, positions, thread_num);
+  ASSERT_EQ(expected.size(), positions.size());
+  for (int64_t i = 0; i < value_num; ++i) {
+    ASSERT_EQ(expected[i], positions[i]);
+    ASSERT_EQ(radix_key<T>(values[positions[i]]), keys[i]);
+  }
+}
+
+/***************************/
+/********** TESTS **********/
+/***************************/
+TEST_F(RadixSortTest, KeysPreserveOrder) {
+  int ints[] = {
+      std::numeric_limits<int>::min(), -1000, -1, 0, 1, 1000,
+      std::numeric_limits<int>::max() };
+  for (int i = 1; i < 7; ++i)
+    ASSERT_LT(radix_key<int>(ints[i-1]), radix_key<int>(ints[i]));
+
+  int64_t int64s[] = {
+      std::numeric_limits<int64_t>::min(), -(int64_t(1) << 40), -1, 0, 1,
+      int64_t(1) << 40, std::numeric_limits<int64_t>::max() };
+  for (int i = 1; i < 7; ++i)
+    ASSERT_LT(radix_key<int64_t>(int64s[i-1]), radix_key<int64_t>(int64s[i]));
+
+  float floats[] = {
+      -std::numeric_limits<float>::infinity(),
+      -std::numeric_limits<float>::max(), -1.5f,
+      -std::numeric_limits<float>::denorm_min(), 0.0f,
+      std::numeric_limits<float>::denorm_min(), 1.5f,
+      std::numeric_limits<float>::max(),
+      std::numeric_limits<float>::infinity() };
+  for (int i = 1; i < 9; ++i)
+    ASSERT_LT(radix_key<float>(floats[i-1]), radix_key<float>(floats[i]));
+
+  double doubles[] = {
+      -std::numeric_limits<double>::infinity(), -1e300, -2.5, -1e-300, 0.0,
+      1e-300, 2.5, 1e300, std::numeric_limits<double>::infinity() };
+  for (int i = 1; i < 9; ++i)
+    ASSERT_LT(radix_key<double>(doubles[i-1]), radix_key<double>(doubles[i]));
+
+  // Negative and positive zero are equal
+  ASSERT_EQ(radix_key<float>(-0.0f), radix_key<float>(0.0f));
+  ASSERT_EQ(radix_key<double>(-0.0), radix_key<double>(0.0));
+}
+
+TEST_F(RadixSortTest, NegativeInts) {
+  std::vector<int> values;
+  for (int i = 0; i < 1000; ++i)
+    values.push_back(rand() % 2001 - 1000);
+  check_sort(values, 1);
+}
+
+TEST_F(RadixSortTest, Int64Extremes) {
+  std::vector<int64_t> values;
+  int64_t extremes[] = {
+      std::numeric_limits<int64_t>::min(),
+      std::numeric_limits<int64_t>::min() + 1, -1, 0, 1,
+      std::numeric_limits<int64_t>::max() - 1,
+      std::numeric_limits<int64_t>::max() };
+  for (int i = 0; i < 1000; ++i)
+    values.push_back(extremes[rand() % 7]);
+  check_sort(values, 1);
+}
+
+TEST_F(RadixSortTest, SignedZerosAndNegativeFloats) {
+  std::vector<float> floats;
+  std::vector<double> doubles;
+  for (int i = 0; i < 1000; ++i) {
+    int r = rand() % 8;
+    float value = (rand() % 200 - 100) / 8.0f;
+    if (r < 2)
+      value = (r == 0) ? -0.0f : 0.0f;
+    floats.push_back(value);
+    doubles.push_back(-double(value));
+  }
+  check_sort(floats, 1);
+  check_sort(doubles, 1);
+}
+
+TEST_F(RadixSortTest, EqualKeys) {
+  // Every pass is skipped, and the positions keep their order
+  std::vector<int64_t> values(1000, -42);
+  check_sort(values, 1);
+
+  // Every pass but one is skipped
+  std::vector<int> ints;
+  for (int i = 0; i < 1000; ++i)
+    ints.push_back((i % 3) << 16);
+  check_sort(ints, 1);
+}
+
+TEST_F(RadixSortTest, MultipleChunksAreStable) {
+  // Few distinct keys spread across several chunks, so that the chunks place
+  // many equal keys
+  int64_t value_num = 3 * TILEDB_RADIX_SORT_MIN_CHUNK_SIZE + 17;
+  std::vector<int> ints;
+  std::vector<double> doubles;
+  for (int64_t i = 0; i < value_num; ++i) {
+    ints.push_back(rand() % 50 - 25);
+    doubles.push_back((rand() % 1000 - 500) * 0.25);
+  }
+  check_sort(ints, 1);
+  check_sort(ints, 4);
+  check_sort(doubles, 4);
+}